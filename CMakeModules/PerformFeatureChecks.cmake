@@ -110,4 +110,8 @@ macro( perform_feature_checks )
     # getc() on platforms where getc_unlocked() doesn't exist.
     check_symbol_exists( getc_unlocked "stdio.h" HAVE_FGETC_NOLOCK )
 
+    # Check for Posix mmap() to parse files straight from their mapping.  Fall back to
+    # reading them line by line on platforms where mmap() doesn't exist.
+    check_symbol_exists( mmap "sys/mman.h" HAVE_MMAP )
+
 endmacro( perform_feature_checks )
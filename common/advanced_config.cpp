@@ -77,6 +77,19 @@ static const wxChar AllowLegacyCanvasInGtk3[] = wxT( "AllowLegacyCanvasInGtk3" )
  */
 static const wxChar ForceThickZones[] = wxT( "ForceThickZones" );
 
+/**
+ * Testing mode for online DRC.  Setting this to on makes pcbnew recheck the tracks touched
+ * by each edit (and the tracks around them) for clearance errors, and update the DRC
+ * markers accordingly, without running the full DRC.
+ */
+static const wxChar OnlineDrc[] = wxT( "OnlineDrc" );
+
+/**
+ * Compute the ratsnest with the former halfedge based Delaunay triangulation instead of
+ * the index based one.  Kept for comparison of the results.
+ */
+static const wxChar LegacyRatsnestTriangulation[] = wxT( "LegacyRatsnestTriangulation" );
+
 } // namespace KEYS
 
 
@@ -158,6 +171,8 @@ ADVANCED_CFG::ADVANCED_CFG()
     m_allowLegacyCanvasInGtk3 = false;
     m_realTimeConnectivity = true;
     m_forceThickOutlinesInZones = true;
+    m_onlineDrc = false;
+    m_legacyRatsnestTriangulation = false;
 
     loadFromConfigFile();
 }
@@ -203,6 +218,12 @@ void ADVANCED_CFG::loadSettings( wxConfigBase& aCfg )
     configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::ForceThickZones,
                                                 &m_forceThickOutlinesInZones, true ) );
 
+    configParams.push_back(
+            new PARAM_CFG_BOOL( true, AC_KEYS::OnlineDrc, &m_onlineDrc, false ) );
+
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::LegacyRatsnestTriangulation,
+                                                &m_legacyRatsnestTriangulation, false ) );
+
     wxConfigLoadSetups( &aCfg, configParams );
 
     dumpCfg( configParams );
@@ -38,6 +38,7 @@
 #include <base_struct.h>
 #include <title_block.h>
 #include <common.h>
+#include <richio.h>
 #include <base_units.h>
 #include "libeval/numeric_evaluator.h"
 
@@ -62,31 +63,29 @@
 
 std::string Double2Str( double aValue )
 {
-    char    buf[50];
-    int     len;
+    std::string buf;
 
     if( aValue != 0.0 && fabs( aValue ) <= 0.0001 )
     {
         // For these small values, %f works fine,
         // and %g gives an exponent
-        len = sprintf( buf,  "%.16f", aValue );
+        buf = OUTPUTFORMATTER::FormatDouble( aValue, 16, true );
 
-        while( --len > 0 && buf[len] == '0' )
-            buf[len] = '\0';
+        size_t len = buf.find_last_not_of( '0' );
 
         if( buf[len] == '.' )
-            buf[len] = '\0';
+            buf.resize( len );
         else
-            ++len;
+            buf.resize( len + 1 );
     }
     else
     {
         // For these values, %g works fine, and sometimes %f
         // gives a bad value (try aValue = 1.222222222222, with %.16f format!)
-        len = sprintf( buf, "%.16g", aValue );
+        buf = OUTPUTFORMATTER::FormatDouble( aValue, 16 );
     }
 
-    return std::string( buf, len );
+    return buf;
 }
 
 
@@ -464,9 +463,8 @@ wxString GetAbbreviatedUnitsLabel( EDA_UNITS_T aUnit, bool aUseMils )
 
 std::string FormatInternalUnits( int aValue )
 {
-    char    buf[50];
-    double  engUnits = aValue;
-    int     len;
+    std::string buf;
+    double      engUnits = aValue;
 
 #ifndef EESCHEMA
     engUnits /= IU_PER_MM;
@@ -474,35 +472,29 @@ std::string FormatInternalUnits( int aValue )
 
     if( engUnits != 0.0 && fabs( engUnits ) <= 0.0001 )
     {
-        len = snprintf( buf, sizeof(buf), "%.10f", engUnits );
+        buf = OUTPUTFORMATTER::FormatDouble( engUnits, 10, true );
 
-        while( --len > 0 && buf[len] == '0' )
-            buf[len] = '\0';
+        size_t len = buf.find_last_not_of( '0' );
 
 #ifndef EESCHEMA
         if( buf[len] == '.' )
-            buf[len] = '\0';
+            buf.resize( len );
         else
 #endif
-            ++len;
+            buf.resize( len + 1 );
     }
     else
     {
-        len = snprintf( buf, sizeof(buf), "%.10g", engUnits );
+        buf = OUTPUTFORMATTER::FormatDouble( engUnits, 10 );
     }
 
-    return std::string( buf, len );
+    return buf;
 }
 
 
 std::string FormatAngle( double aAngle )
 {
-    char temp[50];
-    int len;
-
-    len = snprintf( temp, sizeof(temp), "%.10g", aAngle / 10.0 );
-
-    return std::string( temp, len );
+    return OUTPUTFORMATTER::FormatDouble( aAngle / 10.0, 10 );
 }
 
 
@@ -28,6 +28,11 @@
 #include <cstdio>
 #include <cstdlib>         // bsearch()
 #include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <locale>
+#include <sstream>
 
 #include <macros.h>
 #include <fctsys.h>
@@ -350,6 +355,133 @@ bool DSNLEXER::IsSymbol( int aTok )
 }
 
 
+const char* DSNLEXER::ParseDouble( const char* aStart, const char* aEnd, double& aValue )
+{
+    // The powers of ten which are exact in a double
+    static const double exactPowersOfTen[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* cur = aStart;
+    bool        negative = false;
+
+    if( cur < aEnd && ( *cur == '-' || *cur == '+' ) )
+        negative = *cur++ == '-';
+
+    // The number is the mantissa times 10 to the power of the exponent.  The mantissa keeps
+    // the first 19 significant digits, which always fit in 64 bits.
+    uint64_t    mantissa = 0;
+    int         digits = 0;
+    int         exponent = 0;
+    bool        hasDigits = false;
+    bool        truncated = false;
+    bool        fraction = false;
+
+    for( ; cur < aEnd; ++cur )
+    {
+        if( *cur == '.' && !fraction )
+        {
+            fraction = true;
+            continue;
+        }
+
+        if( !isdigit( (unsigned char) *cur ) )
+            break;
+
+        hasDigits = true;
+
+        if( digits < 19 )
+        {
+            mantissa = mantissa * 10 + ( *cur - '0' );
+
+            if( mantissa )
+                ++digits;
+
+            if( fraction )
+                --exponent;
+        }
+        else
+        {
+            truncated |= *cur != '0';
+
+            if( !fraction )
+                ++exponent;
+        }
+    }
+
+    if( !hasDigits )
+        return aStart;
+
+    if( cur < aEnd && ( *cur == 'e' || *cur == 'E' ) )
+    {
+        const char* exp = cur + 1;
+        bool        negativeExp = false;
+        int         expValue = 0;
+
+        if( exp < aEnd && ( *exp == '-' || *exp == '+' ) )
+            negativeExp = *exp++ == '-';
+
+        // The exponent is only part of the number when it has digits
+        if( exp < aEnd && isdigit( (unsigned char) *exp ) )
+        {
+            for( ; exp < aEnd && isdigit( (unsigned char) *exp ); ++exp )
+            {
+                if( expValue < 100000 )
+                    expValue = expValue * 10 + ( *exp - '0' );
+            }
+
+            exponent += negativeExp ? -expValue : expValue;
+            cur = exp;
+        }
+    }
+
+    double value;
+
+    if( mantissa == 0 && !truncated )
+    {
+        value = 0.0;
+    }
+    else if( !truncated && mantissa <= ( uint64_t( 1 ) << 53 )
+             && exponent >= -22 && exponent <= 22 )
+    {
+        // Both the mantissa and the power of ten are exact, so a single multiplication or
+        // division gives the correctly rounded result.  This covers all the numbers of the
+        // usual board and footprint files.
+        value = (double) mantissa;
+
+        if( exponent < 0 )
+            value /= exactPowersOfTen[-exponent];
+        else
+            value *= exactPowersOfTen[exponent];
+    }
+    else
+    {
+        // Let the library round the other numbers, in the classic "C" locale of a stream
+        // rather than with strtod() which uses the global locale.
+        std::istringstream  stream( std::string( aStart, cur ) );
+
+        stream.imbue( std::locale::classic() );
+        stream >> value;
+
+        if( stream.fail() )
+        {
+            errno = ERANGE;
+            value = HUGE_VAL;
+        }
+        else
+        {
+            // The sign has already been read into the value
+            negative = false;
+        }
+    }
+
+    aValue = negative ? -value : value;
+
+    return cur;
+}
+
+
 void DSNLEXER::Expecting( int aTok )
 {
     wxString errText = wxString::Format(
@@ -655,7 +787,7 @@ L_read:
                     case 'v':   c = '\x0b';     break;
 
                     case 'x':   // 1 or 2 byte hex escape sequence
-                        for( i=0; i<2; ++i )
+                        for( i=0; i<2 && head+i<limit; ++i )
                         {
                             if( !isxdigit( head[i] ) )
                                 break;
@@ -671,7 +803,7 @@ L_read:
 
                     default:    // 1-3 byte octal escape sequence
                         --head;
-                        for( i=0; i<3; ++i )
+                        for( i=0; i<3 && head+i<limit; ++i )
                         {
                             if( head[i] < '0' || head[i] > '7' )
                                 break;
@@ -777,11 +909,11 @@ L_read:
     }           // specctraMode
 
     // non-quoted token, read it into curText.
-    curText.clear();
-
     head = cur;
     while( head<limit && !isSep( *head ) )
-        curText += *head++;
+        ++head;
+
+    curText.assign( cur, head );
 
     if( isNumber( curText.c_str(), curText.c_str() + curText.size() ) )
     {
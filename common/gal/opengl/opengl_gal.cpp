@@ -984,7 +984,7 @@ void OPENGL_GAL::drawTriangulatedPolyset( const SHAPE_POLY_SET& aPolySet )
     {
         for( int j = 0; j < aPolySet.OutlineCount(); ++j )
         {
-            const auto& poly = aPolySet.Polygon( j );
+            const auto& poly = aPolySet.CPolygon( j );
 
             for( const auto& lc : poly )
             {
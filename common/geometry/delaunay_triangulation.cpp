@@ -0,0 +1,434 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <geometry/delaunay_triangulation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+// Bounds the flip stack of legalize(): it can only be reached with extremely degenerate input
+static const size_t MAX_EDGE_STACK = 1024;
+
+
+// True if r lies on the hull side of the directed edge p->q, i.e. p, q, r turn clockwise
+static inline bool orient( double px, double py, double qx, double qy, double rx, double ry )
+{
+    return ( qy - py ) * ( rx - qx ) - ( qx - px ) * ( ry - qy ) < 0;
+}
+
+
+// True if p lies inside the circumcircle of a, b, c
+static inline bool inCircle( double ax, double ay, double bx, double by, double cx, double cy,
+                             double px, double py )
+{
+    const double dx = ax - px;
+    const double dy = ay - py;
+    const double ex = bx - px;
+    const double ey = by - py;
+    const double fx = cx - px;
+    const double fy = cy - py;
+
+    const double ap = dx * dx + dy * dy;
+    const double bp = ex * ex + ey * ey;
+    const double cp = fx * fx + fy * fy;
+
+    return dx * ( ey * cp - bp * fy ) - dy * ( ex * cp - bp * fx ) + ap * ( ex * fy - ey * fx ) < 0;
+}
+
+
+// Circumcentre of a, b, c relative to a; infinite or NaN for colinear points
+static inline void circumcentreOffset( double ax, double ay, double bx, double by, double cx,
+                                       double cy, double& aOffX, double& aOffY )
+{
+    const double dx = bx - ax;
+    const double dy = by - ay;
+    const double ex = cx - ax;
+    const double ey = cy - ay;
+
+    const double bl = dx * dx + dy * dy;
+    const double cl = ex * ex + ey * ey;
+    const double d = 0.5 / ( dx * ey - dy * ex );
+
+    aOffX = ( ey * bl - dy * cl ) * d;
+    aOffY = ( dx * cl - ex * bl ) * d;
+}
+
+
+int DELAUNAY_TRIANGULATION::hashKey( double aX, double aY ) const
+{
+    const int    hashSize = m_hullHash.size();
+    const double dx = aX - m_cx;
+    const double dy = aY - m_cy;
+    const double len = std::abs( dx ) + std::abs( dy );
+
+    if( len == 0.0 )
+        return 0;
+
+    // Monotonic with the angle around the centre, in [0..1]
+    const double p = dx / len;
+    const double angle = ( dy > 0 ? 3 - p : 1 + p ) / 4;
+
+    return static_cast<int>( std::floor( angle * hashSize ) ) % hashSize;
+}
+
+
+void DELAUNAY_TRIANGULATION::link( int aEdge, int aOpposite )
+{
+    m_halfEdges[aEdge] = aOpposite;
+
+    if( aOpposite != -1 )
+        m_halfEdges[aOpposite] = aEdge;
+}
+
+
+int DELAUNAY_TRIANGULATION::addTriangle( int aP0, int aP1, int aP2, int aE0, int aE1, int aE2 )
+{
+    const int t = m_triangles.size();
+
+    m_triangles.push_back( aP0 );
+    m_triangles.push_back( aP1 );
+    m_triangles.push_back( aP2 );
+    m_halfEdges.resize( t + 3 );
+
+    link( t, aE0 );
+    link( t + 1, aE1 );
+    link( t + 2, aE2 );
+
+    return t;
+}
+
+
+int DELAUNAY_TRIANGULATION::legalize( int aEdge )
+{
+    int a = aEdge;
+    int ar = 0;
+
+    m_edgeStack.clear();
+
+    while( true )
+    {
+        const int b = m_halfEdges[a];
+        const int a0 = a - a % 3;
+        ar = a0 + ( a + 2 ) % 3;
+
+        // Edges on the convex hull cannot be flipped
+        if( b == -1 )
+        {
+            if( m_edgeStack.empty() )
+                break;
+
+            a = m_edgeStack.back();
+            m_edgeStack.pop_back();
+            continue;
+        }
+
+        const int b0 = b - b % 3;
+        const int al = a0 + ( a + 1 ) % 3;
+        const int bl = b0 + ( b + 2 ) % 3;
+
+        const int p0 = m_triangles[ar];
+        const int pr = m_triangles[a];
+        const int pl = m_triangles[al];
+        const int p1 = m_triangles[bl];
+
+        // If p1 lies in the circumcircle of [p0, pr, pl], flip the shared edge and check the
+        // two edges of the new pair of triangles that were not checked yet
+        if( inCircle( m_x[p0], m_y[p0], m_x[pr], m_y[pr], m_x[pl], m_y[pl], m_x[p1], m_y[p1] ) )
+        {
+            m_triangles[a] = p1;
+            m_triangles[b] = p0;
+
+            const int hbl = m_halfEdges[bl];
+
+            // The flipped edge was on the other side of the hull: fix the hull reference
+            if( hbl == -1 )
+            {
+                int e = m_hullStart;
+
+                do
+                {
+                    if( m_hullTri[e] == bl )
+                    {
+                        m_hullTri[e] = a;
+                        break;
+                    }
+
+                    e = m_hullPrev[e];
+                } while( e != m_hullStart );
+            }
+
+            link( a, hbl );
+            link( b, m_halfEdges[ar] );
+            link( ar, bl );
+
+            if( m_edgeStack.size() < MAX_EDGE_STACK )
+                m_edgeStack.push_back( b0 + ( b + 1 ) % 3 );
+        }
+        else
+        {
+            if( m_edgeStack.empty() )
+                break;
+
+            a = m_edgeStack.back();
+            m_edgeStack.pop_back();
+        }
+    }
+
+    return ar;
+}
+
+
+bool DELAUNAY_TRIANGULATION::Triangulate( const std::vector<VECTOR2I>& aPoints )
+{
+    const int n = aPoints.size();
+
+    m_triangles.clear();
+    m_halfEdges.clear();
+
+    if( n < 3 )
+        return false;
+
+    // Work relative to the centre of the points to keep the predicates accurate
+    VECTOR2I::extended_type minX = aPoints[0].x, maxX = aPoints[0].x;
+    VECTOR2I::extended_type minY = aPoints[0].y, maxY = aPoints[0].y;
+
+    for( const VECTOR2I& p : aPoints )
+    {
+        minX = std::min<VECTOR2I::extended_type>( minX, p.x );
+        maxX = std::max<VECTOR2I::extended_type>( maxX, p.x );
+        minY = std::min<VECTOR2I::extended_type>( minY, p.y );
+        maxY = std::max<VECTOR2I::extended_type>( maxY, p.y );
+    }
+
+    const VECTOR2I::extended_type midX = ( minX + maxX ) / 2;
+    const VECTOR2I::extended_type midY = ( minY + maxY ) / 2;
+
+    m_x.resize( n );
+    m_y.resize( n );
+
+    for( int i = 0; i < n; i++ )
+    {
+        m_x[i] = static_cast<double>( aPoints[i].x - midX );
+        m_y[i] = static_cast<double>( aPoints[i].y - midY );
+    }
+
+    // Seed triangle: the point closest to the centre, its nearest neighbour, and the point
+    // making the smallest circumcircle with them
+    int    i0 = -1, i1 = -1, i2 = -1;
+    double minDist = std::numeric_limits<double>::max();
+
+    for( int i = 0; i < n; i++ )
+    {
+        const double d = m_x[i] * m_x[i] + m_y[i] * m_y[i];
+
+        if( d < minDist )
+        {
+            i0 = i;
+            minDist = d;
+        }
+    }
+
+    minDist = std::numeric_limits<double>::max();
+
+    for( int i = 0; i < n; i++ )
+    {
+        if( i == i0 )
+            continue;
+
+        const double dx = m_x[i] - m_x[i0];
+        const double dy = m_y[i] - m_y[i0];
+        const double d = dx * dx + dy * dy;
+
+        if( d < minDist && d > 0 )
+        {
+            i1 = i;
+            minDist = d;
+        }
+    }
+
+    if( i1 < 0 )
+        return false;
+
+    double minRadius = std::numeric_limits<double>::max();
+
+    for( int i = 0; i < n; i++ )
+    {
+        if( i == i0 || i == i1 )
+            continue;
+
+        double ox, oy;
+        circumcentreOffset( m_x[i0], m_y[i0], m_x[i1], m_y[i1], m_x[i], m_y[i], ox, oy );
+
+        // Colinear points give an infinite or NaN radius, which never compares smaller
+        const double r = ox * ox + oy * oy;
+
+        if( r < minRadius )
+        {
+            i2 = i;
+            minRadius = r;
+        }
+    }
+
+    if( i2 < 0 )
+        return false;
+
+    if( orient( m_x[i0], m_y[i0], m_x[i1], m_y[i1], m_x[i2], m_y[i2] ) )
+        std::swap( i1, i2 );
+
+    double ox, oy;
+    circumcentreOffset( m_x[i0], m_y[i0], m_x[i1], m_y[i1], m_x[i2], m_y[i2], ox, oy );
+    m_cx = m_x[i0] + ox;
+    m_cy = m_y[i0] + oy;
+
+    // Sweep the points by distance from the seed circumcentre
+    m_ids.resize( n );
+    m_dists.resize( n );
+
+    for( int i = 0; i < n; i++ )
+    {
+        const double dx = m_x[i] - m_cx;
+        const double dy = m_y[i] - m_cy;
+
+        m_ids[i] = i;
+        m_dists[i] = dx * dx + dy * dy;
+    }
+
+    std::sort( m_ids.begin(), m_ids.end(), [this]( int aA, int aB ) {
+        if( m_dists[aA] != m_dists[aB] )
+            return m_dists[aA] < m_dists[aB];
+
+        return aA < aB;
+    } );
+
+    // The seed triangle is the initial hull
+    m_hullPrev.assign( n, -1 );
+    m_hullNext.assign( n, -1 );
+    m_hullTri.assign( n, -1 );
+    m_hullHash.assign( std::max( 1, static_cast<int>( std::ceil( std::sqrt( n ) ) ) ), -1 );
+
+    m_hullStart = i0;
+
+    m_hullNext[i0] = m_hullPrev[i2] = i1;
+    m_hullNext[i1] = m_hullPrev[i0] = i2;
+    m_hullNext[i2] = m_hullPrev[i1] = i0;
+
+    m_hullTri[i0] = 0;
+    m_hullTri[i1] = 1;
+    m_hullTri[i2] = 2;
+
+    m_hullHash[hashKey( m_x[i0], m_y[i0] )] = i0;
+    m_hullHash[hashKey( m_x[i1], m_y[i1] )] = i1;
+    m_hullHash[hashKey( m_x[i2], m_y[i2] )] = i2;
+
+    const int maxTriangles = std::max( 2 * n - 5, 1 );
+    m_triangles.reserve( maxTriangles * 3 );
+    m_halfEdges.reserve( maxTriangles * 3 );
+
+    addTriangle( i0, i1, i2, -1, -1, -1 );
+
+    const int hashSize = m_hullHash.size();
+
+    for( int k = 0; k < n; k++ )
+    {
+        const int    i = m_ids[k];
+        const double x = m_x[i];
+        const double y = m_y[i];
+
+        if( i == i0 || i == i1 || i == i2 )
+            continue;
+
+        // Find a visible edge of the hull, starting from the hull point closest in angle
+        int start = 0;
+
+        for( int j = 0, key = hashKey( x, y ); j < hashSize; j++ )
+        {
+            start = m_hullHash[( key + j ) % hashSize];
+
+            if( start != -1 && start != m_hullNext[start] )
+                break;
+        }
+
+        start = m_hullPrev[start];
+        int e = start;
+
+        while( !orient( x, y, m_x[e], m_y[e], m_x[m_hullNext[e]], m_y[m_hullNext[e]] ) )
+        {
+            e = m_hullNext[e];
+
+            if( e == start )
+            {
+                e = -1;
+                break;
+            }
+        }
+
+        // No visible edge: the point is (numerically) on the hull already
+        if( e == -1 )
+            continue;
+
+        // Connect the point to the first visible edge, then to the visible edges on either
+        // side of it, removing the points that are no longer on the hull
+        int t = addTriangle( e, i, m_hullNext[e], -1, -1, m_hullTri[e] );
+
+        m_hullTri[i] = legalize( t + 2 );
+        m_hullTri[e] = t;
+
+        int next = m_hullNext[e];
+
+        while( orient( x, y, m_x[next], m_y[next], m_x[m_hullNext[next]],
+                       m_y[m_hullNext[next]] ) )
+        {
+            const int q = m_hullNext[next];
+
+            t = addTriangle( next, i, q, m_hullTri[i], -1, m_hullTri[next] );
+            m_hullTri[i] = legalize( t + 2 );
+            m_hullNext[next] = next;    // removed from the hull
+            next = q;
+        }
+
+        if( e == start )
+        {
+            while( orient( x, y, m_x[m_hullPrev[e]], m_y[m_hullPrev[e]], m_x[e], m_y[e] ) )
+            {
+                const int q = m_hullPrev[e];
+
+                t = addTriangle( q, i, e, -1, m_hullTri[e], m_hullTri[q] );
+                legalize( t + 2 );
+                m_hullTri[q] = t;
+                m_hullNext[e] = e;      // removed from the hull
+                e = q;
+            }
+        }
+
+        m_hullStart = m_hullPrev[i] = e;
+        m_hullNext[e] = m_hullPrev[next] = i;
+        m_hullNext[i] = next;
+
+        m_hullHash[hashKey( x, y )] = i;
+        m_hullHash[hashKey( m_x[e], m_y[e] )] = e;
+    }
+
+    return true;
+}
@@ -34,6 +34,12 @@
 #include <algorithm>
 #include <unordered_set>
 #include <memory>
+#include <cmath>
+#include <limits>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <functional>
 
 #include <md5_hash.h>
 #include <map>
@@ -45,9 +51,159 @@
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_poly_set.h>
 #include <geometry/polygon_triangulation.h>
+#include <math/math_util.h>
 
 using namespace ClipperLib;
 
+///> Below this many vertices, starting threads costs more than it saves
+static const int MIN_PARALLEL_VERTICES = 10000;
+
+
+/**
+ * Runs aTask( i ) for each i below aCount, on as many threads as there are cores if aParallel
+ * is true, and on the calling thread otherwise.
+ */
+static void runParallel( size_t aCount, bool aParallel,
+                         const std::function<void( size_t )>& aTask )
+{
+    std::atomic<size_t> nextItem( 0 );
+    size_t              parallelThreadCount = 1;
+
+    if( aParallel )
+        parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(), aCount );
+
+    auto task_lambda = [&]() -> size_t
+    {
+        size_t num = 0;
+
+        for( size_t i = nextItem++; i < aCount; i = nextItem++ )
+        {
+            aTask( i );
+            num++;
+        }
+
+        return num;
+    };
+
+    if( parallelThreadCount <= 1 )
+        task_lambda();
+    else
+    {
+        std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii] = std::async( std::launch::async, task_lambda );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii].wait();
+    }
+}
+
+
+/**
+ * Class SHAPE_POLY_SET::EDGE_INDEX
+ *
+ * A uniform grid over the edges of all the contours of a polygon set.  Each cell lists the
+ * edges passing through it, so the edges near a point, or crossed by the horizontal ray cast
+ * from it, are found without scanning all of them.  The edges are numbered polygon by polygon
+ * and contour by contour, so the edges of a polygon form a range of indices.
+ *
+ * The index is a snapshot of the polygons: it is immutable, and shared by the copies of the
+ * set until one of them is edited.
+ */
+class SHAPE_POLY_SET::EDGE_INDEX
+{
+public:
+    EDGE_INDEX( const POLYSET& aPolys );
+
+    /**
+     * Same result as SHAPE_POLY_SET::Contains(): is aP inside the aPolygon-th polygon, or inside
+     * any of them if aPolygon is -1.
+     */
+    bool Contains( const VECTOR2I& aP, int aPolygon, int aAccuracy ) const;
+
+    ///> Returns true if an edge of the set is within aClearance of aSeg
+    bool CollideEdges( const SEG& aSeg, int aClearance ) const;
+
+    ///> Returns the distance from aSeg to the nearest edge of the aPolygon-th polygon, or of
+    ///> any polygon if aPolygon is -1
+    int Distance( const SEG& aSeg, int aPolygon ) const;
+
+private:
+    ///> Largest number of cells of the grid along each axis
+    static constexpr int MAX_GRID_SIZE = 1024;
+
+    int cellX( int64_t aX ) const
+    {
+        return (int) std::max<int64_t>( 0, std::min<int64_t>( m_cols - 1,
+                                                              ( aX - m_x0 ) / m_cellSize ) );
+    }
+
+    int cellY( int64_t aY ) const
+    {
+        return (int) std::max<int64_t>( 0, std::min<int64_t>( m_rows - 1,
+                                                              ( aY - m_y0 ) / m_cellSize ) );
+    }
+
+    ///> Calls aFunc( aCell ) for each cell the edge aEdge passes through (and a few more)
+    template <class Func>
+    void forEachEdgeCell( int aEdge, Func aFunc ) const;
+
+    ///> Calls aFunc( aEdge ) for each edge listed in the cells between the given ones
+    template <class Func>
+    void forEachEdgeInCells( int aCx0, int aCy0, int aCx1, int aCy1, Func aFunc ) const
+    {
+        for( int cy = aCy0; cy <= aCy1; cy++ )
+        {
+            for( int cx = aCx0; cx <= aCx1; cx++ )
+            {
+                int cell = cy * m_cols + cx;
+
+                for( int i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++ )
+                    aFunc( m_cellEdges[i] );
+            }
+        }
+    }
+
+    ///> Same crossing test as SHAPE_LINE_CHAIN::PointInside()
+    bool crossesRay( int aEdge, const VECTOR2I& aP ) const;
+
+    ///> Same test as SHAPE_LINE_CHAIN::PointOnEdge() for the aContour-th contour
+    bool pointOnEdge( const VECTOR2I& aP, int aContour, int aAccuracy ) const;
+
+    bool polygonContains( const VECTOR2I& aP, int aPolygon, int aAccuracy,
+                          const std::vector<int>& aCrossed ) const;
+
+    int polygonFirstEdge( int aPolygon ) const
+    {
+        return m_contourFirstEdge[m_polygonFirstContour[aPolygon]];
+    }
+
+    std::vector<SEG>  m_edges;
+    std::vector<int>  m_edgeContour;
+
+    ///> First edge of each contour, and the total edge count at the end
+    std::vector<int>  m_contourFirstEdge;
+
+    ///> True for the contours that can contain a point (closed, with at least 3 points)
+    std::vector<bool> m_contourClosed;
+
+    ///> First contour of each polygon, and the total contour count at the end
+    std::vector<int>  m_polygonFirstContour;
+
+    int64_t           m_x0;
+    int64_t           m_y0;
+    int64_t           m_cellSize;
+    int               m_cols;
+    int               m_rows;
+    BOX2I             m_bbox;
+
+    ///> Edges of each cell: m_cellEdges[m_cellStart[cell]] to m_cellEdges[m_cellStart[cell + 1]]
+    std::vector<int>  m_cellStart;
+    std::vector<int>  m_cellEdges;
+};
+
+
 SHAPE_POLY_SET::SHAPE_POLY_SET() :
     SHAPE( SH_POLY_SET )
 {
@@ -55,7 +211,8 @@ SHAPE_POLY_SET::SHAPE_POLY_SET() :
 
 
 SHAPE_POLY_SET::SHAPE_POLY_SET( const SHAPE_POLY_SET& aOther, bool aDeepCopy ) :
-    SHAPE( SH_POLY_SET ), m_polys( aOther.m_polys )
+    SHAPE( SH_POLY_SET ), m_polys( aOther.m_polys ),
+    m_edgeIndex( std::atomic_load( &aOther.m_edgeIndex ) )
 {
     if( aOther.IsTriangulationUpToDate() )
     {
@@ -63,8 +220,11 @@ SHAPE_POLY_SET::SHAPE_POLY_SET( const SHAPE_POLY_SET& aOther, bool aDeepCopy ) :
             m_triangulatedPolys.push_back(
                     std::make_unique<TRIANGULATED_POLYGON>( *aOther.TriangulatedPolygon( i ) ) );
 
-        m_hash = aOther.GetHash();
+        m_hash = aOther.m_hash;
+        m_hashGeneration = aOther.m_hashGeneration;
         m_triangulationValid = true;
+        m_generation = aOther.m_generation;
+        m_triangulationGeneration = aOther.m_triangulationGeneration;
     }
 }
 
@@ -121,7 +281,7 @@ bool SHAPE_POLY_SET::GetRelativeIndices( int aGlobalIdx,
 
 
 bool SHAPE_POLY_SET::GetGlobalIndex( SHAPE_POLY_SET::VERTEX_INDEX aRelativeIndices,
-        int& aGlobalIdx )
+        int& aGlobalIdx ) const
 {
     int selectedVertex = aRelativeIndices.m_vertex;
     unsigned int    selectedContour = aRelativeIndices.m_contour;
@@ -131,13 +291,11 @@ bool SHAPE_POLY_SET::GetGlobalIndex( SHAPE_POLY_SET::VERTEX_INDEX aRelativeIndic
     if( selectedPolygon < m_polys.size() && selectedContour < m_polys[selectedPolygon].size()
         && selectedVertex < m_polys[selectedPolygon][selectedContour].PointCount() )
     {
-        POLYGON currentPolygon;
-
         aGlobalIdx = 0;
 
         for( unsigned int polygonIdx = 0; polygonIdx < selectedPolygon; polygonIdx++ )
         {
-            currentPolygon = Polygon( polygonIdx );
+            const POLYGON& currentPolygon = CPolygon( polygonIdx );
 
             for( unsigned int contourIdx = 0; contourIdx < currentPolygon.size(); contourIdx++ )
             {
@@ -145,7 +303,7 @@ bool SHAPE_POLY_SET::GetGlobalIndex( SHAPE_POLY_SET::VERTEX_INDEX aRelativeIndic
             }
         }
 
-        currentPolygon = Polygon( selectedPolygon );
+        const POLYGON& currentPolygon = CPolygon( selectedPolygon );
 
         for( unsigned int contourIdx = 0; contourIdx < selectedContour; contourIdx++ )
         {
@@ -165,6 +323,8 @@ bool SHAPE_POLY_SET::GetGlobalIndex( SHAPE_POLY_SET::VERTEX_INDEX aRelativeIndic
 
 int SHAPE_POLY_SET::NewOutline()
 {
+    markModified();
+
     SHAPE_LINE_CHAIN empty_path;
     POLYGON poly;
 
@@ -177,6 +337,8 @@ int SHAPE_POLY_SET::NewOutline()
 
 int SHAPE_POLY_SET::NewHole( int aOutline )
 {
+    markModified();
+
     SHAPE_LINE_CHAIN empty_path;
 
     empty_path.SetClosed( true );
@@ -194,6 +356,8 @@ int SHAPE_POLY_SET::NewHole( int aOutline )
 
 int SHAPE_POLY_SET::Append( int x, int y, int aOutline, int aHole, bool aAllowDuplication )
 {
+    markModified();
+
     if( aOutline < 0 )
         aOutline += m_polys.size();
 
@@ -215,6 +379,8 @@ int SHAPE_POLY_SET::Append( int x, int y, int aOutline, int aHole, bool aAllowDu
 
 void SHAPE_POLY_SET::InsertVertex( int aGlobalIndex, VECTOR2I aNewVertex )
 {
+    markModified();
+
     VERTEX_INDEX index;
 
     if( aGlobalIndex < 0 )
@@ -260,7 +426,7 @@ int SHAPE_POLY_SET::VertexCount( int aOutline, int aHole  ) const
 }
 
 
-SHAPE_POLY_SET SHAPE_POLY_SET::Subset( int aFirstPolygon, int aLastPolygon )
+SHAPE_POLY_SET SHAPE_POLY_SET::Subset( int aFirstPolygon, int aLastPolygon ) const
 {
     assert( aFirstPolygon >= 0 && aLastPolygon <= OutlineCount() );
 
@@ -268,7 +434,7 @@ SHAPE_POLY_SET SHAPE_POLY_SET::Subset( int aFirstPolygon, int aLastPolygon )
 
     for( int index = aFirstPolygon; index < aLastPolygon; index++ )
     {
-        newPolySet.m_polys.push_back( Polygon( index ) );
+        newPolySet.m_polys.push_back( CPolygon( index ) );
     }
 
     return newPolySet;
@@ -277,6 +443,8 @@ SHAPE_POLY_SET SHAPE_POLY_SET::Subset( int aFirstPolygon, int aLastPolygon )
 
 VECTOR2I& SHAPE_POLY_SET::Vertex( int aIndex, int aOutline, int aHole )
 {
+    markModified();
+
     if( aOutline < 0 )
         aOutline += m_polys.size();
 
@@ -315,6 +483,8 @@ const VECTOR2I& SHAPE_POLY_SET::CVertex( int aIndex, int aOutline, int aHole ) c
 
 VECTOR2I& SHAPE_POLY_SET::Vertex( int aGlobalIndex )
 {
+    markModified();
+
     SHAPE_POLY_SET::VERTEX_INDEX index;
 
     // Assure the passed index references a legal position; abort otherwise
@@ -339,6 +509,8 @@ const VECTOR2I& SHAPE_POLY_SET::CVertex( int aGlobalIndex ) const
 
 VECTOR2I& SHAPE_POLY_SET::Vertex( SHAPE_POLY_SET::VERTEX_INDEX index )
 {
+    markModified();
+
     return Vertex( index.m_vertex, index.m_polygon, index.m_contour - 1 );
 }
 
@@ -437,6 +609,8 @@ bool SHAPE_POLY_SET::IsSelfIntersecting() const
 
 int SHAPE_POLY_SET::AddOutline( const SHAPE_LINE_CHAIN& aOutline )
 {
+    markModified();
+
     assert( aOutline.IsClosed() );
 
     POLYGON poly;
@@ -451,6 +625,8 @@ int SHAPE_POLY_SET::AddOutline( const SHAPE_LINE_CHAIN& aOutline )
 
 int SHAPE_POLY_SET::AddHole( const SHAPE_LINE_CHAIN& aHole, int aOutline )
 {
+    markModified();
+
     assert( m_polys.size() );
 
     if( aOutline < 0 )
@@ -544,6 +720,74 @@ void SHAPE_POLY_SET::BooleanIntersection( const SHAPE_POLY_SET& a,
 }
 
 
+void SHAPE_POLY_SET::BooleanMany( ClipperLib::ClipType aType,
+                                  const std::vector<const SHAPE_POLY_SET*>& aOperands,
+                                  POLYGON_MODE aFastMode )
+{
+    std::vector<Paths> level( aOperands.size() );
+    int                vertexCount = 0;
+
+    for( const SHAPE_POLY_SET* operand : aOperands )
+        vertexCount += operand->TotalVertices();
+
+    const bool parallel = vertexCount >= MIN_PARALLEL_VERTICES;
+
+    runParallel( aOperands.size(), parallel,
+            [&]( size_t aIdx )
+            {
+                for( const POLYGON& poly : aOperands[aIdx]->m_polys )
+                {
+                    for( size_t i = 0; i < poly.size(); i++ )
+                        level[aIdx].push_back( poly[i].convertToClipper( i == 0 ) );
+                }
+            } );
+
+    // Merge the operands pairwise until one is left, so that each Clipper call only sees the
+    // paths of two operands.  The merged paths are kept as paths between the levels.
+    while( level.size() > 1 )
+    {
+        std::vector<Paths> next( ( level.size() + 1 ) / 2 );
+
+        runParallel( next.size(), parallel && next.size() > 1,
+                [&]( size_t aIdx )
+                {
+                    if( 2 * aIdx + 1 == level.size() )
+                    {
+                        next[aIdx] = std::move( level[2 * aIdx] );
+                        return;
+                    }
+
+                    Clipper c;
+
+                    c.AddPaths( level[2 * aIdx], ptSubject, true );
+                    c.AddPaths( level[2 * aIdx + 1], ptClip, true );
+                    c.Execute( ctUnion, next[aIdx], pftNonZero, pftNonZero );
+                } );
+
+        level = std::move( next );
+    }
+
+    Clipper c;
+
+    c.StrictlySimple( aFastMode == PM_STRICTLY_SIMPLE );
+
+    for( const POLYGON& poly : m_polys )
+    {
+        for( size_t i = 0; i < poly.size(); i++ )
+            c.AddPath( poly[i].convertToClipper( i == 0 ), ptSubject, true );
+    }
+
+    if( !level.empty() )
+        c.AddPaths( level[0], ptClip, true );
+
+    PolyTree solution;
+
+    c.Execute( aType, solution, pftNonZero, pftNonZero );
+
+    importTree( &solution );
+}
+
+
 void SHAPE_POLY_SET::InflateWithLinkedHoles( int aFactor, int aCircleSegmentsCount,
                                              POLYGON_MODE aFastMode )
 {
@@ -553,6 +797,83 @@ void SHAPE_POLY_SET::InflateWithLinkedHoles( int aFactor, int aCircleSegmentsCou
 }
 
 
+/**
+ * Splits the polygons of aSet into at most aMaxBatches batches of about the same number of
+ * vertices, so that the bounding boxes of the polygons of different batches, inflated by
+ * aMargin, do not overlap.  Each batch lists its polygons in increasing order.
+ */
+static void partitionDisjointPolygons( const SHAPE_POLY_SET& aSet, int aMargin,
+                                       size_t aMaxBatches,
+                                       std::vector<std::vector<int>>& aBatches )
+{
+    const int          count = aSet.OutlineCount();
+    std::vector<BOX2I> bboxes( count );
+    std::vector<int>   order( count );
+    std::vector<int>   parent( count );
+
+    for( int ii = 0; ii < count; ii++ )
+    {
+        bboxes[ii] = aSet.COutline( ii ).BBox( aMargin );
+        order[ii] = ii;
+        parent[ii] = ii;
+    }
+
+    auto find = [&]( int aIdx )
+    {
+        while( parent[aIdx] != aIdx )
+            aIdx = parent[aIdx] = parent[parent[aIdx]];
+
+        return aIdx;
+    };
+
+    // Groups the polygons with overlapping boxes, sweeping the boxes from left to right
+    std::sort( order.begin(), order.end(),
+               [&]( int a, int b ) { return bboxes[a].GetLeft() < bboxes[b].GetLeft(); } );
+
+    for( int ii = 0; ii < count; ii++ )
+    {
+        const BOX2I& box = bboxes[order[ii]];
+
+        for( int jj = ii + 1; jj < count && bboxes[order[jj]].GetLeft() <= box.GetRight(); jj++ )
+        {
+            if( box.Intersects( bboxes[order[jj]] ) )
+                parent[find( order[jj] )] = find( order[ii] );
+        }
+    }
+
+    // Fills the batches with whole groups, in order of their first polygon
+    std::map<int, std::vector<int>> groups;
+
+    for( int ii = 0; ii < count; ii++ )
+        groups[find( ii )].push_back( ii );
+
+    const int target = aSet.TotalVertices() / std::max<size_t>( aMaxBatches, 1 ) + 1;
+    int       vertices = 0;
+
+    aBatches.clear();
+
+    for( const auto& group : groups )
+    {
+        if( aBatches.empty() || vertices >= target )
+        {
+            aBatches.emplace_back();
+            vertices = 0;
+        }
+
+        for( int idx : group.second )
+        {
+            aBatches.back().push_back( idx );
+
+            for( const SHAPE_LINE_CHAIN& path : aSet.CPolygon( idx ) )
+                vertices += path.PointCount();
+        }
+    }
+
+    for( std::vector<int>& batch : aBatches )
+        std::sort( batch.begin(), batch.end() );
+}
+
+
 void SHAPE_POLY_SET::Inflate( int aAmount, int aCircleSegmentsCount,
                               CORNER_STRATEGY aCornerStrategy )
 {
@@ -562,8 +883,6 @@ void SHAPE_POLY_SET::Inflate( int aAmount, int aCircleSegmentsCount,
     #define SEG_CNT_MAX 64
     static double arc_tolerance_factor[SEG_CNT_MAX + 1];
 
-    ClipperOffset c;
-
     // N.B. see the Clipper documentation for jtSquare/jtMiter/jtRound.  They are poorly named
     // and are not what you'd think they are.
     // http://www.angusj.com/delphi/clipper/documentation/Docs/Units/ClipperLib/Types/JoinType.htm
@@ -571,14 +890,6 @@ void SHAPE_POLY_SET::Inflate( int aAmount, int aCircleSegmentsCount,
     double   miterLimit = aCornerStrategy == ALLOW_ACUTE_CORNERS ? 10 : 1.5;
     JoinType miterFallback = aCornerStrategy == ROUND_ACUTE_CORNERS ? jtRound : jtSquare;
 
-    for( const POLYGON& poly : m_polys )
-    {
-        for( size_t i = 0; i < poly.size(); i++ )
-            c.AddPath( poly[i].convertToClipper( i == 0 ), joinType, etClosedPolygon );
-    }
-
-    PolyTree solution;
-
     // Calculate the arc tolerance (arc error) from the seg count by circle. The seg count is
     // nn = M_PI / acos(1.0 - c.ArcTolerance / abs(aAmount))
     // http://www.angusj.com/delphi/clipper/documentation/Docs/Units/ClipperLib/Classes/ClipperOffset/Properties/ArcTolerance.htm
@@ -598,17 +909,75 @@ void SHAPE_POLY_SET::Inflate( int aAmount, int aCircleSegmentsCount,
     else
         coeff = arc_tolerance_factor[aCircleSegmentsCount];
 
-    c.ArcTolerance = std::abs( aAmount ) * coeff;
-    c.MiterLimit = miterLimit;
-    c.MiterFallback = miterFallback;
-    c.Execute( solution, aAmount );
+    auto offset = [&]( const std::vector<int>& aPolygons, SHAPE_POLY_SET& aResult )
+    {
+        ClipperOffset c;
 
-    importTree( &solution );
+        for( int idx : aPolygons )
+        {
+            const POLYGON& poly = m_polys[idx];
+
+            for( size_t i = 0; i < poly.size(); i++ )
+                c.AddPath( poly[i].convertToClipper( i == 0 ), joinType, etClosedPolygon );
+        }
+
+        PolyTree solution;
+
+        c.ArcTolerance = std::abs( aAmount ) * coeff;
+        c.MiterLimit = miterLimit;
+        c.MiterFallback = miterFallback;
+        c.Execute( solution, aAmount );
+
+        aResult.importTree( &solution );
+    };
+
+    // The offset of a polygon stays within its bounding box inflated by the amount (times the
+    // miter limit for mitered corners), so the polygons of batches separated by more than that
+    // can be offset independently.
+    std::vector<std::vector<int>> batches;
+
+    if( OutlineCount() > 1 && TotalVertices() >= MIN_PARALLEL_VERTICES )
+    {
+        double reach = std::max( aAmount, 0 ) * ( joinType == jtMiter ? miterLimit : 1.0 );
+
+        partitionDisjointPolygons( *this, (int) std::ceil( reach ) + 1,
+                                   4 * std::thread::hardware_concurrency(), batches );
+    }
+
+    if( batches.size() <= 1 )
+    {
+        std::vector<int> all( OutlineCount() );
+
+        for( int ii = 0; ii < OutlineCount(); ii++ )
+            all[ii] = ii;
+
+        offset( all, *this );
+        return;
+    }
+
+    std::vector<SHAPE_POLY_SET> results( batches.size() );
+
+    runParallel( batches.size(), true,
+            [&]( size_t aIdx )
+            {
+                offset( batches[aIdx], results[aIdx] );
+            } );
+
+    markModified();
+    m_polys.clear();
+
+    for( SHAPE_POLY_SET& result : results )
+    {
+        for( POLYGON& poly : result.m_polys )
+            m_polys.push_back( std::move( poly ) );
+    }
 }
 
 
 void SHAPE_POLY_SET::importTree( PolyTree* tree )
 {
+    markModified();
+
     m_polys.clear();
 
     for( PolyNode* n = tree->GetFirst(); n; n = n->GetNext() )
@@ -838,12 +1207,16 @@ void SHAPE_POLY_SET::fractureSingle( POLYGON& paths )
 
 void SHAPE_POLY_SET::Fracture( POLYGON_MODE aFastMode )
 {
+    markModified();
+
     Simplify( aFastMode );    // remove overlapping holes/degeneracy
 
-    for( POLYGON& paths : m_polys )
-    {
-        fractureSingle( paths );
-    }
+    // The polygons are fractured independently
+    runParallel( m_polys.size(), TotalVertices() >= MIN_PARALLEL_VERTICES,
+            [&]( size_t aIdx )
+            {
+                fractureSingle( m_polys[aIdx] );
+            } );
 }
 
 
@@ -1025,6 +1398,8 @@ bool SHAPE_POLY_SET::HasHoles() const
 
 void SHAPE_POLY_SET::Unfracture( POLYGON_MODE aFastMode )
 {
+    markModified();
+
     for( POLYGON& path : m_polys )
     {
         unfractureSingle( path );
@@ -1044,6 +1419,8 @@ void SHAPE_POLY_SET::Simplify( POLYGON_MODE aFastMode )
 
 int SHAPE_POLY_SET::NormalizeAreaOutlines()
 {
+    markModified();
+
     // We are expecting only one main outline, but this main outline can have holes
     // if holes: combine holes and remove them from the main outline.
     // Note also we are using SHAPE_POLY_SET::PM_STRICTLY_SIMPLE in polygon
@@ -1102,6 +1479,8 @@ const std::string SHAPE_POLY_SET::Format() const
 
 bool SHAPE_POLY_SET::Parse( std::stringstream& aStream )
 {
+    markModified();
+
     std::string tmp;
 
     aStream >> tmp;
@@ -1195,28 +1574,25 @@ bool SHAPE_POLY_SET::PointOnEdge( const VECTOR2I& aP ) const
 
 bool SHAPE_POLY_SET::Collide( const SEG& aSeg, int aClearance ) const
 {
-
-    SHAPE_POLY_SET polySet = SHAPE_POLY_SET( *this );
-
-    // Inflate the polygon if necessary.
-    if( aClearance > 0 )
-    {
-        // fixme: the number of arc segments should not be hardcoded
-        polySet.Inflate( aClearance, 8 );
-    }
-
     // We are going to check to see if the segment crosses an external
     // boundary.  However, if the full segment is inside the polyset, this
     // will not be true.  So we first test to see if one of the points is
     // inside.  If true, then we collide
-    if( polySet.Contains( aSeg.A ) )
+    if( Contains( aSeg.A ) )
         return true;
 
-    for( SEGMENT_ITERATOR it = ( (SHAPE_POLY_SET*) this )->IterateSegmentsWithHoles(); it; it++ )
-    {
-        SEG polygonEdge = *it;
+    // With a clearance, the segment collides if it passes closer than aClearance to an
+    // edge; without, only if it crosses one
+    int clearance = std::max( aClearance, 0 );
 
-        if( polygonEdge.Intersect( aSeg, true ) )
+    if( auto index = edgeIndex() )
+        return index->CollideEdges( aSeg, clearance );
+
+    SEG::ecoord clearanceSq = (SEG::ecoord) clearance * clearance;
+
+    for( CONST_SEGMENT_ITERATOR it = CIterateSegments( 0, OutlineCount() - 1, true ); it; it++ )
+    {
+        if( ( *it ).SquaredDistance( aSeg ) <= clearanceSq )
             return true;
     }
 
@@ -1226,28 +1602,41 @@ bool SHAPE_POLY_SET::Collide( const SEG& aSeg, int aClearance ) const
 
 bool SHAPE_POLY_SET::Collide( const VECTOR2I& aP, int aClearance ) const
 {
-    SHAPE_POLY_SET polySet = SHAPE_POLY_SET( *this );
+    // There is a collision if the point is inside of the polygon...
+    if( Contains( aP ) )
+        return true;
+
+    if( aClearance <= 0 || m_polys.empty() )
+        return false;
 
-    // Inflate the polygon if necessary.
-    if( aClearance > 0 )
+    // ... or closer than aClearance to one of its edges
+    if( auto index = edgeIndex() )
+        return index->CollideEdges( SEG( aP, aP ), aClearance );
+
+    SEG::ecoord clearanceSq = (SEG::ecoord) aClearance * aClearance;
+
+    for( CONST_SEGMENT_ITERATOR it = CIterateSegments( 0, OutlineCount() - 1, true ); it; it++ )
     {
-        // fixme: the number of arc segments should not be hardcoded
-        polySet.Inflate( aClearance, 8 );
+        if( ( *it ).SquaredDistance( aP ) <= clearanceSq )
+            return true;
     }
 
-    // There is a collision if and only if the point is inside of the polygon.
-    return polySet.Contains( aP );
+    return false;
 }
 
 
 void SHAPE_POLY_SET::RemoveAllContours()
 {
+    markModified();
+
     m_polys.clear();
 }
 
 
 void SHAPE_POLY_SET::RemoveContour( int aContourIdx, int aPolygonIdx )
 {
+    markModified();
+
     // Default polygon is the last one
     if( aPolygonIdx < 0 )
         aPolygonIdx += m_polys.size();
@@ -1260,7 +1649,9 @@ int SHAPE_POLY_SET::RemoveNullSegments()
 {
     int removed = 0;
 
-    ITERATOR iterator = IterateWithHoles();
+    // Only scan through the const iterator: RemoveVertex() marks the set as modified, if
+    // there is anything to remove
+    CONST_ITERATOR iterator = CIterateWithHoles();
 
     VECTOR2I    contourStart = *iterator;
     VECTOR2I    segmentStart, segmentEnd;
@@ -1311,12 +1702,16 @@ int SHAPE_POLY_SET::RemoveNullSegments()
 
 void SHAPE_POLY_SET::DeletePolygon( int aIdx )
 {
+    markModified();
+
     m_polys.erase( m_polys.begin() + aIdx );
 }
 
 
 void SHAPE_POLY_SET::Append( const SHAPE_POLY_SET& aSet )
 {
+    markModified();
+
     m_polys.insert( m_polys.end(), aSet.m_polys.begin(), aSet.m_polys.end() );
 }
 
@@ -1340,7 +1735,7 @@ bool SHAPE_POLY_SET::CollideVertex( const VECTOR2I& aPoint,
     // Convert clearance to double for precission when comparing distances
     clearance = aClearance;
 
-    for( ITERATOR iterator = IterateWithHoles(); iterator; iterator++ )
+    for( CONST_ITERATOR iterator = CIterateWithHoles(); iterator; iterator++ )
     {
         // Get the difference vector between current vertex and aPoint
         delta = *iterator - aPoint;
@@ -1371,9 +1766,9 @@ bool SHAPE_POLY_SET::CollideEdge( const VECTOR2I& aPoint,
     // Shows whether there was a collision
     bool collision = false;
 
-    SEGMENT_ITERATOR iterator;
+    CONST_SEGMENT_ITERATOR iterator;
 
-    for( iterator = IterateSegmentsWithHoles(); iterator; iterator++ )
+    for( iterator = CIterateSegments( 0, OutlineCount() - 1, true ); iterator; iterator++ )
     {
         SEG currentSegment = *iterator;
         int distance = currentSegment.Distance( aPoint );
@@ -1397,12 +1792,11 @@ bool SHAPE_POLY_SET::CollideEdge( const VECTOR2I& aPoint,
 
 void SHAPE_POLY_SET::BuildBBoxCaches()
 {
-    for( int polygonIdx = 0; polygonIdx < OutlineCount(); polygonIdx++ )
+    // Only caches the bounding boxes, so the polygons (and the edge index) do not change
+    for( POLYGON& poly : m_polys )
     {
-        Outline( polygonIdx ).GenerateBBoxCache();
-
-        for( int holeIdx = 0; holeIdx < HoleCount( polygonIdx ); holeIdx++ )
-            Hole( polygonIdx, holeIdx ).GenerateBBoxCache();
+        for( SHAPE_LINE_CHAIN& path : poly )
+            path.GenerateBBoxCache();
     }
 }
 
@@ -1413,6 +1807,9 @@ bool SHAPE_POLY_SET::Contains( const VECTOR2I& aP, int aSubpolyIndex, int aAccur
     if( m_polys.empty() )
         return false;
 
+    if( auto index = edgeIndex() )
+        return index->Contains( aP, aSubpolyIndex, aAccuracy );
+
     // If there is a polygon specified, check the condition against that polygon
     if( aSubpolyIndex >= 0 )
         return containsSingle( aP, aSubpolyIndex, aAccuracy, aUseBBoxCaches );
@@ -1442,6 +1839,8 @@ void SHAPE_POLY_SET::RemoveVertex( int aGlobalIndex )
 
 void SHAPE_POLY_SET::RemoveVertex( VERTEX_INDEX aIndex )
 {
+    markModified();
+
     m_polys[aIndex.m_polygon][aIndex.m_contour].Remove( aIndex.m_vertex );
 }
 
@@ -1449,6 +1848,9 @@ void SHAPE_POLY_SET::RemoveVertex( VERTEX_INDEX aIndex )
 bool SHAPE_POLY_SET::containsSingle( const VECTOR2I& aP, int aSubpolyIndex, int aAccuracy,
                                      bool aUseBBoxCaches ) const
 {
+    if( auto index = edgeIndex() )
+        return index->Contains( aP, aSubpolyIndex, aAccuracy );
+
     // Check that the point is inside the outline
     if( m_polys[aSubpolyIndex][0].PointInside( aP, aAccuracy ) )
     {
@@ -1472,6 +1874,8 @@ bool SHAPE_POLY_SET::containsSingle( const VECTOR2I& aP, int aSubpolyIndex, int
 
 void SHAPE_POLY_SET::Move( const VECTOR2I& aVector )
 {
+    markModified();
+
     for( POLYGON& poly : m_polys )
     {
         for( SHAPE_LINE_CHAIN& path : poly )
@@ -1482,6 +1886,8 @@ void SHAPE_POLY_SET::Move( const VECTOR2I& aVector )
 
 void SHAPE_POLY_SET::Rotate( double aAngle, const VECTOR2I& aCenter )
 {
+    markModified();
+
     for( POLYGON& poly : m_polys )
     {
         for( SHAPE_LINE_CHAIN& path : poly )
@@ -1505,7 +1911,7 @@ int SHAPE_POLY_SET::TotalVertices() const
 
 
 SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::ChamferPolygon( unsigned int aDistance, int aIndex,
-                                                        std::set<VECTOR2I>* aPreserveCorners )
+                                                        std::set<VECTOR2I>* aPreserveCorners ) const
 {
     return chamferFilletPolygon( CHAMFERED, aDistance, aIndex, 0, aPreserveCorners );
 }
@@ -1513,13 +1919,13 @@ SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::ChamferPolygon( unsigned int aDistance,
 
 SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::FilletPolygon( unsigned int aRadius, int aErrorMax,
                                                        int aIndex,
-                                                       std::set<VECTOR2I>* aPreserveCorners )
+                                                       std::set<VECTOR2I>* aPreserveCorners ) const
 {
     return chamferFilletPolygon( FILLETED, aRadius, aIndex, aErrorMax, aPreserveCorners );
 }
 
 
-int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex )
+int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex ) const
 {
     // We calculate the min dist between the segment and each outline segment.  However, if the
     // segment to test is inside the outline, and does not cross any edge, it can be seen outside
@@ -1528,7 +1934,10 @@ int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex )
     if( containsSingle( aPoint, aPolygonIndex, 1 ) )
         return 0;
 
-    SEGMENT_ITERATOR iterator = IterateSegmentsWithHoles( aPolygonIndex );
+    if( auto index = edgeIndex() )
+        return index->Distance( SEG( aPoint, aPoint ), aPolygonIndex );
+
+    CONST_SEGMENT_ITERATOR iterator = CIterateSegmentsWithHoles( aPolygonIndex );
 
     SEG polygonEdge = *iterator;
     int minDistance = polygonEdge.Distance( aPoint );
@@ -1547,7 +1956,8 @@ int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex )
 }
 
 
-int SHAPE_POLY_SET::DistanceToPolygon( const SEG& aSegment, int aPolygonIndex, int aSegmentWidth )
+int SHAPE_POLY_SET::DistanceToPolygon( const SEG& aSegment, int aPolygonIndex,
+                                       int aSegmentWidth ) const
 {
     // We calculate the min dist between the segment and each outline segment.  However, if the
     // segment to test is inside the outline, and does not cross any edge, it can be seen outside
@@ -1556,19 +1966,28 @@ int SHAPE_POLY_SET::DistanceToPolygon( const SEG& aSegment, int aPolygonIndex, i
     if( containsSingle( aSegment.A, aPolygonIndex, 1 ) )
         return 0;
 
-    SEGMENT_ITERATOR iterator = IterateSegmentsWithHoles( aPolygonIndex );
+    int minDistance;
 
-    SEG polygonEdge = *iterator;
-    int minDistance = polygonEdge.Distance( aSegment );
-
-    for( iterator++; iterator && minDistance > 0; iterator++ )
+    if( auto index = edgeIndex() )
     {
-        polygonEdge = *iterator;
+        minDistance = index->Distance( aSegment, aPolygonIndex );
+    }
+    else
+    {
+        CONST_SEGMENT_ITERATOR iterator = CIterateSegmentsWithHoles( aPolygonIndex );
 
-        int currentDistance = polygonEdge.Distance( aSegment );
+        SEG polygonEdge = *iterator;
+        minDistance = polygonEdge.Distance( aSegment );
 
-        if( currentDistance < minDistance )
-            minDistance = currentDistance;
+        for( iterator++; iterator && minDistance > 0; iterator++ )
+        {
+            polygonEdge = *iterator;
+
+            int currentDistance = polygonEdge.Distance( aSegment );
+
+            if( currentDistance < minDistance )
+                minDistance = currentDistance;
+        }
     }
 
     // Take into account the width of the segment
@@ -1580,8 +1999,17 @@ int SHAPE_POLY_SET::DistanceToPolygon( const SEG& aSegment, int aPolygonIndex, i
 }
 
 
-int SHAPE_POLY_SET::Distance( VECTOR2I aPoint )
+int SHAPE_POLY_SET::Distance( VECTOR2I aPoint ) const
 {
+    // The index finds the nearest edge of all the polygons at once
+    if( auto index = edgeIndex() )
+    {
+        if( index->Contains( aPoint, -1, 1 ) )
+            return 0;
+
+        return index->Distance( SEG( aPoint, aPoint ), -1 );
+    }
+
     int currentDistance;
     int minDistance = DistanceToPolygon( aPoint, 0 );
 
@@ -1598,8 +2026,21 @@ int SHAPE_POLY_SET::Distance( VECTOR2I aPoint )
 }
 
 
-int SHAPE_POLY_SET::Distance( const SEG& aSegment, int aSegmentWidth )
+int SHAPE_POLY_SET::Distance( const SEG& aSegment, int aSegmentWidth ) const
 {
+    if( auto index = edgeIndex() )
+    {
+        if( index->Contains( aSegment.A, -1, 1 ) )
+            return 0;
+
+        int minDistance = index->Distance( aSegment, -1 );
+
+        if( aSegmentWidth > 0 )
+            minDistance -= aSegmentWidth / 2;
+
+        return minDistance < 0 ? 0 : minDistance;
+    }
+
     int currentDistance;
     int minDistance = DistanceToPolygon( aSegment, 0, aSegmentWidth );
 
@@ -1616,7 +2057,7 @@ int SHAPE_POLY_SET::Distance( const SEG& aSegment, int aSegmentWidth )
 }
 
 
-bool SHAPE_POLY_SET::IsVertexInHole( int aGlobalIdx )
+bool SHAPE_POLY_SET::IsVertexInHole( int aGlobalIdx ) const
 {
     VERTEX_INDEX index;
 
@@ -1629,7 +2070,8 @@ bool SHAPE_POLY_SET::IsVertexInHole( int aGlobalIdx )
 }
 
 
-SHAPE_POLY_SET SHAPE_POLY_SET::Chamfer( int aDistance, std::set<VECTOR2I>* aPreserveCorners )
+SHAPE_POLY_SET SHAPE_POLY_SET::Chamfer( int aDistance,
+                                        std::set<VECTOR2I>* aPreserveCorners ) const
 {
     SHAPE_POLY_SET chamfered;
 
@@ -1641,7 +2083,7 @@ SHAPE_POLY_SET SHAPE_POLY_SET::Chamfer( int aDistance, std::set<VECTOR2I>* aPres
 
 
 SHAPE_POLY_SET SHAPE_POLY_SET::Fillet( int aRadius, int aErrorMax,
-                                       std::set<VECTOR2I>* aPreserveCorners )
+                                       std::set<VECTOR2I>* aPreserveCorners ) const
 {
     SHAPE_POLY_SET filleted;
 
@@ -1654,12 +2096,16 @@ SHAPE_POLY_SET SHAPE_POLY_SET::Fillet( int aRadius, int aErrorMax,
 
 SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::chamferFilletPolygon( CORNER_MODE aMode,
                                         unsigned int aDistance, int aIndex, int aErrorMax,
-                                        std::set<VECTOR2I>* aPreserveCorners )
+                                        std::set<VECTOR2I>* aPreserveCorners ) const
 {
-    // Null segments create serious issues in calculations. Remove them:
-    RemoveNullSegments();
+    // Null segments create serious issues in calculations. Remove them from a copy: the set
+    // itself is only read, possibly by several threads.
+    SHAPE_POLY_SET cleaned;
 
-    SHAPE_POLY_SET::POLYGON currentPoly = Polygon( aIndex );
+    cleaned.m_polys.push_back( CPolygon( aIndex ) );
+    cleaned.RemoveNullSegments();
+
+    SHAPE_POLY_SET::POLYGON currentPoly = std::move( cleaned.m_polys[0] );
     SHAPE_POLY_SET::POLYGON newPoly;
 
     // If the chamfering distance is zero, then the polygon remain intact.
@@ -1825,6 +2271,9 @@ SHAPE_POLY_SET &SHAPE_POLY_SET::operator=( const SHAPE_POLY_SET& aOther )
     static_cast<SHAPE&>(*this) = aOther;
     m_polys = aOther.m_polys;
 
+    // The edge index only depends on the polygons, so it can be shared
+    m_edgeIndex = std::atomic_load( &aOther.m_edgeIndex );
+
     // reset poly cache:
     m_hash = MD5_HASH{};
     m_triangulationValid = false;
@@ -1834,8 +2283,11 @@ SHAPE_POLY_SET &SHAPE_POLY_SET::operator=( const SHAPE_POLY_SET& aOther )
 
 MD5_HASH SHAPE_POLY_SET::GetHash() const
 {
-    if( !m_hash.IsValid() )
-        return checksum();
+    if( !m_hash.IsValid() || m_hashGeneration != m_generation )
+    {
+        m_hash = checksum();
+        m_hashGeneration = m_generation;
+    }
 
     return m_hash;
 }
@@ -1843,38 +2295,19 @@ MD5_HASH SHAPE_POLY_SET::GetHash() const
 
 bool SHAPE_POLY_SET::IsTriangulationUpToDate() const
 {
-    if( !m_triangulationValid )
-        return false;
-
-    if( !m_hash.IsValid() )
+    if( !m_triangulationValid || m_triangulationGeneration != m_generation )
         return false;
 
-    auto hash = checksum();
+    // Every edit must bump the generation: check it did in debug builds
+    assert( checksum() == m_hash );
 
-    return hash == m_hash;
+    return true;
 }
 
 
 void SHAPE_POLY_SET::CacheTriangulation()
 {
-    bool recalculate = !m_hash.IsValid();
-    MD5_HASH hash;
-
-    if( !m_triangulationValid )
-        recalculate = true;
-
-    if( !recalculate )
-    {
-        hash = checksum();
-
-        if( m_hash != hash )
-        {
-            m_hash = hash;
-            recalculate = true;
-        }
-    }
-
-    if( !recalculate )
+    if( IsTriangulationUpToDate() )
         return;
 
     SHAPE_POLY_SET tmpSet = *this;
@@ -1885,27 +2318,54 @@ void SHAPE_POLY_SET::CacheTriangulation()
     m_triangulatedPolys.clear();
     m_triangulationValid = true;
 
-    while( tmpSet.OutlineCount() > 0 )
+    // If the tesselation of an outline fails, the failed outlines are fractured again, which
+    // first simplifies them.  This may result in multiple, disjoint polygons.
+    for( int pass = 0; pass < 2 && tmpSet.OutlineCount() > 0; pass++ )
     {
-        m_triangulatedPolys.push_back( std::make_unique<TRIANGULATED_POLYGON>() );
-        PolygonTriangulation tess( *m_triangulatedPolys.back() );
+        std::vector<std::unique_ptr<TRIANGULATED_POLYGON>> triangulated;
+        SHAPE_POLY_SET failed;
+
+        triangulateOutlines( tmpSet, triangulated );
 
-        // If the tesselation fails, we re-fracture the polygon, which will
-        // first simplify the system before fracturing and removing the holes
-        // This may result in multiple, disjoint polygons.
-        if( !tess.TesselatePolygon( tmpSet.Polygon( 0 ).front() ) )
+        for( int ii = 0; ii < tmpSet.OutlineCount(); ii++ )
         {
-            tmpSet.Fracture( PM_FAST );
-            m_triangulationValid = false;
-            continue;
+            if( triangulated[ii] )
+                m_triangulatedPolys.push_back( std::move( triangulated[ii] ) );
+            else
+                failed.AddOutline( tmpSet.COutline( ii ) );
         }
 
-        tmpSet.DeletePolygon( 0 );
-        m_triangulationValid = true;
+        if( failed.OutlineCount() > 0 )
+            failed.Fracture( PM_FAST );
+
+        tmpSet = failed;
     }
 
-    if( m_triangulationValid )
-        m_hash = checksum();
+    m_triangulationValid = tmpSet.OutlineCount() == 0;
+    m_triangulationGeneration = m_generation;
+
+#ifndef NDEBUG
+    // Only needed by the check of IsTriangulationUpToDate(), GetHash() computes it on demand
+    m_hash = checksum();
+    m_hashGeneration = m_generation;
+#endif
+}
+
+
+void SHAPE_POLY_SET::triangulateOutlines( const SHAPE_POLY_SET& aSet,
+        std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>& aResult )
+{
+    aResult.resize( aSet.OutlineCount() );
+
+    runParallel( aSet.OutlineCount(), aSet.TotalVertices() >= MIN_PARALLEL_VERTICES,
+            [&]( size_t aIdx )
+            {
+                auto result = std::make_unique<TRIANGULATED_POLYGON>();
+                PolygonTriangulation tess( *result );
+
+                if( tess.TesselatePolygon( aSet.COutline( aIdx ) ) )
+                    aResult[aIdx] = std::move( result );
+            } );
 }
 
 
@@ -1972,3 +2432,361 @@ bool SHAPE_POLY_SET::hasTouchingHoles( const POLYGON& aPoly ) const
 
     return false;
 }
+
+
+
+SHAPE_POLY_SET::EDGE_INDEX::EDGE_INDEX( const POLYSET& aPolys ) :
+        m_x0( 0 ),
+        m_y0( 0 ),
+        m_cellSize( 1 ),
+        m_cols( 0 ),
+        m_rows( 0 )
+{
+    for( const POLYGON& poly : aPolys )
+    {
+        m_polygonFirstContour.push_back( m_contourFirstEdge.size() );
+
+        for( const SHAPE_LINE_CHAIN& path : poly )
+        {
+            m_contourFirstEdge.push_back( m_edges.size() );
+            m_contourClosed.push_back( path.IsClosed() && path.PointCount() >= 3 );
+
+            for( int i = 0; i < path.SegmentCount(); i++ )
+            {
+                m_edges.push_back( path.CSegment( i ) );
+                m_edgeContour.push_back( m_contourFirstEdge.size() - 1 );
+            }
+        }
+    }
+
+    m_polygonFirstContour.push_back( m_contourFirstEdge.size() );
+    m_contourFirstEdge.push_back( m_edges.size() );
+
+    if( m_edges.empty() )
+        return;
+
+    m_bbox = BOX2I( m_edges[0].A, VECTOR2I( 0, 0 ) );
+
+    for( const SEG& edge : m_edges )
+    {
+        m_bbox.Merge( edge.A );
+        m_bbox.Merge( edge.B );
+    }
+
+    // About one edge per cell
+    int64_t w = (int64_t) m_bbox.GetWidth() + 1;
+    int64_t h = (int64_t) m_bbox.GetHeight() + 1;
+    double  cellSize = std::sqrt( (double) w * (double) h / m_edges.size() );
+
+    cellSize = std::max( cellSize, (double) w / MAX_GRID_SIZE );
+    cellSize = std::max( cellSize, (double) h / MAX_GRID_SIZE );
+
+    m_x0 = m_bbox.GetX();
+    m_y0 = m_bbox.GetY();
+    m_cellSize = std::max<int64_t>( 1, (int64_t) std::ceil( cellSize ) );
+    m_cols = (int) ( w / m_cellSize + 1 );
+    m_rows = (int) ( h / m_cellSize + 1 );
+
+    m_cellStart.assign( m_cols * m_rows + 1, 0 );
+
+    for( int e = 0; e < (int) m_edges.size(); e++ )
+        forEachEdgeCell( e, [&]( int aCell ) { m_cellStart[aCell + 1]++; } );
+
+    for( size_t i = 1; i < m_cellStart.size(); i++ )
+        m_cellStart[i] += m_cellStart[i - 1];
+
+    std::vector<int> fill( m_cellStart.begin(), m_cellStart.end() - 1 );
+
+    m_cellEdges.resize( m_cellStart.back() );
+
+    for( int e = 0; e < (int) m_edges.size(); e++ )
+        forEachEdgeCell( e, [&]( int aCell ) { m_cellEdges[fill[aCell]++] = e; } );
+}
+
+
+template <class Func>
+void SHAPE_POLY_SET::EDGE_INDEX::forEachEdgeCell( int aEdge, Func aFunc ) const
+{
+    const SEG& edge = m_edges[aEdge];
+
+    int64_t xmin = std::min( edge.A.x, edge.B.x );
+    int64_t xmax = std::max( edge.A.x, edge.B.x );
+    int     cx0 = cellX( xmin );
+    int     cx1 = cellX( xmax );
+
+    for( int cx = cx0; cx <= cx1; cx++ )
+    {
+        int64_t ymin = std::min( edge.A.y, edge.B.y );
+        int64_t ymax = std::max( edge.A.y, edge.B.y );
+
+        // Only keep the part of the edge within the column, with a margin for rounding
+        if( cx0 != cx1 )
+        {
+            double slope = double( edge.B.y - edge.A.y ) / double( edge.B.x - edge.A.x );
+            double xl = std::max<double>( xmin, m_x0 + (double) cx * m_cellSize );
+            double xr = std::min<double>( xmax, m_x0 + (double) ( cx + 1 ) * m_cellSize );
+            double yl = edge.A.y + ( xl - edge.A.x ) * slope;
+            double yr = edge.A.y + ( xr - edge.A.x ) * slope;
+
+            ymin = std::max<int64_t>( ymin, (int64_t) std::floor( std::min( yl, yr ) ) - 1 );
+            ymax = std::min<int64_t>( ymax, (int64_t) std::ceil( std::max( yl, yr ) ) + 1 );
+        }
+
+        for( int cy = cellY( ymin ); cy <= cellY( ymax ); cy++ )
+            aFunc( cy * m_cols + cx );
+    }
+}
+
+
+bool SHAPE_POLY_SET::EDGE_INDEX::crossesRay( int aEdge, const VECTOR2I& aP ) const
+{
+    const VECTOR2I& p1 = m_edges[aEdge].A;
+    const VECTOR2I& p2 = m_edges[aEdge].B;
+    const VECTOR2I  diff = p2 - p1;
+
+    if( diff.y == 0 )
+        return false;
+
+    const int d = rescale( diff.x, ( aP.y - p1.y ), diff.y );
+
+    return ( ( p1.y > aP.y ) != ( p2.y > aP.y ) ) && ( aP.x - p1.x < d );
+}
+
+
+bool SHAPE_POLY_SET::EDGE_INDEX::pointOnEdge( const VECTOR2I& aP, int aContour,
+                                              int aAccuracy ) const
+{
+    const int first = m_contourFirstEdge[aContour];
+    const int last = m_contourFirstEdge[aContour + 1];
+    const int range = aAccuracy + 1;
+    bool      found = false;
+
+    forEachEdgeInCells( cellX( (int64_t) aP.x - range ), cellY( (int64_t) aP.y - range ),
+                        cellX( (int64_t) aP.x + range ), cellY( (int64_t) aP.y + range ),
+            [&]( int aEdge )
+            {
+                if( !found && aEdge >= first && aEdge < last )
+                    found = m_edges[aEdge].Distance( aP ) <= range;
+            } );
+
+    return found;
+}
+
+
+bool SHAPE_POLY_SET::EDGE_INDEX::polygonContains( const VECTOR2I& aP, int aPolygon,
+                                                  int aAccuracy,
+                                                  const std::vector<int>& aCrossed ) const
+{
+    const int outline = m_polygonFirstContour[aPolygon];
+
+    if( outline == m_polygonFirstContour[aPolygon + 1] || !m_contourClosed[outline] )
+        return false;
+
+    bool insideOutline = false;
+    bool insideHole = false;
+
+    // aCrossed is sorted, so the crossed edges of each contour are contiguous
+    auto it = std::lower_bound( aCrossed.begin(), aCrossed.end(), polygonFirstEdge( aPolygon ) );
+    const int end = polygonFirstEdge( aPolygon + 1 );
+
+    while( it != aCrossed.end() && *it < end )
+    {
+        const int contour = m_edgeContour[*it];
+        bool      inside = false;
+
+        for( ; it != aCrossed.end() && m_edgeContour[*it] == contour; ++it )
+            inside = !inside;
+
+        if( !m_contourClosed[contour] )
+            continue;
+
+        if( contour == outline )
+            insideOutline = inside;
+        else if( inside )
+            insideHole = true;
+    }
+
+    // Same handling of the points on the outline as SHAPE_LINE_CHAIN::PointInside()
+    if( aAccuracy == 0 )
+        insideOutline = insideOutline && !pointOnEdge( aP, outline, 0 );
+    else if( aAccuracy > 1 )
+        insideOutline = insideOutline || pointOnEdge( aP, outline, aAccuracy - 1 );
+
+    return insideOutline && !insideHole;
+}
+
+
+bool SHAPE_POLY_SET::EDGE_INDEX::Contains( const VECTOR2I& aP, int aPolygon,
+                                           int aAccuracy ) const
+{
+    const int first = aPolygon < 0 ? 0 : polygonFirstEdge( aPolygon );
+    const int last = aPolygon < 0 ? m_edges.size() : polygonFirstEdge( aPolygon + 1 );
+
+    // The edges crossed by the ray cast from aP in the positive x direction
+    std::vector<int> crossed;
+
+    if( first < last && aP.y >= m_bbox.GetY() && aP.y <= m_bbox.GetBottom()
+            && aP.x <= m_bbox.GetRight() )
+    {
+        forEachEdgeInCells( cellX( aP.x ), cellY( aP.y ), m_cols - 1, cellY( aP.y ),
+                [&]( int aEdge )
+                {
+                    if( aEdge >= first && aEdge < last && crossesRay( aEdge, aP ) )
+                        crossed.push_back( aEdge );
+                } );
+
+        // Long edges are listed in several cells
+        std::sort( crossed.begin(), crossed.end() );
+        crossed.erase( std::unique( crossed.begin(), crossed.end() ), crossed.end() );
+    }
+
+    if( aPolygon >= 0 )
+        return polygonContains( aP, aPolygon, aAccuracy, crossed );
+
+    // Only the polygons with a crossed outline can contain the point, and those with the
+    // point on their outline if the accuracy accepts it
+    std::vector<int> candidates;
+
+    for( int edge : crossed )
+    {
+        const int contour = m_edgeContour[edge];
+        const int polygon = std::upper_bound( m_polygonFirstContour.begin(),
+                                              m_polygonFirstContour.end(), contour )
+                            - m_polygonFirstContour.begin() - 1;
+
+        if( contour == m_polygonFirstContour[polygon]
+                && ( candidates.empty() || candidates.back() != polygon ) )
+            candidates.push_back( polygon );
+    }
+
+    if( aAccuracy > 1 )
+    {
+        const int range = aAccuracy;
+
+        forEachEdgeInCells( cellX( (int64_t) aP.x - range ), cellY( (int64_t) aP.y - range ),
+                            cellX( (int64_t) aP.x + range ), cellY( (int64_t) aP.y + range ),
+                [&]( int aEdge )
+                {
+                    const int contour = m_edgeContour[aEdge];
+                    const int polygon = std::upper_bound( m_polygonFirstContour.begin(),
+                                                          m_polygonFirstContour.end(), contour )
+                                        - m_polygonFirstContour.begin() - 1;
+
+                    if( contour == m_polygonFirstContour[polygon] )
+                        candidates.push_back( polygon );
+                } );
+
+        std::sort( candidates.begin(), candidates.end() );
+        candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+    }
+
+    for( int polygon : candidates )
+    {
+        if( polygonContains( aP, polygon, aAccuracy, crossed ) )
+            return true;
+    }
+
+    return false;
+}
+
+
+bool SHAPE_POLY_SET::EDGE_INDEX::CollideEdges( const SEG& aSeg, int aClearance ) const
+{
+    if( m_edges.empty() )
+        return false;
+
+    const SEG::ecoord clearanceSq = (SEG::ecoord) aClearance * aClearance;
+    bool              collide = false;
+
+    forEachEdgeInCells( cellX( (int64_t) std::min( aSeg.A.x, aSeg.B.x ) - aClearance ),
+                        cellY( (int64_t) std::min( aSeg.A.y, aSeg.B.y ) - aClearance ),
+                        cellX( (int64_t) std::max( aSeg.A.x, aSeg.B.x ) + aClearance ),
+                        cellY( (int64_t) std::max( aSeg.A.y, aSeg.B.y ) + aClearance ),
+            [&]( int aEdge )
+            {
+                if( !collide )
+                    collide = m_edges[aEdge].SquaredDistance( aSeg ) <= clearanceSq;
+            } );
+
+    return collide;
+}
+
+
+int SHAPE_POLY_SET::EDGE_INDEX::Distance( const SEG& aSeg, int aPolygon ) const
+{
+    const int first = aPolygon < 0 ? 0 : polygonFirstEdge( aPolygon );
+    const int last = aPolygon < 0 ? m_edges.size() : polygonFirstEdge( aPolygon + 1 );
+
+    SEG::ecoord best = VECTOR2I::ECOORD_MAX;
+
+    if( first >= last )
+        return std::numeric_limits<int>::max();
+
+    auto visit = [&]( int aEdge )
+    {
+        if( aEdge >= first && aEdge < last )
+            best = std::min( best, m_edges[aEdge].SquaredDistance( aSeg ) );
+    };
+
+    const int cx0 = cellX( std::min( aSeg.A.x, aSeg.B.x ) );
+    const int cx1 = cellX( std::max( aSeg.A.x, aSeg.B.x ) );
+    const int cy0 = cellY( std::min( aSeg.A.y, aSeg.B.y ) );
+    const int cy1 = cellY( std::max( aSeg.A.y, aSeg.B.y ) );
+
+    forEachEdgeInCells( cx0, cy0, cx1, cy1, visit );
+
+    // Visit rings of cells around the segment's cells, until the next ring is further than the
+    // nearest edge found: the cells of ring r + 1 are more than r cells away from the segment.
+    for( int r = 1; ; r++ )
+    {
+        const double ringDist = double( r - 1 ) * m_cellSize;
+
+        if( ringDist * ringDist >= (double) best )
+            break;
+
+        const int x0 = cx0 - r, x1 = cx1 + r;
+        const int y0 = cy0 - r, y1 = cy1 + r;
+
+        if( x0 < 0 && y0 < 0 && x1 >= m_cols && y1 >= m_rows )
+            break;
+
+        const int xl = std::max( x0, 0 ), xh = std::min( x1, m_cols - 1 );
+
+        if( y0 >= 0 )
+            forEachEdgeInCells( xl, y0, xh, y0, visit );
+
+        if( y1 < m_rows )
+            forEachEdgeInCells( xl, y1, xh, y1, visit );
+
+        const int yl = std::max( y0 + 1, 0 ), yh = std::min( y1 - 1, m_rows - 1 );
+
+        if( yl <= yh )
+        {
+            if( x0 >= 0 )
+                forEachEdgeInCells( x0, yl, x0, yh, visit );
+
+            if( x1 < m_cols )
+                forEachEdgeInCells( x1, yl, x1, yh, visit );
+        }
+    }
+
+    return (int) std::sqrt( (double) best );
+}
+
+
+std::shared_ptr<const SHAPE_POLY_SET::EDGE_INDEX> SHAPE_POLY_SET::edgeIndex() const
+{
+    // Below this, scanning the edges is about as fast as looking them up
+    const int minVertices = 64;
+
+    auto index = std::atomic_load( &m_edgeIndex );
+
+    if( !index && TotalVertices() >= minVertices )
+    {
+        // Concurrent queries may build it twice, but they build the same index
+        index = std::make_shared<const EDGE_INDEX>( m_polys );
+        std::atomic_store( &m_edgeIndex, index );
+    }
+
+    return index;
+}
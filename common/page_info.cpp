@@ -271,9 +271,9 @@ void PAGE_INFO::Format( OUTPUTFORMATTER* aFormatter, int aNestLevel, int aContro
     // The page dimensions are only required for user defined page sizes.
     // Internally, the page size is in mils
     if( GetType() == PAGE_INFO::Custom )
-        aFormatter->Print( 0, " %g %g",
-                           GetWidthMils() * 25.4 / 1000.0,
-                           GetHeightMils() * 25.4 / 1000.0 );
+        aFormatter->Print( 0, " %s %s",
+                           OUTPUTFORMATTER::FormatDouble( GetWidthMils() * 25.4 / 1000.0 ).c_str(),
+                           OUTPUTFORMATTER::FormatDouble( GetHeightMils() * 25.4 / 1000.0 ).c_str() );
 
     if( !IsCustom() && IsPortrait() )
         aFormatter->Print( 0, " portrait" );
@@ -116,7 +116,6 @@ PAGE_LAYOUT_READER_PARSER::PAGE_LAYOUT_READER_PARSER( const char* aLine, const w
 void PAGE_LAYOUT_READER_PARSER::Parse( WS_DATA_MODEL* aLayout )
 {
     WS_DATA_ITEM* item;
-    LOCALE_IO     toggle;
 
     for( T token = NextTok(); token != T_RIGHT && token != EOF; token = NextTok() )
     {
@@ -678,7 +677,9 @@ double PAGE_LAYOUT_READER_PARSER::parseDouble()
     if( token != T_NUMBER )
         Expecting( T_NUMBER );
 
-    double val = strtod( CurText(), NULL );
+    double val = 0.0;
+
+    ParseDouble( CurText(), CurText() + CurStr().size(), val );
 
     return val;
 }
@@ -23,11 +23,22 @@
  */
 
 
+#include <cctype>
 #include <cstdarg>
 #include <config.h> // HAVE_FGETC_NOLOCK
 
 #include <richio.h>
 
+#if defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN 1
+#include <windows.h>
+#elif defined( HAVE_MMAP )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 // Fall back to getc() when getc_unlocked() is not available on the target platform.
 #if !defined( HAVE_FGETC_NOLOCK )
@@ -225,6 +236,199 @@ char* FILE_LINE_READER::ReadLine()
 }
 
 
+MMAP_LINE_READER::MMAP_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber, unsigned aMaxLineLength ) :
+    LINE_READER( aMaxLineLength ), m_data( NULL ), m_size( 0 ), m_ndx( 0 )
+{
+    bool opened = false;
+    bool mapped = false;
+
+#if defined( _WIN32 )
+    m_mapping = NULL;
+
+    HANDLE file = CreateFileW( aFileName.wc_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+    if( file != INVALID_HANDLE_VALUE )
+    {
+        LARGE_INTEGER size;
+
+        opened = true;
+
+        if( GetFileSizeEx( file, &size ) )
+        {
+            m_size = (size_t) size.QuadPart;
+
+            // An empty file cannot be mapped, but there is nothing to read anyway
+            if( m_size == 0 )
+            {
+                mapped = true;
+            }
+            else if( ( m_mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL ) ) )
+            {
+                m_data = (const char*) MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0 );
+                mapped = m_data != NULL;
+
+                if( !mapped )
+                    CloseHandle( m_mapping );
+            }
+        }
+
+        // the mapping keeps its own reference to the file
+        CloseHandle( file );
+    }
+#elif defined( HAVE_MMAP )
+    int fd = open( aFileName.fn_str(), O_RDONLY );
+
+    if( fd >= 0 )
+    {
+        struct stat st;
+
+        opened = true;
+
+        // Pipes and devices cannot be mapped
+        if( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) )
+        {
+            m_size = (size_t) st.st_size;
+
+            // An empty file cannot be mapped, but there is nothing to read anyway
+            if( m_size == 0 )
+            {
+                mapped = true;
+            }
+            else
+            {
+                void* data = mmap( NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+                if( data != MAP_FAILED )
+                {
+                    posix_madvise( data, m_size, POSIX_MADV_SEQUENTIAL );
+                    m_data = (const char*) data;
+                    mapped = true;
+                }
+            }
+        }
+
+        // the mapping keeps its own reference to the file
+        close( fd );
+    }
+#endif
+
+    if( !opened )
+    {
+        wxString msg = wxString::Format(
+            _( "Unable to open filename \"%s\" for reading" ), aFileName.GetData() );
+        THROW_IO_ERROR( msg );
+    }
+
+    if( !mapped )
+    {
+        wxString msg = wxString::Format(
+            _( "Unable to map filename \"%s\" into memory" ), aFileName.GetData() );
+        THROW_IO_ERROR( msg );
+    }
+
+    m_source  = aFileName;
+    m_lineNum = aStartingLineNumber;
+}
+
+
+MMAP_LINE_READER::~MMAP_LINE_READER()
+{
+#if defined( _WIN32 )
+    if( m_data )
+    {
+        UnmapViewOfFile( m_data );
+        CloseHandle( m_mapping );
+    }
+#elif defined( HAVE_MMAP )
+    if( m_data )
+        munmap( (void*) m_data, m_size );
+#endif
+}
+
+
+unsigned MMAP_LINE_READER::nextLine()
+{
+    size_t length = 0;
+
+    if( m_ndx < m_size )
+    {
+        const char* line = m_data + m_ndx;
+        const char* nl = (const char*) memchr( line, '\n', m_size - m_ndx );
+
+        length = nl ? nl - line + 1 : m_size - m_ndx;     // include the newline, so +1
+    }
+
+    // m_lineNum is incremented even if there was no line read, because this
+    // leads to better error reporting when we hit an end of file.
+    ++m_lineNum;
+
+    // checked before narrowing, a mapped file can hold a line longer than UINT_MAX
+    if( length >= m_maxLineLength )
+        THROW_IO_ERROR( _( "Maximum line length exceeded" ) );
+
+    return static_cast<unsigned>( length );
+}
+
+
+char* MMAP_LINE_READER::ReadLine()
+{
+    const size_t ndx = m_ndx;
+
+    m_length = nextLine();
+
+    if( m_length )
+    {
+        if( m_length+1 > m_capacity )   // +1 for terminating nul
+            expandCapacity( m_length+1 );
+
+        memcpy( m_line, m_data + ndx, m_length );
+        m_ndx += m_length;
+    }
+
+    m_line[m_length] = 0;
+
+    return m_length ? m_line : NULL;
+}
+
+
+const char* MMAP_LINE_READER::ReadLineView( unsigned& aLength )
+{
+    const size_t ndx = m_ndx;
+
+    m_length = nextLine();
+    aLength = m_length;
+
+    if( !m_length )
+    {
+        // at EOF, like ReadLine()
+        m_line[0] = 0;
+
+        return m_line;
+    }
+
+    m_ndx += m_length;
+
+    return m_data + ndx;
+}
+
+
+std::unique_ptr<LINE_READER> OpenFileLineReader( const wxString& aFileName )
+{
+    try
+    {
+        return std::unique_ptr<LINE_READER>( new MMAP_LINE_READER( aFileName ) );
+    }
+    catch( const IO_ERROR& )
+    {
+        // The file may not be mappable, e.g. a pipe, or a platform without mmap().  Read it
+        // line by line, which also reports the error if it cannot be opened at all.
+        return std::unique_ptr<LINE_READER>( new FILE_LINE_READER( aFileName ) );
+    }
+}
+
+
 STRING_LINE_READER::STRING_LINE_READER( const std::string& aString, const wxString& aSource ):
     LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
     m_lines( aString ), m_ndx( 0 )
@@ -480,6 +684,47 @@ std::string OUTPUTFORMATTER::Quotew( const wxString& aWrapee )
 }
 
 
+std::string OUTPUTFORMATTER::FormatDouble( double aValue, int aPrecision, bool aFixed )
+{
+    wxASSERT( aPrecision >= 0 && aPrecision <= 20 );
+
+    // Room enough for the 309 integer digits of DBL_MAX with a "%.20f" format
+    char    buf[400];
+    int     len = snprintf( buf, sizeof( buf ), aFixed ? "%.*f" : "%.*g", aPrecision, aValue );
+
+    if( len < 0 || len >= (int) sizeof( buf ) )
+        return std::string();
+
+    // printf() writes the decimal separator of the current locale, which is not always a '.'
+    // nor a single byte.  The separator is whatever follows the integer digits, when it is
+    // not the exponent: replace it.
+    const char* in = buf;
+    char*       out = buf;
+
+    if( *in == '-' )
+        *out++ = *in++;
+
+    if( isdigit( (unsigned char) *in ) )
+    {
+        while( isdigit( (unsigned char) *in ) )
+            *out++ = *in++;
+
+        if( *in && *in != 'e' && *in != 'E' )
+        {
+            *out++ = '.';
+
+            while( *in && !isdigit( (unsigned char) *in ) && *in != 'e' && *in != 'E' )
+                ++in;
+        }
+    }
+
+    while( *in )
+        *out++ = *in++;
+
+    return std::string( buf, out - buf );
+}
+
+
 //-----<STRING_FORMATTER>----------------------------------------------------
 
 void STRING_FORMATTER::write( const char* aOutBuf, int aCount )
@@ -84,6 +84,16 @@ public:
      */
     bool m_forceThickOutlinesInZones;
 
+    /**
+     * Recheck the items of each board commit for clearance errors as they are edited
+     */
+    bool m_onlineDrc;
+
+    /**
+     * Use the halfedge based Delaunay triangulation to compute the ratsnest
+     */
+    bool m_legacyRatsnestTriangulation;
+
     /**
      * Helper to determine if legacy canvas is allowed (according to platform
      * and config)
@@ -180,6 +180,13 @@ public:
     BOARD_ITEM* GetMainItem( BOARD* aBoard ) const;
     BOARD_ITEM* GetAuxiliaryItem( BOARD* aBoard ) const;
 
+    /**
+     * Access to the A and B item references themselves.  They are only meant to be
+     * compared to item pointers: the items may have been deleted since.
+     */
+    const void* GetMainItemWeakRef() const { return m_mainItemWeakRef; }
+    const void* GetAuxItemWeakRef() const { return m_auxItemWeakRef; }
+
     /**
      * Function ShowHtml
      * translates this object into a fragment of HTML suitable for the
@@ -107,6 +107,7 @@ protected:
 
     int                 curTok;                 ///< the current token obtained on last NextTok()
     std::string         curText;                ///< the text of the current token
+    std::string         curLine;                ///< the current line for CurLine(), when it is a view
 
     const KEYWORD*      keywords;               ///< table sorted by CMake for bsearch()
     unsigned            keywordCount;           ///< count of keywords table
@@ -118,13 +119,11 @@ protected:
     {
         if( reader )
         {
-            reader->ReadLine();
+            unsigned len;
 
-            unsigned len = reader->Length();
-
-            // start may have changed in ReadLine(), which can resize and
-            // relocate reader's line buffer.
-            start = reader->Line();
+            // The line is either in the reader's line buffer, which ReadLine() can resize
+            // and relocate, or a view into the text of a reader holding all of it in memory.
+            start = reader->ReadLineView( len );
 
             next  = start;
             limit = next + len;
@@ -397,6 +396,21 @@ public:
      */
     static bool IsSymbol( int aTok );
 
+    /**
+     * Function ParseDouble
+     * converts the number at the start of [\a aStart, \a aEnd) to a double, in the way of
+     * std::from_chars(): the decimal separator is always a '.', whatever the current locale.
+     * Numbers read with it don't need a LOCALE_IO, so they can be parsed from any thread.
+     *
+     * @param aStart is the first character of the text.
+     * @param aEnd is one past the last character of the text.
+     * @param aValue receives the number, if there is one.
+     * @return const char* - one past the last character of the number, or \a aStart if the
+     *   text doesn't start with a number.  Like strtod(), errno is set to ERANGE if the number
+     *   does not fit in a double.
+     */
+    static const char* ParseDouble( const char* aStart, const char* aEnd, double& aValue );
+
     /**
      * Function Expecting
      * throws an IO_ERROR exception with an input file specific error message.
@@ -516,6 +530,13 @@ public:
      */
     const char* CurLine()
     {
+        // A line viewed in the reader's text is not nul terminated, so copy it
+        if( start != (const char*)(*reader) )
+        {
+            curLine.assign( start, limit );
+            return curLine.c_str();
+        }
+
         return (const char*)(*reader);
     }
 
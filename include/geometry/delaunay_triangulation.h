@@ -0,0 +1,122 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __DELAUNAY_TRIANGULATION_H
+#define __DELAUNAY_TRIANGULATION_H
+
+#include <vector>
+
+#include <math/vector2d.h>
+
+/**
+ * Class DELAUNAY_TRIANGULATION
+ *
+ * Computes the Delaunay triangulation of a point set with a sweep-hull algorithm: points are
+ * added in order of distance from a seed triangle, each one connected to the visible part of
+ * the convex hull, and edges are flipped until the triangulation is Delaunay again.
+ *
+ * The result is stored in flat index arrays: triangle t is made of the points
+ * Triangles()[3t], [3t+1] and [3t+2], and half-edge e (going from point Triangles()[e] to
+ * the next point of its triangle) has its opposite half-edge at HalfEdges()[e], or -1 on the
+ * convex hull.  The object keeps its buffers, so triangulating many point sets with the same
+ * object does not allocate once the buffers are big enough.
+ */
+class DELAUNAY_TRIANGULATION
+{
+public:
+    /**
+     * Function Triangulate()
+     * Triangulates aPoints, which must not contain duplicates.
+     * @return false if there is no triangle, i.e. there are less than 3 points or all of
+     * them are colinear.
+     */
+    bool Triangulate( const std::vector<VECTOR2I>& aPoints );
+
+    const std::vector<int>& Triangles() const
+    {
+        return m_triangles;
+    }
+
+    const std::vector<int>& HalfEdges() const
+    {
+        return m_halfEdges;
+    }
+
+    /**
+     * Function ForEachEdge()
+     * Calls aFunc( int aPointA, int aPointB ) once for each edge of the triangulation.
+     */
+    template <class Func>
+    void ForEachEdge( Func aFunc ) const
+    {
+        for( int e = 0; e < (int) m_triangles.size(); e++ )
+        {
+            // Interior edges are shared by two half-edges: report only one of them
+            if( e > m_halfEdges[e] )
+                aFunc( m_triangles[e], m_triangles[nextHalfEdge( e )] );
+        }
+    }
+
+private:
+    static int nextHalfEdge( int aEdge )
+    {
+        return ( aEdge % 3 == 2 ) ? aEdge - 2 : aEdge + 1;
+    }
+
+    int hashKey( double aX, double aY ) const;
+
+    int addTriangle( int aP0, int aP1, int aP2, int aE0, int aE1, int aE2 );
+
+    void link( int aEdge, int aOpposite );
+
+    /**
+     * Flips the edge aEdge and its neighbours until they are locally Delaunay.
+     * @return the half-edge of the new point's triangle that lies on the hull.
+     */
+    int legalize( int aEdge );
+
+    ///> Point coordinates, relative to the centre of the bounding box of the points
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+
+    std::vector<int>    m_triangles;
+    std::vector<int>    m_halfEdges;
+
+    ///> Sweep state: points sorted by distance from the seed circumcentre
+    std::vector<int>    m_ids;
+    std::vector<double> m_dists;
+
+    ///> Convex hull, as a doubly linked list of points indexed by point
+    std::vector<int>    m_hullPrev;
+    std::vector<int>    m_hullNext;
+    std::vector<int>    m_hullTri;
+    std::vector<int>    m_hullHash;
+    int                 m_hullStart;
+
+    std::vector<int>    m_edgeStack;
+
+    double              m_cx;
+    double              m_cy;
+};
+
+#endif // __DELAUNAY_TRIANGULATION_H
@@ -49,7 +49,13 @@
  *      outline or a hole.
  *      - Vertex (or corner): each one of the points that define a contour.
  *
- * TODO: add convex partitioning & spatial index
+ * Sets with many vertices build an index of their edges the first time they are queried
+ * (Contains(), Collide(), Distance()), and drop it on any edit.  The cached triangulation is
+ * also outdated by any edit.  Edits are detected through the non-const methods: a reference
+ * returned by Outline(), Polygon() or the iterators must not be used to edit the set once it
+ * has been queried or triangulated.
+ *
+ * TODO: add convex partitioning
  */
 class SHAPE_POLY_SET : public SHAPE
 {
@@ -231,7 +237,7 @@ class SHAPE_POLY_SET : public SHAPE
 
             T& Get()
             {
-                return m_poly->Polygon( m_currentPolygon )[m_currentContour].Point( m_currentVertex );
+                return m_poly->m_polys[m_currentPolygon][m_currentContour].Point( m_currentVertex );
             }
 
             T& operator*()
@@ -353,7 +359,7 @@ class SHAPE_POLY_SET : public SHAPE
 
             T Get()
             {
-                return m_poly->Polygon( m_currentPolygon )[m_currentContour].Segment( m_currentSegment );
+                return m_poly->m_polys[m_currentPolygon][m_currentContour].Segment( m_currentSegment );
             }
 
             T operator*()
@@ -460,7 +466,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @return bool - true if the relative indices are correct; false otherwise. The computed
          *              global index is returned in the \p aGlobalIdx reference.
          */
-        bool GetGlobalIndex( VERTEX_INDEX aRelativeIndices, int& aGlobalIdx );
+        bool GetGlobalIndex( VERTEX_INDEX aRelativeIndices, int& aGlobalIdx ) const;
 
         /// @copydoc SHAPE::Clone()
         SHAPE* Clone() const override;
@@ -579,6 +585,7 @@ class SHAPE_POLY_SET : public SHAPE
         ///> Returns the reference to aIndex-th outline in the set
         SHAPE_LINE_CHAIN& Outline( int aIndex )
         {
+            markModified();
             return m_polys[aIndex][0];
         }
 
@@ -591,9 +598,9 @@ class SHAPE_POLY_SET : public SHAPE
          * @return SHAPE_POLY_SET - a set containing the polygons between aFirstPolygon (included)
          *                        and aLastPolygon (excluded).
          */
-        SHAPE_POLY_SET Subset( int aFirstPolygon, int aLastPolygon );
+        SHAPE_POLY_SET Subset( int aFirstPolygon, int aLastPolygon ) const;
 
-        SHAPE_POLY_SET UnitSet( int aPolygonIndex )
+        SHAPE_POLY_SET UnitSet( int aPolygonIndex ) const
         {
             return Subset( aPolygonIndex, aPolygonIndex + 1 );
         }
@@ -601,12 +608,14 @@ class SHAPE_POLY_SET : public SHAPE
         ///> Returns the reference to aHole-th hole in the aIndex-th outline
         SHAPE_LINE_CHAIN& Hole( int aOutline, int aHole )
         {
+            markModified();
             return m_polys[aOutline][aHole + 1];
         }
 
         ///> Returns the aIndex-th subpolygon in the set
         POLYGON& Polygon( int aIndex )
         {
+            markModified();
             return m_polys[aIndex];
         }
 
@@ -649,6 +658,8 @@ class SHAPE_POLY_SET : public SHAPE
         {
             ITERATOR iter;
 
+            markModified();
+
             iter.m_poly = this;
             iter.m_currentPolygon = aFirst;
             iter.m_lastPolygon = aLast < 0 ? OutlineCount() - 1 : aLast;
@@ -761,6 +772,8 @@ class SHAPE_POLY_SET : public SHAPE
         {
             SEGMENT_ITERATOR iter;
 
+            markModified();
+
             iter.m_poly = this;
             iter.m_currentPolygon = aFirst;
             iter.m_lastPolygon = aLast < 0 ? OutlineCount() - 1 : aLast;
@@ -806,12 +819,24 @@ class SHAPE_POLY_SET : public SHAPE
             return IterateSegments( 0, OutlineCount() - 1 );
         }
 
+        ///> Returns an iterator object, for all outlines in the set (no holes)
+        CONST_SEGMENT_ITERATOR CIterateSegments() const
+        {
+            return CIterateSegments( 0, OutlineCount() - 1 );
+        }
+
         ///> Returns an iterator object, for all outlines in the set (with holes)
         SEGMENT_ITERATOR IterateSegmentsWithHoles()
         {
             return IterateSegments( 0, OutlineCount() - 1, true );
         }
 
+        ///> Returns an iterator object, for all outlines in the set (with holes)
+        CONST_SEGMENT_ITERATOR CIterateSegmentsWithHoles() const
+        {
+            return CIterateSegments( 0, OutlineCount() - 1, true );
+        }
+
         ///> Returns an iterator object, for the aOutline-th outline in the set (with holes)
         SEGMENT_ITERATOR IterateSegmentsWithHoles( int aOutline )
         {
@@ -864,6 +889,19 @@ class SHAPE_POLY_SET : public SHAPE
         void BooleanIntersection( const SHAPE_POLY_SET& a, const SHAPE_POLY_SET& b,
                                   POLYGON_MODE aFastMode );
 
+        /**
+         * Function BooleanMany
+         * performs the boolean operation aType (union, difference or intersection) between
+         * this set and the union of all of aOperands, and stores the result in it self.
+         * Each set is converted to Clipper paths once, and the operands are merged pairwise
+         * on worker threads before the final operation, which is much faster than calling
+         * BooleanAdd() or BooleanSubtract() for each operand.
+         * For aFastMode meaning, see function booleanOp
+         */
+        void BooleanMany( ClipperLib::ClipType aType,
+                          const std::vector<const SHAPE_POLY_SET*>& aOperands,
+                          POLYGON_MODE aFastMode );
+
         enum CORNER_STRATEGY
         {
             ALLOW_ACUTE_CORNERS,
@@ -1090,7 +1128,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @return POLYGON - A polygon containing the chamfered version of the aIndex-th polygon.
          */
         POLYGON ChamferPolygon( unsigned int aDistance, int aIndex,
-                                std::set<VECTOR2I>* aPreserveCorners );
+                                std::set<VECTOR2I>* aPreserveCorners ) const;
 
         /**
          * Function Fillet
@@ -1102,7 +1140,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @return POLYGON - A polygon containing the filleted version of the aIndex-th polygon.
          */
         POLYGON FilletPolygon( unsigned int aRadius, int aErrorMax, int aIndex,
-                               std::set<VECTOR2I>* aPreserveCorners = nullptr );
+                               std::set<VECTOR2I>* aPreserveCorners = nullptr ) const;
 
         /**
          * Function Chamfer
@@ -1112,7 +1150,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @return SHAPE_POLY_SET - A set containing the chamfered version of this set.
          */
         SHAPE_POLY_SET Chamfer( int aDistance,
-                                std::set<VECTOR2I>* aPreserveCorners = nullptr );
+                                std::set<VECTOR2I>* aPreserveCorners = nullptr ) const;
 
         /**
          * Function Fillet
@@ -1123,7 +1161,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @return SHAPE_POLY_SET - A set containing the filleted version of this set.
          */
         SHAPE_POLY_SET Fillet( int aRadius, int aErrorMax,
-                               std::set<VECTOR2I>* aPreserveCorners = nullptr );
+                               std::set<VECTOR2I>* aPreserveCorners = nullptr ) const;
 
         /**
          * Function DistanceToPolygon
@@ -1133,7 +1171,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @return int -  The minimum distance between aPoint and all the segments of the aIndex-th
          *                polygon. If the point is contained in the polygon, the distance is zero.
          */
-        int DistanceToPolygon( VECTOR2I aPoint, int aIndex );
+        int DistanceToPolygon( VECTOR2I aPoint, int aIndex ) const;
 
         /**
          * Function DistanceToPolygon
@@ -1147,7 +1185,7 @@ class SHAPE_POLY_SET : public SHAPE
          *                  aIndex-th polygon. If the point is contained in the polygon, the
          *                  distance is zero.
          */
-        int DistanceToPolygon( const SEG& aSegment, int aIndex, int aSegmentWidth = 0 );
+        int DistanceToPolygon( const SEG& aSegment, int aIndex, int aSegmentWidth = 0 ) const;
 
         /**
          * Function DistanceToPolygon
@@ -1156,7 +1194,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @return int -  The minimum distance between aPoint and all the polygons in the set. If
          *                the point is contained in any of the polygons, the distance is zero.
          */
-        int Distance( VECTOR2I aPoint );
+        int Distance( VECTOR2I aPoint ) const;
 
         /**
          * Function DistanceToPolygon
@@ -1166,7 +1204,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @return int -    The minimum distance between aSegment and all the polygons in the set.
          *                  If the point is contained in the polygon, the distance is zero.
          */
-        int Distance( const SEG& aSegment, int aSegmentWidth = 0 );
+        int Distance( const SEG& aSegment, int aSegmentWidth = 0 ) const;
 
         /**
          * Function IsVertexInHole.
@@ -1174,7 +1212,7 @@ class SHAPE_POLY_SET : public SHAPE
          * @param  aGlobalIdx is the index of the vertex.
          * @return bool - true if the globally indexed aGlobalIdx-th vertex belongs to a hole.
          */
-        bool IsVertexInHole( int aGlobalIdx );
+        bool IsVertexInHole( int aGlobalIdx ) const;
 
     private:
         void fractureSingle( POLYGON& paths );
@@ -1219,6 +1257,23 @@ class SHAPE_POLY_SET : public SHAPE
         bool containsSingle( const VECTOR2I& aP, int aSubpolyIndex, int aAccuracy,
                              bool aUseBBoxCaches = false ) const;
 
+        class EDGE_INDEX;
+
+        ///> Called by every method that may edit the polygons: bumps the generation, which
+        ///> outdates the triangulation, and drops the edge index.  The read paths use the const
+        ///> accessors and iterators, so that they never get here.
+        void markModified()
+        {
+            m_generation++;
+
+            // No const query runs while the set is edited, so this needs no atomic store: that
+            // would take the shared_ptr lock pool on every appended vertex
+            m_edgeIndex.reset();
+        }
+
+        ///> Returns the edge index, building it if the set is large enough to need one
+        std::shared_ptr<const EDGE_INDEX> edgeIndex() const;
+
         /**
          * Operations ChamferPolygon and FilletPolygon are computed under the private chamferFillet
          * method; this enum is defined to make the necessary distinction when calling this method
@@ -1247,7 +1302,7 @@ class SHAPE_POLY_SET : public SHAPE
          */
         POLYGON chamferFilletPolygon( CORNER_MODE aMode, unsigned int aDistance,
                                       int aIndex, int aErrorMax,
-                                      std::set<VECTOR2I>* aPreserveCorners );
+                                      std::set<VECTOR2I>* aPreserveCorners ) const;
 
         ///> Returns true if the polygon set has any holes that touch share a vertex.
         bool hasTouchingHoles( const POLYGON& aPoly ) const;
@@ -1263,15 +1318,40 @@ class SHAPE_POLY_SET : public SHAPE
         void CacheTriangulation();
         bool IsTriangulationUpToDate() const;
 
+        /**
+         * Returns the MD5 hash of the polygons, computed on the first call after an edit.
+         * Like CacheTriangulation(), it must not run concurrently on the same set.
+         */
         MD5_HASH GetHash() const;
 
     private:
 
         MD5_HASH checksum() const;
 
+        /**
+         * Triangulates the outlines of aSet, which must not have holes, in parallel if there
+         * are many vertices.  aResult[i] is the triangulation of the i-th outline, or null if
+         * it failed.
+         */
+        static void triangulateOutlines( const SHAPE_POLY_SET& aSet,
+                std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>& aResult );
+
         std::vector<std::unique_ptr<TRIANGULATED_POLYGON>> m_triangulatedPolys;
         bool m_triangulationValid = false;
-        MD5_HASH m_hash;
+        mutable MD5_HASH m_hash;
+
+        ///> Incremented on each edit of the polygons
+        unsigned int m_generation = 0;
+
+        ///> Value of m_generation when m_triangulatedPolys were computed
+        unsigned int m_triangulationGeneration = 0;
+
+        ///> Value of m_generation when m_hash was computed
+        mutable unsigned int m_hashGeneration = 0;
+
+        ///> Lazily built by const queries, which may run concurrently, so these load and store
+        ///> it atomically.  Mutators just reset it.
+        mutable std::shared_ptr<const EDGE_INDEX> m_edgeIndex;
 
 };
 
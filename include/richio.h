@@ -29,6 +29,7 @@
 // "richio" after its author, Richard Hollenbeck, aka Dick Hollenbeck.
 
 
+#include <memory>
 #include <vector>
 #include <utf8.h>
 
@@ -120,6 +121,25 @@ public:
      */
     virtual char* ReadLine() = 0;
 
+    /**
+     * Function ReadLineView
+     * reads a line of text like ReadLine(), but readers holding all of their text in
+     * memory return the line where it lies instead of copying it into the line buffer.
+     * Such a line is not nul terminated, Line() does not return it, and it stays valid
+     * as long as the reader.  The default copies the line with ReadLine(), so the line
+     * is only valid until the next read.
+     * @param aLength is set to the number of bytes in the line, 0 at EOF.
+     * @return const char* - The beginning of the read line.
+     * @throw IO_ERROR when a line is too long for the line buffer.
+     */
+    virtual const char* ReadLineView( unsigned& aLength )
+    {
+        ReadLine();
+        aLength = m_length;
+
+        return m_line;
+    }
+
     /**
      * Function GetSource
      * returns the name of the source of the lines in an abstract sense.
@@ -283,6 +303,91 @@ public:
 };
 
 
+/**
+ * Class MMAP_LINE_READER
+ * is a LINE_READER that maps a whole file into memory, so ReadLineView() returns its lines
+ * without copying them.  ReadLine() still copies them into the line buffer.  The line
+ * endings are the ones of the file, as with a file opened in binary mode.
+ * <p>
+ * The file must not be truncated while it is mapped: reading a page past its new end raises
+ * SIGBUS on POSIX systems, and an access violation on Windows.  A file replaced by renaming
+ * another one over it is safe, the mapping keeps the old file, which is how
+ * FOOTPRINT_INFO_INDEX::Save() writes its index.  Files that may be rewritten in place while
+ * they are read must be read with a FILE_LINE_READER instead.
+ */
+class MMAP_LINE_READER : public LINE_READER
+{
+protected:
+    const char* m_data;     ///< the mapped text of the file, NULL if it is empty
+    size_t      m_size;     ///< no. bytes in the file
+    size_t      m_ndx;      ///< offset of the next line in m_data
+
+#if defined( _WIN32 )
+    void*       m_mapping;  ///< the handle of the file mapping object
+#endif
+
+    /**
+     * Function nextLine
+     * finds the next line and increments the line number counter.
+     * @return unsigned - the number of bytes of the line starting at m_data + m_ndx.
+     * @throw IO_ERROR if the line is not shorter than m_maxLineLength, as ReadLine() does
+     *        in FILE_LINE_READER.
+     */
+    unsigned nextLine();
+
+public:
+
+    /**
+     * Constructor MMAP_LINE_READER
+     * opens and maps @a aFileName.  The file is closed when this is destructed.
+     *
+     * @param aFileName is the name of the file to map and to use for error reporting purposes.
+     * @param aStartingLineNumber is the initial line number to report on error.
+     * @param aMaxLineLength is the maximum length of the lines returned by ReadLine() and
+     *  ReadLineView().
+     *
+     * @throw IO_ERROR if @a aFileName cannot be opened or mapped.
+     */
+    MMAP_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber = 0,
+            unsigned aMaxLineLength = LINE_READER_LINE_DEFAULT_MAX );
+
+    ~MMAP_LINE_READER();
+
+    char* ReadLine() override;
+
+    const char* ReadLineView( unsigned& aLength ) override;
+
+    /**
+     * Function Rewind
+     * goes back to the beginning of the file and resets the line number back to zero.
+     */
+    void Rewind()
+    {
+        m_ndx = 0;
+        m_lineNum = 0;
+    }
+
+    /**
+     * Function Data
+     * @return the whole mapped file, for binary files, or NULL if the file is empty.
+     */
+    const char* Data() const { return m_data; }
+
+    size_t Size() const { return m_size; }
+};
+
+
+/**
+ * Function OpenFileLineReader
+ * returns a MMAP_LINE_READER for @a aFileName, or a FILE_LINE_READER reading it line by
+ * line when the file cannot be mapped.
+ *
+ * @throw IO_ERROR if @a aFileName cannot be opened.
+ */
+std::unique_ptr<LINE_READER> OpenFileLineReader( const wxString& aFileName );
+
+
 /**
  * Class INPUTSTREAM_LINE_READER
  * is a LINE_READER that reads from a wxInputStream object.
@@ -433,6 +538,19 @@ public:
 
      std::string Quotew( const wxString& aWrapee );
 
+    /**
+     * Function FormatDouble
+     * formats a floating point number like printf() with a "%.*f" or a "%.*g" format, but
+     * always with a '.' as decimal separator, whatever the current locale.  Numbers written
+     * with it don't need a LOCALE_IO, so they can be formatted from any thread.
+     *
+     * @param aValue is the number to format.
+     * @param aPrecision is the precision of the format, at most 20.
+     * @param aFixed selects the "%.*f" format instead of the "%.*g" format.
+     * @return std::string - the formatted number.
+     */
+    static std::string FormatDouble( double aValue, int aPrecision = 6, bool aFixed = false );
+
     //-----</interface functions>-----------------------------------------
 };
 
@@ -160,6 +160,13 @@ extern const wxChar* const traceZoomScroll;
  */
 extern const wxChar* const traceSymbolResolver;
 
+/**
+ * Flag to enable zone filler debug output, such as the knockout cache statistics.
+ *
+ * Use "KICAD_ZONE_FILLER" to enable.
+ */
+extern const wxChar* const traceZoneFiller;
+
 ///@}
 
 /**
@@ -31,6 +31,8 @@
 #include <board_commit.h>
 #include <tools/pcb_tool_base.h>
 #include <tools/pcb_actions.h>
+#include <tools/drc.h>
+#include <tools/zone_filler_tool.h>
 #include <connectivity/connectivity_data.h>
 
 #include <functional>
@@ -67,10 +69,23 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
     auto              connectivity = board->GetConnectivity();
     std::set<EDA_ITEM*>      savedModules;
     std::vector<BOARD_ITEM*> itemsToDeselect;
+    std::vector<BOARD_ITEM*> changedItems;      // for the online DRC
+    std::vector<BOARD_ITEM*> removedItems;
+    ZONE_FILLER_TOOL*        zoneFiller = nullptr;
 
     if( Empty() )
         return;
 
+    if( !m_editModules )
+        zoneFiller = m_toolMgr->GetTool<ZONE_FILLER_TOOL>();
+
+    // Edited areas only need their zones refilled
+    auto markZonesDirty = [&]( EDA_ITEM* aItem )
+    {
+        if( zoneFiller && aItem )
+            zoneFiller->MarkDirty( static_cast<BOARD_ITEM*>( aItem ) );
+    };
+
     for( COMMIT_LINE& ent : m_changes )
     {
         int changeType = ent.m_type & CHT_TYPE;
@@ -120,6 +135,9 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
 
                     if( !( changeFlags & CHT_DONE ) )
                         board->Add( boardItem );        // handles connectivity
+
+                    changedItems.push_back( boardItem );
+                    markZonesDirty( boardItem );
                 }
                 else
                 {
@@ -181,6 +199,8 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                 case PCB_MARKER_T:              // a marker used to show something
                 case PCB_ZONE_AREA_T:
                     itemsToDeselect.push_back( boardItem );
+                    removedItems.push_back( boardItem );
+                    markZonesDirty( boardItem );
 
                     view->Remove( boardItem );
 
@@ -192,6 +212,8 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                 case PCB_MODULE_T:
                 {
                     itemsToDeselect.push_back( boardItem );
+                    removedItems.push_back( boardItem );
+                    markZonesDirty( boardItem );
 
                     // There are no modules inside a module yet
                     wxASSERT( !m_editModules );
@@ -226,9 +248,15 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                 if( ent.m_copy )
                     connectivity->MarkItemNetAsDirty( static_cast<BOARD_ITEM*>( ent.m_copy ) );
 
+                markZonesDirty( ent.m_copy );
+                markZonesDirty( boardItem );
+
                 connectivity->Update( boardItem );
                 view->Update( boardItem );
 
+                if( !m_editModules )
+                    changedItems.push_back( boardItem );
+
                 // if no undo entry is needed, the copy would create a memory leak
                 if( !aCreateUndoEntry )
                     delete ent.m_copy;
@@ -267,6 +295,9 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
 
                 auto boardItem = static_cast<BOARD_ITEM*>( ent.m_item );
 
+                markZonesDirty( ent.m_copy );
+                markZonesDirty( boardItem );
+
                 if( aCreateUndoEntry )
                 {
                     ITEM_PICKER itemWrapper( boardItem, UR_CHANGED );
@@ -280,8 +311,12 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                 }
 
                 view->Update( boardItem );
+                changedItems.push_back( boardItem );
             }
         }
+
+        if( DRC* drcTool = m_toolMgr->GetTool<DRC>() )
+            drcTool->QueueOnlineCheck( changedItems, removedItems );
     }
 
     if( !m_editModules && aCreateUndoEntry )
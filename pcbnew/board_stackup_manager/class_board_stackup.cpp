@@ -452,7 +452,8 @@ void BOARD_STACKUP::FormatBoardStackup( OUTPUTFORMATTER* aFormatter,
                                aFormatter->Quotew( item->m_Material ).c_str() );
 
         if( item->HasEpsilonRValue() )
-            aFormatter->Print( 0, " (epsilon_r %g)", item->m_EpsilonR );
+            aFormatter->Print( 0, " (epsilon_r %s)",
+                               OUTPUTFORMATTER::FormatDouble( item->m_EpsilonR ).c_str() );
 
         if( item->HasLossTangentValue() )
             aFormatter->Print( 0, " (loss %s)",
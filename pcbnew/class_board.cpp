@@ -110,6 +110,8 @@ BOARD::BOARD() :
     m_CurrentZoneContour = NULL;            // This ZONE_CONTAINER handle the
                                             // zone contour currently in progress
 
+    m_markersRevision = 0;
+
     BuildListOfNets();                      // prepare pad and netlist containers.
 
     for( LAYER_NUM layer = 0; layer < PCB_LAYER_ID_COUNT; ++layer )
@@ -539,6 +541,7 @@ void BOARD::Add( BOARD_ITEM* aBoardItem, ADD_MODE aMode )
     // this one uses a vector
     case PCB_MARKER_T:
         m_markers.push_back( (MARKER_PCB*) aBoardItem );
+        m_markersRevision++;
         break;
 
     // this one uses a vector
@@ -622,6 +625,7 @@ void BOARD::Remove( BOARD_ITEM* aBoardItem )
             if( m_markers[i] == (MARKER_PCB*) aBoardItem )
             {
                 m_markers.erase( m_markers.begin() + i );
+                m_markersRevision++;
                 break;
             }
         }
@@ -683,6 +687,7 @@ void BOARD::DeleteMARKERs()
         delete marker;
 
     m_markers.clear();
+    m_markersRevision++;
 }
 
 
@@ -169,6 +169,9 @@ private:
     /// MARKER_PCBs for clearance problems, owned by pointer.
     MARKERS                 m_markers;
 
+    /// Counts the changes of m_markers, see GetMARKERsRevision()
+    unsigned                m_markersRevision;
+
     /// BOARD_ITEMs for drawings on the board, owned by pointer.
     DRAWINGS                m_drawings;
 
@@ -355,6 +358,17 @@ public:
         return (int) m_markers.size();
     }
 
+    /**
+     * Function GetMARKERsRevision
+     * @return a counter incremented each time a MARKER_PCB is added or removed, and each
+     * time all of them are deleted.  Lets a caller keeping track of the markers added and
+     * removed through commits know if others were changed without one.
+     */
+    unsigned GetMARKERsRevision() const
+    {
+        return m_markersRevision;
+    }
+
     /**
      * Function SetAuxOrigin
      * sets the origin point used for plotting.
@@ -976,7 +976,7 @@ bool DRAWSEGMENT::IsPolyShapeValid() const
     if( GetPolyShape().OutlineCount() == 0 )
         return false;
 
-    const SHAPE_LINE_CHAIN& outline = ((SHAPE_POLY_SET&)GetPolyShape()).Outline( 0 );
+    const SHAPE_LINE_CHAIN& outline = GetPolyShape().COutline( 0 );
 
     return outline.PointCount() > 2;
 }
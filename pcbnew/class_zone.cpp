@@ -358,7 +358,7 @@ void ZONE_CONTAINER::Print( PCB_BASE_FRAME* aFrame, wxDC* DC, const wxPoint& off
     lines.reserve( (GetNumCorners() * 2) + 2 );
 
     // Iterate through the segments of the outline
-    for( auto iterator = m_Poly->IterateSegmentsWithHoles(); iterator; iterator++ )
+    for( auto iterator = m_Poly->CIterateSegmentsWithHoles(); iterator; iterator++ )
     {
         // Create the segment
         SEG segment = *iterator;
@@ -592,8 +592,8 @@ bool ZONE_CONTAINER::HitTest( const EDA_RECT& aRect, bool aContained, int aAccur
 
         for( int ii = 0; ii < count; ii++ )
         {
-            auto vertex = m_Poly->Vertex( ii );
-            auto vertexNext = m_Poly->Vertex( ( ii + 1 ) % count );
+            auto vertex = m_Poly->CVertex( ii );
+            auto vertexNext = m_Poly->CVertex( ( ii + 1 ) % count );
 
             // Test if the point is within the rect
             if( arect.Contains( ( wxPoint ) vertex ) )
@@ -978,12 +978,12 @@ void ZONE_CONTAINER::Hatch()
         return;
 
     // define range for hatch lines
-    int min_x = m_Poly->Vertex( 0 ).x;
-    int max_x = m_Poly->Vertex( 0 ).x;
-    int min_y = m_Poly->Vertex( 0 ).y;
-    int max_y = m_Poly->Vertex( 0 ).y;
+    int min_x = m_Poly->CVertex( 0 ).x;
+    int max_x = m_Poly->CVertex( 0 ).x;
+    int min_y = m_Poly->CVertex( 0 ).y;
+    int max_y = m_Poly->CVertex( 0 ).y;
 
-    for( auto iterator = m_Poly->IterateWithHoles(); iterator; iterator++ )
+    for( auto iterator = m_Poly->CIterateWithHoles(); iterator; iterator++ )
     {
         if( iterator->x < min_x )
             min_x = iterator->x;
@@ -1052,7 +1052,7 @@ void ZONE_CONTAINER::Hatch()
         pointbuffer.clear();
 
         // Iterate through all vertices
-        for( auto iterator = m_Poly->IterateSegmentsWithHoles(); iterator; iterator++ )
+        for( auto iterator = m_Poly->CIterateSegmentsWithHoles(); iterator; iterator++ )
         {
             double  x, y, x2, y2;
             int     ok;
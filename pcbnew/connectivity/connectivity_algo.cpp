@@ -23,6 +23,7 @@
  */
 
 #include <connectivity/connectivity_algo.h>
+#include <connectivity/connectivity_store.h>
 #include <widgets/progress_reporter.h>
 #include <geometry/geometry_utils.h>
 #include <board_commit.h>
@@ -31,6 +32,7 @@
 #include <mutex>
 #include <algorithm>
 #include <future>
+#include <map>
 
 #ifdef PROFILE
 #include <profile.h>
@@ -40,6 +42,7 @@
 bool CN_CONNECTIVITY_ALGO::Remove( BOARD_ITEM* aItem )
 {
     markItemNetAsDirty( aItem );
+    markConnectedNetsAsDirty( aItem );
 
     switch( aItem->Type() )
     {
@@ -110,6 +113,37 @@ void CN_CONNECTIVITY_ALGO::markItemNetAsDirty( const BOARD_ITEM* aItem )
 }
 
 
+void CN_CONNECTIVITY_ALGO::markConnectedNetsAsDirty( const BOARD_ITEM* aItem )
+{
+    auto markEntry = [this]( const BOARD_CONNECTED_ITEM* aCItem )
+    {
+        auto it = m_itemMap.find( aCItem );
+
+        if( it == m_itemMap.end() )
+            return;
+
+        for( auto cnItem : it->second.GetItems() )
+        {
+            // The item's net may have changed since it was clustered
+            MarkNetAsDirty( cnItem->ClusterNet() );
+
+            for( auto connected : cnItem->ConnectedItems() )
+                MarkNetAsDirty( connected->Net() );
+        }
+    };
+
+    if( aItem->IsConnected() )
+    {
+        markEntry( static_cast<const BOARD_CONNECTED_ITEM*>( aItem ) );
+    }
+    else if( aItem->Type() == PCB_MODULE_T )
+    {
+        for( auto pad : static_cast<const MODULE*>( aItem )->Pads() )
+            markEntry( pad );
+    }
+}
+
+
 bool CN_CONNECTIVITY_ALGO::Add( BOARD_ITEM* aItem )
 {
     if( !aItem->IsOnCopperLayer() )
@@ -263,6 +297,10 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
 
         if( m_progressReporter )
             m_progressReporter->KeepRefreshing();
+
+        // Connections were pushed unsorted by the search threads
+        for( auto item : m_itemList )
+            item->SortConnections();
     }
 
 #ifdef PROFILE
@@ -278,76 +316,76 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
 }
 
 
-const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUSTER_SEARCH_MODE aMode )
+const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUSTER_SEARCH_MODE aMode,
+        bool aDirtyNetsOnly )
 {
     constexpr KICAD_T types[] = { PCB_TRACE_T, PCB_PAD_T, PCB_VIA_T, PCB_ZONE_AREA_T, PCB_MODULE_T, EOT };
     constexpr KICAD_T no_zones[] = { PCB_TRACE_T, PCB_PAD_T, PCB_VIA_T, PCB_MODULE_T, EOT };
 
     if( aMode == CSM_PROPAGATE )
-        return SearchClusters( aMode, no_zones, -1 );
+        return SearchClusters( aMode, no_zones, -1, aDirtyNetsOnly );
     else
-        return SearchClusters( aMode, types, -1 );
+        return SearchClusters( aMode, types, -1, aDirtyNetsOnly );
 }
 
 
 const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUSTER_SEARCH_MODE aMode,
-        const KICAD_T aTypes[], int aSingleNet )
+        const KICAD_T aTypes[], int aSingleNet, bool aDirtyNetsOnly )
 {
     bool withinAnyNet = ( aMode != CSM_PROPAGATE );
 
     std::deque<CN_ITEM*> Q;
-    CN_ITEM* head = nullptr;
+    std::vector<CN_ITEM*> roots;
     CLUSTERS clusters;
 
     if( m_itemList.IsDirty() )
         searchConnections();
 
-    auto addToSearchList = [&head, withinAnyNet, aSingleNet, aTypes] ( CN_ITEM *aItem )
+    auto isSearched = [withinAnyNet, aSingleNet, aTypes] ( CN_ITEM *aItem )
     {
         if( withinAnyNet && aItem->Net() <= 0 )
-            return;
+            return false;
 
         if( !aItem->Valid() )
-            return;
+            return false;
 
         if( aSingleNet >=0 && aItem->Net() != aSingleNet )
-            return;
-
-        bool found = false;
+            return false;
 
         for( int i = 0; aTypes[i] != EOT; i++ )
         {
             if( aItem->Parent()->Type() == aTypes[i] )
-            {
-                found = true;
-                break;
-            }
+                return true;
         }
 
-        if( !found )
-            return;
-
-        aItem->ListClear();
-        aItem->SetVisited( false );
+        return false;
+    };
 
-        if( !head )
-            head = aItem;
-        else
-            head->ListInsert( aItem );
+    auto isNetDirty = [this] ( int aNet )
+    {
+        return aNet >= 0 && aNet < (int) m_dirtyNets.size() && m_dirtyNets[aNet];
     };
 
-    std::for_each( m_itemList.begin(), m_itemList.end(), addToSearchList );
+    // The items left out of the search are marked as visited, so the flood never enters them
+    for( auto item : m_itemList )
+    {
+        bool searched = isSearched( item );
 
-    while( head )
+        item->SetVisited( !searched );
+
+        if( searched && ( !aDirtyNetsOnly || isNetDirty( item->Net() ) ) )
+            roots.push_back( item );
+    }
+
+    for( auto root : roots )
     {
+        if( root->Visited() )
+            continue;
+
         CN_CLUSTER_PTR cluster ( new CN_CLUSTER() );
 
         Q.clear();
-        CN_ITEM* root = head;
         root->SetVisited ( true );
-
-        head = root->ListRemove();
-
         Q.push_back( root );
 
         while( Q.size() )
@@ -366,7 +404,6 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
                 {
                     n->SetVisited( true );
                     Q.push_back( n );
-                    head = n->ListRemove();
                 }
             }
         }
@@ -395,6 +432,14 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
 
 void CN_CONNECTIVITY_ALGO::Build( BOARD* aBoard )
 {
+    size_t itemCount = aBoard->GetAreaCount() + aBoard->Tracks().size();
+
+    for( auto mod : aBoard->Modules() )
+        itemCount += mod->Pads().size();
+
+    m_itemMap.reserve( m_itemMap.size() + itemCount );
+    m_itemList.Reserve( m_itemList.Size() + itemCount );
+
     for( int i = 0; i<aBoard->GetAreaCount(); i++ )
     {
         auto zone = aBoard->GetArea( i );
@@ -410,6 +455,22 @@ void CN_CONNECTIVITY_ALGO::Build( BOARD* aBoard )
             Add( pad );
     }
 
+    // All the items are searched at once in a CN_STORE, rather than one by one through the
+    // R-tree by searchConnections().  The store and its arena only live for the build.
+    std::vector<CN_ITEM*> garbage;
+
+    m_itemList.RemoveInvalidItems( garbage );
+
+    for( auto item : garbage )
+        delete item;
+
+    CN_STORE store;
+
+    store.Build( m_itemList, m_progressReporter );
+    store.ApplyConnections();
+
+    m_itemList.ClearDirtyFlags();
+
     /*wxLogTrace( "CN", "zones : %lu, pads : %lu vias : %lu tracks : %lu\n",
             m_zoneList.Size(), m_padList.Size(),
             m_viaList.Size(), m_trackList.Size() );*/
@@ -495,9 +556,9 @@ void CN_CONNECTIVITY_ALGO::propagateConnections( BOARD_COMMIT* aCommit )
 }
 
 
-void CN_CONNECTIVITY_ALGO::PropagateNets( BOARD_COMMIT* aCommit )
+void CN_CONNECTIVITY_ALGO::PropagateNets( BOARD_COMMIT* aCommit, bool aDirtyNetsOnly )
 {
-    m_connClusters = SearchClusters( CSM_PROPAGATE );
+    m_connClusters = SearchClusters( CSM_PROPAGATE, aDirtyNetsOnly );
     propagateConnections( aCommit );
 }
 
@@ -507,30 +568,17 @@ void CN_CONNECTIVITY_ALGO::FindIsolatedCopperIslands( ZONE_CONTAINER* aZone, std
     if( aZone->GetFilledPolysList().IsEmpty() )
         return;
 
-    aIslands.clear();
+    std::vector<CN_ZONE_ISOLATED_ISLAND_LIST> zones;
 
-    Remove( aZone );
-    Add( aZone );
+    zones.emplace_back( aZone );
+    FindIsolatedCopperIslands( zones );
 
-    m_connClusters = SearchClusters( CSM_CONNECTIVITY_CHECK );
-
-    for( const auto& cluster : m_connClusters )
-    {
-        if( cluster->Contains( aZone ) && cluster->IsOrphaned() )
-        {
-            for( auto z : *cluster )
-            {
-                if( z->Parent() == aZone )
-                {
-                    aIslands.push_back( static_cast<CN_ZONE*>(z)->SubpolyIndex() );
-                }
-            }
-        }
-    }
+    aIslands = std::move( zones[0].m_islands );
 
     wxLogTrace( "CN", "Found %u isolated islands\n", (unsigned)aIslands.size() );
 }
 
+
 void CN_CONNECTIVITY_ALGO::FindIsolatedCopperIslands( std::vector<CN_ZONE_ISOLATED_ISLAND_LIST>& aZones )
 {
     for ( auto& z : aZones )
@@ -542,25 +590,124 @@ void CN_CONNECTIVITY_ALGO::FindIsolatedCopperIslands( std::vector<CN_ZONE_ISOLAT
             Add( z.m_zone );
     }
 
-    m_connClusters = SearchClusters( CSM_CONNECTIVITY_CHECK );
+    // Finds the anchors inside each filled sub-polygon, using its grid partition
+    if( m_itemList.IsDirty() )
+        searchConnections();
+
+    // An island is a sub-polygon that no pad of its net reaches.  Rather than clustering the
+    // whole board, flood each net holding a zone from its pads: nets share no items, so they
+    // are flooded in parallel.
+    std::map<int, size_t> netIndex;
+    std::vector<std::vector<CN_ZONE_ISOLATED_ISLAND_LIST*>> netZones;
 
-    for ( auto& zone : aZones )
+    for( auto& z : aZones )
     {
-        if( zone.m_zone->GetFilledPolysList().IsEmpty() )
+        z.m_islands.clear();
+
+        int net = z.m_zone->GetNetCode();
+
+        // Only zones with a net can have insulated islands
+        if( net <= 0 || z.m_zone->GetFilledPolysList().IsEmpty() )
+            continue;
+
+        auto it = netIndex.emplace( net, netZones.size() ).first;
+
+        if( it->second == netZones.size() )
+            netZones.emplace_back();
+
+        netZones[it->second].push_back( &z );
+    }
+
+    if( netZones.empty() )
+        return;
+
+    std::vector<std::vector<CN_ITEM*>> netItems( netZones.size() );
+
+    for( auto item : m_itemList )
+    {
+        if( !item->Valid() )
             continue;
 
-        for( const auto& cluster : m_connClusters )
+        auto it = netIndex.find( item->Net() );
+
+        if( it != netIndex.end() )
+            netItems[it->second].push_back( item );
+    }
+
+    std::atomic<size_t> nextNet( 0 );
+
+    auto flood_lambda = [&nextNet, &netItems, &netZones, this]() -> size_t
+    {
+        std::deque<CN_ITEM*> Q;
+
+        for( size_t i = nextNet++; i < netItems.size(); i = nextNet++ )
         {
-            if( cluster->Contains( zone.m_zone ) && cluster->IsOrphaned() )
+            for( auto item : netItems[i] )
             {
-                for( auto z : *cluster )
+                item->SetVisited( item->Parent()->Type() == PCB_PAD_T );
+
+                if( item->Visited() )
+                    Q.push_back( item );
+            }
+
+            while( !Q.empty() )
+            {
+                CN_ITEM* current = Q.front();
+                int      net = current->Net();
+
+                Q.pop_front();
+
+                for( auto n : current->ConnectedItems() )
                 {
-                    if( z->Parent() == zone.m_zone )
+                    if( n->Net() == net && n->Valid() && !n->Visited() )
                     {
-                        zone.m_islands.push_back( static_cast<CN_ZONE*>(z)->SubpolyIndex() );
+                        n->SetVisited( true );
+                        Q.push_back( n );
                     }
                 }
             }
+
+            for( auto zone : netZones[i] )
+            {
+                auto entry = m_itemMap.find( zone->m_zone );
+
+                if( entry == m_itemMap.end() )
+                    continue;
+
+                for( auto item : entry->second.GetItems() )
+                {
+                    if( item->Valid() && !item->Visited() )
+                        zone->m_islands.push_back( static_cast<CN_ZONE*>( item )->SubpolyIndex() );
+                }
+            }
+        }
+
+        return 1;
+    };
+
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+                                                   netItems.size() );
+
+    if( parallelThreadCount <= 1 )
+        flood_lambda();
+    else
+    {
+        std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii] = std::async( std::launch::async, flood_lambda );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        {
+            // Here we balance returns with a 100ms timeout to allow UI updating
+            std::future_status status;
+            do
+            {
+                if( m_progressReporter )
+                    m_progressReporter->KeepRefreshing();
+
+                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
+            } while( status != std::future_status::ready );
         }
     }
 }
@@ -568,7 +715,32 @@ void CN_CONNECTIVITY_ALGO::FindIsolatedCopperIslands( std::vector<CN_ZONE_ISOLAT
 
 const CN_CONNECTIVITY_ALGO::CLUSTERS& CN_CONNECTIVITY_ALGO::GetClusters()
 {
-    m_ratsnestClusters = SearchClusters( CSM_RATSNEST );
+    // Ratsnest clusters never span nets, and any change to a net marks it as dirty: the
+    // clusters of the clean nets are still valid, only those of the dirty nets are searched
+    CLUSTERS dirtyClusters = SearchClusters( CSM_RATSNEST, true );
+
+    auto byNet = []( const CN_CLUSTER_PTR& a, const CN_CLUSTER_PTR& b )
+    {
+        return a->OriginNet() < b->OriginNet();
+    };
+
+    m_ratsnestClusters.erase( std::remove_if( m_ratsnestClusters.begin(), m_ratsnestClusters.end(),
+            [this]( const CN_CLUSTER_PTR& aCluster )
+            {
+                return IsNetDirty( aCluster->OriginNet() );
+            } ), m_ratsnestClusters.end() );
+
+    for( const auto& cluster : dirtyClusters )
+    {
+        for( auto item : *cluster )
+            item->SetClusterNet( cluster->OriginNet() );
+    }
+
+    // Both ranges are sorted by net
+    auto mid = m_ratsnestClusters.insert( m_ratsnestClusters.end(), dirtyClusters.begin(),
+                                          dirtyClusters.end() );
+    std::inplace_merge( m_ratsnestClusters.begin(), mid, m_ratsnestClusters.end(), byNet );
+
     return m_ratsnestClusters;
 }
 
@@ -595,112 +767,125 @@ void CN_CONNECTIVITY_ALGO::MarkNetAsDirty( int aNet )
 }
 
 
-void CN_VISITOR::checkZoneItemConnection( CN_ZONE* aZone, CN_ITEM* aItem )
+bool CN_VISITOR::checkZoneItemConnection( CN_ZONE* aZone, CN_ITEM* aItem,
+                                          const VECTOR2I* aItemAnchors )
 {
-    auto zoneItem = static_cast<CN_ZONE*> ( aZone );
-
-    if( zoneItem->Net() != aItem->Net() && !aItem->CanChangeNet() )
-        return;
+    if( aZone->Net() != aItem->Net() && !aItem->CanChangeNet() )
+        return false;
 
-    if( zoneItem->ContainsPoint( aItem->GetAnchor( 0 ) ) ||
+    return aZone->ContainsPoint( aItemAnchors[0] ) ||
             ( aItem->Parent()->Type() == PCB_TRACE_T &&
-              zoneItem->ContainsPoint( aItem->GetAnchor( 1 ) ) ) )
-    {
-        zoneItem->Connect( aItem );
-        aItem->Connect( zoneItem );
-    }
+              aZone->ContainsPoint( aItemAnchors[1] ) );
 }
 
-void CN_VISITOR::checkZoneZoneConnection( CN_ZONE* aZoneA, CN_ZONE* aZoneB )
+bool CN_VISITOR::checkZoneZoneConnection( CN_ZONE* aZoneA, const VECTOR2I* aAnchorsA,
+                                          int aCountA, CN_ZONE* aZoneB,
+                                          const VECTOR2I* aAnchorsB, int aCountB )
 {
     const auto refParent = static_cast<const ZONE_CONTAINER*>( aZoneA->Parent() );
     const auto testedParent = static_cast<const ZONE_CONTAINER*>( aZoneB->Parent() );
 
     if( testedParent->Type () != PCB_ZONE_AREA_T )
-        return;
+        return false;
 
     if( aZoneB == aZoneA  || refParent == testedParent )
-        return;
+        return false;
 
     if( aZoneB->Net() != aZoneA->Net() )
-        return; // we only test zones belonging to the same net
-
-    const auto& outline = refParent->GetFilledPolysList().COutline( aZoneA->SubpolyIndex() );
+        return false; // we only test zones belonging to the same net
 
-    for( int i = 0; i < outline.PointCount(); i++ )
+    for( int i = 0; i < aCountA; i++ )
     {
-        if( aZoneB->ContainsPoint( outline.CPoint( i ) ) )
-        {
-            aZoneA->Connect( aZoneB );
-            aZoneB->Connect( aZoneA );
-            return;
-        }
+        if( aZoneB->ContainsPoint( aAnchorsA[i] ) )
+            return true;
     }
 
-    const auto& outline2 = testedParent->GetFilledPolysList().COutline( aZoneB->SubpolyIndex() );
-
-    for( int i = 0; i < outline2.PointCount(); i++ )
+    for( int i = 0; i < aCountB; i++ )
     {
-        if( aZoneA->ContainsPoint( outline2.CPoint( i ) ) )
-        {
-            aZoneA->Connect( aZoneB );
-            aZoneB->Connect( aZoneA );
-            return;
-        }
+        if( aZoneA->ContainsPoint( aAnchorsB[i] ) )
+            return true;
     }
+
+    return false;
 }
 
 
-bool CN_VISITOR::operator()( CN_ITEM* aCandidate )
+bool CN_VISITOR::Touch( CN_ITEM* aItemA, const VECTOR2I* aAnchorsA, int aCountA,
+                        CN_ITEM* aItemB, const VECTOR2I* aAnchorsB, int aCountB )
 {
-    const auto parentA = aCandidate->Parent();
-    const auto parentB = m_item->Parent();
-
-    if( !aCandidate->Valid() || !m_item->Valid() )
-        return true;
+    const auto parentA = aItemA->Parent();
+    const auto parentB = aItemB->Parent();
 
     if( parentA == parentB )
-        return true;
+        return false;
 
     if( !( parentA->GetLayerSet() & parentB->GetLayerSet() ).any() )
-        return true;
-
-    // If both m_item and aCandidate are marked dirty, they will both be searched
-    // Since we are reciprocal in our connection, we arbitrarily pick one of the connections
-    // to conduct the expensive search
-    if( aCandidate->Dirty() && aCandidate < m_item )
-        return true;
+        return false;
 
     // We should handle zone-zone connection separately
     if ( parentA->Type() == PCB_ZONE_AREA_T && parentB->Type() == PCB_ZONE_AREA_T )
     {
-        checkZoneZoneConnection( static_cast<CN_ZONE*>( m_item ),
-                static_cast<CN_ZONE*>( aCandidate ) );
-        return true;
+        return checkZoneZoneConnection( static_cast<CN_ZONE*>( aItemA ), aAnchorsA, aCountA,
+                                        static_cast<CN_ZONE*>( aItemB ), aAnchorsB, aCountB );
     }
 
     if( parentA->Type() == PCB_ZONE_AREA_T )
-    {
-        checkZoneItemConnection( static_cast<CN_ZONE*>( aCandidate ), m_item );
-        return true;
-    }
+        return checkZoneItemConnection( static_cast<CN_ZONE*>( aItemA ), aItemB, aAnchorsB );
 
     if( parentB->Type() == PCB_ZONE_AREA_T )
-    {
-        checkZoneItemConnection( static_cast<CN_ZONE*>( m_item ), aCandidate );
-        return true;
-    }
+        return checkZoneItemConnection( static_cast<CN_ZONE*>( aItemB ), aItemA, aAnchorsA );
 
     // Items do not necessarily have reciprocity as we only check for anchors
     //  therefore, we check HitTest both directions A->B & B->A
     // TODO: Check for collision geometry on extended features
-    wxPoint ptA1( aCandidate->GetAnchor( 0 ).x, aCandidate->GetAnchor( 0 ).y );
-    wxPoint ptA2( aCandidate->GetAnchor( 1 ).x, aCandidate->GetAnchor( 1 ).y );
-    wxPoint ptB1( m_item->GetAnchor( 0 ).x, m_item->GetAnchor( 0 ).y );
-    wxPoint ptB2( m_item->GetAnchor( 1 ).x, m_item->GetAnchor( 1 ).y );
-    if( parentA->HitTest( ptB1 ) || parentB->HitTest( ptA1 ) ||
-            ( parentA->Type() == PCB_TRACE_T && parentB->HitTest( ptA2 ) ) ||
-            ( parentB->Type() == PCB_TRACE_T && parentA->HitTest( ptB2 ) ) )
+    auto pt = []( const VECTOR2I& aAnchor )
+    {
+        return wxPoint( aAnchor.x, aAnchor.y );
+    };
+
+    return parentA->HitTest( pt( aAnchorsB[0] ) ) || parentB->HitTest( pt( aAnchorsA[0] ) ) ||
+            ( parentA->Type() == PCB_TRACE_T && parentB->HitTest( pt( aAnchorsA[1] ) ) ) ||
+            ( parentB->Type() == PCB_TRACE_T && parentA->HitTest( pt( aAnchorsB[1] ) ) );
+}
+
+
+const VECTOR2I* CN_VISITOR::anchors( CN_ITEM* aItem, VECTOR2I aBuffer[2], int& aCount )
+{
+    if( aItem->Parent()->Type() == PCB_ZONE_AREA_T )
+    {
+        const auto zone = static_cast<const ZONE_CONTAINER*>( aItem->Parent() );
+        const auto& outline = zone->GetFilledPolysList().COutline(
+                static_cast<CN_ZONE*>( aItem )->SubpolyIndex() );
+
+        aCount = outline.PointCount();
+        return outline.CPoints().data();
+    }
+
+    aCount = aItem->AnchorCount();
+    aBuffer[0] = aItem->GetAnchor( 0 );
+    aBuffer[1] = aItem->GetAnchor( 1 );
+
+    return aBuffer;
+}
+
+
+bool CN_VISITOR::operator()( CN_ITEM* aCandidate )
+{
+    if( !aCandidate->Valid() || !m_item->Valid() )
+        return true;
+
+    // If both m_item and aCandidate are marked dirty, they will both be searched
+    // Since we are reciprocal in our connection, we arbitrarily pick one of the connections
+    // to conduct the expensive search
+    if( aCandidate->Dirty() && aCandidate < m_item )
+        return true;
+
+    VECTOR2I        bufferA[2], bufferB[2];
+    int             countA, countB;
+    const VECTOR2I* anchorsA = anchors( m_item, bufferA, countA );
+    const VECTOR2I* anchorsB = anchors( aCandidate, bufferB, countB );
+
+    if( Touch( m_item, anchorsA, countA, aCandidate, anchorsB, countB ) )
     {
         m_item->Connect( aCandidate );
         aCandidate->Connect( m_item );
@@ -168,6 +168,12 @@ private:
 
     void markItemNetAsDirty( const BOARD_ITEM* aItem );
 
+    /**
+     * Marks as dirty the nets a removed item may still be clustered with: the net of its
+     * ratsnest cluster, and the nets of the items it connects to (which may split).
+     */
+    void markConnectedNetsAsDirty( const BOARD_ITEM* aItem );
+
 public:
 
     CN_CONNECTIVITY_ALGO() {}
@@ -221,14 +227,25 @@ public:
     bool    Remove( BOARD_ITEM* aItem );
     bool    Add( BOARD_ITEM* aItem );
 
-    const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode, const KICAD_T aTypes[], int aSingleNet );
-    const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode );
+    /**
+     * Function SearchClusters()
+     * Floods the connections of the items of types aTypes into clusters.
+     * @param aSingleNet restricts the search to a single net, if >= 0.
+     * @param aDirtyNetsOnly restricts the search to the clusters holding an item of a dirty
+     * net.  Clusters never span nets in the CSM_RATSNEST and CSM_CONNECTIVITY_CHECK modes,
+     * so only the clusters of the dirty nets are returned.
+     */
+    const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode, const KICAD_T aTypes[],
+                                    int aSingleNet, bool aDirtyNetsOnly = false );
+    const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode, bool aDirtyNetsOnly = false );
 
     /**
      * Propagates nets from pads to other items in clusters
      * @param aCommit is used to store undo information for items modified by the call
+     * @param aDirtyNetsOnly propagates only in the clusters holding an item of a dirty net.
+     * The other clusters did not change since their nets were last propagated.
      */
-    void    PropagateNets( BOARD_COMMIT* aCommit = nullptr );
+    void    PropagateNets( BOARD_COMMIT* aCommit = nullptr, bool aDirtyNetsOnly = false );
 
     void    FindIsolatedCopperIslands( ZONE_CONTAINER* aZone, std::vector<int>& aIslands );
 
@@ -268,11 +285,26 @@ public:
 
     bool operator()( CN_ITEM* aCandidate );
 
+    /**
+     * Function Touch()
+     * Tests whether two valid items are physically connected.  The anchors are those of
+     * CN_ITEM::GetAnchor() for the pads, tracks and vias, and the outline points of the
+     * filled polygon for the zones.  Thread safe, and used by CN_STORE for full builds.
+     */
+    static bool Touch( CN_ITEM* aItemA, const VECTOR2I* aAnchorsA, int aCountA,
+                       CN_ITEM* aItemB, const VECTOR2I* aAnchorsB, int aCountB );
+
 protected:
 
-    void checkZoneItemConnection( CN_ZONE* aZone, CN_ITEM* aItem );
+    static bool checkZoneItemConnection( CN_ZONE* aZone, CN_ITEM* aItem,
+                                         const VECTOR2I* aItemAnchors );
+
+    static bool checkZoneZoneConnection( CN_ZONE* aZoneA, const VECTOR2I* aAnchorsA,
+                                         int aCountA, CN_ZONE* aZoneB,
+                                         const VECTOR2I* aAnchorsB, int aCountB );
 
-    void checkZoneZoneConnection( CN_ZONE* aZoneA, CN_ZONE* aZoneB );
+    ///> returns the anchors of aItem passed to Touch(), copied to aBuffer unless it is a zone
+    static const VECTOR2I* anchors( CN_ITEM* aItem, VECTOR2I aBuffer[2], int& aCount );
 
     ///> the item we are looking for connections to
     CN_ITEM* m_item;
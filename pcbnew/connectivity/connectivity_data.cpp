@@ -33,6 +33,7 @@
 
 #include <connectivity/connectivity_data.h>
 #include <connectivity/connectivity_algo.h>
+#include <connectivity/dynamic_ratsnest.h>
 #include <ratsnest_data.h>
 
 CONNECTIVITY_DATA::CONNECTIVITY_DATA()
@@ -149,7 +150,11 @@ void CONNECTIVITY_DATA::addRatsnestCluster( const std::shared_ptr<CN_CLUSTER>& a
 
 void CONNECTIVITY_DATA::RecalculateRatsnest( BOARD_COMMIT* aCommit  )
 {
-    m_connAlgo->PropagateNets( aCommit );
+    // The dynamic ratsnest targets are a copy of the ratsnest nodes
+    if( m_dynamicRatsnest )
+        m_dynamicRatsnest->Invalidate();
+
+    m_connAlgo->PropagateNets( aCommit, true );
 
     int lastNet = m_connAlgo->NetCount();
 
@@ -244,75 +249,60 @@ void CONNECTIVITY_DATA::FindIsolatedCopperIslands( std::vector<CN_ZONE_ISOLATED_
 
 void CONNECTIVITY_DATA::ComputeDynamicRatsnest( const std::vector<BOARD_ITEM*>& aItems )
 {
-    m_dynamicRatsnest.clear();
-
     if( std::none_of( aItems.begin(), aItems.end(), []( const BOARD_ITEM* aItem )
             { return( aItem->Type() == PCB_TRACE_T || aItem->Type() == PCB_PAD_T ||
                       aItem->Type() == PCB_ZONE_AREA_T || aItem->Type() == PCB_MODULE_T ||
                       aItem->Type() == PCB_VIA_T ); } ) )
     {
+        HideDynamicRatsnest();
         return ;
     }
 
-    CONNECTIVITY_DATA connData( aItems );
-    BlockRatsnestItems( aItems );
+    if( !m_dynamicRatsnest )
+        m_dynamicRatsnest.reset( new DYNAMIC_RATSNEST );
 
-    for( unsigned int nc = 1; nc < connData.m_nets.size(); nc++ )
+    // The moving items keep their connections while they are dragged, so their connectivity
+    // is only computed when the set of items changes
+    if( !m_dynamicRatsnest->IsSnapshotOf( aItems ) )
     {
-        auto dynNet = connData.m_nets[nc];
+        CONNECTIVITY_DATA connData( aItems );
+        BlockRatsnestItems( aItems );
 
-        if( dynNet->GetNodeCount() != 0 )
-        {
-            auto ourNet = m_nets[nc];
-            CN_ANCHOR_PTR nodeA, nodeB;
+        m_dynamicRatsnest->Snapshot( aItems, *this, connData );
+    }
 
-            if( ourNet->NearestBicoloredPair( *dynNet, nodeA, nodeB ) )
-            {
-                RN_DYNAMIC_LINE l;
-                l.a = nodeA->Pos();
-                l.b = nodeB->Pos();
-                l.netCode = nc;
+    m_dynamicRatsnest->Update();
+}
 
-                m_dynamicRatsnest.push_back( l );
-            }
-        }
-    }
 
-    for( auto net : connData.m_nets )
-    {
-        if( !net )
-            continue;
+std::shared_ptr<const std::vector<RN_DYNAMIC_LINE>> CONNECTIVITY_DATA::GetDynamicRatsnest() const
+{
+    if( !m_dynamicRatsnest )
+        return std::make_shared<const std::vector<RN_DYNAMIC_LINE>>();
 
-        const auto& edges = net->GetUnconnected();
+    return m_dynamicRatsnest->GetLines();
+}
 
-        if( edges.empty() )
-            continue;
 
-        for( const auto& edge : edges )
-        {
-            const auto& nodeA   = edge.GetSourceNode();
-            const auto& nodeB   = edge.GetTargetNode();
-            RN_DYNAMIC_LINE l;
-
-            l.a = nodeA->Pos();
-            l.b = nodeB->Pos();
-            l.netCode = 0;
-            m_dynamicRatsnest.push_back( l );
-        }
-    }
+bool CONNECTIVITY_DATA::IsDynamicRatsnestUpToDate() const
+{
+    return !m_dynamicRatsnest || m_dynamicRatsnest->IsUpToDate();
 }
 
 
 void CONNECTIVITY_DATA::ClearDynamicRatsnest()
 {
     m_connAlgo->ForEachAnchor( [] ( CN_ANCHOR& anchor ) { anchor.SetNoLine( false ); } );
-    HideDynamicRatsnest();
+
+    if( m_dynamicRatsnest )
+        m_dynamicRatsnest->Invalidate();
 }
 
 
 void CONNECTIVITY_DATA::HideDynamicRatsnest()
 {
-    m_dynamicRatsnest.clear();
+    if( m_dynamicRatsnest )
+        m_dynamicRatsnest->Hide();
 }
 
 
@@ -40,6 +40,7 @@
 
 class CN_CLUSTER;
 class CN_CONNECTIVITY_ALGO;
+class DYNAMIC_RATSNEST;
 class CN_EDGE;
 class BOARD;
 class BOARD_COMMIT;
@@ -199,13 +200,26 @@ public:
      * Function ComputeDynamicRatsnest()
      * Calculates the temporary dynamic ratsnest (i.e. the ratsnest lines that)
      * for the set of items aItems.
+     * The lines are computed in the background: GetDynamicRatsnest() returns them once
+     * IsDynamicRatsnestUpToDate() is true.
      */
     void ComputeDynamicRatsnest( const std::vector<BOARD_ITEM*>& aItems );
 
-    const std::vector<RN_DYNAMIC_LINE>& GetDynamicRatsnest() const
-    {
-        return m_dynamicRatsnest;
-    }
+#ifndef SWIG
+    /**
+     * Function GetDynamicRatsnest()
+     * Returns the last computed dynamic ratsnest.  It is published atomically, so it needs
+     * no lock.  Python scripts get a copy of the lines instead, see connectivity.i.
+     */
+    std::shared_ptr<const std::vector<RN_DYNAMIC_LINE>> GetDynamicRatsnest() const;
+#endif
+
+    /**
+     * Function IsDynamicRatsnestUpToDate()
+     * Returns true if the dynamic ratsnest of the last ComputeDynamicRatsnest() call is
+     * available.
+     */
+    bool IsDynamicRatsnestUpToDate() const;
 
     /**
      * Function GetConnectedItems()
@@ -249,13 +263,14 @@ public:
 #endif
 
 private:
+    friend class DYNAMIC_RATSNEST;
 
     void    updateRatsnest();
     void    addRatsnestCluster( const std::shared_ptr<CN_CLUSTER>& aCluster );
 
     std::shared_ptr<CN_CONNECTIVITY_ALGO> m_connAlgo;
 
-    std::vector<RN_DYNAMIC_LINE> m_dynamicRatsnest;
+    std::unique_ptr<DYNAMIC_RATSNEST> m_dynamicRatsnest;
     std::vector<RN_NET*> m_nets;
 
     PROGRESS_REPORTER* m_progressReporter;
@@ -111,13 +111,9 @@ const VECTOR2I CN_ZONE::GetAnchor( int n ) const
 
 void CN_ITEM::RemoveInvalidRefs()
 {
-    for( auto it = m_connected.begin(); it != m_connected.end(); )
-    {
-        if( !(*it)->Valid() )
-            it = m_connected.erase( it );
-        else
-            ++it;
-    }
+    m_connected.erase( std::remove_if( m_connected.begin(), m_connected.end(),
+                                       []( const CN_ITEM* aItem ) { return !aItem->Valid(); } ),
+                       m_connected.end() );
 }
 
 
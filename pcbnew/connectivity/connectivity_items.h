@@ -155,16 +155,23 @@ typedef std::shared_ptr<CN_ANCHOR>  CN_ANCHOR_PTR;
 typedef std::vector<CN_ANCHOR_PTR>  CN_ANCHORS;
 
 
-// basic connectivity item
+/**
+ * Basic connectivity item.
+ *
+ * Items stay separate objects, as the ratsnest shares their anchors and the incremental
+ * updates search the connections of the items added since the last search.  A full
+ * CN_CONNECTIVITY_ALGO::Build( BOARD* ) searches the connections of all the items at once
+ * in a CN_STORE, which holds them in index-based arrays and a CSR adjacency.
+ */
 class CN_ITEM : public INTRUSIVE_LIST<CN_ITEM>
 {
 public:
-    using CONNECTED_ITEMS = std::set<CN_ITEM*>;
+    using CONNECTED_ITEMS = std::vector<CN_ITEM*>;
 
 private:
     BOARD_CONNECTED_ITEM* m_parent;
 
-    ///> list of items physically connected (touching)
+    ///> list of items physically connected (touching), sorted once the search is done
     CONNECTED_ITEMS m_connected;
 
     CN_ANCHORS m_anchors;
@@ -181,6 +188,9 @@ private:
     ///> mutex protecting this item's connected_items set to allow parallel connection threads
     std::mutex m_listLock;
 
+    ///> net of the ratsnest cluster the item was last put in, -1 if none
+    int m_clusterNet;
+
 protected:
     ///> dirty flag, used to identify recently added item not yet scanned into the connectivity search
     bool m_dirty;
@@ -201,6 +211,7 @@ public:
         m_visited = false;
         m_valid = true;
         m_dirty = true;
+        m_clusterNet = -1;
         m_anchors.reserve( 2 );
         m_layers = LAYER_RANGE( 0, PCB_LAYER_ID_COUNT );
     }
@@ -317,10 +328,46 @@ public:
         return m_canChangeNet;
     }
 
+    void SetClusterNet( int aNet )
+    {
+        m_clusterNet = aNet;
+    }
+
+    int ClusterNet() const
+    {
+        return m_clusterNet;
+    }
+
     void Connect( CN_ITEM* b )
     {
         std::lock_guard<std::mutex> lock( m_listLock );
-        m_connected.insert( b );
+        m_connected.push_back( b );
+    }
+
+    /**
+     * Function SortConnections()
+     * Sorts the connected items and removes the duplicates Connect() may have added.
+     * Not thread safe: call it once the connection search is done.
+     */
+    void SortConnections()
+    {
+        if( m_connected.size() < 2 )
+            return;
+
+        std::sort( m_connected.begin(), m_connected.end() );
+        m_connected.erase( std::unique( m_connected.begin(), m_connected.end() ),
+                           m_connected.end() );
+    }
+
+    /**
+     * Function SetConnections()
+     * Replaces the connected items with aItems, for the searches done outside of the item.
+     * Not thread safe.
+     */
+    void SetConnections( const CONNECTED_ITEMS& aItems )
+    {
+        m_connected = aItems;
+        SortConnections();
     }
 
     void RemoveInvalidRefs();
@@ -414,6 +461,11 @@ public:
         m_index.RemoveAll();
     }
 
+    void Reserve( size_t aSize )
+    {
+        m_items.reserve( aSize );
+    }
+
     using ITER = decltype(m_items)::iterator;
 
     ITER begin() { return m_items.begin(); };
@@ -0,0 +1,283 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <connectivity/connectivity_store.h>
+#include <connectivity/connectivity_algo.h>
+#include <widgets/progress_reporter.h>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+
+
+size_t CN_ARENA::Capacity() const
+{
+    size_t capacity = 0;
+
+    for( const auto& block : m_blocks )
+        capacity += block.m_size;
+
+    return capacity;
+}
+
+
+void* CN_ARENA::allocBytes( size_t aSize, size_t aAlign )
+{
+    // Blocks too small for the array are skipped, and stay available after a Reset()
+    for( ; m_current < m_blocks.size(); m_current++, m_offset = 0 )
+    {
+        const BLOCK& block = m_blocks[m_current];
+        size_t       start = ( m_offset + aAlign - 1 ) / aAlign * aAlign;
+
+        if( start + aSize <= block.m_size )
+        {
+            m_offset = start + aSize;
+            return block.m_data.get() + start;
+        }
+    }
+
+    // operator new[] aligns the block for any fundamental type
+    BLOCK block;
+    block.m_size = aSize > MIN_BLOCK_SIZE ? aSize : MIN_BLOCK_SIZE;
+    block.m_data.reset( new char[block.m_size] );
+
+    m_blocks.push_back( std::move( block ) );
+    m_current = m_blocks.size() - 1;
+    m_offset = aSize;
+
+    return m_blocks.back().m_data.get();
+}
+
+
+void CN_STORE::Clear()
+{
+    m_arena.Reset();
+
+    m_itemCount = 0;
+    m_items = nullptr;
+    m_extents = nullptr;
+    m_anchorOffsets = nullptr;
+    m_anchors = nullptr;
+    m_offsets = nullptr;
+    m_neighbours = nullptr;
+}
+
+
+void CN_STORE::Build( CN_LIST& aList, PROGRESS_REPORTER* aReporter )
+{
+    Clear();
+    fillItems( aList );
+
+    if( aReporter )
+    {
+        aReporter->SetMaxProgress( m_itemCount );
+        aReporter->KeepRefreshing();
+    }
+
+    searchConnections( aReporter );
+}
+
+
+void CN_STORE::fillItems( CN_LIST& aList )
+{
+    int count = 0;
+
+    for( auto item : aList )
+    {
+        if( item->Valid() )
+            count++;
+    }
+
+    CN_ITEM** items = m_arena.Alloc<CN_ITEM*>( count );
+    EXTENT*   extents = m_arena.Alloc<EXTENT>( count );
+    int*      order = m_arena.Alloc<int>( count );
+    int       anchorCount = 0;
+
+    for( auto item : aList )
+    {
+        if( !item->Valid() )
+            continue;
+
+        const BOX2I&       bbox = item->BBox();
+        const LAYER_RANGE& layers = item->Layers();
+
+        items[m_itemCount] = item;
+        extents[m_itemCount] = { bbox.GetX(), bbox.GetY(), bbox.GetRight(), bbox.GetBottom(),
+                                 layers.Start(), layers.End() };
+        order[m_itemCount] = m_itemCount;
+        anchorCount += item->Anchors().size();
+        m_itemCount++;
+    }
+
+    std::sort( order, order + count, [extents]( int a, int b )
+            {
+                if( extents[a].m_xMin != extents[b].m_xMin )
+                    return extents[a].m_xMin < extents[b].m_xMin;
+
+                return a < b;
+            } );
+
+    m_items = m_arena.Alloc<CN_ITEM*>( count );
+    m_extents = m_arena.Alloc<EXTENT>( count );
+    m_anchorOffsets = m_arena.Alloc<int>( count + 1 );
+    m_anchors = m_arena.Alloc<VECTOR2I>( anchorCount );
+
+    int anchor = 0;
+
+    for( int i = 0; i < count; i++ )
+    {
+        m_items[i] = items[order[i]];
+        m_extents[i] = extents[order[i]];
+        m_anchorOffsets[i] = anchor;
+
+        for( const auto& itemAnchor : m_items[i]->Anchors() )
+            m_anchors[anchor++] = itemAnchor->Pos();
+    }
+
+    m_anchorOffsets[count] = anchor;
+}
+
+
+bool CN_STORE::touch( int aItemA, int aItemB ) const
+{
+    const int firstA = m_anchorOffsets[aItemA];
+    const int firstB = m_anchorOffsets[aItemB];
+
+    return CN_VISITOR::Touch( m_items[aItemA], m_anchors + firstA,
+                              m_anchorOffsets[aItemA + 1] - firstA,
+                              m_items[aItemB], m_anchors + firstB,
+                              m_anchorOffsets[aItemB + 1] - firstB );
+}
+
+
+void CN_STORE::searchConnections( PROGRESS_REPORTER* aReporter )
+{
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+            ( m_itemCount + 7 ) / 8 );
+
+    parallelThreadCount = std::max<size_t>( parallelThreadCount, 1 );
+
+    std::vector<std::vector<std::pair<int, int>>> edges( parallelThreadCount );
+    std::atomic<int> nextItem( 0 );
+
+    auto search_lambda = [this, &edges, &nextItem, aReporter]( size_t aThread ) -> size_t
+    {
+        auto& threadEdges = edges[aThread];
+
+        for( int i = nextItem++; i < m_itemCount; i = nextItem++ )
+        {
+            const EXTENT& a = m_extents[i];
+
+            // The items are sorted by m_xMin: those overlapping item i along x are the
+            // following ones, up to the first one starting right of it.  Each pair is
+            // tested once, by its leftmost item.
+            for( int j = i + 1; j < m_itemCount && m_extents[j].m_xMin <= a.m_xMax; j++ )
+            {
+                const EXTENT& b = m_extents[j];
+
+                if( b.m_yMin > a.m_yMax || b.m_yMax < a.m_yMin )
+                    continue;
+
+                if( b.m_layerStart > a.m_layerEnd || b.m_layerEnd < a.m_layerStart )
+                    continue;
+
+                if( touch( i, j ) )
+                    threadEdges.emplace_back( i, j );
+            }
+
+            if( aReporter )
+                aReporter->AdvanceProgress();
+        }
+
+        return 1;
+    };
+
+    if( parallelThreadCount <= 1 )
+        search_lambda( 0 );
+    else
+    {
+        std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii] = std::async( std::launch::async, search_lambda, ii );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        {
+            // Here we balance returns with a 100ms timeout to allow UI updating
+            std::future_status status;
+            do
+            {
+                if( aReporter )
+                    aReporter->KeepRefreshing();
+
+                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
+            } while( status != std::future_status::ready );
+        }
+    }
+
+    // Count the neighbours of each item, then turn the counts into row offsets
+    m_offsets = m_arena.Alloc<int>( m_itemCount + 1 );
+
+    for( const auto& threadEdges : edges )
+    {
+        for( const auto& edge : threadEdges )
+        {
+            m_offsets[edge.first + 1]++;
+            m_offsets[edge.second + 1]++;
+        }
+    }
+
+    for( int i = 0; i < m_itemCount; i++ )
+        m_offsets[i + 1] += m_offsets[i];
+
+    int* next = m_arena.Alloc<int>( m_itemCount );
+
+    std::copy( m_offsets, m_offsets + m_itemCount, next );
+    m_neighbours = m_arena.Alloc<int>( m_offsets[m_itemCount] );
+
+    for( const auto& threadEdges : edges )
+    {
+        for( const auto& edge : threadEdges )
+        {
+            m_neighbours[next[edge.first]++] = edge.second;
+            m_neighbours[next[edge.second]++] = edge.first;
+        }
+    }
+}
+
+
+void CN_STORE::ApplyConnections()
+{
+    CN_ITEM::CONNECTED_ITEMS connected;
+
+    for( int i = 0; i < m_itemCount; i++ )
+    {
+        connected.clear();
+
+        for( const int* n = NeighboursBegin( i ); n != NeighboursEnd( i ); ++n )
+            connected.push_back( m_items[*n] );
+
+        m_items[i]->SetConnections( connected );
+    }
+}
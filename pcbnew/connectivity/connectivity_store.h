@@ -0,0 +1,208 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef PCBNEW_CONNECTIVITY_STORE_H_
+#define PCBNEW_CONNECTIVITY_STORE_H_
+
+#include <math/vector2d.h>
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+class CN_ITEM;
+class CN_LIST;
+class PROGRESS_REPORTER;
+
+
+/**
+ * Class CN_ARENA
+ * Bump allocator for the arrays of a single build.  The arrays are never freed one by one:
+ * Reset() makes the whole arena available again while keeping its blocks, and the blocks
+ * are freed with the arena.  Only trivially destructible types can be allocated.
+ */
+class CN_ARENA
+{
+public:
+    CN_ARENA() {}
+
+    CN_ARENA( const CN_ARENA& ) = delete;
+    CN_ARENA& operator=( const CN_ARENA& ) = delete;
+
+    /**
+     * Function Alloc()
+     * Returns an array of aCount value-initialized elements, valid until the next Reset().
+     */
+    template <class T>
+    T* Alloc( size_t aCount )
+    {
+        static_assert( std::is_trivially_destructible<T>::value,
+                       "the arena does not run destructors" );
+
+        T* array = static_cast<T*>( allocBytes( aCount * sizeof( T ), alignof( T ) ) );
+
+        for( size_t i = 0; i < aCount; i++ )
+            new( array + i ) T();
+
+        return array;
+    }
+
+    /**
+     * Function Reset()
+     * Releases all the arrays, keeping the blocks for the next build.
+     */
+    void Reset()
+    {
+        m_current = 0;
+        m_offset = 0;
+    }
+
+    /**
+     * Function Capacity()
+     * Returns the size in bytes of the blocks held by the arena.
+     */
+    size_t Capacity() const;
+
+private:
+    void* allocBytes( size_t aSize, size_t aAlign );
+
+    struct BLOCK
+    {
+        std::unique_ptr<char[]> m_data;
+        size_t                  m_size;
+    };
+
+    ///> smallest block allocated, larger arrays get a block of their own size
+    static const size_t MIN_BLOCK_SIZE = 1 << 20;
+
+    std::vector<BLOCK> m_blocks;
+    size_t             m_current = 0;     ///< block the next array is taken from
+    size_t             m_offset = 0;      ///< first free byte of the current block
+};
+
+
+/**
+ * Class CN_STORE
+ * Index-based snapshot of the connectivity items, used to search the connections of a
+ * whole board at once.
+ *
+ * The items are numbered by their position in flat arrays, sorted by the left edge of their
+ * bounding box.  Their extents and anchors are stored by value in those arrays, so the
+ * search sweeps the sorted extents instead of querying the R-tree of CN_LIST once per item.
+ * The connections found are stored as a CSR adjacency: the neighbours of the item i are
+ * m_neighbours[ m_offsets[i] ] to m_neighbours[ m_offsets[i + 1] - 1 ].  All the arrays
+ * live in a CN_ARENA, so a build makes a handful of allocations whatever the item count.
+ */
+class CN_STORE
+{
+public:
+    CN_STORE() {}
+
+    /**
+     * Function Build()
+     * Copies the valid items of aList to the arrays and searches their connections.
+     * The items of aList must not change until ApplyConnections() is called.
+     */
+    void Build( CN_LIST& aList, PROGRESS_REPORTER* aReporter = nullptr );
+
+    /**
+     * Function ApplyConnections()
+     * Replaces the connected items of each item of the store with its neighbours.
+     */
+    void ApplyConnections();
+
+    /**
+     * Function Clear()
+     * Empties the store, keeping the arena blocks for the next Build().
+     */
+    void Clear();
+
+    int ItemCount() const
+    {
+        return m_itemCount;
+    }
+
+    int AnchorCount() const
+    {
+        return m_itemCount ? m_anchorOffsets[m_itemCount] : 0;
+    }
+
+    ///> Returns the count of connections, counted once for each of the two items
+    int ConnectionCount() const
+    {
+        return m_itemCount ? m_offsets[m_itemCount] : 0;
+    }
+
+    CN_ITEM* Item( int aIndex ) const
+    {
+        return m_items[aIndex];
+    }
+
+    const int* NeighboursBegin( int aIndex ) const
+    {
+        return m_neighbours + m_offsets[aIndex];
+    }
+
+    const int* NeighboursEnd( int aIndex ) const
+    {
+        return m_neighbours + m_offsets[aIndex + 1];
+    }
+
+    ///> Returns the memory held by the store, in bytes
+    size_t MemoryUsage() const
+    {
+        return m_arena.Capacity();
+    }
+
+private:
+    ///> Bounding box and layer range of an item, as indexed by CN_RTREE
+    struct EXTENT
+    {
+        int m_xMin;
+        int m_yMin;
+        int m_xMax;
+        int m_yMax;
+        int m_layerStart;
+        int m_layerEnd;
+    };
+
+    void fillItems( CN_LIST& aList );
+
+    void searchConnections( PROGRESS_REPORTER* aReporter );
+
+    bool touch( int aItemA, int aItemB ) const;
+
+    CN_ARENA m_arena;
+
+    int       m_itemCount = 0;
+    CN_ITEM** m_items = nullptr;            ///< items, sorted by m_xMin
+    EXTENT*   m_extents = nullptr;          ///< extent of each item
+    int*      m_anchorOffsets = nullptr;    ///< first anchor of each item, and the anchor count
+    VECTOR2I* m_anchors = nullptr;          ///< anchor positions, grouped by item
+    int*      m_offsets = nullptr;          ///< first neighbour of each item, and the total
+    int*      m_neighbours = nullptr;       ///< neighbour item indices, by row
+};
+
+
+#endif /* PCBNEW_CONNECTIVITY_STORE_H_ */
@@ -0,0 +1,323 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <class_track.h>
+#include <connectivity/dynamic_ratsnest.h>
+#include <connectivity/connectivity_algo.h>
+#include <ratsnest_data.h>
+
+
+DYNAMIC_RATSNEST::DYNAMIC_RATSNEST() :
+        m_lines( std::make_shared<const LINES>() ),
+        m_generation( 0 ),
+        m_publishedGeneration( 0 ),
+        m_quit( false )
+{
+    m_worker = std::thread( &DYNAMIC_RATSNEST::workerLoop, this );
+}
+
+
+DYNAMIC_RATSNEST::~DYNAMIC_RATSNEST()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_jobLock );
+        m_quit = true;
+    }
+
+    m_jobReady.notify_one();
+    m_worker.join();
+}
+
+
+bool DYNAMIC_RATSNEST::IsSnapshotOf( const std::vector<BOARD_ITEM*>& aItems ) const
+{
+    return m_snapshot && m_snapshot->m_items == aItems;
+}
+
+
+void DYNAMIC_RATSNEST::Snapshot( const std::vector<BOARD_ITEM*>& aItems, CONNECTIVITY_DATA& aBoard,
+                                 CONNECTIVITY_DATA& aMoving )
+{
+    auto snapshot = std::make_shared<SNAPSHOT>();
+    std::unordered_map<const CN_ANCHOR*, int> anchorIndex;
+
+    snapshot->m_items = aItems;
+
+    for( unsigned int nc = 0; nc < aMoving.m_nets.size(); nc++ )
+    {
+        const RN_NET* dynNet = aMoving.m_nets[nc];
+
+        if( !dynNet || dynNet->GetNodeCount() == 0 )
+            continue;
+
+        const RN_NET* ourNet = nc > 0 && nc < aBoard.m_nets.size() ? aBoard.m_nets[nc] : nullptr;
+        NET_TARGETS   targets;
+
+        targets.m_net = nc;
+
+        for( const CN_ANCHOR_PTR& node : dynNet->GetAllNodes() )
+        {
+            CN_ITEM*   cnItem = node->Item();
+            ANCHOR_REF ref = { node->Parent(), 0, (int) nc };
+
+            if( cnItem->Parent()->Type() == PCB_ZONE_AREA_T )
+            {
+                ref.m_index = static_cast<CN_ZONE*>( cnItem )->SubpolyIndex();
+            }
+            else
+            {
+                const auto& anchors = cnItem->Anchors();
+                auto        it = std::find( anchors.begin(), anchors.end(), node );
+
+                ref.m_index = it - anchors.begin();
+            }
+
+            targets.m_anchors.push_back( snapshot->m_anchors.size() );
+            anchorIndex[node.get()] = snapshot->m_anchors.size();
+            snapshot->m_anchors.push_back( ref );
+        }
+
+        // The board anchors of the moving items are blocked, so they are never targets
+        if( ourNet )
+        {
+            for( const CN_ANCHOR_PTR& node : ourNet->GetAllNodes() )
+            {
+                if( !node->GetNoLine() )
+                    targets.m_targets.push_back( node->Pos() );
+            }
+
+            std::sort( targets.m_targets.begin(), targets.m_targets.end(),
+                    []( const VECTOR2I& aA, const VECTOR2I& aB ) { return aA.x < aB.x; } );
+        }
+
+        if( !targets.m_targets.empty() )
+            snapshot->m_nets.push_back( std::move( targets ) );
+    }
+
+    // The ratsnest between the moving items does not change while they move together
+    for( unsigned int nc = 0; nc < aMoving.m_nets.size(); nc++ )
+    {
+        const RN_NET* dynNet = aMoving.m_nets[nc];
+
+        if( !dynNet )
+            continue;
+
+        for( const CN_EDGE& edge : dynNet->GetUnconnected() )
+        {
+            snapshot->m_internalEdges.emplace_back( anchorIndex[edge.GetSourceNode().get()],
+                                                    anchorIndex[edge.GetTargetNode().get()] );
+        }
+    }
+
+    m_snapshot = snapshot;
+}
+
+
+VECTOR2I DYNAMIC_RATSNEST::anchorPosition( const ANCHOR_REF& aAnchor )
+{
+    switch( aAnchor.m_item->Type() )
+    {
+    case PCB_PAD_T:
+        return static_cast<const D_PAD*>( aAnchor.m_item )->ShapePos();
+
+    case PCB_TRACE_T:
+    {
+        auto track = static_cast<const TRACK*>( aAnchor.m_item );
+        return aAnchor.m_index == 0 ? track->GetStart() : track->GetEnd();
+    }
+
+    case PCB_VIA_T:
+        return static_cast<const VIA*>( aAnchor.m_item )->GetStart();
+
+    case PCB_ZONE_AREA_T:
+    {
+        const auto& polys = static_cast<const ZONE_CONTAINER*>( aAnchor.m_item )
+                                    ->GetFilledPolysList();
+
+        if( aAnchor.m_index < polys.OutlineCount()
+                && polys.COutline( aAnchor.m_index ).PointCount() > 0 )
+            return polys.COutline( aAnchor.m_index ).CPoint( 0 );
+
+        return aAnchor.m_item->GetPosition();
+    }
+
+    default:
+        return aAnchor.m_item->GetPosition();
+    }
+}
+
+
+void DYNAMIC_RATSNEST::Update()
+{
+    if( !m_snapshot )
+        return;
+
+    std::unique_ptr<JOB> job( new JOB );
+
+    job->m_snapshot = m_snapshot;
+    job->m_positions.reserve( m_snapshot->m_anchors.size() );
+
+    for( const ANCHOR_REF& anchor : m_snapshot->m_anchors )
+        job->m_positions.push_back( anchorPosition( anchor ) );
+
+    {
+        std::lock_guard<std::mutex> lock( m_jobLock );
+
+        job->m_generation = ++m_generation;
+
+        // Replaces the update the worker did not start yet, if any
+        m_pendingJob = std::move( job );
+    }
+
+    m_jobReady.notify_one();
+}
+
+
+void DYNAMIC_RATSNEST::Hide()
+{
+    std::lock_guard<std::mutex> lock( m_jobLock );
+
+    m_pendingJob.reset();
+    m_publishedGeneration = ++m_generation;
+    std::atomic_store( &m_lines, std::make_shared<const LINES>() );
+}
+
+
+void DYNAMIC_RATSNEST::Invalidate()
+{
+    Hide();
+    m_snapshot.reset();
+}
+
+
+bool DYNAMIC_RATSNEST::IsUpToDate() const
+{
+    std::lock_guard<std::mutex> lock( m_jobLock );
+
+    return m_publishedGeneration == m_generation;
+}
+
+
+void DYNAMIC_RATSNEST::computeLines( const JOB& aJob, LINES& aLines )
+{
+    const SNAPSHOT& snapshot = *aJob.m_snapshot;
+
+    for( const NET_TARGETS& net : snapshot.m_nets )
+    {
+        const std::vector<VECTOR2I>& targets = net.m_targets;
+
+        VECTOR2I::extended_type bestDist = VECTOR2I::ECOORD_MAX;
+        VECTOR2I                bestA, bestB;
+
+        for( int anchor : net.m_anchors )
+        {
+            const VECTOR2I& pos = aJob.m_positions[anchor];
+
+            // Walk the targets from the anchor's x outwards, until they are further away in x
+            // than the best target found so far
+            auto mid = std::lower_bound( targets.begin(), targets.end(), pos,
+                    []( const VECTOR2I& aTarget, const VECTOR2I& aPos ) {
+                        return aTarget.x < aPos.x;
+                    } );
+
+            auto visit = [&]( const VECTOR2I& aTarget ) -> bool
+            {
+                VECTOR2I::extended_type dx = (VECTOR2I::extended_type) aTarget.x - pos.x;
+
+                if( dx * dx >= bestDist )
+                    return false;
+
+                VECTOR2I::extended_type dist = ( aTarget - pos ).SquaredEuclideanNorm();
+
+                if( dist < bestDist )
+                {
+                    bestDist = dist;
+                    bestA = aTarget;
+                    bestB = pos;
+                }
+
+                return true;
+            };
+
+            for( auto it = mid; it != targets.end() && visit( *it ); ++it )
+                ;
+
+            for( auto it = mid; it != targets.begin() && visit( *( it - 1 ) ); --it )
+                ;
+        }
+
+        if( bestDist != VECTOR2I::ECOORD_MAX )
+        {
+            RN_DYNAMIC_LINE l;
+            l.a = bestA;
+            l.b = bestB;
+            l.netCode = net.m_net;
+
+            aLines.push_back( l );
+        }
+    }
+
+    for( const auto& edge : snapshot.m_internalEdges )
+    {
+        RN_DYNAMIC_LINE l;
+        l.a = aJob.m_positions[edge.first];
+        l.b = aJob.m_positions[edge.second];
+        l.netCode = 0;
+
+        aLines.push_back( l );
+    }
+}
+
+
+void DYNAMIC_RATSNEST::workerLoop()
+{
+    std::unique_lock<std::mutex> lock( m_jobLock );
+
+    while( true )
+    {
+        m_jobReady.wait( lock, [this]() { return m_quit || m_pendingJob; } );
+
+        if( m_quit )
+            return;
+
+        std::unique_ptr<JOB> job = std::move( m_pendingJob );
+
+        lock.unlock();
+
+        auto lines = std::make_shared<LINES>();
+        computeLines( *job, *lines );
+
+        lock.lock();
+
+        // A newer update may be pending, but publishing this one still shows progress.  Do
+        // not publish if the lines were hidden in the meantime.
+        if( job->m_generation > m_publishedGeneration )
+        {
+            m_publishedGeneration = job->m_generation;
+            std::atomic_store( &m_lines, std::shared_ptr<const LINES>( lines ) );
+        }
+    }
+}
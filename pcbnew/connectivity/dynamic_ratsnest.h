@@ -0,0 +1,161 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __DYNAMIC_RATSNEST_H
+#define __DYNAMIC_RATSNEST_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <connectivity/connectivity_data.h>
+
+class BOARD_ITEM;
+class BOARD_CONNECTED_ITEM;
+
+/**
+ * Class DYNAMIC_RATSNEST
+ * Computes the ratsnest lines of items being moved on a persistent worker thread.
+ *
+ * When a drag starts, Snapshot() records what does not change while the items move: the
+ * ratsnest targets of the rest of the board, per net, and the ratsnest between the moving
+ * items themselves (it is invariant under a rigid move).  Each Update() then only reads the
+ * current positions of the moving anchors and posts them to the worker, which finds the
+ * nearest target of each net.  Updates posted while the worker is busy are coalesced: only
+ * the latest one is computed.  The result is published atomically, so it can be drawn
+ * without taking any lock.
+ *
+ * Snapshot() and Update() read board items and must be called from the UI thread; the
+ * worker only reads the copies they make.
+ */
+class DYNAMIC_RATSNEST
+{
+public:
+    using LINES = std::vector<RN_DYNAMIC_LINE>;
+
+    DYNAMIC_RATSNEST();
+    ~DYNAMIC_RATSNEST();
+
+    /**
+     * Function IsSnapshotOf()
+     * @return true if the current snapshot was taken for the items aItems.
+     */
+    bool IsSnapshotOf( const std::vector<BOARD_ITEM*>& aItems ) const;
+
+    /**
+     * Function Snapshot()
+     * Records the moving items aItems, the connectivity aMoving computed for them alone,
+     * and the ratsnest targets of the board connectivity aBoard.
+     */
+    void Snapshot( const std::vector<BOARD_ITEM*>& aItems, CONNECTIVITY_DATA& aBoard,
+                   CONNECTIVITY_DATA& aMoving );
+
+    /**
+     * Function Update()
+     * Reads the current positions of the moving items and posts them to the worker.
+     */
+    void Update();
+
+    /**
+     * Function Hide()
+     * Publishes an empty set of lines, and drops the updates not computed yet.
+     */
+    void Hide();
+
+    /**
+     * Function Invalidate()
+     * Hides the lines and drops the snapshot, e.g. when the board connectivity changed.
+     */
+    void Invalidate();
+
+    /**
+     * Function GetLines()
+     * Returns the last published lines.  Safe to call from any thread.
+     */
+    std::shared_ptr<const LINES> GetLines() const
+    {
+        return std::atomic_load( &m_lines );
+    }
+
+    /**
+     * Function IsUpToDate()
+     * @return true if the lines of the last update are published.
+     */
+    bool IsUpToDate() const;
+
+private:
+    ///> A moving anchor: the item owning it, and which of its anchors it is
+    struct ANCHOR_REF
+    {
+        const BOARD_CONNECTED_ITEM* m_item;
+        int                         m_index;
+        int                         m_net;
+    };
+
+    ///> The ratsnest targets of a net that are not moving, sorted by x
+    struct NET_TARGETS
+    {
+        int                   m_net;
+        std::vector<VECTOR2I> m_targets;
+        std::vector<int>      m_anchors;    ///> Indices of the moving anchors of the net
+    };
+
+    struct SNAPSHOT
+    {
+        std::vector<BOARD_ITEM*>         m_items;
+        std::vector<ANCHOR_REF>          m_anchors;
+        std::vector<NET_TARGETS>         m_nets;
+        std::vector<std::pair<int, int>> m_internalEdges;
+    };
+
+    struct JOB
+    {
+        std::shared_ptr<const SNAPSHOT> m_snapshot;
+        std::vector<VECTOR2I>           m_positions;
+        int                             m_generation;
+    };
+
+    static VECTOR2I anchorPosition( const ANCHOR_REF& aAnchor );
+
+    static void computeLines( const JOB& aJob, LINES& aLines );
+
+    void workerLoop();
+
+    std::shared_ptr<const SNAPSHOT> m_snapshot;
+
+    std::shared_ptr<const LINES>    m_lines;
+
+    ///> Worker state, protected by m_jobLock
+    mutable std::mutex              m_jobLock;
+    std::condition_variable         m_jobReady;
+    std::unique_ptr<JOB>            m_pendingJob;
+    int                             m_generation;
+    int                             m_publishedGeneration;
+    bool                            m_quit;
+
+    std::thread                     m_worker;
+};
+
+#endif // __DYNAMIC_RATSNEST_H
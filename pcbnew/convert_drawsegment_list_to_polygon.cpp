@@ -703,7 +703,7 @@ bool ConvertOutlineToPolygon( std::vector<DRAWSEGMENT*>& aSegList, SHAPE_POLY_SE
     // All of the silliness that follows is to work around the segment iterator
     // while checking for collisions.
     // TODO: Implement proper segment and point iterators that follow std
-    for( auto seg1 = aPolygons.IterateSegmentsWithHoles(); seg1; seg1++ )
+    for( auto seg1 = aPolygons.CIterateSegmentsWithHoles(); seg1; seg1++ )
     {
         auto seg2 = seg1;
 
@@ -0,0 +1,213 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+#include <drc/drc_copper_index.h>
+
+#include <algorithm>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <convert_to_biu.h>
+
+
+DRC_COPPER_INDEX::DRC_COPPER_INDEX() :
+        m_removedCount( 0 ),
+        m_maxClearance( 0 )
+{
+}
+
+
+void DRC_COPPER_INDEX::Clear()
+{
+    m_tracks.clear();
+    m_pads.clear();
+    m_trackEntries.clear();
+    m_padEntries.clear();
+    m_trackSlots.clear();
+    m_padSlots.clear();
+    m_removedCount = 0;
+    m_trackTree.RemoveAll();
+    m_padTree.RemoveAll();
+    m_maxClearance = 0;
+}
+
+
+void DRC_COPPER_INDEX::Build( BOARD* aBoard )
+{
+    Clear();
+
+    for( TRACK* track : aBoard->Tracks() )
+        insertTrack( track );
+
+    for( MODULE* mod : aBoard->Modules() )
+        Insert( mod );
+}
+
+
+void DRC_COPPER_INDEX::insertTrack( TRACK* aTrack )
+{
+    ENTRY  entry = { aTrack->GetBoundingBox(), aTrack->GetLayerSet() };
+    size_t idx = m_tracks.size();
+
+    m_maxClearance = std::max( m_maxClearance, aTrack->GetNetClass()->GetClearance() );
+    m_maxClearance = std::max( m_maxClearance, aTrack->GetClearance() );
+
+    m_tracks.push_back( aTrack );
+    m_trackEntries.push_back( entry );
+    m_trackSlots[aTrack] = idx;
+    m_trackTree.Insert( entry.m_BBox, entry.m_Layers, idx );
+}
+
+
+void DRC_COPPER_INDEX::insertPad( D_PAD* aPad )
+{
+    EDA_RECT bbox( aPad->ShapePos(), wxSize( 0, 0 ) );
+    bbox.Inflate( aPad->GetBoundingRadius() );
+
+    EDA_RECT holeBox( aPad->GetPosition(), wxSize( 0, 0 ) );
+    holeBox.Inflate( std::max( aPad->GetDrillSize().x, aPad->GetDrillSize().y ) / 2 );
+    bbox.Merge( holeBox );
+
+    LSET   layers = aPad->GetDrillSize().x ? LSET::AllCuMask() : aPad->GetLayerSet();
+    ENTRY  entry = { bbox, layers };
+    size_t idx = m_pads.size();
+
+    m_maxClearance = std::max( m_maxClearance, aPad->GetClearance() );
+
+    m_pads.push_back( aPad );
+    m_padEntries.push_back( entry );
+    m_padSlots[aPad->GetParent()].push_back( idx );
+    m_padTree.Insert( entry.m_BBox, entry.m_Layers, idx );
+}
+
+
+void DRC_COPPER_INDEX::Insert( BOARD_ITEM* aItem )
+{
+    switch( aItem->Type() )
+    {
+    case PCB_TRACE_T:
+    case PCB_VIA_T:
+        Remove( aItem );
+        insertTrack( static_cast<TRACK*>( aItem ) );
+        break;
+
+    case PCB_MODULE_T:
+        Remove( aItem );
+
+        // Footprints without pads are counted too, see GetFootprintCount()
+        m_padSlots[aItem];
+
+        for( D_PAD* pad : static_cast<MODULE*>( aItem )->Pads() )
+            insertPad( pad );
+
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+void DRC_COPPER_INDEX::Remove( const BOARD_ITEM* aItem )
+{
+    auto track = m_trackSlots.find( aItem );
+
+    if( track != m_trackSlots.end() )
+    {
+        const ENTRY& entry = m_trackEntries[track->second];
+
+        m_trackTree.Remove( entry.m_BBox, entry.m_Layers, track->second );
+        m_tracks[track->second] = nullptr;
+        m_trackSlots.erase( track );
+        m_removedCount++;
+        return;
+    }
+
+    auto pads = m_padSlots.find( aItem );
+
+    if( pads != m_padSlots.end() )
+    {
+        for( size_t idx : pads->second )
+        {
+            m_padTree.Remove( m_padEntries[idx].m_BBox, m_padEntries[idx].m_Layers, idx );
+            m_pads[idx] = nullptr;
+            m_removedCount++;
+        }
+
+        m_padSlots.erase( pads );
+    }
+}
+
+
+int DRC_COPPER_INDEX::GetSearchMargin() const
+{
+    // Item bounding boxes already include half the item width; pad shapes converted to
+    // polygons can be a little larger than their bounding radius, hence the extra margin.
+    return m_maxClearance + Millimeter2iu( 0.01 );
+}
+
+
+void DRC_COPPER_INDEX::QueryTracks( const BOX2I& aArea, LSET aLayers,
+                                    std::vector<TRACK*>& aResult, size_t aFirst )
+{
+    std::vector<size_t> hits;
+
+    auto visitor = [&]( size_t aIdx ) -> bool
+    {
+        if( aIdx >= aFirst )
+            hits.push_back( aIdx );
+
+        return true;
+    };
+
+    m_trackTree.Query( aArea, aLayers, visitor );
+    std::sort( hits.begin(), hits.end() );
+
+    aResult.clear();
+
+    for( size_t idx : hits )
+        aResult.push_back( m_tracks[idx] );
+}
+
+
+void DRC_COPPER_INDEX::QueryPads( const BOX2I& aArea, LSET aLayers, std::vector<D_PAD*>& aResult )
+{
+    std::vector<size_t> hits;
+
+    auto visitor = [&]( size_t aIdx ) -> bool
+    {
+        hits.push_back( aIdx );
+        return true;
+    };
+
+    m_padTree.Query( aArea, aLayers, visitor );
+    std::sort( hits.begin(), hits.end() );
+
+    aResult.clear();
+
+    for( size_t idx : hits )
+        aResult.push_back( m_pads[idx] );
+}
@@ -0,0 +1,178 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+#ifndef DRC_COPPER_INDEX__H
+#define DRC_COPPER_INDEX__H
+
+#include <vector>
+#include <unordered_map>
+
+#include <drc/drc_rtree.h>
+
+class BOARD;
+class BOARD_ITEM;
+class TRACK;
+class D_PAD;
+
+
+/**
+ * Spatial index of the copper items of a board (tracks, vias and pads), built once per
+ * DRC run and shared by the clearance tests.
+ *
+ * Queries return items in board order (tracks in BOARD::Tracks() order, pads in
+ * footprint order), so a test that walks the candidates reports its markers in the same
+ * order as a test that walks the whole board.
+ *
+ * The index holds plain pointers: once the board has been edited, it must be rebuilt (or
+ * cleared), or the edited items must be removed and inserted again.  Items inserted after
+ * Build() come after the other ones in query results, and removed items leave a null
+ * entry in Tracks() or Pads().
+ */
+class DRC_COPPER_INDEX
+{
+public:
+    DRC_COPPER_INDEX();
+
+    /**
+     * Index all tracks, vias and pads of aBoard
+     */
+    void Build( BOARD* aBoard );
+
+    void Clear();
+
+    bool IsEmpty() const
+    {
+        return m_tracks.empty() && m_pads.empty();
+    }
+
+    /**
+     * Index aItem: a track or via, or the pads of a footprint.  Other items are ignored.
+     * An item already in the index is moved to its new place.
+     */
+    void Insert( BOARD_ITEM* aItem );
+
+    /**
+     * Remove aItem from the index: a track or via, or the pads of a footprint.  aItem is
+     * only compared to the indexed items, so it may have been deleted since it was
+     * inserted.
+     */
+    void Remove( const BOARD_ITEM* aItem );
+
+    /**
+     * @return true if more entries of Tracks() and Pads() were removed than are left, i.e.
+     * the index is worth rebuilding.
+     */
+    bool IsFragmented() const
+    {
+        return 2 * m_removedCount > m_tracks.size() + m_pads.size();
+    }
+
+    /**
+     * @return the number of tracks and vias in the index, removed ones excepted
+     */
+    size_t GetTrackCount() const
+    {
+        return m_trackSlots.size();
+    }
+
+    /**
+     * @return the number of footprints whose pads are in the index
+     */
+    size_t GetFootprintCount() const
+    {
+        return m_padSlots.size();
+    }
+
+    const std::vector<TRACK*>& Tracks() const
+    {
+        return m_tracks;
+    }
+
+    const std::vector<D_PAD*>& Pads() const
+    {
+        return m_pads;
+    }
+
+    /**
+     * @return the largest clearance of any indexed item.  Inflating a query area by this
+     * value (see GetSearchMargin()) finds every item that can be in conflict with it.
+     * Removed items are still accounted for.
+     */
+    int GetMaxClearance() const
+    {
+        return m_maxClearance;
+    }
+
+    /**
+     * @return the max clearance, plus a small margin for shapes converted to polygons
+     */
+    int GetSearchMargin() const;
+
+    /**
+     * Find the tracks and vias whose bounding box (which includes their width) intersects
+     * aArea on one of aLayers.
+     *
+     * @param aFirst only tracks at index aFirst or later in Tracks() are returned
+     * @param aResult receives the tracks, in board order
+     */
+    void QueryTracks( const BOX2I& aArea, LSET aLayers, std::vector<TRACK*>& aResult,
+                      size_t aFirst = 0 );
+
+    /**
+     * Find the pads whose shape or hole may intersect aArea on one of aLayers.
+     * Pads with a hole are returned for all copper layers, since their hole goes through
+     * the whole board.
+     *
+     * @param aResult receives the pads, in board order
+     */
+    void QueryPads( const BOX2I& aArea, LSET aLayers, std::vector<D_PAD*>& aResult );
+
+private:
+    ///> Where an item was inserted, to remove it without accessing it
+    struct ENTRY
+    {
+        BOX2I m_BBox;
+        LSET  m_Layers;
+    };
+
+    void insertTrack( TRACK* aTrack );
+    void insertPad( D_PAD* aPad );
+
+    std::vector<TRACK*> m_tracks;
+    std::vector<D_PAD*> m_pads;
+    std::vector<ENTRY>  m_trackEntries;
+    std::vector<ENTRY>  m_padEntries;
+
+    ///> Indexes in m_tracks of the tracks, and in m_pads of the pads of each footprint
+    std::unordered_map<const BOARD_ITEM*, size_t>              m_trackSlots;
+    std::unordered_map<const BOARD_ITEM*, std::vector<size_t>> m_padSlots;
+    size_t                                                     m_removedCount;
+
+    DRC_RTREE<size_t>   m_trackTree;
+    DRC_RTREE<size_t>   m_padTree;
+
+    int                 m_maxClearance;
+};
+
+#endif // DRC_COPPER_INDEX__H
@@ -0,0 +1,179 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef DRC_RTREE_H_
+#define DRC_RTREE_H_
+
+#include <algorithm>
+#include <climits>
+
+#include <math/box2.h>
+#include <layers_id_colors_and_visibility.h>
+
+#include <geometry/rtree.h>
+
+
+/**
+ * Class DRC_RTREE -
+ * Implements an R-tree for fast spatial queries during DRC.  Each entry is stored with
+ * its bounding box and the span of copper layers it occupies, so queries can be limited
+ * both in the plane and in the layer stack.
+ * Non-owning: T is usually an item pointer or an index into a caller-owned array.
+ */
+template< class T >
+class DRC_RTREE
+{
+public:
+
+    DRC_RTREE()
+    {
+        this->m_tree = new RTree<T, int, 3, double>();
+        this->m_count = 0;
+    }
+
+    ~DRC_RTREE()
+    {
+        delete this->m_tree;
+    }
+
+    /**
+     * Function Insert()
+     * Inserts an item occupying aBBox on the copper layers of aLayers.  An item with no
+     * copper layers is treated as being on all of them (e.g. the hole of a technical pad).
+     */
+    void Insert( const BOX2I& aBBox, LSET aLayers, T aItem )
+    {
+        int layerStart, layerEnd;
+        copperRange( aLayers, layerStart, layerEnd );
+
+        const int mmin[3] = { layerStart, aBBox.GetX(), aBBox.GetY() };
+        const int mmax[3] = { layerEnd, aBBox.GetRight(), aBBox.GetBottom() };
+
+        m_tree->Insert( mmin, mmax, aItem );
+        m_count++;
+    }
+
+    /**
+     * Function Remove()
+     * Removes an item from the tree.  aBBox and aLayers must be the values the item was
+     * inserted with; if the item cannot be found there, the whole tree is searched.
+     */
+    void Remove( const BOX2I& aBBox, LSET aLayers, T aItem )
+    {
+        int layerStart, layerEnd;
+        copperRange( aLayers, layerStart, layerEnd );
+
+        const int mmin[3] = { layerStart, aBBox.GetX(), aBBox.GetY() };
+        const int mmax[3] = { layerEnd, aBBox.GetRight(), aBBox.GetBottom() };
+
+        // 1 == not found
+        if( m_tree->Remove( mmin, mmax, aItem ) )
+        {
+            const int mmin2[3] = { INT_MIN, INT_MIN, INT_MIN };
+            const int mmax2[3] = { INT_MAX, INT_MAX, INT_MAX };
+
+            if( m_tree->Remove( mmin2, mmax2, aItem ) )
+                return;
+        }
+
+        m_count--;
+    }
+
+    /**
+     * Function RemoveAll()
+     * Removes all items from the RTree
+     */
+    void RemoveAll()
+    {
+        m_tree->RemoveAll();
+        m_count = 0;
+    }
+
+    /**
+     * Function Query()
+     * Executes a function object aVisitor for each item whose bounding box intersects
+     * aBounds on at least one copper layer of aLayers.  The visitor returns false to stop
+     * the search.
+     * The tree is not modified by a query, so several threads may query it at once as long
+     * as nobody inserts or removes items in the meantime.
+     */
+    template <class Visitor>
+    void Query( const BOX2I& aBounds, LSET aLayers, Visitor& aVisitor )
+    {
+        int layerStart, layerEnd;
+        copperRange( aLayers, layerStart, layerEnd );
+
+        const int mmin[3] = { layerStart, aBounds.GetX(), aBounds.GetY() };
+        const int mmax[3] = { layerEnd, aBounds.GetRight(), aBounds.GetBottom() };
+
+        m_tree->Search( mmin, mmax, aVisitor );
+    }
+
+    /**
+     * Function size()
+     * Returns the number of items in the tree
+     */
+    size_t size() const
+    {
+        return m_count;
+    }
+
+    bool empty() const
+    {
+        return m_count == 0;
+    }
+
+private:
+
+    /**
+     * Copper layers are numbered contiguously from F_Cu to B_Cu, so a layer set maps to
+     * the range between its outermost copper layers.  This is exact for tracks and vias,
+     * and a superset for other items.
+     */
+    static void copperRange( const LSET& aLayers, int& aStart, int& aEnd )
+    {
+        aStart = B_Cu;
+        aEnd = F_Cu;
+
+        for( int layer = F_Cu; layer <= B_Cu; ++layer )
+        {
+            if( aLayers[layer] )
+            {
+                aStart = std::min( aStart, layer );
+                aEnd = std::max( aEnd, layer );
+            }
+        }
+
+        if( aStart > aEnd )
+        {
+            aStart = F_Cu;
+            aEnd = B_Cu;
+        }
+    }
+
+    RTree<T, int, 3, double>* m_tree;
+    size_t                    m_count;
+};
+
+
+#endif /* DRC_RTREE_H_ */
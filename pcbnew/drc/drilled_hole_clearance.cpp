@@ -0,0 +1,156 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+#include <drc/drilled_hole_clearance.h>
+
+#include <algorithm>
+
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <tools/drc.h>
+#include <trigo.h>
+
+#include <drc/drc_marker_factory.h>
+
+
+DRC_DRILLED_HOLE_CLEARANCE::DRC_DRILLED_HOLE_CLEARANCE(
+        const DRC_MARKER_FACTORY& aMarkerFactory, MARKER_HANDLER aMarkerHandler )
+        : DRC_PROVIDER( aMarkerFactory, aMarkerHandler )
+{
+}
+
+
+bool DRC_DRILLED_HOLE_CLEARANCE::RunDRC( BOARD& aBoard ) const
+{
+    int holeToHoleMin = aBoard.GetDesignSettings().m_HoleToHoleMin;
+
+    if( holeToHoleMin == 0 )    // No min setting turns testing off.
+        return true;
+
+    // Test drilled hole clearances to minimize drill bit breakage.
+    //
+    // Notes: slots are milled, so we're only concerned with circular holes
+    //        microvias are laser-drilled, so we're only concerned with standard vias
+
+    struct DRILLED_HOLE
+    {
+        wxPoint     m_location;
+        int         m_drillRadius;
+        BOARD_ITEM* m_owner;
+    };
+
+    std::vector<DRILLED_HOLE> holes;
+    DRILLED_HOLE              hole;
+    int                       maxRadius = 0;
+
+    for( MODULE* mod : aBoard.Modules() )
+    {
+        for( D_PAD* pad : mod->Pads( ) )
+        {
+            if( pad->GetDrillSize().x && pad->GetDrillShape() == PAD_DRILL_SHAPE_CIRCLE )
+            {
+                hole.m_location = pad->GetPosition();
+                hole.m_drillRadius = pad->GetDrillSize().x / 2;
+                hole.m_owner = pad;
+                holes.push_back( hole );
+            }
+        }
+    }
+
+    for( TRACK* track : aBoard.Tracks() )
+    {
+        VIA* via = dynamic_cast<VIA*>( track );
+        if( via && via->GetViaType() == VIA_THROUGH )
+        {
+            hole.m_location = via->GetPosition();
+            hole.m_drillRadius = via->GetDrillValue() / 2;
+            hole.m_owner = via;
+            holes.push_back( hole );
+        }
+    }
+
+    for( const DRILLED_HOLE& h : holes )
+        maxRadius = std::max( maxRadius, h.m_drillRadius );
+
+    // Sweep the holes in X order.  A hole can only be too close to the holes that follow
+    // it in the sweep while the X distance is below its radius + the largest radius + the
+    // minimum clearance.
+    std::vector<size_t> sweep( holes.size() );
+
+    for( size_t ii = 0; ii < holes.size(); ++ii )
+        sweep[ii] = ii;
+
+    std::sort( sweep.begin(), sweep.end(),
+            [&]( size_t a, size_t b )
+            {
+                return holes[a].m_location.x < holes[b].m_location.x;
+            } );
+
+    // Conflicting pairs, as indices in the holes list (lower index first)
+    std::vector<std::pair<size_t, size_t>> conflicts;
+
+    for( size_t ii = 0; ii < sweep.size(); ++ii )
+    {
+        const DRILLED_HOLE& refHole = holes[ sweep[ii] ];
+        int64_t xLimit = (int64_t) refHole.m_location.x + refHole.m_drillRadius + maxRadius
+                         + holeToHoleMin;
+
+        for( size_t jj = ii + 1; jj < sweep.size(); ++jj )
+        {
+            const DRILLED_HOLE& checkHole = holes[ sweep[jj] ];
+
+            if( checkHole.m_location.x >= xLimit )
+                break;
+
+            // Holes with identical locations are allowable
+            if( checkHole.m_location == refHole.m_location )
+                continue;
+
+            if( KiROUND( GetLineLength( checkHole.m_location, refHole.m_location ) )
+                    <  checkHole.m_drillRadius + refHole.m_drillRadius + holeToHoleMin )
+            {
+                conflicts.emplace_back( std::min( sweep[ii], sweep[jj] ),
+                                        std::max( sweep[ii], sweep[jj] ) );
+            }
+        }
+    }
+
+    // Report in the order of the hole list, as a plain pairwise test would
+    std::sort( conflicts.begin(), conflicts.end() );
+
+    const DRC_MARKER_FACTORY& marker_factory = GetMarkerFactory();
+
+    for( const std::pair<size_t, size_t>& conflict : conflicts )
+    {
+        const DRILLED_HOLE& refHole = holes[ conflict.first ];
+        const DRILLED_HOLE& checkHole = holes[ conflict.second ];
+
+        HandleMarker( std::unique_ptr<MARKER_PCB>( marker_factory.NewMarker(
+                refHole.m_location, refHole.m_owner, checkHole.m_owner,
+                DRCE_DRILLED_HOLES_TOO_CLOSE ) ) );
+    }
+
+    return conflicts.empty();
+}
@@ -38,6 +38,9 @@
 #include <wildcards_and_files_ext.h>
 #include <widgets/progress_reporter.h>
 
+#include <wx/dir.h>
+
+#include <map>
 #include <thread>
 #include <mutex>
 
@@ -97,6 +100,81 @@ bool FOOTPRINT_LIST_IMPL::CatchErrors( const std::function<void()>& aFunc )
 }
 
 
+/**
+ * Function isLocaleIndependent
+ * @return true if the footprints of the library \a aNickname are read without depending on
+ *         the locale, which is the case of the KiCad plugin.
+ */
+static bool isLocaleIndependent( FP_LIB_TABLE* aTable, const wxString& aNickname )
+{
+    try
+    {
+        const FP_LIB_TABLE_ROW* row = aTable->FindRow( aNickname );
+
+        return row->GetType() == IO_MGR::ShowType( IO_MGR::KICAD_SEXP );
+    }
+    catch( const IO_ERROR& )
+    {
+        // The error is reported when the library is enumerated
+        return true;
+    }
+}
+
+
+/**
+ * Function listFootprintFiles
+ * lists the footprint files of the library \a aNickname with their modification times, if it
+ * is a KiCad library: the index only knows the footprints of the KiCad plugin.
+ *
+ * @return true if the library is listed in \a aLibraryPath and \a aTimestamps.
+ */
+static bool listFootprintFiles( FP_LIB_TABLE* aTable, const wxString& aNickname,
+                                wxString& aLibraryPath, std::map<wxString, long long>& aTimestamps )
+{
+    try
+    {
+        const FP_LIB_TABLE_ROW* row = aTable->FindRow( aNickname );
+
+        if( row->GetType() != IO_MGR::ShowType( IO_MGR::KICAD_SEXP ) )
+            return false;
+
+        aLibraryPath = row->GetFullURI( true );
+    }
+    catch( const IO_ERROR& )
+    {
+        // The error is reported when the library is enumerated
+        return false;
+    }
+
+    wxDir dir( aLibraryPath );
+
+    if( !dir.IsOpened() )
+        return false;
+
+    wxString    fullName;
+    wxString    fileSpec = wxT( "*." ) + KiCadFootprintFileExtension;
+    WX_FILENAME fn( aLibraryPath, wxT( "dummyName" ) );
+
+    if( dir.GetFirst( &fullName, fileSpec ) )
+    {
+        do
+        {
+            fn.SetFullName( fullName );
+            aTimestamps[ fn.GetName() ] = fn.GetTimestamp();
+        } while( dir.GetNext( &fullName ) );
+    }
+
+    return true;
+}
+
+
+///> The index of the footprints of all the projects, in the KiCad configuration directory
+static wxString footprintIndexPath()
+{
+    return GetKicadConfigPath() + wxFileName::GetPathSeparator() + wxT( "fp-info-index" );
+}
+
+
 void FOOTPRINT_LIST_IMPL::loader_job()
 {
     wxString nickname;
@@ -239,14 +317,28 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
 
     size_t total_count = m_queue_out.size();
 
-    LOCALE_IO toggle_locale;
+    // Parse the footprints in parallel.  The KiCad plugin reads its numbers without depending
+    // on the locale, so its libraries need nothing more.  The other plugins still change the
+    // locale, which is GLOBAL: it is only threadsafe to construct the LOCALE_IO before the
+    // threads are created, destroy it after they finish, and block the main (GUI) thread while
+    // they work.  Any deviation from this will cause nasal demons.
+    std::unique_ptr<LOCALE_IO> toggle_locale;
+    std::vector<wxString>      nicknames;
+    wxString                   queued;
 
-    // Parse the footprints in parallel. WARNING! This requires changing the locale, which is
-    // GLOBAL. It is only threadsafe to construct the LOCALE_IO before the threads are created,
-    // destroy it after they finish, and block the main (GUI) thread while they work. Any deviation
-    // from this will cause nasal demons.
-    //
-    // TODO: blast LOCALE_IO into the sun
+    while( m_queue_out.pop( queued ) )
+        nicknames.push_back( queued );
+
+    for( const wxString& nickname : nicknames )
+    {
+        if( !toggle_locale && !isLocaleIndependent( m_lib_table, nickname ) )
+            toggle_locale = std::make_unique<LOCALE_IO>();
+
+        m_queue_out.push( nickname );
+    }
+
+    // Read again, another KiCad may have added to it
+    m_index.Load( footprintIndexPath() );
 
     SYNC_QUEUE<std::unique_ptr<FOOTPRINT_INFO>> queue_parsed;
     std::vector<std::thread>                    threads;
@@ -258,7 +350,40 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
 
             while( this->m_queue_out.pop( nickname ) && !m_cancelled )
             {
-                wxArrayString fpnames;
+                wxArrayString                 fpnames;
+                wxString                      libPath;
+                std::map<wxString, long long> timestamps;
+                bool indexed = listFootprintFiles( m_lib_table, nickname, libPath, timestamps );
+
+                // A library whose files are all in the index is not read at all
+                if( indexed )
+                {
+                    std::vector<std::unique_ptr<FOOTPRINT_INFO>> found;
+
+                    for( const auto& file : timestamps )
+                    {
+                        auto fpinfo = m_index.Find( libPath, nickname, file.first, file.second );
+
+                        if( !fpinfo )
+                            break;
+
+                        found.push_back( std::move( fpinfo ) );
+                    }
+
+                    if( found.size() == timestamps.size() )
+                    {
+                        for( auto& fpinfo : found )
+                            queue_parsed.move_push( std::move( fpinfo ) );
+
+                        if( m_progress_reporter )
+                            m_progress_reporter->AdvanceProgress();
+
+                        m_count_finished.fetch_add( 1 );
+                        continue;
+                    }
+
+                    m_index.Refresh( libPath );
+                }
 
                 try
                 {
@@ -284,9 +409,23 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
 
                 for( unsigned jj = 0; jj < fpnames.size() && !m_cancelled; ++jj )
                 {
-                    wxString fpname = fpnames[jj];
-                    FOOTPRINT_INFO* fpinfo = new FOOTPRINT_INFO_IMPL( this, nickname, fpname );
-                    queue_parsed.move_push( std::unique_ptr<FOOTPRINT_INFO>( fpinfo ) );
+                    wxString                        fpname = fpnames[jj];
+                    std::unique_ptr<FOOTPRINT_INFO> fpinfo;
+                    auto timestamp = indexed ? timestamps.find( fpname ) : timestamps.end();
+
+                    // Only the changed files of the library are parsed
+                    if( timestamp != timestamps.end() )
+                        fpinfo = m_index.Find( libPath, nickname, fpname, timestamp->second );
+
+                    if( !fpinfo )
+                    {
+                        fpinfo = std::make_unique<FOOTPRINT_INFO_IMPL>( this, nickname, fpname );
+
+                        if( timestamp != timestamps.end() )
+                            m_index.Add( libPath, *fpinfo, timestamp->second );
+                    }
+
+                    queue_parsed.move_push( std::move( fpinfo ) );
                 }
 
                 if( m_progress_reporter )
@@ -308,6 +447,9 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
     for( auto& thr : threads )
         thr.join();
 
+    // If it cannot be written, the libraries are just read again next time
+    m_index.Save( footprintIndexPath() );
+
     std::unique_ptr<FOOTPRINT_INFO> fpi;
 
     while( queue_parsed.pop( fpi ) )
@@ -27,6 +27,7 @@
 #include <vector>
 
 #include <footprint_info.h>
+#include <footprint_info_index.h>
 #include <sync_queue.h>
 
 class LOCALE_IO;
@@ -92,6 +93,7 @@ class FOOTPRINT_LIST_IMPL : public FOOTPRINT_LIST
     PROGRESS_REPORTER*       m_progress_reporter;
     std::atomic_bool         m_cancelled;
     std::mutex               m_join;
+    FOOTPRINT_INFO_INDEX     m_index;           ///< the records shared by all the projects
 
     /**
      * Call aFunc, pushing any IO_ERRORs and std::exceptions it throws onto m_errors.
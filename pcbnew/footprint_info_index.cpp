@@ -0,0 +1,383 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footprint_info_index.h>
+
+#include <cstring>
+
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include <footprint_info_impl.h>
+#include <macros.h>
+#include <make_unique.h>
+#include <richio.h>
+
+
+///> Identifies an index file
+static const char INDEX_MAGIC[8] = { 'K', 'I', 'F', 'P', 'I', 'D', 'X', '\0' };
+
+///> Bumped at each change of the file layout, older files are rebuilt
+static const uint32_t INDEX_VERSION = 1;
+
+///> Reads back differently from a host of another byte order, whose files are rebuilt
+static const uint32_t INDEX_BYTE_ORDER = 0x01020304;
+
+
+struct FP_INFO_INDEX_HEADER
+{
+    char        m_magic[8];
+    uint32_t    m_byteOrder;
+    uint32_t    m_version;
+    uint32_t    m_recordCount;
+    uint32_t    m_stringsSize;
+};
+
+
+/**
+ * The strings of a record are offsets in the string table which follows the records
+ */
+struct FOOTPRINT_INFO_INDEX::RECORD
+{
+    uint32_t    m_library;
+    uint32_t    m_name;
+    uint32_t    m_description;
+    uint32_t    m_keywords;
+    int64_t     m_timestamp;
+    uint32_t    m_padCount;
+    uint32_t    m_uniquePadCount;
+};
+
+
+FOOTPRINT_INFO_INDEX::FOOTPRINT_INFO_INDEX() :
+        m_records( nullptr ),
+        m_recordCount( 0 ),
+        m_strings( nullptr )
+{
+}
+
+
+FOOTPRINT_INFO_INDEX::~FOOTPRINT_INFO_INDEX()
+{
+}
+
+
+void FOOTPRINT_INFO_INDEX::clear()
+{
+    m_file.reset();
+    m_records = nullptr;
+    m_recordCount = 0;
+    m_strings = nullptr;
+}
+
+
+void FOOTPRINT_INFO_INDEX::Load( const wxString& aFilePath )
+{
+    // The file is used as is: its layout must not depend on the compiler
+    static_assert( sizeof( FP_INFO_INDEX_HEADER ) == 24, "unexpected index header padding" );
+    static_assert( sizeof( RECORD ) == 32, "unexpected index record padding" );
+
+    clear();
+    m_used.clear();
+    m_added.clear();
+    m_refreshed.clear();
+
+    if( !wxFileName::FileExists( aFilePath ) )
+        return;
+
+    try
+    {
+        m_file = std::make_unique<MMAP_LINE_READER>( aFilePath );
+    }
+    catch( const IO_ERROR& )
+    {
+        return;
+    }
+
+    // The mapping is page aligned, and so are the records
+    const char* data = m_file->Data();
+    size_t      size = m_file->Size();
+
+    if( size < sizeof( FP_INFO_INDEX_HEADER ) )
+    {
+        clear();
+        return;
+    }
+
+    FP_INFO_INDEX_HEADER header;
+    memcpy( &header, data, sizeof( header ) );
+
+    size_t recordsStart = sizeof( FP_INFO_INDEX_HEADER );
+    size_t stringsStart = recordsStart + (size_t) header.m_recordCount * sizeof( RECORD );
+
+    if( memcmp( header.m_magic, INDEX_MAGIC, sizeof( INDEX_MAGIC ) ) != 0
+            || header.m_byteOrder != INDEX_BYTE_ORDER
+            || header.m_version != INDEX_VERSION
+            || header.m_stringsSize == 0
+            || stringsStart + header.m_stringsSize != size
+            || data[size - 1] != '\0' )
+    {
+        clear();
+        return;
+    }
+
+    const RECORD* records = reinterpret_cast<const RECORD*>( data + recordsStart );
+
+    for( uint32_t ii = 0; ii < header.m_recordCount; ++ii )
+    {
+        const RECORD& record = records[ii];
+
+        if( record.m_library >= header.m_stringsSize || record.m_name >= header.m_stringsSize
+                || record.m_description >= header.m_stringsSize
+                || record.m_keywords >= header.m_stringsSize )
+        {
+            clear();
+            return;
+        }
+    }
+
+    m_records = records;
+    m_recordCount = header.m_recordCount;
+    m_strings = data + stringsStart;
+    m_used.assign( m_recordCount, false );
+}
+
+
+bool FOOTPRINT_INFO_INDEX::Save( const wxString& aFilePath )
+{
+    if( m_added.empty() && m_refreshed.empty() )
+        return true;
+
+    std::vector<RECORD>             records;
+    std::vector<char>               strings;
+    std::map<std::string, uint32_t> libraries;
+
+    auto addString = [&strings]( const char* aText ) -> uint32_t
+    {
+        uint32_t offset = (uint32_t) strings.size();
+        strings.insert( strings.end(), aText, aText + strlen( aText ) + 1 );
+        return offset;
+    };
+
+    auto addRecord = [&]( const char* aLibrary, const char* aName, const char* aDescription,
+                          const char* aKeywords, int64_t aTimestamp, uint32_t aPadCount,
+                          uint32_t aUniquePadCount )
+    {
+        RECORD record;
+        auto   library = libraries.find( aLibrary );
+
+        if( library == libraries.end() )
+            library = libraries.emplace( aLibrary, addString( aLibrary ) ).first;
+
+        record.m_library = library->second;
+        record.m_name = addString( aName );
+        record.m_description = addString( aDescription );
+        record.m_keywords = addString( aKeywords );
+        record.m_timestamp = aTimestamp;
+        record.m_padCount = aPadCount;
+        record.m_uniquePadCount = aUniquePadCount;
+
+        records.push_back( record );
+    };
+
+    // Merge the added records into the records of the file, both sorted by key
+    auto added = m_added.begin();
+
+    for( uint32_t ii = 0; ii <= m_recordCount; ++ii )
+    {
+        for( ; added != m_added.end()
+                    && ( ii == m_recordCount || compare( m_records[ii], added->first ) > 0 );
+                ++added )
+        {
+            const ENTRY& entry = added->second;
+
+            addRecord( added->first.first.c_str(), added->first.second.c_str(),
+                       entry.m_description.c_str(), entry.m_keywords.c_str(), entry.m_timestamp,
+                       entry.m_padCount, entry.m_uniquePadCount );
+        }
+
+        if( ii == m_recordCount )
+            break;
+
+        const RECORD& record = m_records[ii];
+
+        // Replaced by an added record
+        if( added != m_added.end() && compare( record, added->first ) == 0 )
+            continue;
+
+        // Not in its library any more
+        if( !m_used[ii] && m_refreshed.count( stringAt( record.m_library ) ) )
+            continue;
+
+        addRecord( stringAt( record.m_library ), stringAt( record.m_name ),
+                   stringAt( record.m_description ), stringAt( record.m_keywords ),
+                   record.m_timestamp, record.m_padCount, record.m_uniquePadCount );
+    }
+
+    if( strings.empty() )
+        strings.push_back( '\0' );
+
+    FP_INFO_INDEX_HEADER header;
+
+    memcpy( header.m_magic, INDEX_MAGIC, sizeof( INDEX_MAGIC ) );
+    header.m_byteOrder = INDEX_BYTE_ORDER;
+    header.m_version = INDEX_VERSION;
+    header.m_recordCount = (uint32_t) records.size();
+    header.m_stringsSize = (uint32_t) strings.size();
+
+    // Write a temporary file and rename it, so another KiCad never reads half a file
+    wxString tempFileName = aFilePath + wxT( ".tmp" );
+    bool     ok;
+
+    {
+        wxFFile file( tempFileName, wxT( "wb" ) );
+
+        ok = file.IsOpened()
+                && file.Write( &header, sizeof( header ) ) == sizeof( header )
+                && file.Write( records.data(), records.size() * sizeof( RECORD ) )
+                        == records.size() * sizeof( RECORD )
+                && file.Write( strings.data(), strings.size() ) == strings.size()
+                && file.Close();
+    }
+
+    // A mapped file cannot be replaced everywhere
+    clear();
+
+    if( !ok || !wxRenameFile( tempFileName, aFilePath, true ) )
+    {
+        wxRemoveFile( tempFileName );
+        Load( aFilePath );
+        return false;
+    }
+
+    Load( aFilePath );
+
+    return true;
+}
+
+
+int FOOTPRINT_INFO_INDEX::compare( const RECORD& aRecord, const KEY& aKey ) const
+{
+    int cmp = strcmp( stringAt( aRecord.m_library ), aKey.first.c_str() );
+
+    if( cmp == 0 )
+        cmp = strcmp( stringAt( aRecord.m_name ), aKey.second.c_str() );
+
+    return cmp;
+}
+
+
+int FOOTPRINT_INFO_INDEX::findRecord( const KEY& aKey ) const
+{
+    uint32_t first = 0;
+    uint32_t last = m_recordCount;
+
+    while( first < last )
+    {
+        uint32_t middle = first + ( last - first ) / 2;
+
+        if( compare( m_records[middle], aKey ) < 0 )
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    if( first < m_recordCount && compare( m_records[first], aKey ) == 0 )
+        return (int) first;
+
+    return -1;
+}
+
+
+std::unique_ptr<FOOTPRINT_INFO> FOOTPRINT_INFO_INDEX::Find( const wxString& aLibraryPath,
+                                                            const wxString& aNickname,
+                                                            const wxString& aFootprintName,
+                                                            long long aTimestamp )
+{
+    KEY      key( TO_UTF8( aLibraryPath ), TO_UTF8( aFootprintName ) );
+    wxString description;
+    wxString keywords;
+    unsigned padCount;
+    unsigned uniquePadCount;
+
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto added = m_added.find( key );
+
+        if( added != m_added.end() )
+        {
+            const ENTRY& entry = added->second;
+
+            if( entry.m_timestamp != aTimestamp )
+                return nullptr;
+
+            description = wxString::FromUTF8( entry.m_description.c_str() );
+            keywords = wxString::FromUTF8( entry.m_keywords.c_str() );
+            padCount = entry.m_padCount;
+            uniquePadCount = entry.m_uniquePadCount;
+        }
+        else
+        {
+            int ii = findRecord( key );
+
+            if( ii < 0 || m_records[ii].m_timestamp != aTimestamp )
+                return nullptr;
+
+            const RECORD& record = m_records[ii];
+
+            m_used[ii] = true;
+            description = wxString::FromUTF8( stringAt( record.m_description ) );
+            keywords = wxString::FromUTF8( stringAt( record.m_keywords ) );
+            padCount = record.m_padCount;
+            uniquePadCount = record.m_uniquePadCount;
+        }
+    }
+
+    return std::make_unique<FOOTPRINT_INFO_IMPL>( aNickname, aFootprintName, description,
+                                                  keywords, 0, padCount, uniquePadCount );
+}
+
+
+void FOOTPRINT_INFO_INDEX::Add( const wxString& aLibraryPath, FOOTPRINT_INFO& aInfo,
+                                long long aTimestamp )
+{
+    ENTRY entry;
+
+    entry.m_description = TO_UTF8( aInfo.GetDescription() );
+    entry.m_keywords = TO_UTF8( aInfo.GetKeywords() );
+    entry.m_timestamp = aTimestamp;
+    entry.m_padCount = aInfo.GetPadCount();
+    entry.m_uniquePadCount = aInfo.GetUniquePadCount();
+
+    KEY key( TO_UTF8( aLibraryPath ), TO_UTF8( aInfo.GetName() ) );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_added[key] = entry;
+}
+
+
+void FOOTPRINT_INFO_INDEX::Refresh( const wxString& aLibraryPath )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_refreshed.insert( TO_UTF8( aLibraryPath ) );
+}
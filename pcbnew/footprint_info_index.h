@@ -0,0 +1,144 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTPRINT_INFO_INDEX_H
+#define FOOTPRINT_INFO_INDEX_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <wx/string.h>
+
+class FOOTPRINT_INFO;
+class MMAP_LINE_READER;
+
+
+/**
+ * Class FOOTPRINT_INFO_INDEX
+ * is a persistent index of the #FOOTPRINT_INFO records of the footprint files, shared by all
+ * the projects of the user.
+ *
+ * A record is keyed by the path of its library and its footprint name, and is only valid for
+ * the modification time of the footprint file it was read from.  So a library is only parsed
+ * again for its changed files, whatever the project which uses it.
+ *
+ * The file is a header, an array of fixed size records sorted by library and footprint name,
+ * and a table of the nul terminated UTF-8 strings they point to.  The file is mapped and its
+ * records are searched in place, without building anything per record.
+ *
+ * Find() and Add() are thread safe, Load() and Save() are not.
+ */
+class FOOTPRINT_INFO_INDEX
+{
+public:
+    FOOTPRINT_INFO_INDEX();
+    ~FOOTPRINT_INFO_INDEX();
+
+    /**
+     * Function Load
+     * reads the index file \a aFilePath.  A missing or invalid file gives an empty index,
+     * which is rebuilt as the libraries are read.
+     */
+    void Load( const wxString& aFilePath );
+
+    /**
+     * Function Save
+     * writes the index to \a aFilePath, if there is any change since it was loaded.
+     *
+     * @return bool - false if the file cannot be written.
+     */
+    bool Save( const wxString& aFilePath );
+
+    /**
+     * Function Find
+     * @return the record of \a aFootprintName in the library \a aLibraryPath, for the file
+     *         modification time \a aTimestamp, or NULL if there is none.  The record is given
+     *         the nickname \a aNickname.
+     */
+    std::unique_ptr<FOOTPRINT_INFO> Find( const wxString& aLibraryPath,
+                                          const wxString& aNickname,
+                                          const wxString& aFootprintName,
+                                          long long aTimestamp );
+
+    /**
+     * Function Add
+     * records \a aInfo, read from the library \a aLibraryPath in a file of modification
+     * time \a aTimestamp.
+     */
+    void Add( const wxString& aLibraryPath, FOOTPRINT_INFO& aInfo, long long aTimestamp );
+
+    /**
+     * Function Refresh
+     * tells the library \a aLibraryPath is being read again: its records which are neither
+     * found nor added from now on are removed by the next Save().
+     */
+    void Refresh( const wxString& aLibraryPath );
+
+private:
+    ///> The fields of a record, in the index file as well as added
+    struct ENTRY
+    {
+        std::string m_description;
+        std::string m_keywords;
+        int64_t     m_timestamp;
+        uint32_t    m_padCount;
+        uint32_t    m_uniquePadCount;
+    };
+
+    ///> A library path and a footprint name, in UTF-8
+    typedef std::pair<std::string, std::string> KEY;
+
+    ///> A record of the index file, see footprint_info_index.cpp
+    struct RECORD;
+
+    /**
+     * Function findRecord
+     * @return the index of the record of \a aKey in the mapped file, or -1.
+     */
+    int findRecord( const KEY& aKey ) const;
+
+    /**
+     * Function compare
+     * compares the key of \a aRecord to \a aKey, like strcmp().
+     */
+    int compare( const RECORD& aRecord, const KEY& aKey ) const;
+
+    const char* stringAt( uint32_t aOffset ) const { return m_strings + aOffset; }
+
+    ///> Unmaps the index file
+    void clear();
+
+    std::mutex              m_mutex;
+
+    std::unique_ptr<MMAP_LINE_READER> m_file;   ///< the mapped index file
+    const RECORD*           m_records;      ///< the records of m_file
+    uint32_t                m_recordCount;
+    const char*             m_strings;      ///< the string table of m_file
+
+    std::vector<bool>       m_used;         ///< the records of m_file found since loaded
+    std::map<KEY, ENTRY>    m_added;        ///< the records added since loaded
+    std::set<std::string>   m_refreshed;    ///< the libraries read again since loaded
+};
+
+#endif // FOOTPRINT_INFO_INDEX_H
@@ -41,6 +41,7 @@
 #include <class_drawsegment.h>
 #include <class_edge_mod.h>
 #include <gpcb_plugin.h>
+#include <parse_footprint_files.h>
 
 #include <wx/dir.h>
 #include <wx/filename.h>
@@ -242,33 +243,52 @@ void GPCB_FPL_CACHE::Load()
     if( !dir.GetFirst( &fullName, fileSpec ) )
         return;
 
-    wxString cacheErrorMsg;
+    std::vector<WX_FILENAME> files;
 
     do
     {
         fn.SetFullName( fullName );
+        files.push_back( fn );
+    } while( dir.GetNext( &fullName ) );
 
-        // Queue I/O errors so only files that fail to parse don't get loaded.
-        try
-        {
-            // reader now owns fp, will close on exception or return
-            FILE_LINE_READER reader( fn.GetFullPath() );
+    // parseMODULE() keeps no state, so the threads need nothing of their own
+    std::vector<std::unique_ptr<MODULE>> footprints;
+    std::vector<wxString>                errors;
 
-            std::string      name = TO_UTF8( fn.GetName() );
-            MODULE*          footprint = parseMODULE( &reader );
+    ParseFootprintFiles( files,
+            [&]( const WX_FILENAME& aFile, int ) -> MODULE*
+            {
+                // reader now owns fp, will close on exception or return
+                FILE_LINE_READER reader( aFile.GetFullPath() );
+                std::unique_ptr<MODULE> footprint( parseMODULE( &reader ) );
 
-            // The footprint name is the file name without the extension.
-            footprint->SetFPID( LIB_ID( wxEmptyString, fn.GetName() ) );
-            m_modules.insert( name, new GPCB_FPL_CACHE_ITEM( footprint, fn ) );
+                // The footprint name is the file name without the extension.
+                footprint->SetFPID( LIB_ID( wxEmptyString, aFile.GetName() ) );
+
+                return footprint.release();
+            },
+            footprints, errors );
+
+    // Merge in the order of the directory, whatever thread parsed each file
+    wxString cacheErrorMsg;
+
+    for( size_t ii = 0; ii < files.size(); ++ii )
+    {
+        if( footprints[ii] )
+        {
+            std::string name = TO_UTF8( files[ii].GetName() );
+
+            m_modules.insert( name, new GPCB_FPL_CACHE_ITEM( footprints[ii].release(),
+                                                             files[ii] ) );
         }
-        catch( const IO_ERROR& ioe )
+        else
         {
             if( !cacheErrorMsg.IsEmpty() )
                 cacheErrorMsg += "\n\n";
 
-            cacheErrorMsg += ioe.What();
+            cacheErrorMsg += errors[ii];
         }
-    } while( dir.GetNext( &fullName ) );
+    }
 
     if( !cacheErrorMsg.IsEmpty() )
         THROW_IO_ERROR( cacheErrorMsg );
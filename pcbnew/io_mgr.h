@@ -415,6 +415,9 @@ public:
      * Function GetEnumeratedFootprint
      * a version of FootprintLoad() for use after FootprintEnumerate() for more efficient
      * cache management.
+     *
+     * @return  const MODULE* - owned by the plugin, to be used before the next call of this
+     *          function on the same plugin, or NULL if not found or broken.
      */
     virtual const MODULE* GetEnumeratedFootprint( const wxString& aLibraryPath,
                                                   const wxString& aFootprintName,
@@ -148,8 +148,6 @@ void CLIPBOARD_IO::SaveSelection( const PCBNEW_SELECTION& aSelected )
     {
         // we will fake being a .kicad_pcb to get the full parser kicking
         // This means we also need layers and nets
-        LOCALE_IO io;
-
         m_formatter.Print( 0, "(kicad_pcb (version %d) (host pcbnew %s)\n",
                 SEXPR_BOARD_FILE_VERSION, m_formatter.Quotew( GetBuildVersion() ).c_str() );
 
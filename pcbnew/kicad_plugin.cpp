@@ -43,6 +43,7 @@
 #include <zones.h>
 #include <kicad_plugin.h>
 #include <pcb_parser.h>
+#include <parse_footprint_files.h>
 #include <wx/dir.h>
 #include <wx/filename.h>
 #include <wx/wfstream.h>
@@ -52,6 +53,11 @@
 #include <convert_basic_shapes_to_polygon.h>    // for enum RECT_CHAMFER_POSITIONS definition
 #include <kiface_i.h>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 using namespace PCB_KEYS_T;
 
 
@@ -83,19 +89,32 @@ void filterNetClass( const BOARD& aBoard, NETCLASS& aNetClass )
 class FP_CACHE_ITEM
 {
     WX_FILENAME             m_filename;
-    std::unique_ptr<MODULE> m_module;
+    long long               m_timestamp;    // Modification time of the file when listed.
+    std::shared_ptr<MODULE> m_module;       // NULL until parsed, in a lazy cache.  Shared
+                                            // with the callers of FP_CACHE::GetModule().
+    unsigned long long      m_last_use;     // FP_CACHE use count when last returned.
 
 public:
-    FP_CACHE_ITEM( MODULE* aModule, const WX_FILENAME& aFileName );
+    FP_CACHE_ITEM( MODULE* aModule, const WX_FILENAME& aFileName, long long aTimestamp = 0 );
+
+    const WX_FILENAME& GetFileName()  const { return m_filename; }
+    long long          GetTimestamp() const { return m_timestamp; }
+    const MODULE*      GetModule()    const { return m_module.get(); }
+    unsigned long long GetLastUse()   const { return m_last_use; }
+
+    std::shared_ptr<const MODULE> GetSharedModule() const { return m_module; }
 
-    const WX_FILENAME& GetFileName() const { return m_filename; }
-    const MODULE*      GetModule()   const { return m_module.get(); }
+    void SetModule( MODULE* aModule ) { m_module.reset( aModule ); }
+    void SetLastUse( unsigned long long aUse ) { m_last_use = aUse; }
 };
 
 
-FP_CACHE_ITEM::FP_CACHE_ITEM( MODULE* aModule, const WX_FILENAME& aFileName ) :
+FP_CACHE_ITEM::FP_CACHE_ITEM( MODULE* aModule, const WX_FILENAME& aFileName,
+                              long long aTimestamp ) :
     m_filename( aFileName ),
-    m_module( aModule )
+    m_timestamp( aTimestamp ),
+    m_module( aModule ),
+    m_last_use( 0 )
 { }
 
 
@@ -116,13 +135,63 @@ class FP_CACHE
     long long       m_cache_timestamp;  // A hash of the timestamps for all the footprint
                                         // files.
 
+    bool            m_lazy;             // Parse each footprint on its first use only.
+    bool            m_prefetch;         // Parse the footprints of a lazy cache in background.
+    size_t          m_max_resident;     // Most footprints a lazy cache keeps parsed, 0 for all.
+    unsigned long long m_use_count;     // Stamps the footprint uses, for the LRU eviction.
+
+    std::mutex        m_mutex;          // Guards the parsed footprints against the prefetch.
+    std::thread       m_prefetch_thread;
+    std::atomic<bool> m_cancel_prefetch;
+
+    /**
+     * Function prefetch
+     * parses the footprints of a lazy cache not parsed yet, with its own parser.  It runs on
+     * #m_prefetch_thread and stops at the #m_max_resident bound.
+     */
+    void prefetch();
+
+    /**
+     * Function stopPrefetch
+     * cancels the prefetch and waits for its thread.  It must be called before the map of
+     * footprints is changed.
+     */
+    void stopPrefetch();
+
+    /**
+     * Function evict
+     * drops the least recently used footprints until a lazy cache has no more than
+     * #m_max_resident parsed footprints.  \a aKeep is never dropped.  A dropped footprint
+     * is only deleted once the callers of GetModule() holding it have released it.
+     */
+    void evict( const FP_CACHE_ITEM* aKeep );
+
 public:
     FP_CACHE( PCB_IO* aOwner, const wxString& aLibraryPath );
+    ~FP_CACHE();
 
     wxString    GetPath() const { return m_lib_raw_path; }
     bool        IsWritable() const { return m_lib_path.IsOk() && m_lib_path.IsDirWritable(); }
     bool        Exists() const { return m_lib_path.IsOk() && m_lib_path.DirExists(); }
-    MODULE_MAP& GetModules() { return m_modules; }
+
+    /**
+     * Function GetModules
+     * @return the map of footprints, for a change.  The footprints of a lazy cache may not
+     *         be parsed, see GetModule().
+     */
+    MODULE_MAP& GetModules() { stopPrefetch(); return m_modules; }
+
+    const MODULE_MAP& GetModules() const { return m_modules; }
+
+    /**
+     * Function GetModule
+     * @return the footprint \a aFootprintName, parsed now if the cache is lazy and it was
+     *         not parsed yet, or NULL if there is no such footprint.  The footprint stays
+     *         valid while the returned pointer is held, even once evicted from the cache or
+     *         once the cache is deleted.
+     * @throw IO_ERROR if the footprint file cannot be parsed.
+     */
+    std::shared_ptr<const MODULE> GetModule( const wxString& aFootprintName );
 
     // Most all functions in this class throw IO_ERROR exceptions.  There are no
     // error codes nor user interface calls from here, nor in any PLUGIN.
@@ -170,18 +239,57 @@ public:
 };
 
 
-FP_CACHE::FP_CACHE( PCB_IO* aOwner, const wxString& aLibraryPath )
+/**
+ * Function parseFootprint
+ * parses the footprint file \a aFileName with \a aParser.
+ * @throw IO_ERROR if the file cannot be read or parsed.
+ */
+static MODULE* parseFootprint( PCB_PARSER* aParser, const WX_FILENAME& aFileName )
+{
+    std::unique_ptr<LINE_READER> reader = OpenFileLineReader( aFileName.GetFullPath() );
+
+    aParser->SetLineReader( reader.get() );
+
+    MODULE* footprint = (MODULE*) aParser->Parse();
+
+    footprint->SetFPID( LIB_ID( wxEmptyString, aFileName.GetName() ) );
+
+    return footprint;
+}
+
+
+FP_CACHE::FP_CACHE( PCB_IO* aOwner, const wxString& aLibraryPath ) :
+    m_cancel_prefetch( false )
 {
     m_owner = aOwner;
     m_lib_raw_path = aLibraryPath;
     m_lib_path.SetPath( aLibraryPath );
     m_cache_timestamp = 0;
     m_cache_dirty = true;
+    m_use_count = 0;
+
+    const PROPERTIES* props = aOwner->m_props;
+    UTF8              maxResident;
+
+    m_lazy = props && props->Value( "lazy_load" );
+    m_prefetch = m_lazy && props->Value( "prefetch" );
+    m_max_resident = 0;
+
+    if( m_lazy && props->Value( "max_resident_footprints", &maxResident ) )
+        m_max_resident = (size_t) std::max( 0L, strtol( maxResident.c_str(), NULL, 10 ) );
+}
+
+
+FP_CACHE::~FP_CACHE()
+{
+    stopPrefetch();
 }
 
 
 void FP_CACHE::Save( MODULE* aModule )
 {
+    stopPrefetch();
+
     m_cache_timestamp = 0;
 
     if( !m_lib_path.DirExists() && !m_lib_path.Mkdir() )
@@ -203,6 +311,13 @@ void FP_CACHE::Save( MODULE* aModule )
 
         WX_FILENAME fn = it->second->GetFileName();
 
+        // The footprints a lazy cache did not parse are unchanged on disk, since it was listed
+        if( !it->second->GetModule() )
+        {
+            m_cache_timestamp += it->second->GetTimestamp();
+            continue;
+        }
+
         wxString tempFileName =
 #ifdef USE_TMP_FILE
         wxFileName::CreateTempFileName( fn.GetPath() );
@@ -270,46 +385,200 @@ void FP_CACHE::Load()
     // the filename thereafter.
     WX_FILENAME fn( m_lib_raw_path, wxT( "dummyName" ) );
 
+    std::vector<WX_FILENAME> files;
+
     if( dir.GetFirst( &fullName, fileSpec ) )
     {
-        wxString cacheError;
-
         do
         {
             fn.SetFullName( fullName );
 
-            // Queue I/O errors so only files that fail to parse don't get loaded.
-            try
+            // A lazy cache only lists the files, the footprints are parsed by GetModule()
+            if( m_lazy )
             {
-                FILE_LINE_READER    reader( fn.GetFullPath() );
+                long long timestamp = fn.GetTimestamp();
 
-                m_owner->m_parser->SetLineReader( &reader );
+                m_modules.insert( fn.GetName(), new FP_CACHE_ITEM( nullptr, fn, timestamp ) );
+                m_cache_timestamp += timestamp;
+                continue;
+            }
 
-                MODULE*     footprint = (MODULE*) m_owner->m_parser->Parse();
-                wxString    fpName = fn.GetName();
+            files.push_back( fn );
+        } while( dir.GetNext( &fullName ) );
+    }
 
-                footprint->SetFPID( LIB_ID( wxEmptyString, fpName ) );
-                m_modules.insert( fpName, new FP_CACHE_ITEM( footprint, fn ) );
+    if( !files.empty() )
+    {
+        std::vector<std::unique_ptr<MODULE>> footprints;
+        std::vector<wxString>                errors;
+        wxString                             cacheError;
+
+        // The calling thread uses the parser of the plugin, the other ones their own
+        std::vector<std::unique_ptr<PCB_PARSER>> parsers(
+                std::max( 1u, std::thread::hardware_concurrency() ) );
+
+        ParseFootprintFiles( files,
+                [&]( const WX_FILENAME& aFile, int aThread ) -> MODULE*
+                {
+                    if( aThread == 0 )
+                        return parseFootprint( m_owner->m_parser, aFile );
+
+                    if( !parsers[aThread] )
+                        parsers[aThread].reset( new PCB_PARSER );
+
+                    return parseFootprint( parsers[aThread].get(), aFile );
+                },
+                footprints, errors );
+
+        // Merge in the order of the directory, whatever thread parsed each file
+        for( size_t ii = 0; ii < files.size(); ++ii )
+        {
+            if( footprints[ii] )
+            {
+                m_modules.insert( files[ii].GetName(),
+                                  new FP_CACHE_ITEM( footprints[ii].release(), files[ii] ) );
 
-                m_cache_timestamp += fn.GetTimestamp();
+                m_cache_timestamp += files[ii].GetTimestamp();
             }
-            catch( const IO_ERROR& ioe )
+            else
             {
                 if( !cacheError.IsEmpty() )
                     cacheError += "\n\n";
 
-                cacheError += ioe.What();
+                cacheError += errors[ii];
             }
-        } while( dir.GetNext( &fullName ) );
+        }
 
         if( !cacheError.IsEmpty() )
             THROW_IO_ERROR( cacheError );
     }
+
+    if( m_prefetch && !m_modules.empty() )
+        m_prefetch_thread = std::thread( &FP_CACHE::prefetch, this );
+}
+
+
+std::shared_ptr<const MODULE> FP_CACHE::GetModule( const wxString& aFootprintName )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    MODULE_ITER it = m_modules.find( aFootprintName );
+
+    if( it == m_modules.end() )
+        return nullptr;
+
+    FP_CACHE_ITEM* item = it->second;
+
+    item->SetLastUse( ++m_use_count );
+
+    if( !item->GetModule() )
+    {
+        item->SetModule( parseFootprint( m_owner->m_parser, item->GetFileName() ) );
+        evict( item );
+    }
+
+    return item->GetSharedModule();
+}
+
+
+void FP_CACHE::evict( const FP_CACHE_ITEM* aKeep )
+{
+    if( !m_lazy || m_max_resident == 0 )
+        return;
+
+    for( ;; )
+    {
+        size_t          resident = 0;
+        FP_CACHE_ITEM*  oldest = nullptr;
+
+        for( MODULE_ITER it = m_modules.begin();  it != m_modules.end();  ++it )
+        {
+            FP_CACHE_ITEM* item = it->second;
+
+            if( !item->GetModule() )
+                continue;
+
+            resident++;
+
+            if( item != aKeep && ( !oldest || item->GetLastUse() < oldest->GetLastUse() ) )
+                oldest = item;
+        }
+
+        if( resident <= m_max_resident || !oldest )
+            return;
+
+        oldest->SetModule( nullptr );
+    }
+}
+
+
+void FP_CACHE::prefetch()
+{
+    std::vector<std::pair<wxString, WX_FILENAME>> pending;
+    size_t                                        budget = 0;
+
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        size_t                      resident = 0;
+
+        for( MODULE_CITER it = m_modules.begin();  it != m_modules.end();  ++it )
+        {
+            if( it->second->GetModule() )
+                resident++;
+            else
+                pending.emplace_back( it->first, it->second->GetFileName() );
+        }
+
+        if( m_max_resident == 0 )
+            budget = pending.size();
+        else if( m_max_resident > resident )
+            budget = std::min( pending.size(), m_max_resident - resident );
+    }
+
+    // The owner's parser belongs to the GUI thread
+    PCB_PARSER parser;
+
+    for( size_t ii = 0; ii < budget && !m_cancel_prefetch; ++ii )
+    {
+        std::unique_ptr<MODULE> footprint;
+
+        try
+        {
+            footprint.reset( parseFootprint( &parser, pending[ii].second ) );
+        }
+        catch( const IO_ERROR& )
+        {
+            // Reported by GetModule() when the footprint is used
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        MODULE_ITER it = m_modules.find( pending[ii].first );
+
+        // The footprint may have been parsed by GetModule() meanwhile.  A use count of 0
+        // leaves the prefetched footprints to be evicted first.
+        if( it != m_modules.end() && !it->second->GetModule() )
+            it->second->SetModule( footprint.release() );
+    }
+}
+
+
+void FP_CACHE::stopPrefetch()
+{
+    if( m_prefetch_thread.joinable() )
+    {
+        m_cancel_prefetch = true;
+        m_prefetch_thread.join();
+        m_cancel_prefetch = false;
+    }
 }
 
 
 void FP_CACHE::Remove( const wxString& aFootprintName )
 {
+    stopPrefetch();
+
     MODULE_CITER it = m_modules.find( aFootprintName );
 
     if( it == m_modules.end() )
@@ -351,8 +620,6 @@ long long FP_CACHE::GetTimestamp( const wxString& aLibPath )
 
 void PCB_IO::Save( const wxString& aFileName, BOARD* aBoard, const PROPERTIES* aProperties )
 {
-    LOCALE_IO   toggle;     // toggles on, then off, the C locale.
-
     init( aProperties );
 
     m_board = aBoard;       // after init()
@@ -397,8 +664,6 @@ BOARD_ITEM* PCB_IO::Parse( const wxString& aClipboardSourceInput )
 
 void PCB_IO::Format( BOARD_ITEM* aItem, int aNestLevel ) const
 {
-    LOCALE_IO   toggle;     // public API function, perform anything convenient for caller
-
     switch( aItem->Type() )
     {
     case PCB_T:
@@ -1823,7 +2088,7 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
         bool new_polygon = true;
         bool is_closed = false;
 
-        for( auto iterator = aZone->IterateWithHoles(); iterator; iterator++ )
+        for( auto iterator = aZone->CIterateWithHoles(); iterator; iterator++ )
         {
             if( new_polygon )
             {
@@ -1965,11 +2230,11 @@ PCB_IO::~PCB_IO()
 
 BOARD* PCB_IO::Load( const wxString& aFileName, BOARD* aAppendToMe, const PROPERTIES* aProperties )
 {
-    FILE_LINE_READER    reader( aFileName );
+    std::unique_ptr<LINE_READER> reader = OpenFileLineReader( aFileName );
 
     init( aProperties );
 
-    m_parser->SetLineReader( &reader );
+    m_parser->SetLineReader( reader.get() );
     m_parser->SetBoard( aAppendToMe );
 
     BOARD* board;
@@ -2032,8 +2297,7 @@ void PCB_IO::FootprintEnumerate( wxArrayString&    aFootprintNames,
                                  const wxString&   aLibraryPath,
                                  const PROPERTIES* aProperties )
 {
-    LOCALE_IO     toggle;     // toggles on, then off, the C locale.
-    wxDir         dir( aLibraryPath );
+    wxDir dir( aLibraryPath );
 
     init( aProperties );
 
@@ -2051,7 +2315,9 @@ void PCB_IO::FootprintEnumerate( wxArrayString&    aFootprintNames,
     // Some of the files may have been parsed correctly so we want to add the valid files to
     // the library.
 
-    const MODULE_MAP& mods = m_cache->GetModules();
+    // Only the names are needed: the const map doesn't stop the prefetch
+    const FP_CACHE*   cache = m_cache;
+    const MODULE_MAP& mods = cache->GetModules();
 
     for( MODULE_CITER it = mods.begin();  it != mods.end();  ++it )
     {
@@ -2063,13 +2329,11 @@ void PCB_IO::FootprintEnumerate( wxArrayString&    aFootprintNames,
 }
 
 
-const MODULE* PCB_IO::getFootprint( const wxString& aLibraryPath,
-                                    const wxString& aFootprintName,
-                                    const PROPERTIES* aProperties,
-                                    bool checkModified )
+std::shared_ptr<const MODULE> PCB_IO::getFootprint( const wxString& aLibraryPath,
+                                                    const wxString& aFootprintName,
+                                                    const PROPERTIES* aProperties,
+                                                    bool checkModified )
 {
-    LOCALE_IO   toggle;     // toggles on, then off, the C locale.
-
     init( aProperties );
 
     try
@@ -2081,14 +2345,7 @@ const MODULE* PCB_IO::getFootprint( const wxString& aLibraryPath,
         // do nothing with the error
     }
 
-    const MODULE_MAP& mods = m_cache->GetModules();
-
-    MODULE_CITER it = mods.find( aFootprintName );
-
-    if( it == mods.end() )
-        return nullptr;
-
-    return it->second->GetModule();
+    return m_cache->GetModule( aFootprintName );
 }
 
 
@@ -2096,7 +2353,19 @@ const MODULE* PCB_IO::GetEnumeratedFootprint( const wxString& aLibraryPath,
                                               const wxString& aFootprintName,
                                               const PROPERTIES* aProperties )
 {
-    return getFootprint( aLibraryPath, aFootprintName, aProperties, false );
+    // The previous footprint is released first, so a bounded cache can delete it
+    m_enumeratedFootprint.reset();
+
+    try
+    {
+        m_enumeratedFootprint = getFootprint( aLibraryPath, aFootprintName, aProperties, false );
+    }
+    catch( const IO_ERROR& )
+    {
+        // A footprint of a lazy cache which fails to parse is handled as a broken one
+    }
+
+    return m_enumeratedFootprint.get();
 }
 
 
@@ -2119,7 +2388,8 @@ bool PCB_IO::FootprintExists( const wxString& aLibraryPath, const wxString& aFoo
 MODULE* PCB_IO::FootprintLoad( const wxString& aLibraryPath, const wxString& aFootprintName,
                                const PROPERTIES* aProperties )
 {
-    const MODULE* footprint = getFootprint( aLibraryPath, aFootprintName, aProperties, true );
+    std::shared_ptr<const MODULE> footprint = getFootprint( aLibraryPath, aFootprintName,
+                                                            aProperties, true );
     return footprint ? new MODULE( *footprint ) : nullptr;
 }
 
@@ -2127,8 +2397,6 @@ MODULE* PCB_IO::FootprintLoad( const wxString& aLibraryPath, const wxString& aFo
 void PCB_IO::FootprintSave( const wxString& aLibraryPath, const MODULE* aFootprint,
                             const PROPERTIES* aProperties )
 {
-    LOCALE_IO   toggle;     // toggles on, then off, the C locale.
-
     init( aProperties );
 
     // In this public PLUGIN API function, we can safely assume it was
@@ -2231,8 +2499,6 @@ void PCB_IO::FootprintSave( const wxString& aLibraryPath, const MODULE* aFootpri
 void PCB_IO::FootprintDelete( const wxString& aLibraryPath, const wxString& aFootprintName,
                               const PROPERTIES* aProperties )
 {
-    LOCALE_IO   toggle;     // toggles on, then off, the C locale.
-
     init( aProperties );
 
     validateCache( aLibraryPath );
@@ -2262,8 +2528,6 @@ void PCB_IO::FootprintLibCreate( const wxString& aLibraryPath, const PROPERTIES*
                                           aLibraryPath.GetData() ) );
     }
 
-    LOCALE_IO   toggle;
-
     init( aProperties );
 
     delete m_cache;
@@ -2351,11 +2615,30 @@ bool PCB_IO::FootprintLibDelete( const wxString& aLibraryPath, const PROPERTIES*
 
 bool PCB_IO::IsFootprintLibWritable( const wxString& aLibraryPath )
 {
-    LOCALE_IO   toggle;
-
     init( NULL );
 
     validateCache( aLibraryPath );
 
     return m_cache->IsWritable();
 }
+
+
+void PCB_IO::FootprintLibOptions( PROPERTIES* aListToAppendTo ) const
+{
+    PLUGIN::FootprintLibOptions( aListToAppendTo );
+
+    (*aListToAppendTo)["lazy_load"] = UTF8( _(
+        "Parse each footprint when it is first used, instead of the whole library when it "
+        "is opened. The mere presence of this option turns it on, no need to set a Value."
+        ));
+
+    (*aListToAppendTo)["max_resident_footprints"] = UTF8( _(
+        "With <b>lazy_load</b>, the most footprints kept in memory. The least recently used "
+        "ones are dropped, and parsed again when needed."
+        ));
+
+    (*aListToAppendTo)["prefetch"] = UTF8( _(
+        "With <b>lazy_load</b>, parse the footprints in the background once the library "
+        "is opened."
+        ));
+}
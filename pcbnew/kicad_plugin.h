@@ -26,6 +26,7 @@
 #define KICAD_PLUGIN_H_
 
 #include <io_mgr.h>
+#include <memory>
 #include <string>
 #include <layers_id_colors_and_visibility.h>
 
@@ -123,6 +124,13 @@ public:
     void FootprintEnumerate( wxArrayString& aFootprintNames, const wxString& aLibraryPath,
                              const PROPERTIES* aProperties = NULL ) override;
 
+    /**
+     * Function GetEnumeratedFootprint
+     * @return the footprint, still owned by the plugin, or NULL if it is missing or broken.
+     *         It stays valid until the next call of this function or the plugin is deleted,
+     *         even if the library cache drops it meanwhile ("max_resident_footprints"
+     *         option) or is read again.
+     */
     const MODULE* GetEnumeratedFootprint( const wxString& aLibraryPath,
                                           const wxString& aFootprintName,
                                           const PROPERTIES* aProperties = NULL ) override;
@@ -147,6 +155,8 @@ public:
 
     bool IsFootprintLibWritable( const wxString& aLibraryPath ) override;
 
+    void FootprintLibOptions( PROPERTIES* aListToAppendTo ) const override;
+
     //-----</PLUGIN API>--------------------------------------------------------
 
     PCB_IO( int aControlFlags = CTL_FOR_BOARD );
@@ -185,6 +195,9 @@ protected:
     PROPERTIES*     m_props;        ///< passed via Save() or Load(), no ownership, may be NULL.
     FP_CACHE*       m_cache;        ///< Footprint library cache.
 
+    /// The last footprint returned by GetEnumeratedFootprint(), held for its caller
+    std::shared_ptr<const MODULE> m_enumeratedFootprint;
+
     LINE_READER*    m_reader;       ///< no ownership here.
     wxString        m_filename;     ///< for saves only, name is in m_reader for loads
 
@@ -199,8 +212,10 @@ protected:
 
     void validateCache( const wxString& aLibraryPath, bool checkModified = true );
 
-    const MODULE* getFootprint( const wxString& aLibraryPath, const wxString& aFootprintName,
-                  const PROPERTIES* aProperties, bool checkModified );
+    std::shared_ptr<const MODULE> getFootprint( const wxString& aLibraryPath,
+                                                const wxString& aFootprintName,
+                                                const PROPERTIES* aProperties,
+                                                bool checkModified );
 
     void init( const PROPERTIES* aProperties );
 
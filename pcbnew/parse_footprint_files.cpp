@@ -0,0 +1,101 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <parse_footprint_files.h>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+
+#include <class_module.h>
+#include <common.h>
+#include <ki_exception.h>
+
+
+///> Footprint files per thread below which a library is not worth splitting
+static const size_t MIN_FOOTPRINTS_PER_THREAD = 32;
+
+///> The extra parser threads of all the libraries being parsed
+static std::atomic<int> s_parserThreads( 0 );
+
+
+void ParseFootprintFiles( const std::vector<WX_FILENAME>& aFiles,
+        const std::function<MODULE*( const WX_FILENAME& aFile, int aThread )>& aParse,
+        std::vector<std::unique_ptr<MODULE>>& aFootprints, std::vector<wxString>& aErrors )
+{
+    aFootprints.clear();
+    aFootprints.resize( aFiles.size() );
+    aErrors.clear();
+    aErrors.resize( aFiles.size() );
+
+    std::atomic<size_t> nextFile( 0 );
+
+    auto parse_lambda = [&]( int aThread )
+    {
+        for( size_t ii = nextFile++; ii < aFiles.size(); ii = nextFile++ )
+        {
+            // Queue I/O errors so only files that fail to parse don't get loaded.
+            try
+            {
+                aFootprints[ii].reset( aParse( aFiles[ii], aThread ) );
+            }
+            catch( const IO_ERROR& ioe )
+            {
+                aErrors[ii] = ioe.What();
+            }
+        }
+    };
+
+    int maxThreads = (int) std::thread::hardware_concurrency() - 1;
+    int wanted = (int) std::min<size_t>( aFiles.size() / MIN_FOOTPRINTS_PER_THREAD,
+                                         std::thread::hardware_concurrency() ) - 1;
+    int threadCount = 0;
+    int running = s_parserThreads.load();
+
+    while( wanted > 0 && running < maxThreads )
+    {
+        threadCount = std::min( wanted, maxThreads - running );
+
+        if( s_parserThreads.compare_exchange_weak( running, running + threadCount ) )
+            break;
+
+        threadCount = 0;
+    }
+
+    std::vector<std::future<void>> returns( threadCount );
+
+    for( int ii = 0; ii < threadCount; ++ii )
+        returns[ii] = std::async( std::launch::async, parse_lambda, ii + 1 );
+
+    parse_lambda( 0 );
+
+    for( auto& ret : returns )
+        ret.wait();
+
+    s_parserThreads -= threadCount;
+
+    // Rethrow anything else than a parse error, as the calling thread would
+    for( auto& ret : returns )
+        ret.get();
+}
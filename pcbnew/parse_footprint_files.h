@@ -0,0 +1,55 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef PARSE_FOOTPRINT_FILES_H
+#define PARSE_FOOTPRINT_FILES_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <wx/string.h>
+
+class MODULE;
+class WX_FILENAME;
+
+
+/**
+ * Function ParseFootprintFiles
+ * parses the footprint files \a aFiles of a library into \a aFootprints, or their errors into
+ * \a aErrors, both in the order of \a aFiles.
+ *
+ * The files of a large library are split across extra threads.  FOOTPRINT_LIST_IMPL already
+ * loads the libraries in parallel, so the extra threads of all the libraries being parsed
+ * share one budget: a library only gets the cores the others leave idle.
+ *
+ * @param aParse parses one file, and throws an IO_ERROR if it cannot.  It runs on several
+ *               threads at once.  \a aThread is 0 on the calling thread, and a different
+ *               index below std::thread::hardware_concurrency() on each extra thread, so
+ *               that every thread can keep its own parser state.
+ */
+void ParseFootprintFiles( const std::vector<WX_FILENAME>& aFiles,
+        const std::function<MODULE*( const WX_FILENAME& aFile, int aThread )>& aParse,
+        std::vector<std::unique_ptr<MODULE>>& aFootprints, std::vector<wxString>& aErrors );
+
+#endif // PARSE_FOOTPRINT_FILES_H
@@ -125,11 +125,12 @@ void PCB_PARSER::pushValueIntoMap( int aIndex, int aValue )
 
 double PCB_PARSER::parseDouble()
 {
-    char* tmp;
+    const char* text = CurText();
+    double      fval = 0.0;
 
     errno = 0;
 
-    double fval = strtod( CurText(), &tmp );
+    const char* tmp = ParseDouble( text, text + CurStr().size(), fval );
 
     if( errno )
     {
@@ -140,7 +141,7 @@ double PCB_PARSER::parseDouble()
         THROW_IO_ERROR( error );
     }
 
-    if( CurText() == tmp )
+    if( text == tmp )
     {
         wxString error;
         error.Printf( _( "Missing floating point number in\nfile: \"%s\"\nline: %d\noffset: %d" ),
@@ -445,7 +446,6 @@ BOARD_ITEM* PCB_PARSER::Parse()
 {
     T               token;
     BOARD_ITEM*     item;
-    LOCALE_IO       toggle;
 
     // MODULEs can be prefixed with an initial block of single line comments and these
     // are kept for Format() so they round trip in s-expression form.  BOARDs might
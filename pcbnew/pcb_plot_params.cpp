@@ -178,8 +178,8 @@ void PCB_PLOT_PARAMS::Format( OUTPUTFORMATTER* aFormatter,
 
     aFormatter->Print( aNestLevel+1, "(%s %s)\n", getTokenName( T_excludeedgelayer ),
                        m_excludeEdgeLayer ? trueStr : falseStr );
-    aFormatter->Print( aNestLevel+1, "(%s %f)\n", getTokenName( T_linewidth ),
-                       m_lineWidth / IU_PER_MM );
+    aFormatter->Print( aNestLevel+1, "(%s %s)\n", getTokenName( T_linewidth ),
+                       OUTPUTFORMATTER::FormatDouble( m_lineWidth / IU_PER_MM, 6, true ).c_str() );
     aFormatter->Print( aNestLevel+1, "(%s %s)\n", getTokenName( T_plotframeref ),
                        m_plotFrameRef ? trueStr : falseStr );
     aFormatter->Print( aNestLevel+1, "(%s %s)\n", getTokenName( T_viasonmask ),
@@ -198,8 +198,8 @@ void PCB_PLOT_PARAMS::Format( OUTPUTFORMATTER* aFormatter,
 
     aFormatter->Print( aNestLevel+1, "(%s %d)\n", getTokenName( T_hpglpenspeed ),
                        m_HPGLPenSpeed );
-    aFormatter->Print( aNestLevel+1, "(%s %f)\n", getTokenName( T_hpglpendiameter ),
-                       m_HPGLPenDiam );
+    aFormatter->Print( aNestLevel+1, "(%s %s)\n", getTokenName( T_hpglpendiameter ),
+                       OUTPUTFORMATTER::FormatDouble( m_HPGLPenDiam, 6, true ).c_str() );
     aFormatter->Print( aNestLevel+1, "(%s %s)\n", getTokenName( T_psnegative ),
                        m_negative ? trueStr : falseStr );
     aFormatter->Print( aNestLevel+1, "(%s %s)\n", getTokenName( T_psa4output ),
@@ -574,7 +574,9 @@ double PCB_PLOT_PARAMS_PARSER::parseDouble()
     if( token != T_NUMBER )
         Expecting( T_NUMBER );
 
-    double val = strtod( CurText(), NULL );
+    double val = 0.0;
+
+    ParseDouble( CurText(), CurText() + CurStr().size(), val );
 
     return val;
 }
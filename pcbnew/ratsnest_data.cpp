@@ -39,6 +39,10 @@ using namespace std::placeholders;
 #include <cassert>
 #include <algorithm>
 #include <limits>
+#include <numeric>
+
+#include <advanced_config.h>
+#include <geometry/delaunay_triangulation.h>
 
 static uint64_t getDistance( const CN_ANCHOR_PTR& aNode1, const CN_ANCHOR_PTR& aNode2 )
 {
@@ -150,11 +154,129 @@ static const std::vector<CN_EDGE> kruskalMST( std::list<CN_EDGE>& aEdges,
 }
 
 
+/**
+ * An edge between two nodes of a net, identified by their index in RN_NET::m_nodes
+ */
+struct RN_MST_EDGE
+{
+    int      m_source;
+    int      m_target;
+    uint64_t m_weight;
+
+    bool operator<( const RN_MST_EDGE& aOther ) const
+    {
+        if( m_weight != aOther.m_weight )
+            return m_weight < aOther.m_weight;
+
+        if( m_source != aOther.m_source )
+            return m_source < aOther.m_source;
+
+        return m_target < aOther.m_target;
+    }
+};
+
+
+/**
+ * Kruskal algorithm on node indices, with a flat union-find instead of per-node lists.
+ * Edges of zero weight are existing connections: their nodes get the tag of the
+ * connected group they belong to, and they are not part of the ratsnest.
+ */
+static const std::vector<CN_EDGE> kruskalMST( std::vector<RN_MST_EDGE>& aEdges,
+        const std::vector<CN_ANCHOR_PTR>& aNodes )
+{
+    const int       nodeNumber = aNodes.size();
+    unsigned int    mstExpectedSize = nodeNumber - 1;
+    unsigned int    mstSize = 0;
+    bool            ratsnestLines = false;
+
+    std::vector<CN_EDGE> mst;
+
+    std::vector<int> parent( nodeNumber );
+    std::vector<int> size( nodeNumber, 1 );
+    std::iota( parent.begin(), parent.end(), 0 );
+
+    auto find = [&parent]( int aNode )
+    {
+        while( parent[aNode] != aNode )
+        {
+            parent[aNode] = parent[parent[aNode]];
+            aNode = parent[aNode];
+        }
+
+        return aNode;
+    };
+
+    auto tagConnected = [&]()
+    {
+        for( int i = 0; i < nodeNumber; i++ )
+            aNodes[i]->SetTag( find( i ) );
+    };
+
+    // Kruskal algorithm requires edges to be sorted by their weight
+    std::sort( aEdges.begin(), aEdges.end() );
+
+    for( const RN_MST_EDGE& edge : aEdges )
+    {
+        if( mstSize >= mstExpectedSize )
+            break;
+
+        int srcRoot = find( edge.m_source );
+        int trgRoot = find( edge.m_target );
+
+        // Check if by adding this edge we are going to join two different forests
+        if( srcRoot == trgRoot )
+            continue;
+
+        // Because edges are sorted by their weight, first we always process connected
+        // items (weight == 0). Once we stumble upon an edge with non-zero weight,
+        // it means that the rest of the lines are ratsnest.
+        if( !ratsnestLines && edge.m_weight != 0 )
+        {
+            ratsnestLines = true;
+            tagConnected();
+        }
+
+        if( ratsnestLines )
+        {
+            const CN_ANCHOR_PTR& src = aNodes[edge.m_source];
+            const CN_ANCHOR_PTR& dst = aNodes[edge.m_target];
+
+            assert( src->GetTag() != dst->GetTag() );
+
+            mst.emplace_back( src, dst, edge.m_weight );
+            ++mstSize;
+        }
+        else
+        {
+            // Processing a connection, decrease the expected size of the ratsnest MST
+            --mstExpectedSize;
+        }
+
+        if( size[srcRoot] < size[trgRoot] )
+            std::swap( srcRoot, trgRoot );
+
+        parent[trgRoot] = srcRoot;
+        size[srcRoot] += size[trgRoot];
+    }
+
+    if( !ratsnestLines )
+        tagConnected();
+
+    return mst;
+}
+
+
 class RN_NET::TRIANGULATOR_STATE
 {
 private:
     std::vector<CN_ANCHOR_PTR>  m_allNodes;
 
+    // Buffers of the index based triangulation, kept to avoid reallocating them
+    DELAUNAY_TRIANGULATION      m_delaunay;
+    std::vector<int>            m_order;
+    std::vector<VECTOR2I>       m_points;
+    std::vector<int>            m_pointNodes;
+
     std::list<hed::EDGE_PTR> hedTriangulation( std::vector<hed::NODE_PTR>& aNodes )
     {
         hed::TRIANGULATION triangulator;
@@ -316,6 +438,82 @@ public:
 
         return mstEdges;
     }
+
+    /**
+     * Triangulates aNodes into aEdges, which refer to the nodes by index.  Anchors sharing
+     * a position are chained together, and only one of them is triangulated.
+     */
+    void Triangulate( const std::vector<CN_ANCHOR_PTR>& aNodes, std::vector<RN_MST_EDGE>& aEdges )
+    {
+        const int nodeCount = aNodes.size();
+
+        m_order.resize( nodeCount );
+        std::iota( m_order.begin(), m_order.end(), 0 );
+
+        // Sort by position, then by cluster so coincident anchors of a cluster are chained
+        // together
+        std::sort( m_order.begin(), m_order.end(), [&aNodes]( int aA, int aB ) {
+            const VECTOR2I& posA = aNodes[aA]->Pos();
+            const VECTOR2I& posB = aNodes[aB]->Pos();
+
+            if( posA.y != posB.y )
+                return posA.y < posB.y;
+
+            if( posA.x != posB.x )
+                return posA.x < posB.x;
+
+            const CN_CLUSTER* clusterA = aNodes[aA]->GetCluster().get();
+            const CN_CLUSTER* clusterB = aNodes[aB]->GetCluster().get();
+
+            if( clusterA != clusterB )
+                return clusterA < clusterB;
+
+            return aA < aB;
+        } );
+
+        m_points.clear();
+        m_pointNodes.clear();
+
+        for( int i = 0; i < nodeCount; i++ )
+        {
+            const int   node = m_order[i];
+            const auto& anchor = aNodes[node];
+
+            if( i > 0 && aNodes[m_order[i - 1]]->Pos() == anchor->Pos() )
+            {
+                const auto& prevAnchor = aNodes[m_order[i - 1]];
+                uint64_t weight = prevAnchor->GetCluster() != anchor->GetCluster() ? 1 : 0;
+
+                aEdges.push_back( { m_order[i - 1], node, weight } );
+            }
+            else
+            {
+                m_points.push_back( anchor->Pos() );
+                m_pointNodes.push_back( node );
+            }
+        }
+
+        auto addEdge = [&]( int aPointA, int aPointB )
+        {
+            const int src = m_pointNodes[aPointA];
+            const int dst = m_pointNodes[aPointB];
+
+            aEdges.push_back( { src, dst, getDistance( aNodes[src], aNodes[dst] ) } );
+        };
+
+        if( m_delaunay.Triangulate( m_points ) )
+        {
+            m_delaunay.ForEachEdge( addEdge );
+        }
+        else
+        {
+            // special case: less than 3 positions, or all of them on the same line - there's
+            // no triangulation for such set. The points are sorted along the line, so chain
+            // them together.
+            for( int i = 0; i + 1 < (int) m_points.size(); i++ )
+                addEdge( i, i + 1 );
+        }
+    }
 };
 
 
@@ -356,35 +554,59 @@ void RN_NET::compute()
     }
 
 
-    m_triangulator->Clear();
-
-    for( auto n : m_nodes )
+    if( ADVANCED_CFG::GetCfg().m_legacyRatsnestTriangulation )
     {
-        m_triangulator->AddNode( n );
+        computeLegacy();
+        return;
     }
 
+    // Number the nodes, edges refer to them by index
+    for( unsigned int i = 0; i < m_nodes.size(); i++ )
+        m_nodes[i]->SetTag( i );
+
+    std::vector<RN_MST_EDGE> edges;
+    edges.reserve( 3 * m_nodes.size() + m_boardEdges.size() );
+
     #ifdef PROFILE
     PROF_COUNTER cnt("triangulate");
     #endif
-    auto triangEdges = m_triangulator->Triangulate();
+    m_triangulator->Triangulate( m_nodes, edges );
     #ifdef PROFILE
     cnt.Show();
     #endif
 
     for( const auto& e : m_boardEdges )
-        triangEdges.push_back( e );
+        edges.push_back( { e.GetSourceNode()->GetTag(), e.GetTargetNode()->GetTag(), 0 } );
 
 // Get the minimal spanning tree
 #ifdef PROFILE
     PROF_COUNTER cnt2("mst");
 #endif
-    m_rnEdges = kruskalMST( triangEdges, m_nodes );
+    m_rnEdges = kruskalMST( edges, m_nodes );
 #ifdef PROFILE
     cnt2.Show();
 #endif
 }
 
 
+void RN_NET::computeLegacy()
+{
+    m_triangulator->Clear();
+
+    for( auto n : m_nodes )
+    {
+        m_triangulator->AddNode( n );
+    }
+
+    auto triangEdges = m_triangulator->Triangulate();
+
+    for( const auto& e : m_boardEdges )
+        triangEdges.push_back( e );
+
+    m_rnEdges = kruskalMST( triangEdges, m_nodes );
+}
+
+
 
 void RN_NET::Update()
 {
@@ -114,6 +114,11 @@ public:
         return m_nodes.size();
     }
 
+    const std::vector<CN_ANCHOR_PTR>& GetAllNodes() const
+    {
+        return m_nodes;
+    }
+
     /**
      * Function GetNodes()
      * Returns list of nodes that are associated with a given item.
@@ -148,6 +153,9 @@ protected:
     ///> Recomputes ratsnest from scratch.
     void compute();
 
+    ///> Recomputes ratsnest from scratch with the former halfedge based triangulator.
+    void computeLegacy();
+
     ///> Vector of nodes
     std::vector<CN_ANCHOR_PTR> m_nodes;
 
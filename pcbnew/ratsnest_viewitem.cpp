@@ -61,11 +61,6 @@ const BOX2I RATSNEST_VIEWITEM::ViewBBox() const
 
 void RATSNEST_VIEWITEM::ViewDraw( int aLayer, KIGFX::VIEW* aView ) const
 {
-    std::unique_lock<std::mutex> lock( m_data->GetLock(), std::try_to_lock );
-
-    if( !lock )
-        return;
-
     constexpr int CROSS_SIZE = 200000;
 
     auto gal = aView->GetGAL();
@@ -81,8 +76,11 @@ void RATSNEST_VIEWITEM::ViewDraw( int aLayer, KIGFX::VIEW* aView ) const
 
     const bool curved_ratsnest = rs->GetCurvedRatsnestLinesEnabled();
 
-    // Draw the "dynamic" ratsnest (i.e. for objects that may be currently being moved)
-    for( const auto& l : m_data->GetDynamicRatsnest() )
+    // Draw the "dynamic" ratsnest (i.e. for objects that may be currently being moved).
+    // It is published atomically by the ratsnest worker, so it needs no lock.
+    const auto dynamicRatsnest = m_data->GetDynamicRatsnest();
+
+    for( const auto& l : *dynamicRatsnest )
     {
         if ( l.a == l.b )
         {
@@ -108,6 +106,11 @@ void RATSNEST_VIEWITEM::ViewDraw( int aLayer, KIGFX::VIEW* aView ) const
         }
     }
 
+    std::unique_lock<std::mutex> lock( m_data->GetLock(), std::try_to_lock );
+
+    if( !lock )
+        return;
+
     for( int i = 1 /* skip "No Net" at [0] */; i < m_data->GetNetCount(); ++i )
     {
         RN_NET* net = m_data->GetRatsnestForNet( i );
@@ -30,6 +30,15 @@
 
 %include connectivity/connectivity_data.h
 
+%extend CONNECTIVITY_DATA
+{
+    // The C++ version returns the shared lines published by the ratsnest worker, which
+    // SWIG does not wrap.  Scripts get a copy of them.
+    std::vector<RN_DYNAMIC_LINE> GetDynamicRatsnest() const
+    {
+        return *$self->GetDynamicRatsnest();
+    }
+}
  
 
 
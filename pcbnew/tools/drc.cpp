@@ -46,6 +46,7 @@
 #include <tools/pcb_actions.h>
 #include <tools/pcb_tool_base.h>
 #include <kiface_i.h>
+#include <advanced_config.h>
 #include <pcbnew.h>
 #include <tools/drc.h>
 #include <pcb_netlist.h>
@@ -57,12 +58,25 @@
 #include <geometry/shape_arc.h>
 
 #include <drc/courtyard_overlap.h>
+#include <drc/drc_rtree.h>
+#include <drc/drilled_hole_clearance.h>
+#include <profile.h>
+#include <zone_filler.h>
 #include "zone_filler_tool.h"
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
 DRC::DRC() :
         PCB_TOOL_BASE( "pcbnew.DRCTool" )
 {
     m_drcDialog  = NULL;
+    m_pcbEditorFrame = nullptr;
+    m_pcb = nullptr;
 
     // establish initial values for everything:
     m_doPad2PadTest     = true;         // enable pad to pad clearance tests
@@ -81,13 +95,11 @@ DRC::DRC() :
 
     m_currentMarker = NULL;
 
-    m_segmAngle  = 0;
-    m_segmLength = 0;
-
-    m_xcliplo = 0;
-    m_ycliplo = 0;
-    m_xcliphi = 0;
-    m_ycliphi = 0;
+    m_onlineOutlinesValid = false;
+    m_onlineIndexValid = false;
+    m_onlineIndexClearance = 0;
+    m_onlineMarkersRevision = 0;
+    m_onlineMarkersValid = false;
 }
 
 
@@ -112,6 +124,8 @@ void DRC::Reset( RESET_REASON aReason )
 
         m_pcb = m_pcbEditorFrame->GetBoard();
 
+        resetOnlineCheck();
+
         m_markerFactory.SetUnitsProvider( [=]() { return m_pcbEditorFrame->GetUserUnits(); } );
     }
 }
@@ -163,12 +177,43 @@ int DRC::ShowDRCDialog( const TOOL_EVENT& aEvent )
 
 void DRC::addMarkerToPcb( MARKER_PCB* aMarker )
 {
+    if( m_markerHandler )
+    {
+        m_markerHandler( aMarker );
+        return;
+    }
+
     BOARD_COMMIT commit( m_pcbEditorFrame );
     commit.Add( aMarker );
     commit.Push( wxEmptyString, false, false );
 }
 
 
+void DRC::addMarkersToPcb( const std::vector<MARKER_PCB*>& aMarkers )
+{
+    if( m_markerHandler )
+    {
+        for( MARKER_PCB* marker : aMarkers )
+            m_markerHandler( marker );
+
+        return;
+    }
+
+    BOARD_COMMIT commit( m_pcbEditorFrame );
+
+    for( MARKER_PCB* marker : aMarkers )
+        commit.Add( marker );
+
+    commit.Push( wxEmptyString, false, false );
+}
+
+
+EDA_UNITS_T DRC::userUnits() const
+{
+    return m_pcbEditorFrame ? m_pcbEditorFrame->GetUserUnits() : MILLIMETRES;
+}
+
+
 void DRC::DestroyDRCDialog( int aReason )
 {
     if( m_drcDialog )
@@ -183,8 +228,7 @@ void DRC::DestroyDRCDialog( int aReason )
 
 int DRC::TestZoneToZoneOutline( ZONE_CONTAINER* aZone, bool aCreateMarkers )
 {
-    BOARD* board = m_pcbEditorFrame->GetBoard();
-    BOARD_COMMIT commit( m_pcbEditorFrame );
+    BOARD* board = m_pcbEditorFrame ? m_pcbEditorFrame->GetBoard() : m_pcb;
     int nerrors = 0;
 
     std::vector<SHAPE_POLY_SET> smoothed_polys;
@@ -199,139 +243,260 @@ int DRC::TestZoneToZoneOutline( ZONE_CONTAINER* aZone, bool aCreateMarkers )
         zoneRef->BuildSmoothedPoly( smoothed_polys[ia], &colinearCorners );
     }
 
-    // iterate through all areas
+    // A pair of zones to compare, and the conflicts found between them
+    struct ZONE_PAIR
+    {
+        int                   m_ref;
+        int                   m_test;
+        int                   m_clearance;
+        std::vector<VECTOR2I> m_refCornersInTest;
+        std::vector<VECTOR2I> m_testCornersInRef;
+        std::set<wxPoint>     m_conflictPoints;
+    };
+
+    // Only zones on the same copper layer can conflict, so bucket them by layer
+    std::map<PCB_LAYER_ID, std::vector<int>> layerZones;
+    std::vector<BOX2I>                       bboxes( board->GetAreaCount() );
+
     for( int ia = 0; ia < board->GetAreaCount(); ia++ )
     {
-        ZONE_CONTAINER* zoneRef = board->GetArea( ia );
+        ZONE_CONTAINER* zone = board->GetArea( ia );
 
-        if( !zoneRef->IsOnCopperLayer() )
+        if( !zone->IsOnCopperLayer() )
             continue;
 
-        // When testing only a single area, skip all others
-        if( aZone && ( aZone != zoneRef) )
-            continue;
+        layerZones[ zone->GetLayer() ].push_back( ia );
+        bboxes[ia] = smoothed_polys[ia].BBox();
+    }
+
+    std::vector<ZONE_PAIR> pairs;
+
+    for( const auto& bucket : layerZones )
+    {
+        const std::vector<int>& zones = bucket.second;
 
-        // If we are testing a single zone, then iterate through all other zones
-        // Otherwise, we have already tested the zone combination
-        for( int ia2 = ( aZone ? 0 : ia + 1 ); ia2 < board->GetAreaCount(); ia2++ )
+        for( size_t ii = 0; ii < zones.size(); ii++ )
         {
-            ZONE_CONTAINER* zoneToTest = board->GetArea( ia2 );
+            int             ia = zones[ii];
+            ZONE_CONTAINER* zoneRef = board->GetArea( ia );
 
-            if( zoneRef == zoneToTest )
+            // When testing only a single area, skip all others
+            if( aZone && ( aZone != zoneRef) )
                 continue;
 
-            // test for same layer
-            if( zoneRef->GetLayer() != zoneToTest->GetLayer() )
-                continue;
+            // If we are testing a single zone, then iterate through all other zones
+            // Otherwise, we have already tested the zone combination
+            for( size_t jj = ( aZone ? 0 : ii + 1 ); jj < zones.size(); jj++ )
+            {
+                int             ia2 = zones[jj];
+                ZONE_CONTAINER* zoneToTest = board->GetArea( ia2 );
 
-            // Test for same net
-            if( zoneRef->GetNetCode() == zoneToTest->GetNetCode() && zoneRef->GetNetCode() >= 0 )
-                continue;
+                if( zoneRef == zoneToTest )
+                    continue;
 
-            // test for different priorities
-            if( zoneRef->GetPriority() != zoneToTest->GetPriority() )
-                continue;
+                // Test for same net
+                if( zoneRef->GetNetCode() == zoneToTest->GetNetCode()
+                        && zoneRef->GetNetCode() >= 0 )
+                    continue;
 
-            // test for different types
-            if( zoneRef->GetIsKeepout() != zoneToTest->GetIsKeepout() )
-                continue;
+                // test for different priorities
+                if( zoneRef->GetPriority() != zoneToTest->GetPriority() )
+                    continue;
 
-            // Examine a candidate zone: compare zoneToTest to zoneRef
+                // test for different types
+                if( zoneRef->GetIsKeepout() != zoneToTest->GetIsKeepout() )
+                    continue;
 
-            // Get clearance used in zone to zone test.  The policy used to
-            // obtain that value is now part of the zone object itself by way of
-            // ZONE_CONTAINER::GetClearance().
-            int zone2zoneClearance = zoneRef->GetClearance( zoneToTest );
+                // Get clearance used in zone to zone test.  The policy used to
+                // obtain that value is now part of the zone object itself by way of
+                // ZONE_CONTAINER::GetClearance().
+                int zone2zoneClearance = zoneRef->GetClearance( zoneToTest );
 
-            // Keepout areas have no clearance, so set zone2zoneClearance to 1
-            // ( zone2zoneClearance = 0  can create problems in test functions)
-            if( zoneRef->GetIsKeepout() )
-                zone2zoneClearance = 1;
+                // Keepout areas have no clearance, so set zone2zoneClearance to 1
+                // ( zone2zoneClearance = 0  can create problems in test functions)
+                if( zoneRef->GetIsKeepout() )
+                    zone2zoneClearance = 1;
 
-            // test for some corners of zoneRef inside zoneToTest
-            for( auto iterator = smoothed_polys[ia].IterateWithHoles(); iterator; iterator++ )
-            {
-                VECTOR2I currentVertex = *iterator;
-                wxPoint pt( currentVertex.x, currentVertex.y );
+                // Zones further apart than the clearance can neither overlap nor be
+                // too close
+                BOX2I refBox = bboxes[ia];
+                refBox.Inflate( zone2zoneClearance );
 
-                if( smoothed_polys[ia2].Contains( currentVertex ) )
-                {
-                    if( aCreateMarkers )
-                        commit.Add( m_markerFactory.NewMarker( pt, zoneRef, zoneToTest,
-                                                               DRCE_ZONES_INTERSECT ) );
+                if( !refBox.Intersects( bboxes[ia2] ) )
+                    continue;
 
-                    nerrors++;
-                }
+                ZONE_PAIR pair;
+                pair.m_ref = ia;
+                pair.m_test = ia2;
+                pair.m_clearance = zone2zoneClearance;
+                pairs.push_back( std::move( pair ) );
             }
+        }
+    }
 
-            // test for some corners of zoneToTest inside zoneRef
-            for( auto iterator = smoothed_polys[ia2].IterateWithHoles(); iterator; iterator++ )
-            {
-                VECTOR2I currentVertex = *iterator;
-                wxPoint pt( currentVertex.x, currentVertex.y );
+    // Report in the order of the zone list, whatever the layer buckets were
+    std::sort( pairs.begin(), pairs.end(), []( const ZONE_PAIR& a, const ZONE_PAIR& b )
+    {
+        return a.m_ref < b.m_ref || ( a.m_ref == b.m_ref && a.m_test < b.m_test );
+    } );
 
-                if( smoothed_polys[ia].Contains( currentVertex ) )
-                {
-                    if( aCreateMarkers )
-                        commit.Add( m_markerFactory.NewMarker( pt, zoneToTest, zoneRef,
-                                                               DRCE_ZONES_INTERSECT ) );
+    // Index the outline segments of each zone tested against another one, so each
+    // reference segment is only compared to the nearby ones
+    std::vector<std::vector<SEG>>                zoneSegments( board->GetAreaCount() );
+    std::vector<std::unique_ptr<DRC_RTREE<int>>> segmentIndex( board->GetAreaCount() );
 
-                    nerrors++;
-                }
-            }
+    for( const ZONE_PAIR& pair : pairs )
+    {
+        if( segmentIndex[pair.m_test] )
+            continue;
 
-            // Iterate through all the segments of refSmoothedPoly
-            std::set<wxPoint> conflictPoints;
+        std::vector<SEG>& segments = zoneSegments[pair.m_test];
+        segmentIndex[pair.m_test].reset( new DRC_RTREE<int>() );
 
-            for( auto refIt = smoothed_polys[ia].IterateSegmentsWithHoles(); refIt; refIt++ )
-            {
-                // Build ref segment
-                SEG refSegment = *refIt;
+        for( auto it = smoothed_polys[pair.m_test].CIterateSegmentsWithHoles(); it; it++ )
+        {
+            SEG   seg = *it;
+            BOX2I box( seg.A, seg.B - seg.A );
 
-                // Iterate through all the segments in smoothed_polys[ia2]
-                for( auto testIt = smoothed_polys[ia2].IterateSegmentsWithHoles(); testIt; testIt++ )
-                {
-                    // Build test segment
-                    SEG testSegment = *testIt;
-                    wxPoint pt;
-
-                    int ax1, ay1, ax2, ay2;
-                    ax1 = refSegment.A.x;
-                    ay1 = refSegment.A.y;
-                    ax2 = refSegment.B.x;
-                    ay2 = refSegment.B.y;
-
-                    int bx1, by1, bx2, by2;
-                    bx1 = testSegment.A.x;
-                    by1 = testSegment.A.y;
-                    bx2 = testSegment.B.x;
-                    by2 = testSegment.B.y;
-
-                    int d = GetClearanceBetweenSegments( bx1, by1, bx2, by2,
-                                                         0,
-                                                         ax1, ay1, ax2, ay2,
-                                                         0,
-                                                         zone2zoneClearance,
-                                                         &pt.x, &pt.y );
-
-                    if( d < zone2zoneClearance )
-                        conflictPoints.insert( pt );
-                }
-            }
+            segmentIndex[pair.m_test]->Insert( box.Normalize(), LSET(), (int) segments.size() );
+            segments.push_back( seg );
+        }
+    }
+
+    // Compare the zone pairs.  Nothing is written to the board here, so the pairs are
+    // shared between several threads.
+    auto testPair = [&]( ZONE_PAIR& aPair )
+    {
+        // Only read through const accessors: the edge index of each polygon, built by its
+        // first Contains(), is shared by all the pairs it belongs to
+        const SHAPE_POLY_SET& refPoly = smoothed_polys[aPair.m_ref];
+        const SHAPE_POLY_SET& testPoly = smoothed_polys[aPair.m_test];
+        const BOX2I&          refBox = bboxes[aPair.m_ref];
+        const BOX2I&          testBox = bboxes[aPair.m_test];
+
+        // test for some corners of zoneRef inside zoneToTest
+        for( auto iterator = refPoly.CIterateWithHoles(); iterator; iterator++ )
+        {
+            VECTOR2I currentVertex = *iterator;
+
+            if( testBox.Contains( currentVertex ) && testPoly.Contains( currentVertex ) )
+                aPair.m_refCornersInTest.push_back( currentVertex );
+        }
+
+        // test for some corners of zoneToTest inside zoneRef
+        for( auto iterator = testPoly.CIterateWithHoles(); iterator; iterator++ )
+        {
+            VECTOR2I currentVertex = *iterator;
+
+            if( refBox.Contains( currentVertex ) && refPoly.Contains( currentVertex ) )
+                aPair.m_testCornersInRef.push_back( currentVertex );
+        }
 
-            for( wxPoint pt : conflictPoints )
+        // Iterate through all the segments of refSmoothedPoly
+        const std::vector<SEG>& testSegments = zoneSegments[aPair.m_test];
+        DRC_RTREE<int>&         testIndex = *segmentIndex[aPair.m_test];
+        int                     zone2zoneClearance = aPair.m_clearance;
+        SEG                     refSegment;
+
+        auto checkSegment = [&]( int aIdx ) -> bool
+        {
+            const SEG& testSegment = testSegments[aIdx];
+            wxPoint    pt;
+
+            int d = GetClearanceBetweenSegments( testSegment.A.x, testSegment.A.y,
+                                                 testSegment.B.x, testSegment.B.y,
+                                                 0,
+                                                 refSegment.A.x, refSegment.A.y,
+                                                 refSegment.B.x, refSegment.B.y,
+                                                 0,
+                                                 zone2zoneClearance,
+                                                 &pt.x, &pt.y );
+
+            if( d < zone2zoneClearance )
+                aPair.m_conflictPoints.insert( pt );
+
+            return true;
+        };
+
+        for( auto refIt = refPoly.CIterateSegmentsWithHoles(); refIt; refIt++ )
+        {
+            refSegment = *refIt;
+
+            BOX2I area( refSegment.A, refSegment.B - refSegment.A );
+            area.Normalize();
+            area.Inflate( zone2zoneClearance );
+
+            testIndex.Query( area, LSET(), checkSegment );
+        }
+    };
+
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+                                                   ( pairs.size() + 7 ) / 8 );
+    std::atomic<size_t> nextPair( 0 );
+
+    if( parallelThreadCount <= 1 )
+    {
+        for( ZONE_PAIR& pair : pairs )
+            testPair( pair );
+    }
+    else
+    {
+        std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        {
+            returns[ii] = std::async( std::launch::async, [&]()
             {
-                if( aCreateMarkers )
-                    commit.Add( m_markerFactory.NewMarker( pt, zoneRef, zoneToTest,
-                                                           DRCE_ZONES_TOO_CLOSE ) );
+                for( size_t i = nextPair++; i < pairs.size(); i = nextPair++ )
+                    testPair( pairs[i] );
 
-                nerrors++;
-            }
+                return size_t( 1 );
+            } );
+        }
+
+        for( auto& ret : returns )
+            ret.wait();
+    }
+
+    std::vector<MARKER_PCB*> markers;
+
+    for( const ZONE_PAIR& pair : pairs )
+    {
+        ZONE_CONTAINER* zoneRef = board->GetArea( pair.m_ref );
+        ZONE_CONTAINER* zoneToTest = board->GetArea( pair.m_test );
+
+        for( const VECTOR2I& corner : pair.m_refCornersInTest )
+        {
+            if( aCreateMarkers )
+                markers.push_back( m_markerFactory.NewMarker( wxPoint( corner.x, corner.y ),
+                                                              zoneRef, zoneToTest,
+                                                              DRCE_ZONES_INTERSECT ) );
+
+            nerrors++;
+        }
+
+        for( const VECTOR2I& corner : pair.m_testCornersInRef )
+        {
+            if( aCreateMarkers )
+                markers.push_back( m_markerFactory.NewMarker( wxPoint( corner.x, corner.y ),
+                                                              zoneToTest, zoneRef,
+                                                              DRCE_ZONES_INTERSECT ) );
+
+            nerrors++;
+        }
+
+        for( const wxPoint& pt : pair.m_conflictPoints )
+        {
+            if( aCreateMarkers )
+                markers.push_back( m_markerFactory.NewMarker( pt, zoneRef, zoneToTest,
+                                                              DRCE_ZONES_TOO_CLOSE ) );
+
+            nerrors++;
         }
     }
 
     if( aCreateMarkers )
-        commit.Push( wxEmptyString, false, false );
+        addMarkersToPcb( markers );
 
     return nerrors;
 }
@@ -341,7 +506,20 @@ void DRC::RunTests( wxTextCtrl* aMessages )
 {
     // be sure m_pcb is the current board, not a old one
     // ( the board can be reloaded )
-    m_pcb = m_pcbEditorFrame->GetBoard();
+    if( m_pcbEditorFrame )
+        m_pcb = m_pcbEditorFrame->GetBoard();
+
+    m_testTimings.clear();
+
+    PROF_COUNTER testTimer;
+
+    // Record the time taken by the test which just ran, and restart the timer
+    auto recordTest = [&]( const wxString& aTest, size_t aItemCount )
+    {
+        testTimer.Stop();
+        m_testTimings.push_back( { aTest, aItemCount, testTimer.msecs() } );
+        testTimer.Start();
+    };
 
     if( aMessages )
     {
@@ -350,9 +528,13 @@ void DRC::RunTests( wxTextCtrl* aMessages )
     }
 
     testOutline();
+    recordTest( "outline", m_pcb->Drawings().size() );
 
     // someone should have cleared the two lists before calling this.
-    if( !testNetClasses() )
+    bool netclassesOk = testNetClasses();
+    recordTest( "netclasses", m_pcb->GetDesignSettings().m_NetClasses.GetCount() + 1 );
+
+    if( !netclassesOk )
     {
         // testing the netclasses is a special case because if the netclasses
         // do not pass the BOARD_DESIGN_SETTINGS checks, then every member of a net
@@ -377,6 +559,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         }
 
         testPad2Pad();
+        recordTest( "pad_clearances", m_pcb->GetPadCount() );
     }
 
     // test clearances between drilled holes
@@ -387,16 +570,31 @@ void DRC::RunTests( wxTextCtrl* aMessages )
     }
 
     testDrilledHoles();
+    recordTest( "drilled_holes", m_pcb->GetPadCount() + m_pcb->Tracks().size() );
 
     // caller (a wxTopLevelFrame) is the wxDialog or the Pcb Editor frame that call DRC:
     wxWindow* caller = aMessages ? aMessages->GetParent() : m_pcbEditorFrame;
 
-    if( m_refillZones )
+    if( !m_pcbEditorFrame )
+    {
+        // Batch mode: nobody can be asked about outdated fills, so zones are only
+        // refilled on request
+        if( m_refillZones )
+        {
+            std::vector<ZONE_CONTAINER*> toFill( m_pcb->Zones().begin(), m_pcb->Zones().end() );
+
+            ZONE_FILLER filler( m_pcb );
+            filler.Fill( toFill );
+            recordTest( "zone_fills", toFill.size() );
+        }
+    }
+    else if( m_refillZones )
     {
         if( aMessages )
             aMessages->AppendText( _( "Refilling all zones...\n" ) );
 
         m_toolMgr->GetTool<ZONE_FILLER_TOOL>()->FillAllZones( caller );
+        recordTest( "zone_fills", m_pcb->GetAreaCount() );
     }
     else
     {
@@ -404,6 +602,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
             aMessages->AppendText( _( "Checking zone fills...\n" ) );
 
         m_toolMgr->GetTool<ZONE_FILLER_TOOL>()->CheckAllZones( caller );
+        recordTest( "zone_fills", m_pcb->GetAreaCount() );
     }
 
     // test track and via clearances to other tracks, pads, and vias
@@ -413,7 +612,12 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         wxSafeYield();
     }
 
-    testTracks( aMessages ? aMessages->GetParent() : m_pcbEditorFrame, true );
+    // Tracks and pads are not modified by the following tests, so they share one index
+    m_copperIndex.Build( m_pcb );
+    recordTest( "copper_index", m_copperIndex.Tracks().size() + m_copperIndex.Pads().size() );
+
+    testTracks( caller, m_pcbEditorFrame != nullptr );
+    recordTest( "track_clearances", m_copperIndex.Tracks().size() );
 
     // test zone clearances to other zones
     if( aMessages )
@@ -423,6 +627,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
     }
 
     testZones();
+    recordTest( "zone_clearances", m_pcb->GetAreaCount() );
 
     // find and gather unconnected pads.
     if( m_doUnconnectedTest )
@@ -434,6 +639,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         }
 
         testUnconnected();
+        recordTest( "unconnected", m_pcb->GetPadCount() + m_pcb->Tracks().size() );
     }
 
     // find and gather vias, tracks, pads inside keepout areas.
@@ -446,6 +652,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         }
 
         testKeepoutAreas();
+        recordTest( "keepout_areas", m_pcb->GetAreaCount() );
     }
 
     // find and gather vias, tracks, pads inside text boxes.
@@ -456,6 +663,11 @@ void DRC::RunTests( wxTextCtrl* aMessages )
     }
 
     testCopperTextAndGraphics();
+    recordTest( "text_and_graphics", m_pcb->Drawings().size() + m_pcb->Modules().size() );
+
+    // The online check builds its own index again
+    m_copperIndex.Clear();
+    m_onlineIndexValid = false;
 
     // find overlapping courtyard ares.
     if( m_pcb->GetDesignSettings().m_ProhibitOverlappingCourtyards
@@ -468,6 +680,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         }
 
         doFootprintOverlappingDrc();
+        recordTest( "courtyards", m_pcb->Modules().size() );
     }
 
     for( DRC_ITEM* footprintItem : m_footprints )
@@ -476,7 +689,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
     m_footprints.clear();
     m_footprintsTested = false;
 
-    if( m_testFootprints && !Kiface().IsSingle() )
+    if( m_testFootprints && m_pcbEditorFrame && !Kiface().IsSingle() )
     {
         if( aMessages )
         {
@@ -492,10 +705,13 @@ void DRC::RunTests( wxTextCtrl* aMessages )
 
         TestFootprints( netlist, m_pcb, m_drcDialog->GetUserUnits(), m_footprints );
         m_footprintsTested = true;
+        recordTest( "footprints", m_pcb->Modules().size() );
     }
 
     // Check if there are items on disabled layers
     testDisabledLayers();
+    recordTest( "disabled_layers", m_pcb->Tracks().size() + m_pcb->Modules().size()
+                                           + m_pcb->GetAreaCount() );
 
     if( aMessages )
     {
@@ -517,10 +733,25 @@ void DRC::RunTests( wxTextCtrl* aMessages )
 }
 
 
+void DRC::RunBatchTests( BOARD* aBoard, DRC_PROVIDER::MARKER_HANDLER aMarkerHandler )
+{
+    wxCHECK( !m_pcbEditorFrame, /*void*/ );
+
+    m_pcb = aBoard;
+    m_markerHandler = aMarkerHandler;
+    m_markerFactory.SetUnits( MILLIMETRES );
+
+    RunTests( nullptr );
+
+    m_markerHandler = nullptr;
+}
+
+
 void DRC::updatePointers()
 {
     // update my pointers, m_pcbEditorFrame is the only unchangeable one
-    m_pcb = m_pcbEditorFrame->GetBoard();
+    if( m_pcbEditorFrame )
+        m_pcb = m_pcbEditorFrame->GetBoard();
 
     if( m_drcDialog )  // Use diag list boxes only in DRC dialog
     {
@@ -542,7 +773,7 @@ bool DRC::doNetClass( const NETCLASSPTR& nc, wxString& msg )
 
     const BOARD_DESIGN_SETTINGS& g = m_pcb->GetDesignSettings();
 
-#define FmtVal( x ) GetChars( StringFromValue( m_pcbEditorFrame->GetUserUnits(), x ) )
+#define FmtVal( x ) GetChars( StringFromValue( userUnits(), x ) )
 
 #if 0   // set to 1 when (if...) BOARD_DESIGN_SETTINGS has a m_MinClearance value
     if( nc->GetClearance() < g.m_MinClearance )
@@ -685,131 +916,563 @@ void DRC::testPad2Pad()
 
 void DRC::testDrilledHoles()
 {
-    int holeToHoleMin = m_pcb->GetDesignSettings().m_HoleToHoleMin;
+    DRC_DRILLED_HOLE_CLEARANCE drc_holes(
+            m_markerFactory, [&]( MARKER_PCB* aMarker ) { addMarkerToPcb( aMarker ); } );
 
-    if( holeToHoleMin == 0 )    // No min setting turns testing off.
-        return;
+    drc_holes.RunDRC( *m_pcb );
+}
 
-    // Test drilled hole clearances to minimize drill bit breakage.
-    //
-    // Notes: slots are milled, so we're only concerned with circular holes
-    //        microvias are laser-drilled, so we're only concerned with standard vias
 
-    struct DRILLED_HOLE
+void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
+{
+    wxProgressDialog * progressDialog = NULL;
+    const int delta = 500;  // This is the number of tests between 2 calls to the
+                            // progress bar
+
+    const std::vector<TRACK*>& tracks = m_copperIndex.Tracks();
+
+    int deltamax = tracks.size() / delta;
+
+    if( aShowProgressBar && deltamax > 3 )
+    {
+        // Do not use wxPD_APP_MODAL style here: it is not necessary and create issues
+        // on OSX
+        progressDialog = new wxProgressDialog( _( "Track clearances" ), wxEmptyString,
+                                               deltamax, aActiveWindow,
+                                               wxPD_AUTO_HIDE | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME );
+        progressDialog->Update( 0, wxEmptyString );
+    }
+
+    const int searchMargin = m_copperIndex.GetSearchMargin();
+
+    std::vector<std::vector<MARKER_PCB*>> trackMarkers( tracks.size() );
+    std::atomic<size_t>                   nextItem( 0 );
+    std::atomic<size_t>                   doneItems( 0 );
+    std::atomic<bool>                     cancelled( false );
+
+    auto drc_lambda = [&]() -> size_t
     {
-        wxPoint     m_location;
-        int         m_drillRadius;
-        BOARD_ITEM* m_owner;
+        std::vector<TRACK*> candidateTracks;
+        std::vector<D_PAD*> candidatePads;
+
+        for( size_t i = nextItem++; i < tracks.size() && !cancelled; i = nextItem++ )
+        {
+            TRACK*   refSeg = tracks[i];
+            EDA_RECT area = refSeg->GetBoundingBox();
+            LSET     layers = refSeg->GetLayerSet();
+
+            area.Inflate( searchMargin );
+
+            // Earlier tracks have already been tested against this one
+            m_copperIndex.QueryTracks( area, layers, candidateTracks, i + 1 );
+            m_copperIndex.QueryPads( area, layers, candidatePads );
+
+            // Test new segment against tracks and pads, optionally against copper zones
+            doTrackDrc( refSeg, candidateTracks, candidatePads, m_doZonesTest, trackMarkers[i] );
+
+            doneItems++;
+        }
+
+        return 1;
     };
 
-    std::vector<DRILLED_HOLE> holes;
-    DRILLED_HOLE              hole;
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+            ( tracks.size() + 7 ) / 8 );
+    parallelThreadCount = std::max<size_t>( parallelThreadCount, 1 );
+
+    std::vector<std::future<size_t>> returns( parallelThreadCount );
 
-    for( MODULE* mod : m_pcb->Modules() )
+    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        returns[ii] = std::async( std::launch::async, drc_lambda );
+
+    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
     {
-        for( D_PAD* pad : mod->Pads( ) )
+        // Here we balance returns with a 100ms timeout to allow UI updating
+        std::future_status status;
+
+        do
         {
-            if( pad->GetDrillSize().x && pad->GetDrillShape() == PAD_DRILL_SHAPE_CIRCLE )
+            if( progressDialog && !cancelled )
             {
-                hole.m_location = pad->GetPosition();
-                hole.m_drillRadius = pad->GetDrillSize().x / 2;
-                hole.m_owner = pad;
-                holes.push_back( hole );
+                int count = std::min<int>( doneItems / delta, deltamax );
+
+                if( !progressDialog->Update( count, wxEmptyString ) )
+                    cancelled = true;   // Aborted by user
+#ifdef __WXMAC__
+                // Work around a dialog z-order issue on OS X
+                if( count == deltamax )
+                    aActiveWindow->Raise();
+#endif
             }
-        }
+
+            status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
+        } while( status != std::future_status::ready );
     }
 
-    for( TRACK* track : m_pcb->Tracks() )
+    // Markers are added in track order, as if the tracks had been tested one by one
+    std::vector<MARKER_PCB*> markers;
+
+    for( const std::vector<MARKER_PCB*>& markersOfTrack : trackMarkers )
+        markers.insert( markers.end(), markersOfTrack.begin(), markersOfTrack.end() );
+
+    addMarkersToPcb( markers );
+
+    if( progressDialog )
+        progressDialog->Destroy();
+}
+
+
+/**
+ * @return true if aErrorCode is reported by the track tests (see doTrackDrc()), i.e. if
+ * the online check can find the error again
+ */
+static bool isTrackError( int aErrorCode )
+{
+    switch( aErrorCode )
     {
-        VIA* via = dynamic_cast<VIA*>( track );
-        if( via && via->GetViaType() == VIA_THROUGH )
+    case DRCE_TRACK_NEAR_THROUGH_HOLE:
+    case DRCE_TRACK_NEAR_PAD:
+    case DRCE_TRACK_NEAR_VIA:
+    case DRCE_VIA_NEAR_VIA:
+    case DRCE_VIA_NEAR_TRACK:
+    case DRCE_TRACK_ENDS1:
+    case DRCE_TRACK_ENDS2:
+    case DRCE_TRACK_ENDS3:
+    case DRCE_TRACK_ENDS4:
+    case DRCE_TRACK_SEGMENTS_TOO_CLOSE:
+    case DRCE_TRACKS_CROSSING:
+    case DRCE_ENDS_PROBLEM1:
+    case DRCE_ENDS_PROBLEM2:
+    case DRCE_ENDS_PROBLEM3:
+    case DRCE_ENDS_PROBLEM4:
+    case DRCE_ENDS_PROBLEM5:
+    case DRCE_TRACK_NEAR_ZONE:
+    case DRCE_TRACK_NEAR_EDGE:
+    case DRCE_TOO_SMALL_TRACK_WIDTH:
+    case DRCE_TOO_SMALL_VIA:
+    case DRCE_TOO_SMALL_MICROVIA:
+    case DRCE_TOO_SMALL_VIA_DRILL:
+    case DRCE_TOO_SMALL_MICROVIA_DRILL:
+    case DRCE_VIA_HOLE_BIGGER:
+    case DRCE_MICRO_VIA_INCORRECT_LAYER_PAIR:
+    case DRCE_MICRO_VIA_NOT_ALLOWED:
+    case DRCE_BURIED_VIA_NOT_ALLOWED:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+/**
+ * Index aMarker in aMarkers by its main and aux items, if it is a track error
+ */
+static void mapTrackMarker( std::unordered_multimap<const void*, MARKER_PCB*>& aMarkers,
+                            MARKER_PCB* aMarker )
+{
+    const DRC_ITEM& drcItem = aMarker->GetReporter();
+
+    if( !isTrackError( drcItem.GetErrorCode() ) )
+        return;
+
+    const void* mainItem = drcItem.GetMainItemWeakRef();
+    const void* auxItem = drcItem.GetAuxItemWeakRef();
+
+    aMarkers.emplace( mainItem, aMarker );
+
+    if( auxItem && auxItem != mainItem )
+        aMarkers.emplace( auxItem, aMarker );
+}
+
+
+/**
+ * Remove aMarker from aMarkers, see mapTrackMarker()
+ */
+static void unmapTrackMarker( std::unordered_multimap<const void*, MARKER_PCB*>& aMarkers,
+                              MARKER_PCB* aMarker )
+{
+    const DRC_ITEM& drcItem = aMarker->GetReporter();
+
+    for( const void* item : { drcItem.GetMainItemWeakRef(), drcItem.GetAuxItemWeakRef() } )
+    {
+        auto range = aMarkers.equal_range( item );
+
+        for( auto it = range.first; it != range.second; )
         {
-            hole.m_location = via->GetPosition();
-            hole.m_drillRadius = via->GetDrillValue() / 2;
-            hole.m_owner = via;
-            holes.push_back( hole );
+            if( it->second == aMarker )
+                it = aMarkers.erase( it );
+            else
+                ++it;
         }
     }
+}
+
+
+void DRC::QueueOnlineCheck( const std::vector<BOARD_ITEM*>& aChanged,
+                            const std::vector<BOARD_ITEM*>& aRemoved )
+{
+    if( !ADVANCED_CFG::GetCfg().m_onlineDrc )
+        return;
+
+    queueOnlineItems( aChanged, aRemoved );
+}
 
-    for( size_t ii = 0; ii < holes.size(); ++ii )
+
+void DRC::queueOnlineItems( const std::vector<BOARD_ITEM*>& aChanged,
+                            const std::vector<BOARD_ITEM*>& aRemoved )
+{
+    // The areas are taken now: removed items may be deleted before the check
+    auto queueEdge = [&]( BOARD_ITEM* aItem )
     {
-        const DRILLED_HOLE& refHole = holes[ ii ];
+        m_onlineOutlinesValid = false;
+        m_onlineAreas.push_back( { aItem->GetBoundingBox(), LSET::AllCuMask(), true } );
+    };
 
-        for( size_t jj = ii + 1; jj < holes.size(); ++jj )
+    auto queuePad = [&]( D_PAD* aPad )
+    {
+        LSET layers = aPad->GetDrillSize().x ? LSET::AllCuMask() : aPad->GetLayerSet();
+        m_onlineAreas.push_back( { aPad->GetBoundingBox(), layers, false } );
+    };
+
+    auto queueItem = [&]( BOARD_ITEM* aItem, bool aChanged )
+    {
+        // Markers are what the check produces, not what it checks
+        if( aItem->Type() == PCB_MARKER_T )
+            return;
+
+        std::vector<BOARD_ITEM*> items = { aItem };
+
+        if( aItem->Type() == PCB_MODULE_T )
         {
-            const DRILLED_HOLE& checkHole = holes[ jj ];
+            MODULE* module = static_cast<MODULE*>( aItem );
 
-            // Holes with identical locations are allowable
-            if( checkHole.m_location == refHole.m_location )
-                continue;
+            items.insert( items.end(), module->Pads().begin(), module->Pads().end() );
+            items.insert( items.end(), module->GraphicalItems().begin(),
+                          module->GraphicalItems().end() );
+        }
+
+        for( BOARD_ITEM* item : items )
+        {
+            if( item->GetLayer() == Edge_Cuts )
+                queueEdge( item );
+
+            if( item->Type() == PCB_PAD_T && aChanged )
+                queuePad( static_cast<D_PAD*>( item ) );
 
-            if( KiROUND( GetLineLength( checkHole.m_location, refHole.m_location ) )
-                    <  checkHole.m_drillRadius + refHole.m_drillRadius + holeToHoleMin )
+            if( item->Type() != PCB_MODULE_TEXT_T && item->Type() != PCB_MODULE_EDGE_T )
             {
-                addMarkerToPcb( new MARKER_PCB( m_pcbEditorFrame->GetUserUnits(),
-                                                DRCE_DRILLED_HOLES_TOO_CLOSE, refHole.m_location,
-                                                refHole.m_owner, refHole.m_location,
-                                                checkHole.m_owner, checkHole.m_location ) );
+                // An item changed, then removed, is not on the board anymore
+                if( aChanged )
+                {
+                    m_onlineChanged.insert( item );
+                }
+                else
+                {
+                    m_onlineChanged.erase( item );
+                    m_onlineRemoved.insert( item );
+                }
             }
         }
-    }
+    };
+
+    for( BOARD_ITEM* item : aChanged )
+        queueItem( item, true );
+
+    for( BOARD_ITEM* item : aRemoved )
+        queueItem( item, false );
 }
 
 
-void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
+int DRC::CheckQueuedItems( const TOOL_EVENT& aEvent )
 {
-    wxProgressDialog * progressDialog = NULL;
-    const int delta = 500;  // This is the number of tests between 2 calls to the
-                            // progress bar
-    int count = m_pcb->Tracks().size();
+    if( !m_onlineChanged.empty() || !m_onlineRemoved.empty() )
+        runOnlineCheck();
 
-    int deltamax = count/delta;
+    return 0;
+}
 
-    if( aShowProgressBar && deltamax > 3 )
+
+int DRC::ResetOnlineCheck( const TOOL_EVENT& aEvent )
+{
+    resetOnlineCheck();
+    return 0;
+}
+
+
+void DRC::RunBatchOnlineCheck( BOARD* aBoard, const std::vector<BOARD_ITEM*>& aChanged,
+                               const std::vector<BOARD_ITEM*>& aRemoved )
+{
+    wxCHECK( !m_pcbEditorFrame, /*void*/ );
+
+    if( aBoard != m_pcb )
     {
-        // Do not use wxPD_APP_MODAL style here: it is not necessary and create issues
-        // on OSX
-        progressDialog = new wxProgressDialog( _( "Track clearances" ), wxEmptyString,
-                                               deltamax, aActiveWindow,
-                                               wxPD_AUTO_HIDE | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME );
-        progressDialog->Update( 0, wxEmptyString );
+        resetOnlineCheck();
+        m_pcb = aBoard;
     }
 
-    int ii = 0;
-    count = 0;
+    m_markerFactory.SetUnits( MILLIMETRES );
+
+    queueOnlineItems( aChanged, aRemoved );
+
+    if( !m_onlineChanged.empty() || !m_onlineRemoved.empty() )
+        runOnlineCheck();
+}
+
+
+void DRC::resetOnlineCheck()
+{
+    m_onlineChanged.clear();
+    m_onlineRemoved.clear();
+    m_onlineAreas.clear();
+    m_onlineOutlinesValid = false;
+
+    m_copperIndex.Clear();
+    m_onlineIndexValid = false;
 
-    for( auto seg_it = m_pcb->Tracks().begin(); seg_it != m_pcb->Tracks().end(); seg_it++ )
+    m_onlineMarkers.clear();
+    m_onlineMarkersValid = false;
+}
+
+
+void DRC::updateOnlineIndex()
+{
+    BOARD_DESIGN_SETTINGS& bds = m_pcb->GetDesignSettings();
+
+    if( m_onlineIndexValid && !m_copperIndex.IsFragmented() )
     {
-        if( ii++ > delta )
+        // Removed items first: a changed item may have been allocated where a removed one was
+        for( BOARD_ITEM* item : m_onlineRemoved )
+            m_copperIndex.Remove( item );
+
+        for( BOARD_ITEM* item : m_onlineChanged )
         {
-            ii = 0;
-            count++;
+            // Pads are indexed with their footprint
+            if( item->Type() == PCB_PAD_T )
+            {
+                MODULE* module = static_cast<D_PAD*>( item )->GetParent();
 
-            if( progressDialog )
+                if( module && !m_onlineChanged.count( module ) )
+                    m_copperIndex.Insert( module );
+            }
+            else
             {
-                if( !progressDialog->Update( count, wxEmptyString ) )
-                    break;  // Aborted by user
-#ifdef __WXMAC__
-                // Work around a dialog z-order issue on OS X
-                if( count == deltamax )
-                    aActiveWindow->Raise();
-#endif
+                m_copperIndex.Insert( item );
             }
         }
+    }
+    else
+    {
+        m_onlineIndexValid = false;
+    }
 
-        // Test new segment against tracks and pads, optionally against copper zones
-        if( !doTrackDrc( *seg_it, seg_it + 1, m_pcb->Tracks().end(), m_doZonesTest ) )
+    // Items deleted without a commit, or larger clearances in the design rules, are caught
+    // here.  Both are rare, so the index is simply built again.
+    if( !m_onlineIndexValid
+            || m_copperIndex.GetTrackCount() != m_pcb->Tracks().size()
+            || m_copperIndex.GetFootprintCount() != m_pcb->Modules().size()
+            || m_onlineIndexClearance != bds.GetBiggestClearanceValue() )
+    {
+        m_copperIndex.Build( m_pcb );
+        m_onlineIndexClearance = bds.GetBiggestClearanceValue();
+        m_onlineIndexValid = true;
+    }
+}
+
+
+void DRC::syncOnlineMarkers()
+{
+    if( m_onlineMarkersValid && m_onlineMarkersRevision == m_pcb->GetMARKERsRevision() )
+        return;
+
+    m_onlineMarkers.clear();
+
+    for( int ii = 0; ii < m_pcb->GetMARKERCount(); ++ii )
+        mapTrackMarker( m_onlineMarkers, m_pcb->GetMARKER( ii ) );
+
+    m_onlineMarkersRevision = m_pcb->GetMARKERsRevision();
+    m_onlineMarkersValid = true;
+}
+
+
+void DRC::runOnlineCheck()
+{
+    if( m_pcbEditorFrame )
+        m_pcb = m_pcbEditorFrame->GetBoard();
+
+    if( !m_onlineOutlinesValid )
+    {
+        m_board_outlines.RemoveAllContours();
+        m_pcb->GetBoardPolygonOutlines( m_board_outlines );
+        m_onlineOutlinesValid = true;
+    }
+
+    // Removed items (and items changed, then removed) may have been deleted since they were
+    // queued: they are only compared to the indexed items and to the items of the markers.
+    updateOnlineIndex();
+    syncOnlineMarkers();
+
+    const int searchMargin = m_copperIndex.GetSearchMargin();
+    const int edgeMargin = std::max( searchMargin,
+                                     m_pcb->GetDesignSettings().m_CopperEdgeClearance );
+
+    // Rechecked tracks, and their position in that list
+    std::vector<TRACK*>                recheck;
+    std::unordered_map<TRACK*, size_t> recheckPos;
+    std::vector<TRACK*>                found;
+
+    auto addRecheck = [&]( TRACK* aTrack )
+    {
+        if( recheckPos.emplace( aTrack, recheck.size() ).second )
+            recheck.push_back( aTrack );
+    };
+
+    for( BOARD_ITEM* item : m_onlineChanged )
+    {
+        if( item->Type() == PCB_TRACE_T || item->Type() == PCB_VIA_T )
+            addRecheck( static_cast<TRACK*>( item ) );
+    }
+
+    // Tracks around changed pads and board edges are rechecked too
+    for( const ONLINE_AREA& area : m_onlineAreas )
+    {
+        EDA_RECT bbox = area.m_BBox;
+
+        bbox.Inflate( area.m_Edge ? edgeMargin : searchMargin );
+        m_copperIndex.QueryTracks( bbox, area.m_Layers, found );
+
+        for( TRACK* track : found )
+            addRecheck( track );
+    }
+
+    // Track errors involving a rechecked track are found again by the recheck, and those
+    // involving a removed item are gone
+    std::set<MARKER_PCB*> staleMarkers;
+
+    auto findStaleMarkers = [&]( const void* aItem )
+    {
+        auto range = m_onlineMarkers.equal_range( aItem );
+
+        for( auto it = range.first; it != range.second; ++it )
+            staleMarkers.insert( it->second );
+    };
+
+    for( BOARD_ITEM* item : m_onlineChanged )
+        findStaleMarkers( item );
+
+    for( BOARD_ITEM* item : m_onlineRemoved )
+        findStaleMarkers( item );
+
+    for( TRACK* track : recheck )
+        findStaleMarkers( track );
+
+    m_onlineChanged.clear();
+    m_onlineRemoved.clear();
+    m_onlineAreas.clear();
+
+    std::vector<std::vector<MARKER_PCB*>> trackMarkers( recheck.size() );
+    std::atomic<size_t>                   nextItem( 0 );
+
+    // The board is not modified while the workers run: the UI thread waits for them
+    auto drc_lambda = [&]() -> size_t
+    {
+        std::vector<TRACK*> candidateTracks;
+        std::vector<D_PAD*> candidatePads;
+
+        for( size_t i = nextItem++; i < recheck.size(); i = nextItem++ )
         {
-            if( m_currentMarker )
-            {
-                addMarkerToPcb ( m_currentMarker );
-                m_currentMarker = nullptr;
-            }
+            TRACK*   refSeg = recheck[i];
+            EDA_RECT area = refSeg->GetBoundingBox();
+            LSET     layers = refSeg->GetLayerSet();
+
+            area.Inflate( searchMargin );
+
+            m_copperIndex.QueryTracks( area, layers, candidateTracks );
+            m_copperIndex.QueryPads( area, layers, candidatePads );
+
+            // A pair of rechecked tracks is tested from the first one only
+            candidateTracks.erase( std::remove_if( candidateTracks.begin(), candidateTracks.end(),
+                    [&]( TRACK* aTrack )
+                    {
+                        auto it = recheckPos.find( aTrack );
+                        return it != recheckPos.end() && it->second <= i;
+                    } ),
+                    candidateTracks.end() );
+
+            doTrackDrc( refSeg, candidateTracks, candidatePads, m_doZonesTest, trackMarkers[i] );
+        }
+
+        return 1;
+    };
+
+    bool reportAllTrackErrors = m_reportAllTrackErrors;
+    m_reportAllTrackErrors = true;
+
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+            ( recheck.size() + 7 ) / 8 );
+
+    if( parallelThreadCount <= 1 )
+    {
+        drc_lambda();
+    }
+    else
+    {
+        std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii] = std::async( std::launch::async, drc_lambda );
+
+        for( auto& ret : returns )
+            ret.wait();
+    }
+
+    m_reportAllTrackErrors = reportAllTrackErrors;
+
+    for( MARKER_PCB* marker : staleMarkers )
+        unmapTrackMarker( m_onlineMarkers, marker );
+
+    for( const std::vector<MARKER_PCB*>& markers : trackMarkers )
+    {
+        for( MARKER_PCB* marker : markers )
+            mapTrackMarker( m_onlineMarkers, marker );
+    }
+
+    if( m_pcbEditorFrame )
+    {
+        BOARD_COMMIT commit( m_pcbEditorFrame );
+
+        for( MARKER_PCB* marker : staleMarkers )
+            commit.Remove( marker );
+
+        for( const std::vector<MARKER_PCB*>& markers : trackMarkers )
+        {
+            for( MARKER_PCB* marker : markers )
+                commit.Add( marker );
+        }
+
+        commit.Push( wxEmptyString, false, false );
+    }
+    else
+    {
+        for( MARKER_PCB* marker : staleMarkers )
+            m_pcb->Remove( marker );
+
+        for( const std::vector<MARKER_PCB*>& markers : trackMarkers )
+        {
+            for( MARKER_PCB* marker : markers )
+                m_pcb->Add( marker );
         }
     }
 
-    if( progressDialog )
-        progressDialog->Destroy();
+    // Removed markers are not kept for undo
+    for( MARKER_PCB* marker : staleMarkers )
+        delete marker;
+
+    // The markers changed above are already in m_onlineMarkers
+    m_onlineMarkersRevision = m_pcb->GetMARKERsRevision();
+
+    if( m_drcDialog )
+        m_drcDialog->UpdateDisplayedCounts();
 }
 
 
@@ -834,7 +1497,7 @@ void DRC::testUnconnected()
         auto src = edge.GetSourcePos();
         auto dst = edge.GetTargetPos();
 
-        m_unconnected.emplace_back( new DRC_ITEM( m_pcbEditorFrame->GetUserUnits(),
+        m_unconnected.emplace_back( new DRC_ITEM( userUnits(),
                                                   DRCE_UNCONNECTED_ITEMS,
                                                   edge.GetSourceNode()->Parent(),
                                                   wxPoint( src.x, src.y ),
@@ -1025,8 +1688,28 @@ void DRC::testCopperDrawItem( DRAWSEGMENT* aItem )
         break;
     }
 
+    if( itemShape.empty() )
+        return;
+
+    // Only the copper items near the drawing need to be tested
+    EDA_RECT area( (wxPoint) itemShape[0].A, wxSize( 0, 0 ) );
+
+    for( const SEG& itemSeg : itemShape )
+    {
+        area.Merge( (wxPoint) itemSeg.A );
+        area.Merge( (wxPoint) itemSeg.B );
+    }
+
+    area.Inflate( itemWidth / 2 + m_copperIndex.GetSearchMargin() );
+
+    std::vector<TRACK*> tracks;
+    std::vector<D_PAD*> pads;
+
+    m_copperIndex.QueryTracks( area, LSET( aItem->GetLayer() ), tracks );
+    m_copperIndex.QueryPads( area, LSET( aItem->GetLayer() ), pads );
+
     // Test tracks and vias
-    for( auto track : m_pcb->Tracks() )
+    for( auto track : tracks )
     {
         if( !track->IsOnLayer( aItem->GetLayer() ) )
             continue;
@@ -1050,7 +1733,7 @@ void DRC::testCopperDrawItem( DRAWSEGMENT* aItem )
     }
 
     // Test pads
-    for( auto pad : m_pcb->GetPads() )
+    for( auto pad : pads )
     {
         if( !pad->IsOnLayer( aItem->GetLayer() ) )
             continue;
@@ -1093,8 +1776,23 @@ void DRC::testCopperTextItem( BOARD_ITEM* aTextItem )
     EDA_RECT bbox = text->GetTextBox();
     SHAPE_RECT rect_area( bbox.GetX(), bbox.GetY(), bbox.GetWidth(), bbox.GetHeight() );
 
+    // Only the copper items near the text need to be tested
+    EDA_RECT area = bbox;
+    area.Normalize();
+
+    for( const wxPoint& pt : textShape )
+        area.Merge( pt );
+
+    area.Inflate( textWidth / 2 + m_copperIndex.GetSearchMargin() );
+
+    std::vector<TRACK*> tracks;
+    std::vector<D_PAD*> pads;
+
+    m_copperIndex.QueryTracks( area, LSET( aTextItem->GetLayer() ), tracks );
+    m_copperIndex.QueryPads( area, LSET( aTextItem->GetLayer() ), pads );
+
     // Test tracks and vias
-    for( auto track : m_pcb->Tracks() )
+    for( auto track : tracks )
     {
         if( !track->IsOnLayer( aTextItem->GetLayer() ) )
             continue;
@@ -1124,7 +1822,7 @@ void DRC::testCopperTextItem( BOARD_ITEM* aTextItem )
     }
 
     // Test pads
-    for( auto pad : m_pcb->GetPads() )
+    for( auto pad : pads )
     {
         if( !pad->IsOnLayer( aTextItem->GetLayer() ) )
             continue;
@@ -1172,7 +1870,7 @@ void DRC::testOutline()
 
 void DRC::testDisabledLayers()
 {
-    BOARD* board = m_pcbEditorFrame->GetBoard();
+    BOARD* board = m_pcb;
     wxCHECK( board, /*void*/ );
     LSET disabledLayers = board->GetEnabledLayers().flip();
 
@@ -1403,6 +2101,8 @@ void DRC::TestFootprints( NETLIST& aNetlist, BOARD* aPCB, EDA_UNITS_T aUnits,
 void DRC::setTransitions()
 {
     Go( &DRC::ShowDRCDialog,              PCB_ACTIONS::runDRC.MakeEvent() );
+    Go( &DRC::CheckQueuedItems,           TOOL_EVENT( TC_MESSAGE, TA_MODEL_CHANGE, AS_GLOBAL ) );
+    Go( &DRC::ResetOnlineCheck,           TOOL_EVENT( TC_MESSAGE, TA_UNDO_REDO_POST, AS_GLOBAL ) );
 }
 
 
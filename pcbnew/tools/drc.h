@@ -30,9 +30,13 @@
 #include <geometry/seg.h>
 #include <geometry/shape_poly_set.h>
 #include <memory>
+#include <set>
+#include <unordered_map>
 #include <vector>
 #include <tools/pcb_tool_base.h>
 #include <drc/drc_marker_factory.h>
+#include <drc/drc_copper_index.h>
+#include <drc/drc_provider.h>
 
 #define OK_DRC  0
 #define BAD_DRC 1
@@ -175,6 +179,17 @@ public:
 typedef std::vector<DRC_ITEM*> DRC_LIST;
 
 
+/**
+ * Time taken by one of the tests of DRC::RunTests(), and the number of items it tested.
+ */
+struct DRC_TEST_TIMING
+{
+    wxString    m_Test;             ///< short, untranslated name of the test
+    size_t      m_ItemCount;        ///< number of items tested
+    double      m_Msecs;            ///< wall time of the test
+};
+
+
 /**
  * Design Rule Checker object that performs all the DRC tests.  The output of
  * the checking goes to the BOARD file in the form of two MARKER lists.  Those
@@ -213,37 +228,70 @@ private:
     /* In DRC functions, many calculations are using coordinates relative
      * to the position of the segment under test (segm to segm DRC, segm to pad DRC
      * Next variables store coordinates relative to the start point of this segment
+     *
+     * These are scratch values of the segment currently under test.  Track DRC runs
+     * on several threads, so each thread gets its own copy.
      */
-    wxPoint m_padToTestPos; // Position of the pad to compare in drc test segm to pad or pad to pad
-    wxPoint m_segmEnd;      // End point of the reference segment (start point = (0,0) )
+    static thread_local wxPoint m_padToTestPos; // Position of the pad to compare in drc test
+                                                // segm to pad or pad to pad
+    static thread_local wxPoint m_segmEnd;      // End point of the reference segment
+                                                // (start point = (0,0) )
 
     /* Some functions are comparing the ref segm to pads or others segments using
      * coordinates relative to the ref segment considered as the X axis
      * so we store the ref segment length (the end point relative to these axis)
      * and the segment orientation (used to rotate other coordinates)
      */
-    double m_segmAngle;     // Ref segm orientation in 0,1 degre
-    int m_segmLength;       // length of the reference segment
+    static thread_local double m_segmAngle;     // Ref segm orientation in 0,1 degre
+    static thread_local int    m_segmLength;    // length of the reference segment
 
     /* variables used in checkLine to test DRC segm to segm:
      * define the area relative to the ref segment that does not contains any other segment
      */
-    int                 m_xcliplo;
-    int                 m_ycliplo;
-    int                 m_xcliphi;
-    int                 m_ycliphi;
+    static thread_local int m_xcliplo;
+    static thread_local int m_ycliplo;
+    static thread_local int m_xcliphi;
+    static thread_local int m_ycliphi;
 
     PCB_EDIT_FRAME*     m_pcbEditorFrame;   ///< The pcb frame editor which owns the board
     BOARD*              m_pcb;
     SHAPE_POLY_SET      m_board_outlines;   ///< The board outline including cutouts
     DIALOG_DRC_CONTROL* m_drcDialog;
     DRC_MARKER_FACTORY  m_markerFactory;    ///< Class that generates markers
+    DRC_COPPER_INDEX    m_copperIndex;      ///< Tracks and pads, indexed during a DRC run
 
     DRC_LIST            m_unconnected;      ///< list of unconnected pads, as DRC_ITEMs
     DRC_LIST            m_footprints;       ///< list of footprint warnings, as DRC_ITEMs
     bool                m_drcRun;
     bool                m_footprintsTested;
 
+    std::vector<DRC_TEST_TIMING> m_testTimings;     ///< timings of the last RunTests()
+
+    /// In batch mode (no editor frame), receives the markers instead of the board
+    DRC_PROVIDER::MARKER_HANDLER m_markerHandler;
+
+    ///> An area around a queued pad or board edge item, whose tracks are rechecked
+    struct ONLINE_AREA
+    {
+        EDA_RECT m_BBox;
+        LSET     m_Layers;
+        bool     m_Edge;        ///< Searched with the copper to edge clearance too
+    };
+
+    std::set<BOARD_ITEM*> m_onlineChanged;        ///< Items changed since the last online check
+    std::set<BOARD_ITEM*> m_onlineRemoved;        ///< Items removed since the last online check
+    std::vector<ONLINE_AREA> m_onlineAreas;       ///< Areas of the queued pads and edges
+    bool                  m_onlineOutlinesValid;  ///< m_board_outlines matches the board
+
+    /// m_copperIndex is kept between online checks, and matches the board if this is true
+    bool                  m_onlineIndexValid;
+    int                   m_onlineIndexClearance; ///< Biggest clearance of the rules then
+
+    /// The track error markers of the board, by their main and aux items
+    std::unordered_multimap<const void*, MARKER_PCB*> m_onlineMarkers;
+    unsigned              m_onlineMarkersRevision;  ///< BOARD::GetMARKERsRevision() of them
+    bool                  m_onlineMarkersValid;
+
 
     ///> Sets up handlers for various events.
     void setTransitions() override;
@@ -254,10 +302,55 @@ private:
     void updatePointers();
 
     /**
-     * Adds a DRC marker to the PCB through the COMMIT mechanism.
+     * Adds a DRC marker to the PCB through the COMMIT mechanism, or hands it to the
+     * marker handler in batch mode.
      */
     void addMarkerToPcb( MARKER_PCB* aMarker );
 
+    /**
+     * Adds several DRC markers to the PCB through a single commit, or hands them to the
+     * marker handler in batch mode.
+     */
+    void addMarkersToPcb( const std::vector<MARKER_PCB*>& aMarkers );
+
+    /**
+     * @return the units of the editor frame, or millimetres in batch mode
+     */
+    EDA_UNITS_T userUnits() const;
+
+    /**
+     * Recheck the tracks queued by QueueOnlineCheck(), and the tracks around the other
+     * queued items, and replace their track error markers.
+     *
+     * Rechecked tracks report all their errors, whatever m_reportAllTrackErrors is, since
+     * all their markers are replaced.
+     */
+    void runOnlineCheck();
+
+    /**
+     * Queue items for the online check, see QueueOnlineCheck()
+     */
+    void queueOnlineItems( const std::vector<BOARD_ITEM*>& aChanged,
+                           const std::vector<BOARD_ITEM*>& aRemoved );
+
+    /**
+     * Update m_copperIndex for the queued items, or build it again if it no longer
+     * matches the board.
+     */
+    void updateOnlineIndex();
+
+    /**
+     * Find the track error markers of the board again if they were added or removed
+     * since the last online check, other than by this check.
+     */
+    void syncOnlineMarkers();
+
+    /**
+     * Forget the queued items, the copper index and the markers of the online check, for
+     * edits made without a commit.
+     */
+    void resetOnlineCheck();
+
     //-----<categorical group tests>-----------------------------------------
 
     /**
@@ -274,6 +367,11 @@ private:
     /**
      * Perform the DRC on all tracks.
      *
+     * Candidate neighbours of each track are taken from an R-tree of tracks and pads,
+     * searched within the largest clearance found on the board, and tracks are tested
+     * on several threads.  Markers are added to the board in track order, so the result
+     * is the same as testing every track against every later track.
+     *
      * This test can take a while, a progress bar can be displayed
      * @param aActiveWindow = the active window ued as parent for the progress bar
      * @param aShowProgressBar = true to show a progress bar
@@ -292,6 +390,7 @@ private:
     void testKeepoutAreas();
 
     // aTextItem is type BOARD_ITEM* to accept either TEXTE_PCB or TEXTE_MODULE
+    // Both tests only look at the tracks and pads found near the item in m_copperIndex.
     void testCopperTextItem( BOARD_ITEM* aTextItem );
 
     void testCopperDrawItem( DRAWSEGMENT* aDrawing );
@@ -327,15 +426,19 @@ private:
     /**
      * Test the current segment.
      *
+     * This function does not touch the board: markers are handed back in aMarkers, in the
+     * order they must be added to the board, so it can be run on several threads at once.
+     *
      * @param aRefSeg The segment to test
-     * @param aStartIt the iterator to the first track to test
-     * @param aEndIt the marker for the iterator end
+     * @param aTracks the tracks to test aRefSeg against, in board order
+     * @param aPads the pads to test aRefSeg against, in board order
      * @param aTestZones true if should do copper zones test. This can be very time consumming
-     * @return bool - true if no problems, else false and m_currentMarker is
-     *          filled in with the problem information.
+     * @param aMarkers receives the markers created for aRefSeg
+     * @return bool - true if no problems, else false
      */
-    bool doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterator aEndIt,
-                     bool aTestZones );
+    bool doTrackDrc( TRACK* aRefSeg, const std::vector<TRACK*>& aTracks,
+                     const std::vector<D_PAD*>& aPads, bool aTestZones,
+                     std::vector<MARKER_PCB*>& aMarkers );
 
     /**
      * Test for footprint courtyard overlaps.
@@ -399,6 +502,8 @@ private:
 public:
     /**
      * Tests whether distance between zones complies with the DRC rules.
+     * Only zones on the same layer whose bounding boxes are within clearance of each other
+     * are compared; the pairs are tested in parallel and reported in zone list order.
      *
      * @param aZone: zone to compare with other zones, or if NULL then
      *          all zones are compared to all others.
@@ -448,6 +553,57 @@ public:
      * @param aMessages = a wxTextControl where to display some activity messages. Can be NULL
      */
     void RunTests( wxTextCtrl* aMessages = NULL );
+
+    /**
+     * Run the tests of RunTests() on aBoard without an editor frame, e.g. from a command
+     * line tool.  Nothing is displayed, and markers are handed to aMarkerHandler (which
+     * takes ownership) instead of being added to the board.
+     *
+     * Zones are refilled first if requested by SetRefillZones(), otherwise the fills are
+     * tested as they are.  The footprints against schematic test needs the schematic
+     * editor, so it is not run.
+     */
+    void RunBatchTests( BOARD* aBoard, DRC_PROVIDER::MARKER_HANDLER aMarkerHandler );
+
+    void SetRefillZones( bool aRefill ) { m_refillZones = aRefill; }
+    void SetTestTracksAgainstZones( bool aTest ) { m_doZonesTest = aTest; }
+    void SetReportAllTrackErrors( bool aReportAll ) { m_reportAllTrackErrors = aReportAll; }
+
+    /**
+     * @return the items found by the last unconnected items test, as DRC_ITEMs
+     */
+    const DRC_LIST& GetUnconnectedItems() const { return m_unconnected; }
+
+    /**
+     * @return the time taken by each test in the last RunTests() or RunBatchTests(),
+     * in the order they were run
+     */
+    const std::vector<DRC_TEST_TIMING>& GetTestTimings() const { return m_testTimings; }
+
+    /**
+     * Queue the items of a board commit for the online DRC, if it is enabled (see
+     * ADVANCED_CFG::m_onlineDrc).  The check itself runs when the commit's model change
+     * event is processed, so the items of several commits are checked at once.
+     *
+     * @param aChanged are the items added or modified by the commit
+     * @param aRemoved are the items removed by the commit.  Their pointers are only compared
+     * to the items of existing markers.
+     */
+    void QueueOnlineCheck( const std::vector<BOARD_ITEM*>& aChanged,
+                           const std::vector<BOARD_ITEM*>& aRemoved );
+
+    int CheckQueuedItems( const TOOL_EVENT& aEvent );
+
+    ///> Undo and redo modify the board without a commit
+    int ResetOnlineCheck( const TOOL_EVENT& aEvent );
+
+    /**
+     * Run the online check in batch mode, without an editor frame: queue aChanged and
+     * aRemoved as QueueOnlineCheck() would, whatever ADVANCED_CFG::m_onlineDrc is, and check
+     * them.  The markers are added to and removed from aBoard directly.
+     */
+    void RunBatchOnlineCheck( BOARD* aBoard, const std::vector<BOARD_ITEM*>& aChanged,
+                              const std::vector<BOARD_ITEM*>& aRemoved );
 };
 
 
@@ -37,7 +37,6 @@
 #include <math_for_graphics.h>
 #include <polygon_test_point_inside.h>
 #include <convert_basic_shapes_to_polygon.h>
-#include <board_commit.h>
 
 
 /**
@@ -106,14 +105,24 @@ bool poly2segmentDRC( wxPoint* aTref, int aTrefCount, wxPoint aSegStart, wxPoint
 }
 
 
+thread_local wxPoint DRC::m_padToTestPos;
+thread_local wxPoint DRC::m_segmEnd;
+thread_local double  DRC::m_segmAngle = 0;
+thread_local int     DRC::m_segmLength = 0;
+thread_local int     DRC::m_xcliplo = 0;
+thread_local int     DRC::m_ycliplo = 0;
+thread_local int     DRC::m_xcliphi = 0;
+thread_local int     DRC::m_ycliphi = 0;
+
+
 #define PUSH_NEW_MARKER_3( a, b, c ) push_back( m_markerFactory.NewMarker( a, b, c ) )
 #define PUSH_NEW_MARKER_4( a, b, c, d ) push_back( m_markerFactory.NewMarker( a, b, c, d ) )
 
 
-bool DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterator aEndIt,
-                      bool aTestZones )
+bool DRC::doTrackDrc( TRACK* aRefSeg, const std::vector<TRACK*>& aTracks,
+                      const std::vector<D_PAD*>& aPads, bool aTestZones,
+                      std::vector<MARKER_PCB*>& aMarkers )
 {
-    TRACK*    track;
     wxPoint   delta;           // length on X and Y axis of segments
     wxPoint   shape_pos;
 
@@ -121,12 +130,8 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterato
 
     auto commitMarkers = [&]()
     {
-        BOARD_COMMIT commit( m_pcbEditorFrame );
-
-        for( MARKER_PCB* marker : markers )
-            commit.Add( marker );
-
-        commit.Push( wxEmptyString, false, false );
+        aMarkers.insert( aMarkers.end(), markers.begin(), markers.end() );
+        markers.clear();
     };
 
     // Returns false if we should return false from call site, or true to continue
@@ -309,58 +314,55 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterato
     dummypad.SetLayerSet( LSET::AllCuMask() );     // Ensure the hole is on all layers
 
     // Compute the min distance to pads
-    for( MODULE* mod : m_pcb->Modules() )
+    for( D_PAD* pad : aPads )
     {
-        for( D_PAD* pad : mod->Pads() )
-        {
-            SEG padSeg( pad->GetPosition(), pad->GetPosition() );
-
-            // No problem if pads are on another layer, but if a drill hole exists (a pad on
-            // a single layer can have a hole!) we must test the hole
-            if( !( pad->GetLayerSet() & layerMask ).any() )
-            {
-                // We must test the pad hole. In order to use checkClearanceSegmToPad(), a
-                // pseudo pad is used, with a shape and a size like the hole
-                if( pad->GetDrillSize().x == 0 )
-                    continue;
-
-                dummypad.SetSize( pad->GetDrillSize() );
-                dummypad.SetPosition( pad->GetPosition() );
-                dummypad.SetShape( pad->GetDrillShape() == PAD_DRILL_SHAPE_OBLONG ?
-                                   PAD_SHAPE_OVAL : PAD_SHAPE_CIRCLE );
-                dummypad.SetOrientation( pad->GetOrientation() );
-
-                m_padToTestPos = dummypad.GetPosition() - origin;
-
-                if( !checkClearanceSegmToPad( &dummypad, ref_seg_width, ref_seg_clearance ) )
-                {
-                    markers.PUSH_NEW_MARKER_4( aRefSeg, pad, padSeg, DRCE_TRACK_NEAR_THROUGH_HOLE );
-
-                    if( !handleNewMarker() )
-                        return false;
-                }
+        SEG padSeg( pad->GetPosition(), pad->GetPosition() );
 
+        // No problem if pads are on another layer, but if a drill hole exists (a pad on
+        // a single layer can have a hole!) we must test the hole
+        if( !( pad->GetLayerSet() & layerMask ).any() )
+        {
+            // We must test the pad hole. In order to use checkClearanceSegmToPad(), a
+            // pseudo pad is used, with a shape and a size like the hole
+            if( pad->GetDrillSize().x == 0 )
                 continue;
-            }
 
-            // The pad must be in a net (i.e pt_pad->GetNet() != 0 )
-            // but no problem if the pad netcode is the current netcode (same net)
-            if( pad->GetNetCode()                       // the pad must be connected
-               && net_code_ref == pad->GetNetCode() )   // the pad net is the same as current net -> Ok
-                continue;
+            dummypad.SetSize( pad->GetDrillSize() );
+            dummypad.SetPosition( pad->GetPosition() );
+            dummypad.SetShape( pad->GetDrillShape() == PAD_DRILL_SHAPE_OBLONG ?
+                               PAD_SHAPE_OVAL : PAD_SHAPE_CIRCLE );
+            dummypad.SetOrientation( pad->GetOrientation() );
 
-            // DRC for the pad
-            shape_pos = pad->ShapePos();
-            m_padToTestPos = shape_pos - origin;
-            int segToPadClearance = std::max( ref_seg_clearance, pad->GetClearance() );
+            m_padToTestPos = dummypad.GetPosition() - origin;
 
-            if( !checkClearanceSegmToPad( pad, ref_seg_width, segToPadClearance ) )
+            if( !checkClearanceSegmToPad( &dummypad, ref_seg_width, ref_seg_clearance ) )
             {
-                markers.PUSH_NEW_MARKER_4( aRefSeg, pad, padSeg, DRCE_TRACK_NEAR_PAD );
+                markers.PUSH_NEW_MARKER_4( aRefSeg, pad, padSeg, DRCE_TRACK_NEAR_THROUGH_HOLE );
 
                 if( !handleNewMarker() )
                     return false;
             }
+
+            continue;
+        }
+
+        // The pad must be in a net (i.e pt_pad->GetNet() != 0 )
+        // but no problem if the pad netcode is the current netcode (same net)
+        if( pad->GetNetCode()                       // the pad must be connected
+           && net_code_ref == pad->GetNetCode() )   // the pad net is the same as current net -> Ok
+            continue;
+
+        // DRC for the pad
+        shape_pos = pad->ShapePos();
+        m_padToTestPos = shape_pos - origin;
+        int segToPadClearance = std::max( ref_seg_clearance, pad->GetClearance() );
+
+        if( !checkClearanceSegmToPad( pad, ref_seg_width, segToPadClearance ) )
+        {
+            markers.PUSH_NEW_MARKER_4( aRefSeg, pad, padSeg, DRCE_TRACK_NEAR_PAD );
+
+            if( !handleNewMarker() )
+                return false;
         }
     }
 
@@ -374,9 +376,8 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterato
     wxPoint segStartPoint;
     wxPoint segEndPoint;
 
-    for( auto it = aStartIt; it != aEndIt; it++ )
+    for( TRACK* track : aTracks )
     {
-        track = *it;
         // No problem if segments have the same net code:
         if( net_code_ref == track->GetNetCode() )
             continue;
@@ -675,7 +676,7 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterato
             SHAPE_POLY_SET* outline = const_cast<SHAPE_POLY_SET*>( &zone->GetFilledPolysList() );
 
             if( outline->Distance( refSeg, ref_seg_width ) < clearance )
-                addMarkerToPcb( m_markerFactory.NewMarker( aRefSeg, zone, DRCE_TRACK_NEAR_ZONE ) );
+                aMarkers.push_back( m_markerFactory.NewMarker( aRefSeg, zone, DRCE_TRACK_NEAR_ZONE ) );
         }
     }
 
@@ -691,7 +692,7 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACKS::iterator aStartIt, TRACKS::iterato
         SEG::ecoord w_dist = clearance + ref_seg_width / 2;
         SEG::ecoord w_dist_sq = w_dist * w_dist;
 
-        for( auto it = m_board_outlines.IterateSegmentsWithHoles(); it; it++ )
+        for( auto it = m_board_outlines.CIterateSegmentsWithHoles(); it; it++ )
         {
             if( test_seg.SquaredDistance( *it ) < w_dist_sq )
             {
@@ -48,7 +48,6 @@
 #include <view/view_group.h>
 #include <view/view_controls.h>
 #include <origin_viewitem.h>
-#include <profile.h>
 #include <widgets/progress_reporter.h>
 #include <dialogs/dialog_page_settings.h>
 #include <pcb_netlist.h>
@@ -148,7 +147,6 @@ PCB_EDITOR_CONTROL::PCB_EDITOR_CONTROL() :
     m_placeOrigin.reset( new KIGFX::ORIGIN_VIEWITEM( KIGFX::COLOR4D( 0.8, 0.0, 0.0, 1.0 ),
                                                 KIGFX::ORIGIN_VIEWITEM::CIRCLE_CROSS ) );
     m_probingSchToPcb = false;
-    m_slowRatsnest = false;
     m_lastNetcode = -1;
 }
 
@@ -1438,26 +1436,14 @@ int PCB_EDITOR_CONTROL::UpdateSelectionRatsnest( const TOOL_EVENT& aEvent )
     {
         connectivity->ClearDynamicRatsnest();
     }
-    else if( m_slowRatsnest )
-    {
-        // Compute ratsnest only when user stops dragging for a moment
-        connectivity->HideDynamicRatsnest();
-        m_ratsnestTimer.Start( 20 );
-    }
     else
     {
-        // Check how much time doest it take to calculate ratsnest
-        PROF_COUNTER counter;
+        // The ratsnest is computed in the background: the lines of the last update are
+        // drawn until the new ones are ready, and the timer redraws them when they are
         calculateSelectionRatsnest();
-        counter.Stop();
 
-        // If it is too slow, then switch to 'slow ratsnest' mode when
-        // ratsnest is calculated when user stops dragging items for a moment
-        if( counter.msecs() > 25 )
-        {
-            m_slowRatsnest = true;
-            connectivity->HideDynamicRatsnest();
-        }
+        if( !m_ratsnestTimer.IsRunning() )
+            m_ratsnestTimer.Start( 10 );
     }
 
     return 0;
@@ -1467,15 +1453,16 @@ int PCB_EDITOR_CONTROL::UpdateSelectionRatsnest( const TOOL_EVENT& aEvent )
 int PCB_EDITOR_CONTROL::HideDynamicRatsnest( const TOOL_EVENT& aEvent )
 {
     getModel<BOARD>()->GetConnectivity()->HideDynamicRatsnest();
-    m_slowRatsnest = false;
     return 0;
 }
 
 
 void PCB_EDITOR_CONTROL::ratsnestTimer( wxTimerEvent& aEvent )
 {
+    if( !board()->GetConnectivity()->IsDynamicRatsnestUpToDate() )
+        return;
+
     m_ratsnestTimer.Stop();
-    calculateSelectionRatsnest();
     m_frame->GetCanvas()->RedrawRatsnest();
     m_frame->GetCanvas()->Refresh();
 }
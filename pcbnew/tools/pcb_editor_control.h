@@ -144,7 +144,7 @@ public:
 private:
     bool highlightNet( const VECTOR2D& aPosition, bool aUseSelection );
 
-    ///> Event handler to recalculate dynamic ratsnest
+    ///> Event handler to redraw the dynamic ratsnest once the ratsnest worker published it
     void ratsnestTimer( wxTimerEvent& aEvent );
 
     ///> Recalculates dynamic ratsnest for the current selection
@@ -159,8 +159,7 @@ private:
     std::unique_ptr<KIGFX::ORIGIN_VIEWITEM> m_placeOrigin;    ///> Place & drill origin marker
 
     bool m_probingSchToPcb;     ///> Recursion guard when cross-probing to EESchema
-    bool m_slowRatsnest;        ///> Indicates current selection ratsnest will be slow to calculate
-    wxTimer m_ratsnestTimer;    ///> Timer to initiate lazy ratsnest calculation (ie: when slow)
+    wxTimer m_ratsnestTimer;    ///> Timer to redraw the selection ratsnest once it is computed
 
     int  m_lastNetcode;         ///> Used for toggling between last two highlighted nets
 
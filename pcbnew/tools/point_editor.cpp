@@ -886,11 +886,11 @@ bool POINT_EDITOR::addCornerCondition( const SELECTION& aSelection )
 static std::pair<bool, SHAPE_POLY_SET::VERTEX_INDEX>
 findVertex( SHAPE_POLY_SET& aPolySet, const EDIT_POINT& aPoint )
 {
-    for( auto it = aPolySet.IterateWithHoles(); it; ++it )
+    for( auto it = aPolySet.CIterateWithHoles(); it; ++it )
     {
         auto vertexIdx = it.GetIndex();
 
-        if( aPolySet.Vertex( vertexIdx ) == aPoint.GetPosition() )
+        if( aPolySet.CVertex( vertexIdx ) == aPoint.GetPosition() )
             return std::make_pair( true, vertexIdx );
     }
 
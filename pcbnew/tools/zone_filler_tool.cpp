@@ -38,7 +38,8 @@
 
 
 ZONE_FILLER_TOOL::ZONE_FILLER_TOOL() :
-    PCB_TOOL_BASE( "pcbnew.ZoneFiller" )
+    PCB_TOOL_BASE( "pcbnew.ZoneFiller" ),
+    m_filling( false )
 {
 }
 
@@ -50,6 +51,35 @@ ZONE_FILLER_TOOL::~ZONE_FILLER_TOOL()
 
 void ZONE_FILLER_TOOL::Reset( RESET_REASON aReason )
 {
+    if( aReason == MODEL_RELOAD )
+        m_fillCache.Clear();
+}
+
+
+void ZONE_FILLER_TOOL::MarkDirty( const BOARD_ITEM* aItem )
+{
+    if( !m_filling )
+        m_fillCache.AddDirtyItem( aItem );
+}
+
+
+int ZONE_FILLER_TOOL::ClearFillCache( const TOOL_EVENT& aEvent )
+{
+    m_fillCache.Clear();
+    return 0;
+}
+
+
+bool ZONE_FILLER_TOOL::fill( ZONE_FILLER& aFiller, const std::vector<ZONE_CONTAINER*>& aZones,
+                             bool aCheck )
+{
+    aFiller.SetFillCache( &m_fillCache );
+
+    m_filling = true;
+    bool filled = aFiller.Fill( aZones, aCheck );
+    m_filling = false;
+
+    return filled;
 }
 
 
@@ -68,7 +98,7 @@ void ZONE_FILLER_TOOL::CheckAllZones( wxWindow* aCaller )
     ZONE_FILLER filler( frame()->GetBoard(), &commit );
     filler.InstallNewProgressReporter( aCaller, _( "Checking Zones" ), 4 );
 
-    if( filler.Fill( toFill, true ) )
+    if( fill( filler, toFill, true ) )
     {
         getEditFrame<PCB_EDIT_FRAME>()->m_ZoneFillsDirty = false;
         canvas()->Refresh();
@@ -95,7 +125,7 @@ void ZONE_FILLER_TOOL::FillAllZones( wxWindow* aCaller )
     ZONE_FILLER filler( board(), &commit );
     filler.InstallNewProgressReporter( aCaller, _( "Fill All Zones" ),  4 );
 
-    if( filler.Fill( toFill ) )
+    if( fill( filler, toFill ) )
         getEditFrame<PCB_EDIT_FRAME>()->m_ZoneFillsDirty = false;
 
     canvas()->Refresh();
@@ -128,7 +158,7 @@ int ZONE_FILLER_TOOL::ZoneFill( const TOOL_EVENT& aEvent )
 
     ZONE_FILLER filler( board(), &commit );
     filler.InstallNewProgressReporter( frame(), _( "Fill Zone" ), 4 );
-    filler.Fill( toFill );
+    fill( filler, toFill );
 
     canvas()->Refresh();
     return 0;
@@ -191,4 +221,6 @@ void ZONE_FILLER_TOOL::setTransitions()
     Go( &ZONE_FILLER_TOOL::ZoneFillAll, PCB_ACTIONS::zoneFillAll.MakeEvent() );
     Go( &ZONE_FILLER_TOOL::ZoneUnfill, PCB_ACTIONS::zoneUnfill.MakeEvent() );
     Go( &ZONE_FILLER_TOOL::ZoneUnfillAll, PCB_ACTIONS::zoneUnfillAll.MakeEvent() );
+
+    Go( &ZONE_FILLER_TOOL::ClearFillCache, TOOL_EVENT( TC_MESSAGE, TA_UNDO_REDO_POST, AS_GLOBAL ) );
 }
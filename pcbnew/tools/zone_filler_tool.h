@@ -26,6 +26,7 @@
 #define ZONE_FILLER_TOOL_H
 
 #include <tools/pcb_tool_base.h>
+#include <zone_filler.h>
 
 
 class PCB_EDIT_FRAME;
@@ -52,12 +53,30 @@ public:
     int ZoneUnfill( const TOOL_EVENT& aEvent );
     int ZoneUnfillAll( const TOOL_EVENT& aEvent );
 
+    /**
+     * Function MarkDirty()
+     * Records an item added, modified or removed by a commit, so the next fill only
+     * refills the zones around it.  Modified items must be passed in both their previous
+     * and their new state.
+     */
+    void MarkDirty( const BOARD_ITEM* aItem );
+
+    ///> Forgets the cached fills after an undo or redo, which bypass commits.
+    int ClearFillCache( const TOOL_EVENT& aEvent );
+
 private:
     ///> Refocuses on an idle event (used after the Progress Reporter messes up the focus)
     void singleShotRefocus( wxIdleEvent& );
 
     ///> Sets up handlers for various events.
     void setTransitions() override;
+
+    ///> Runs aFiller on aZones with the fill cache.
+    bool fill( ZONE_FILLER& aFiller, const std::vector<ZONE_CONTAINER*>& aZones,
+               bool aCheck = false );
+
+    ZONE_FILL_CACHE m_fillCache;
+    bool            m_filling;      // our own fill commits don't dirty the cache
 };
 
 #endif
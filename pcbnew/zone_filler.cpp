@@ -24,6 +24,8 @@
  */
 
 #include <cstdint>
+#include <cmath>
+#include <tuple>
 #include <thread>
 #include <mutex>
 #include <algorithm>
@@ -48,6 +50,7 @@
 #include <geometry/convex_hull.h>
 #include <geometry/geometry_utils.h>
 #include <confirm.h>
+#include <trace_helpers.h>
 
 #include "zone_filler.h"
 
@@ -79,9 +82,293 @@ static const double s_RoundPadThermalSpokeAngle = 450;
 static const bool s_DumpZonesWhenFilling = false;
 
 
+/**
+ * Past this many edits, the cache is cleared rather than kept growing.
+ */
+static const size_t s_MaxDirtyAreas = 10000;
+
+
+ZONE_FILL_CACHE::ZONE_FILL_CACHE() :
+    m_settingsHash( 0 ),
+    m_knockoutHits( 0 ),
+    m_knockoutMisses( 0 )
+{
+}
+
+
+void ZONE_FILL_CACHE::Clear()
+{
+    m_fills.clear();
+    m_dirtyAreas.clear();
+    m_knockouts.clear();
+    m_knockoutHits = 0;
+    m_knockoutMisses = 0;
+}
+
+
+void ZONE_FILL_CACHE::eraseKnockouts( const BOARD_ITEM* aItem )
+{
+    m_knockouts.erase( aItem );
+
+    if( aItem->Type() == PCB_MODULE_T )
+    {
+        const MODULE* module = static_cast<const MODULE*>( aItem );
+
+        for( const D_PAD* pad : module->Pads() )
+            m_knockouts.erase( pad );
+
+        for( const BOARD_ITEM* item : module->GraphicalItems() )
+            m_knockouts.erase( item );
+
+        m_knockouts.erase( &module->Reference() );
+        m_knockouts.erase( &module->Value() );
+    }
+}
+
+
+void ZONE_FILL_CACHE::AddDirtyItem( const BOARD_ITEM* aItem )
+{
+    LSET          layers = aItem->GetLayerSet();
+    EDA_RECT      bbox = aItem->GetBoundingBox();
+    std::set<int> nets;
+
+    if( aItem->Type() == PCB_MARKER_T )
+        return;
+
+    eraseKnockouts( aItem );
+
+    if( aItem->IsConnected() )
+        nets.insert( static_cast<const BOARD_CONNECTED_ITEM*>( aItem )->GetNetCode() );
+
+    switch( aItem->Type() )
+    {
+
+    case PCB_ZONE_AREA_T:
+        m_fills.erase( static_cast<const ZONE_CONTAINER*>( aItem ) );
+        break;
+
+    case PCB_MODULE_T:
+    {
+        const MODULE* module = static_cast<const MODULE*>( aItem );
+
+        // Pads with holes are knocked out of all layers
+        layers = LSET::AllCuMask();
+        bbox.Merge( module->Reference().GetBoundingBox() );
+        bbox.Merge( module->Value().GetBoundingBox() );
+
+        for( const D_PAD* pad : module->Pads() )
+            nets.insert( pad->GetNetCode() );
+
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    // Board edges are knocked out of all layers
+    if( layers[Edge_Cuts] )
+        layers = LSET::AllCuMask();
+
+    layers &= LSET::AllCuMask();
+
+    if( layers.none() )
+        return;
+
+    if( m_dirtyAreas.size() >= s_MaxDirtyAreas )
+        Clear();
+
+    // Items without a net connect nothing
+    nets.erase( 0 );
+
+    m_dirtyAreas.push_back( { layers, bbox, nets } );
+}
+
+
+static void hashCombine( size_t& aHash, size_t aValue )
+{
+    aHash ^= aValue + 0x9e3779b9 + ( aHash << 6 ) + ( aHash >> 2 );
+}
+
+
+/**
+ * Returns a hash of the board settings the zone fills depend on, other than the items
+ * themselves.  Cached fills are only valid as long as it doesn't change.
+ */
+static size_t fillSettingsHash( BOARD* aBoard )
+{
+    BOARD_DESIGN_SETTINGS& bds = aBoard->GetDesignSettings();
+    size_t                 hash = 0;
+
+    auto combine = [&]( size_t aValue )
+    {
+        hashCombine( hash, aValue );
+    };
+
+    combine( bds.m_MaxError );
+    combine( bds.m_CopperEdgeClearance );
+    combine( bds.m_ZoneUseNoOutlineInFill );
+    combine( ADVANCED_CFG::GetCfg().m_forceThickOutlinesInZones );
+
+    auto hashNetclass = [&]( const NETCLASSPTR& aNetclass )
+    {
+        combine( std::hash<std::string>()( aNetclass->GetName().ToStdString() ) );
+        combine( aNetclass->GetClearance() );
+
+        for( const wxString& net : *aNetclass )
+            combine( std::hash<std::string>()( net.ToStdString() ) );
+    };
+
+    hashNetclass( bds.GetDefault() );
+
+    for( const auto& netclass : bds.m_NetClasses )
+        hashNetclass( netclass.second );
+
+    return hash;
+}
+
+
+/**
+ * Returns a hash of everything the shape of an item's knockout is built from, down to the
+ * text box of texts and the vertices of polygons.  Knockouts are dropped from the cache
+ * when their item is committed; the hash catches the other changes (items edited in place,
+ * reused addresses).
+ */
+static size_t knockoutGeometryHash( const BOARD_ITEM* aItem )
+{
+    size_t   hash = aItem->Type();
+    EDA_RECT bbox = aItem->GetBoundingBox();
+
+    auto combine = [&]( size_t aValue )
+    {
+        hashCombine( hash, aValue );
+    };
+
+    auto combinePoint = [&]( const wxPoint& aPoint )
+    {
+        combine( aPoint.x );
+        combine( aPoint.y );
+    };
+
+    auto combinePolys = [&]( const SHAPE_POLY_SET& aPolys )
+    {
+        combine( aPolys.OutlineCount() );
+
+        for( auto it = aPolys.CIterateWithHoles(); it; ++it )
+        {
+            combine( it->x );
+            combine( it->y );
+
+            if( it.IsEndContour() )
+                combine( 0x5eed );
+        }
+    };
+
+    auto combineText = [&]( const EDA_TEXT* aText )
+    {
+        EDA_RECT box = aText->GetTextBox( -1 );
+
+        combine( aText->GetText().IsEmpty() );
+        combinePoint( box.GetOrigin() );
+        combinePoint( box.GetEnd() );
+        combinePoint( aText->GetTextPos() );
+        combine( KiROUND( aText->GetTextAngle() ) );
+    };
+
+    combinePoint( bbox.GetOrigin() );
+    combinePoint( bbox.GetEnd() );
+
+    switch( aItem->Type() )
+    {
+    case PCB_PAD_T:
+    {
+        const D_PAD* pad = static_cast<const D_PAD*>( aItem );
+
+        combinePoint( pad->GetPosition() );
+        combinePoint( pad->GetOffset() );
+        combine( pad->GetShape() );
+        combine( pad->GetSize().x );
+        combine( pad->GetSize().y );
+        combine( pad->GetDelta().x );
+        combine( pad->GetDelta().y );
+        combine( KiROUND( pad->GetOrientation() ) );
+        combine( KiROUND( pad->GetRoundRectRadiusRatio() * 1e6 ) );
+        combine( KiROUND( pad->GetChamferRectRatio() * 1e6 ) );
+        combine( pad->GetChamferPositions() );
+        combine( pad->GetDrillShape() );
+        combine( pad->GetDrillSize().x );
+        combine( pad->GetDrillSize().y );
+        combine( pad->GetCustomShapeInZoneOpt() );
+        combinePolys( pad->GetCustomShapeAsPolygon() );
+        break;
+    }
+
+    case PCB_TRACE_T:
+    case PCB_VIA_T:
+    {
+        const TRACK* track = static_cast<const TRACK*>( aItem );
+
+        combinePoint( track->GetStart() );
+        combinePoint( track->GetEnd() );
+        combine( track->GetWidth() );
+        break;
+    }
+
+    case PCB_LINE_T:
+    case PCB_MODULE_EDGE_T:
+    {
+        const DRAWSEGMENT* seg = static_cast<const DRAWSEGMENT*>( aItem );
+
+        combinePoint( seg->GetStart() );
+        combinePoint( seg->GetEnd() );
+        combine( seg->GetShape() );
+        combine( seg->GetWidth() );
+        combine( KiROUND( seg->GetAngle() ) );
+
+        for( const wxPoint& pt : seg->GetBezierPoints() )
+            combinePoint( pt );
+
+        combinePolys( seg->GetPolyShape() );
+        break;
+    }
+
+    case PCB_TEXT_T:
+        combineText( static_cast<const TEXTE_PCB*>( aItem ) );
+        break;
+
+    case PCB_MODULE_TEXT_T:
+    {
+        const TEXTE_MODULE* text = static_cast<const TEXTE_MODULE*>( aItem );
+
+        combineText( text );
+        combine( KiROUND( text->GetDrawRotation() ) );
+        combine( text->IsVisible() );
+        break;
+    }
+
+    case PCB_ZONE_AREA_T:
+    {
+        const ZONE_CONTAINER* zone = static_cast<const ZONE_CONTAINER*>( aItem );
+
+        combinePolys( *zone->Outline() );
+        combine( zone->GetCornerSmoothingType() );
+        combine( zone->GetCornerRadius() );
+        combine( zone->GetZoneClearance() );
+        combine( zone->GetNetCode() );
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return hash;
+}
+
+
 ZONE_FILLER::ZONE_FILLER(  BOARD* aBoard, COMMIT* aCommit ) :
     m_board( aBoard ), m_brdOutlinesValid( false ), m_commit( aCommit ),
-    m_progressReporter( nullptr )
+    m_fillCache( nullptr ), m_progressReporter( nullptr )
 {
 }
 
@@ -123,12 +410,61 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
     m_boardOutline.RemoveAllContours();
     m_brdOutlinesValid = m_board->GetBoardPolygonOutlines( m_boardOutline );
 
+    if( m_fillCache )
+    {
+        size_t settingsHash = fillSettingsHash( m_board );
+
+        if( settingsHash != m_fillCache->m_settingsHash )
+        {
+            m_fillCache->Clear();
+            m_fillCache->m_settingsHash = settingsHash;
+        }
+    }
+
+    std::vector<ZONE_CONTAINER*> zones;
+    std::vector<FILL_AREA>       zoneAreas;
+    std::vector<FILL_MODE>       zoneModes;
+    std::set<int>                refilledNets;
+
     for( auto zone : aZones )
     {
         // Keepout zones are not filled
         if( zone->GetIsKeepout() )
             continue;
 
+        FILL_AREA area;
+        FILL_MODE mode = getFillArea( zone, area );
+
+        if( mode == FILL_FULL || mode == FILL_PATCH )
+            refilledNets.insert( zone->GetNetCode() );
+
+        zones.push_back( zone );
+        zoneAreas.push_back( area );
+        zoneModes.push_back( mode );
+    }
+
+    std::vector<FILL_AREA> fillAreas;
+    std::vector<FILL_MODE> fillModes;
+
+    for( size_t ii = 0; ii < zones.size(); ++ii )
+    {
+        ZONE_CONTAINER* zone = zones[ii];
+        FILL_MODE       mode = zoneModes[ii];
+
+        // A refilled zone can connect or cut off the islands of the other zones of its net
+        if( mode == FILL_UNCHANGED && zone->GetNetCode() > 0
+                && refilledNets.count( zone->GetNetCode() ) )
+        {
+            mode = FILL_ISLANDS;
+        }
+
+        // Nothing the zone's fill depends on has changed since its last fill
+        if( mode == FILL_UNCHANGED )
+            continue;
+
+        fillAreas.push_back( zoneAreas[ii] );
+        fillModes.push_back( mode );
+
         if( m_commit )
             m_commit->Modify( zone );
 
@@ -144,55 +480,139 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         zone->UnFill();
     }
 
-    std::atomic<size_t> nextItem( 0 );
-    size_t              parallelThreadCount =
-            std::min<size_t>( std::thread::hardware_concurrency(), aZones.size() );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
+    m_high_def = m_board->GetDesignSettings().m_MaxError;
+    m_low_def = std::min( ARC_LOW_DEF, int( m_high_def*1.5 ) );   // Reasonable value
 
-    auto fill_lambda = [&] ( PROGRESS_REPORTER* aReporter ) -> size_t
+    // Zones are filled in three passes, each spread over all cores:
+    //  1 - collect the items to knock out of each copper zone, and split the knockouts of
+    //      large zones into tiles,
+    //  2 - build and merge the clearance holes of every tile of every zone,
+    //  3 - fill the zones, the most expensive ones first.
+    // A zone's fill only depends on the outlines of higher priority zones, never on their
+    // fills, so zones can be filled in any order.  Filling the big ones first keeps the
+    // small ones for the end, where they fill the gaps instead of leaving cores idle.
+    // Zones refilled incrementally only knock out the items around the edited area, and
+    // zones only checked for islands reuse their previous fill.
+    struct FILL_JOB
     {
-        size_t num = 0;
+        const FILL_AREA*                   m_area = nullptr;
+        bool                               m_islandsOnly = false;
+        std::vector<std::vector<KNOCKOUT>> m_tiles;
+        std::vector<SHAPE_POLY_SET>        m_tileHoles;
+        SHAPE_POLY_SET                     m_unfractured;
+        size_t                             m_cost = 0;
+    };
 
-        for( size_t i = nextItem++; i < toFill.size(); i = nextItem++ )
-        {
-            ZONE_CONTAINER* zone = toFill[i].m_zone;
-            zone->SetFilledPolysUseThickness( filledPolyWithOutline );
-            SHAPE_POLY_SET rawPolys, finalPolys;
-            fillSingleZone( zone, rawPolys, finalPolys );
+    std::vector<FILL_JOB> jobs( toFill.size() );
 
-            zone->SetRawPolysList( rawPolys );
-            zone->SetFilledPolysList( finalPolys );
-            zone->SetIsFilled( true );
+    for( size_t ii = 0; ii < jobs.size(); ++ii )
+    {
+        if( fillModes[ii] != FILL_FULL )
+            jobs[ii].m_area = &fillAreas[ii];
 
-            if( m_progressReporter )
-                m_progressReporter->AdvanceProgress();
+        jobs[ii].m_islandsOnly = fillModes[ii] == FILL_ISLANDS;
+    }
 
-            num++;
-        }
+    runParallel( toFill.size(), [&]( size_t aIdx )
+    {
+        ZONE_CONTAINER* zone = toFill[aIdx].m_zone;
+        FILL_JOB&       job = jobs[aIdx];
 
-        return num;
-    };
+        job.m_cost = zone->Outline()->TotalVertices();
 
-    if( parallelThreadCount <= 1 )
-        fill_lambda( m_progressReporter );
-    else
+        if( job.m_islandsOnly || !zone->IsOnCopperLayer() )
+            return;
+
+        std::vector<KNOCKOUT> knockouts;
+        collectKnockouts( zone, knockouts, job.m_area ? &job.m_area->m_Window : nullptr );
+
+        job.m_cost += knockouts.size();
+        tileKnockouts( zone, knockouts, job.m_tiles );
+        job.m_tileHoles.resize( job.m_tiles.size() );
+    } );
+
+    std::vector<std::pair<size_t, size_t>> tiles;
+
+    for( size_t ii = 0; ii < jobs.size(); ++ii )
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, fill_lambda, m_progressReporter );
+        for( size_t jj = 0; jj < jobs[ii].m_tiles.size(); ++jj )
+            tiles.emplace_back( ii, jj );
+    }
 
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+    runParallel( tiles.size(), [&]( size_t aIdx )
+    {
+        FILL_JOB&       job = jobs[tiles[aIdx].first];
+        SHAPE_POLY_SET& holes = job.m_tileHoles[tiles[aIdx].second];
+
+        addKnockouts( job.m_tiles[tiles[aIdx].second], holes );
+        holes.Simplify( SHAPE_POLY_SET::PM_FAST );
+    } );
+
+    if( m_fillCache )
+    {
+        wxLogTrace( traceZoneFiller, "Knockout cache: %zu hits, %zu misses",
+                    m_fillCache->GetKnockoutHits(), m_fillCache->GetKnockoutMisses() );
+    }
+
+    std::vector<size_t> fillOrder( toFill.size() );
+
+    for( size_t ii = 0; ii < fillOrder.size(); ++ii )
+        fillOrder[ii] = ii;
+
+    std::stable_sort( fillOrder.begin(), fillOrder.end(),
+                      [&]( size_t a, size_t b )
+                      {
+                          return jobs[a].m_cost > jobs[b].m_cost;
+                      } );
+
+    runParallel( fillOrder.size(), [&]( size_t aIdx )
+    {
+        ZONE_CONTAINER* zone = toFill[fillOrder[aIdx]].m_zone;
+        FILL_JOB&       job = jobs[fillOrder[aIdx]];
+        SHAPE_POLY_SET  clearanceHoles;
+
+        if( job.m_tileHoles.size() == 1 )
         {
-            // Here we balance returns with a 100ms timeout to allow UI updating
-            std::future_status status;
-            do
-            {
-                if( m_progressReporter )
-                    m_progressReporter->KeepRefreshing();
+            clearanceHoles = job.m_tileHoles[0];
+        }
+        else if( job.m_tileHoles.size() > 1 )
+        {
+            // Knockouts straddling a tile boundary overlap their neighbours' ones
+            std::vector<const SHAPE_POLY_SET*> tileHoles;
 
-                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-            } while( status != std::future_status::ready );
+            for( const SHAPE_POLY_SET& holes : job.m_tileHoles )
+                tileHoles.push_back( &holes );
+
+            clearanceHoles.BooleanMany( ClipperLib::ctUnion, tileHoles,
+                                        SHAPE_POLY_SET::PM_FAST );
         }
-    }
+
+        job.m_tileHoles.clear();
+
+        zone->SetFilledPolysUseThickness( filledPolyWithOutline );
+        SHAPE_POLY_SET rawPolys, finalPolys;
+
+        if( job.m_islandsOnly )
+        {
+            job.m_unfractured = *job.m_area->m_PreviousFill;
+            rawPolys = job.m_unfractured;
+            rawPolys.Fracture( SHAPE_POLY_SET::PM_FAST );
+            finalPolys = rawPolys;
+        }
+        else
+        {
+            fillSingleZone( zone, rawPolys, finalPolys,
+                            zone->IsOnCopperLayer() ? &clearanceHoles : nullptr,
+                            job.m_area, m_fillCache ? &job.m_unfractured : nullptr );
+        }
+
+        zone->SetRawPolysList( rawPolys );
+        zone->SetFilledPolysList( finalPolys );
+        zone->SetIsFilled( true );
+
+        if( m_progressReporter )
+            m_progressReporter->AdvanceProgress();
+    } );
 
     // Now update the connectivity to check for copper islands
     if( m_progressReporter )
@@ -235,8 +655,8 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         {
             for( int idx = 0; idx < poly.OutlineCount(); )
             {
-                if( poly.Polygon( idx ).empty() ||
-                    !m_boardOutline.Contains( poly.Polygon( idx ).front().CPoint( 0 ) ) )
+                if( poly.CPolygon( idx ).empty() ||
+                    !m_boardOutline.Contains( poly.CPolygon( idx ).front().CPoint( 0 ) ) )
                 {
                     poly.DeletePolygon( idx );
                 }
@@ -270,6 +690,24 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         }
     }
 
+    // Keep the new fills for the next incremental refill.  Hatched fills are not local, so
+    // hatched zones are always filled in full.
+    if( m_fillCache )
+    {
+        for( size_t ii = 0; ii < toFill.size(); ++ii )
+        {
+            ZONE_CONTAINER* zone = toFill[ii].m_zone;
+
+            if( zone->IsOnCopperLayer() && zone->GetFillMode() != ZFM_HATCH_PATTERN )
+            {
+                ZONE_FILL_CACHE::ZONE_FILL& cached = m_fillCache->m_fills[zone];
+
+                cached.m_Fill = jobs[ii].m_unfractured;
+                cached.m_DirtyCount = m_fillCache->m_dirtyAreas.size();
+            }
+        }
+    }
+
     if( m_progressReporter )
     {
         m_progressReporter->AdvancePhase();
@@ -278,44 +716,13 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
     }
 
 
-    nextItem = 0;
-
-    auto tri_lambda = [&] ( PROGRESS_REPORTER* aReporter ) -> size_t
+    runParallel( toFill.size(), [&]( size_t aIdx )
     {
-        size_t num = 0;
+        toFill[aIdx].m_zone->CacheTriangulation();
 
-        for( size_t i = nextItem++; i < toFill.size(); i = nextItem++ )
-        {
-            toFill[i].m_zone->CacheTriangulation();
-            num++;
-
-            if( m_progressReporter )
-                m_progressReporter->AdvanceProgress();
-        }
-
-        return num;
-    };
-
-    if( parallelThreadCount <= 1 )
-        tri_lambda( m_progressReporter );
-    else
-    {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, tri_lambda, m_progressReporter );
-
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            // Here we balance returns with a 100ms timeout to allow UI updating
-            std::future_status status;
-            do
-            {
-                if( m_progressReporter )
-                    m_progressReporter->KeepRefreshing();
-
-                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-            } while( status != std::future_status::ready );
-        }
-    }
+        if( m_progressReporter )
+            m_progressReporter->AdvanceProgress();
+    } );
 
     if( m_progressReporter )
     {
@@ -332,13 +739,56 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
     }
     else
     {
-        for( auto& i : toFill )
-            connectivity->Update( i.m_zone );
+        for( auto& i : toFill )
+            connectivity->Update( i.m_zone );
+
+        connectivity->RecalculateRatsnest();
+    }
+
+    return true;
+}
+
+
+void ZONE_FILLER::runParallel( size_t aCount, const std::function<void( size_t )>& aTask )
+{
+    std::atomic<size_t> nextItem( 0 );
+    size_t              parallelThreadCount =
+            std::min<size_t>( std::thread::hardware_concurrency(), aCount );
+    std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+    auto task_lambda = [&]() -> size_t
+    {
+        size_t num = 0;
+
+        for( size_t i = nextItem++; i < aCount; i = nextItem++ )
+        {
+            aTask( i );
+            num++;
+        }
+
+        return num;
+    };
+
+    if( parallelThreadCount <= 1 )
+        task_lambda();
+    else
+    {
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii] = std::async( std::launch::async, task_lambda );
 
-        connectivity->RecalculateRatsnest();
-    }
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        {
+            // Here we balance returns with a 100ms timeout to allow UI updating
+            std::future_status status;
+            do
+            {
+                if( m_progressReporter )
+                    m_progressReporter->KeepRefreshing();
 
-    return true;
+                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
+            } while( status != std::future_status::ready );
+        }
+    }
 }
 
 
@@ -371,6 +821,131 @@ bool hasThermalConnection( D_PAD* pad, const ZONE_CONTAINER* aZone )
 }
 
 
+/**
+ * Return a rectangle as a polygon, to clip zone fills with.
+ */
+static SHAPE_POLY_SET rectToPoly( const EDA_RECT& aRect )
+{
+    SHAPE_POLY_SET poly;
+
+    poly.NewOutline();
+    poly.Append( aRect.GetLeft(), aRect.GetTop() );
+    poly.Append( aRect.GetRight(), aRect.GetTop() );
+    poly.Append( aRect.GetRight(), aRect.GetBottom() );
+    poly.Append( aRect.GetLeft(), aRect.GetBottom() );
+
+    return poly;
+}
+
+
+/**
+ * Return the area a thermally connected pad can change in a zone fill: its thermal relief
+ * and its spokes, at any rotation.
+ */
+static EDA_RECT thermalReach( D_PAD* aPad, const ZONE_CONTAINER* aZone )
+{
+    EDA_RECT reach = aPad->GetBoundingBox();
+    int      size = std::max( aPad->GetSize().x, aPad->GetSize().y );
+
+    reach.Inflate( size + 2 * aZone->GetThermalReliefGap( aPad ) + KiROUND( IU_PER_MM * 0.1 ) );
+    return reach;
+}
+
+
+ZONE_FILLER::FILL_MODE ZONE_FILLER::getFillArea( const ZONE_CONTAINER* aZone,
+                                                 FILL_AREA& aArea )
+{
+    if( !m_fillCache || !aZone->IsFilled() || !aZone->IsOnCopperLayer()
+            || aZone->GetFillMode() == ZFM_HATCH_PATTERN )
+    {
+        return FILL_FULL;
+    }
+
+    auto cached = m_fillCache->m_fills.find( aZone );
+
+    if( cached == m_fillCache->m_fills.end() )
+        return FILL_FULL;
+
+    BOARD_DESIGN_SETTINGS& bds = m_board->GetDesignSettings();
+    int clearance = std::max( bds.GetBiggestClearanceValue(), aZone->GetClearance() );
+    clearance = std::max( clearance, bds.m_CopperEdgeClearance );
+    clearance = std::max( clearance, aZone->GetZoneClearance() );
+
+    EDA_RECT zoneBox = aZone->GetBoundingBox();
+    zoneBox.Inflate( clearance );
+
+    // The edited area: everything that changed on the zone's layer since its last fill
+    EDA_RECT dirty;
+    bool     isDirty = false;
+    bool     isNetDirty = false;
+
+    for( size_t ii = cached->second.m_DirtyCount; ii < m_fillCache->m_dirtyAreas.size(); ++ii )
+    {
+        const ZONE_FILL_CACHE::DIRTY_AREA& area = m_fillCache->m_dirtyAreas[ii];
+
+        // An edit of the zone's net anywhere can connect or cut off its islands
+        if( area.m_Nets.count( aZone->GetNetCode() ) )
+            isNetDirty = true;
+
+        if( !area.m_Layers[aZone->GetLayer()] || !area.m_BBox.Intersects( zoneBox ) )
+            continue;
+
+        if( isDirty )
+            dirty.Merge( area.m_BBox );
+        else
+            dirty = area.m_BBox;
+
+        isDirty = true;
+    }
+
+    aArea.m_PreviousFill = &cached->second.m_Fill;
+
+    if( !isDirty )
+        return isNetDirty ? FILL_ISLANDS : FILL_UNCHANGED;
+
+    // The fill changes within clearance of the edited items, and wherever the thermal
+    // reliefs and spokes of pads reaching into that area are.
+    auto addThermalReach = [&]( EDA_RECT& aRect )
+    {
+        EDA_RECT grown = aRect;
+
+        for( auto module : m_board->Modules() )
+        {
+            for( auto pad : module->Pads() )
+            {
+                if( !hasThermalConnection( pad, aZone ) )
+                    continue;
+
+                EDA_RECT reach = thermalReach( pad, aZone );
+
+                if( reach.Intersects( aRect ) )
+                    grown.Merge( reach );
+            }
+        }
+
+        aRect = grown;
+    };
+
+    dirty.Inflate( clearance );
+    addThermalReach( dirty );
+
+    // Removing features narrower than the min width spreads changes by up to the min width
+    aArea.m_Patch = dirty;
+    aArea.m_Patch.Inflate( 2 * aZone->GetMinThickness() );
+
+    // The fill computed in the window is exact except within the min width of its edges
+    aArea.m_Window = aArea.m_Patch;
+    addThermalReach( aArea.m_Window );
+    aArea.m_Window.Inflate( 2 * aZone->GetMinThickness() + clearance );
+
+    // A large patch is no faster than a full refill
+    if( aArea.m_Window.GetArea() > zoneBox.GetArea() / 2 )
+        return FILL_FULL;
+
+    return FILL_PATCH;
+}
+
+
 /**
  * Setup aDummyPad to have the same size and shape of aPad's hole.  This allows us to create
  * thermal reliefs and clearances for holes using the pad code.
@@ -471,11 +1046,90 @@ void ZONE_FILLER::addKnockout( BOARD_ITEM* aItem, int aGap, bool aIgnoreLineWidt
 }
 
 
+bool ZONE_FILLER::THERMAL_KEY::operator<( const THERMAL_KEY& aOther ) const
+{
+    return std::tie( m_Shape, m_SizeX, m_SizeY, m_DeltaX, m_DeltaY, m_OffsetX, m_OffsetY,
+                     m_Orientation, m_RoundRectRatio, m_ChamferRatio, m_ChamferPositions, m_Gap,
+                     m_SpokeWidth )
+           < std::tie( aOther.m_Shape, aOther.m_SizeX, aOther.m_SizeY, aOther.m_DeltaX,
+                       aOther.m_DeltaY, aOther.m_OffsetX, aOther.m_OffsetY, aOther.m_Orientation,
+                       aOther.m_RoundRectRatio, aOther.m_ChamferRatio, aOther.m_ChamferPositions,
+                       aOther.m_Gap, aOther.m_SpokeWidth );
+}
+
+
+bool ZONE_FILLER::getThermalKey( const D_PAD* aPad, int aGap, int aSpokeWidth,
+                                 THERMAL_KEY& aKey ) const
+{
+    // Custom pads are rare, and not worth describing in a key
+    if( aPad->GetShape() == PAD_SHAPE_CUSTOM )
+        return false;
+
+    aKey.m_Shape = aPad->GetShape();
+    aKey.m_SizeX = aPad->GetSize().x;
+    aKey.m_SizeY = aPad->GetSize().y;
+    aKey.m_DeltaX = aPad->GetDelta().x;
+    aKey.m_DeltaY = aPad->GetDelta().y;
+    aKey.m_OffsetX = aPad->GetOffset().x;
+    aKey.m_OffsetY = aPad->GetOffset().y;
+    aKey.m_Orientation = aPad->GetOrientation();
+    aKey.m_RoundRectRatio = aPad->GetRoundRectRadiusRatio();
+    aKey.m_ChamferRatio = aPad->GetChamferRectRatio();
+    aKey.m_ChamferPositions = aPad->GetChamferPositions();
+    aKey.m_Gap = aGap;
+    aKey.m_SpokeWidth = aSpokeWidth;
+
+    return true;
+}
+
+
+void ZONE_FILLER::addThermalRelief( D_PAD* aPad, int aGap, SHAPE_POLY_SET& aHoles )
+{
+    THERMAL_KEY key;
+
+    if( !getThermalKey( aPad, aGap, 0, key ) )
+    {
+        addKnockout( aPad, aGap, aHoles );
+        return;
+    }
+
+    SHAPE_POLY_SET relief;
+    bool           found = false;
+
+    {
+        std::lock_guard<std::mutex> lock( m_templatesLock );
+        auto it = m_reliefTemplates.find( key );
+
+        if( it != m_reliefTemplates.end() )
+        {
+            relief = it->second;
+            found = true;
+        }
+    }
+
+    if( !found )
+    {
+        // The pad shapes are built from exact offsets to the pad position, so a relief built
+        // at the origin and moved to the pad is the same as one built on the pad.
+        D_PAD padAtOrigin( *aPad );
+        padAtOrigin.SetPosition( wxPoint( 0, 0 ) );
+        addKnockout( &padAtOrigin, aGap, relief );
+
+        std::lock_guard<std::mutex> lock( m_templatesLock );
+        m_reliefTemplates.emplace( key, relief );
+    }
+
+    relief.Move( aPad->GetPosition() );
+    aHoles.Append( relief );
+}
+
+
 /**
  * Removes thermal reliefs from the shape for any pads connected to the zone.  Does NOT add
  * in spokes, which must be done later.
  */
-void ZONE_FILLER::knockoutThermalReliefs( const ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aFill )
+void ZONE_FILLER::knockoutThermalReliefs( const ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aFill,
+                                          const EDA_RECT* aWindow )
 {
     SHAPE_POLY_SET holes;
 
@@ -493,6 +1147,9 @@ void ZONE_FILLER::knockoutThermalReliefs( const ZONE_CONTAINER* aZone, SHAPE_POL
             if( !hasThermalConnection( pad, aZone ) )
                 continue;
 
+            if( aWindow && !thermalReach( pad, aZone ).Intersects( *aWindow ) )
+                continue;
+
             // If the pad isn't on the current layer but has a hole, knock out a thermal relief
             // for the hole.
             if( !pad->IsOnLayer( aZone->GetLayer() ) )
@@ -504,7 +1161,7 @@ void ZONE_FILLER::knockoutThermalReliefs( const ZONE_CONTAINER* aZone, SHAPE_POL
                 pad = &dummypad;
             }
 
-            addKnockout( pad, aZone->GetThermalReliefGap( pad ), holes );
+            addThermalRelief( pad, aZone->GetThermalReliefGap( pad ), holes );
         }
     }
 
@@ -514,10 +1171,11 @@ void ZONE_FILLER::knockoutThermalReliefs( const ZONE_CONTAINER* aZone, SHAPE_POL
 
 
 /**
- * Removes clearance from the shape for copper items which share the zone's layer but are
- * not connected to it.
+ * Collects the copper items which share the zone's layer but are not connected to it.
  */
-void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aHoles )
+void ZONE_FILLER::collectKnockouts( const ZONE_CONTAINER* aZone,
+                                    std::vector<KNOCKOUT>& aKnockouts,
+                                    const EDA_RECT* aWindow )
 {
     int zone_clearance = aZone->GetClearance();
     int edgeClearance = m_board->GetDesignSettings().m_CopperEdgeClearance;
@@ -525,7 +1183,8 @@ void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_
 
     // items outside the zone bounding box are skipped
     // the bounding box is the zone bounding box + the biggest clearance found in Netclass list
-    EDA_RECT zone_boundingbox = aZone->GetBoundingBox();
+    // When only a window of the zone is refilled, items outside the window are skipped too
+    EDA_RECT zone_boundingbox = aWindow ? *aWindow : aZone->GetBoundingBox();
     int biggest_clearance = m_board->GetDesignSettings().GetBiggestClearanceValue();
     biggest_clearance = std::max( biggest_clearance, zone_clearance );
     zone_boundingbox.Inflate( biggest_clearance );
@@ -543,25 +1202,29 @@ void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_
     {
         for( auto pad : module->Pads() )
         {
+            D_PAD*         knockout = pad;
+            KNOCKOUT::KIND kind = KNOCKOUT::PAD;
+
             if( !pad->IsOnLayer( aZone->GetLayer() ) )
             {
                 if( pad->GetDrillSize().x == 0 && pad->GetDrillSize().y == 0 )
                     continue;
 
                 setupDummyPadForHole( pad, dummypad );
-                pad = &dummypad;
+                knockout = &dummypad;
+                kind = KNOCKOUT::PAD_HOLE;
             }
 
-            if( pad->GetNetCode() != aZone->GetNetCode()
-                  || pad->GetNetCode() <= 0
-                  || aZone->GetPadConnection( pad ) == PAD_ZONE_CONN_NONE )
+            if( knockout->GetNetCode() != aZone->GetNetCode()
+                  || knockout->GetNetCode() <= 0
+                  || aZone->GetPadConnection( knockout ) == PAD_ZONE_CONN_NONE )
             {
-                int gap = std::max( zone_clearance, pad->GetClearance() );
-                EDA_RECT item_boundingbox = pad->GetBoundingBox();
-                item_boundingbox.Inflate( pad->GetClearance() );
+                int gap = std::max( zone_clearance, knockout->GetClearance() );
+                EDA_RECT item_boundingbox = knockout->GetBoundingBox();
+                item_boundingbox.Inflate( knockout->GetClearance() );
 
                 if( item_boundingbox.Intersects( zone_boundingbox ) )
-                    addKnockout( pad, gap, aHoles );
+                    aKnockouts.push_back( { kind, pad, gap, false } );
             }
         }
     }
@@ -580,7 +1243,7 @@ void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_
         EDA_RECT item_boundingbox = track->GetBoundingBox();
 
         if( item_boundingbox.Intersects( zone_boundingbox ) )
-            track->TransformShapeWithClearanceToPolygon( aHoles, gap, m_low_def );
+            aKnockouts.push_back( { KNOCKOUT::TRACK, track, gap, false } );
     }
 
     // Add graphic item clearances.  They are by definition unconnected, and have no clearance
@@ -606,7 +1269,7 @@ void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_
             ignoreLineWidth = true;
         }
 
-        addKnockout( aItem, gap, ignoreLineWidth, aHoles );
+        aKnockouts.push_back( { KNOCKOUT::GRAPHIC, aItem, gap, ignoreLineWidth } );
     };
 
     for( auto module : m_board->Modules() )
@@ -659,8 +1322,200 @@ void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_
             useNetClearance = false;
         }
 
-        zone->TransformOutlinesShapeWithClearanceToPolygon( aHoles, minClearance, useNetClearance );
+        aKnockouts.push_back( { KNOCKOUT::ZONE_OUTLINE, zone, minClearance, useNetClearance } );
+    }
+}
+
+
+/**
+ * Zones with fewer knockouts than this are not worth splitting into tiles.
+ */
+static const size_t s_KnockoutsPerTile = 1000;
+
+
+void ZONE_FILLER::tileKnockouts( const ZONE_CONTAINER* aZone, std::vector<KNOCKOUT>& aKnockouts,
+                                 std::vector<std::vector<KNOCKOUT>>& aTiles )
+{
+    size_t tileCount = aKnockouts.size() / s_KnockoutsPerTile;
+
+    if( tileCount <= 1 )
+    {
+        aTiles.emplace_back( std::move( aKnockouts ) );
+        return;
+    }
+
+    int cols = KiROUND( std::ceil( std::sqrt( (double) tileCount ) ) );
+    int rows = KiROUND( std::ceil( (double) tileCount / cols ) );
+
+    EDA_RECT bbox = aZone->GetBoundingBox();
+    int      tileWidth = std::max( 1, bbox.GetWidth() / cols + 1 );
+    int      tileHeight = std::max( 1, bbox.GetHeight() / rows + 1 );
+
+    aTiles.resize( cols * rows );
+
+    // Knockouts keep their relative order inside a tile.  Items outside the zone bounding
+    // box (but within clearance of it) go to the nearest edge tile.
+    for( KNOCKOUT& knockout : aKnockouts )
+    {
+        wxPoint centre = knockout.m_Item->GetBoundingBox().Centre() - bbox.GetOrigin();
+        int     col = Clamp( 0, centre.x / tileWidth, cols - 1 );
+        int     row = Clamp( 0, centre.y / tileHeight, rows - 1 );
+
+        aTiles[ row * cols + col ].push_back( knockout );
+    }
+
+    aTiles.erase( std::remove_if( aTiles.begin(), aTiles.end(),
+                                  []( const std::vector<KNOCKOUT>& aTile )
+                                  {
+                                      return aTile.empty();
+                                  } ),
+                  aTiles.end() );
+}
+
+
+void ZONE_FILLER::addKnockouts( const std::vector<KNOCKOUT>& aKnockouts, SHAPE_POLY_SET& aHoles )
+{
+    // See collectKnockouts() for the dummy pad
+    MODULE  dummymodule( m_board );
+    D_PAD   dummypad( &dummymodule );
+
+    auto buildKnockout = [&]( const KNOCKOUT& aKnockout, SHAPE_POLY_SET& aShape )
+    {
+        switch( aKnockout.m_Kind )
+        {
+        case KNOCKOUT::PAD:
+            addKnockout( static_cast<D_PAD*>( aKnockout.m_Item ), aKnockout.m_Gap, aShape );
+            break;
+
+        case KNOCKOUT::PAD_HOLE:
+            setupDummyPadForHole( static_cast<D_PAD*>( aKnockout.m_Item ), dummypad );
+            addKnockout( &dummypad, aKnockout.m_Gap, aShape );
+            break;
+
+        case KNOCKOUT::TRACK:
+            static_cast<TRACK*>( aKnockout.m_Item )->TransformShapeWithClearanceToPolygon(
+                    aShape, aKnockout.m_Gap, m_low_def );
+            break;
+
+        case KNOCKOUT::GRAPHIC:
+            addKnockout( aKnockout.m_Item, aKnockout.m_Gap, aKnockout.m_Flag, aShape );
+            break;
+
+        case KNOCKOUT::ZONE_OUTLINE:
+            static_cast<ZONE_CONTAINER*>( aKnockout.m_Item )
+                    ->TransformOutlinesShapeWithClearanceToPolygon( aShape, aKnockout.m_Gap,
+                                                                    aKnockout.m_Flag );
+            break;
+        }
+    };
+
+    if( !m_fillCache )
+    {
+        for( const KNOCKOUT& knockout : aKnockouts )
+            buildKnockout( knockout, aHoles );
+
+        return;
+    }
+
+    typedef ZONE_FILL_CACHE::KNOCKOUT_SHAPE KNOCKOUT_SHAPE;
+
+    auto sameKnockout = []( const KNOCKOUT_SHAPE& aShape, const KNOCKOUT& aKnockout )
+    {
+        return aShape.m_Kind == aKnockout.m_Kind && aShape.m_Gap == aKnockout.m_Gap
+               && aShape.m_Flag == aKnockout.m_Flag;
+    };
+
+    ZONE_FILL_CACHE&                   cache = *m_fillCache;
+    std::vector<size_t>                hashes( aKnockouts.size() );
+    std::vector<const SHAPE_POLY_SET*> cached( aKnockouts.size(), nullptr );
+
+    for( size_t ii = 0; ii < aKnockouts.size(); ++ii )
+        hashes[ii] = knockoutGeometryHash( aKnockouts[ii].m_Item );
+
+    // Look all the knockouts up at once, to take the lock only once.  The shapes found
+    // stay in place until the cache is cleared, which never happens during a fill.
+    {
+        std::lock_guard<std::mutex> lock( cache.m_knockoutsLock );
+
+        for( size_t ii = 0; ii < aKnockouts.size(); ++ii )
+        {
+            auto it = cache.m_knockouts.find( aKnockouts[ii].m_Item );
+
+            if( it == cache.m_knockouts.end() )
+                continue;
+
+            for( const KNOCKOUT_SHAPE& shape : it->second )
+            {
+                if( sameKnockout( shape, aKnockouts[ii] ) && shape.m_GeometryHash == hashes[ii] )
+                {
+                    cached[ii] = &shape.m_Shape;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Knockouts are added in order, cached or not, so the holes are the same either way
+    std::vector<KNOCKOUT_SHAPE> built;
+    std::vector<size_t>         builtIndex;
+
+    for( size_t ii = 0; ii < aKnockouts.size(); ++ii )
+    {
+        if( cached[ii] )
+        {
+            aHoles.Append( *cached[ii] );
+            continue;
+        }
+
+        const KNOCKOUT& knockout = aKnockouts[ii];
+
+        built.push_back( { knockout.m_Kind, knockout.m_Gap, knockout.m_Flag, hashes[ii],
+                           SHAPE_POLY_SET() } );
+        builtIndex.push_back( ii );
+
+        buildKnockout( knockout, built.back().m_Shape );
+        aHoles.Append( built.back().m_Shape );
+    }
+
+    cache.m_knockoutHits += aKnockouts.size() - built.size();
+    cache.m_knockoutMisses += built.size();
+
+    if( built.empty() )
+        return;
+
+    std::lock_guard<std::mutex> lock( cache.m_knockoutsLock );
+
+    for( size_t ii = 0; ii < built.size(); ++ii )
+    {
+        const KNOCKOUT&             knockout = aKnockouts[builtIndex[ii]];
+        std::deque<KNOCKOUT_SHAPE>& shapes = cache.m_knockouts[knockout.m_Item];
+
+        auto it = std::find_if( shapes.begin(), shapes.end(),
+                                [&]( const KNOCKOUT_SHAPE& aShape )
+                                {
+                                    return sameKnockout( aShape, knockout );
+                                } );
+
+        // Another thread may have built the same knockout meanwhile; keep its shape, which
+        // may be in use.  A stale shape can't be in use, and is replaced.
+        if( it == shapes.end() )
+            shapes.push_back( built[ii] );
+        else if( it->m_GeometryHash != built[ii].m_GeometryHash )
+            *it = built[ii];
     }
+}
+
+
+/**
+ * Removes clearance from the shape for copper items which share the zone's layer but are
+ * not connected to it.
+ */
+void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aHoles )
+{
+    std::vector<KNOCKOUT> knockouts;
+
+    collectKnockouts( aZone, knockouts );
+    addKnockouts( knockouts, aHoles );
 
     aHoles.Simplify( SHAPE_POLY_SET::PM_FAST );
 }
@@ -681,11 +1536,11 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone,
                                         const SHAPE_POLY_SET& aSmoothedOutline,
                                         std::set<VECTOR2I>* aPreserveCorners,
                                         SHAPE_POLY_SET& aRawPolys,
-                                        SHAPE_POLY_SET& aFinalPolys )
+                                        SHAPE_POLY_SET& aFinalPolys,
+                                        const SHAPE_POLY_SET* aClearanceHoles,
+                                        const FILL_AREA* aArea,
+                                        SHAPE_POLY_SET* aUnfractured )
 {
-    m_high_def = m_board->GetDesignSettings().m_MaxError;
-    m_low_def = std::min( ARC_LOW_DEF, int( m_high_def*1.5 ) );   // Reasonable value
-
     // Features which are min_width should survive pruning; features that are *less* than
     // min_width should not.  Therefore we subtract epsilon from the min_width when
     // deflating/inflating.
@@ -704,22 +1559,38 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone,
     std::unique_ptr<SHAPE_FILE_IO> dumper( new SHAPE_FILE_IO(
                     s_DumpZonesWhenFilling ? "zones_dump.txt" : "", SHAPE_FILE_IO::IOM_APPEND ) );
 
-    aRawPolys = aSmoothedOutline;
+    // When only a window of the zone is refilled, the zone is clipped to the window
+    SHAPE_POLY_SET        windowOutline;
+    const SHAPE_POLY_SET* outline = &aSmoothedOutline;
+    const EDA_RECT*       window = aArea ? &aArea->m_Window : nullptr;
+
+    if( aArea )
+    {
+        windowOutline = aSmoothedOutline;
+        windowOutline.BooleanIntersection( rectToPoly( aArea->m_Window ),
+                                           SHAPE_POLY_SET::PM_FAST );
+        outline = &windowOutline;
+    }
+
+    aRawPolys = *outline;
 
     if( s_DumpZonesWhenFilling )
         dumper->BeginGroup( "clipper-zone" );
 
-    knockoutThermalReliefs( aZone, aRawPolys );
+    knockoutThermalReliefs( aZone, aRawPolys, window );
 
     if( s_DumpZonesWhenFilling )
         dumper->Write( &aRawPolys, "solid-areas-minus-thermal-reliefs" );
 
-    buildCopperItemClearances( aZone, clearanceHoles );
+    if( aClearanceHoles )
+        clearanceHoles = *aClearanceHoles;
+    else
+        buildCopperItemClearances( aZone, clearanceHoles );
 
     if( s_DumpZonesWhenFilling )
         dumper->Write( &aRawPolys, "clearance holes" );
 
-    buildThermalSpokes( aZone, thermalSpokes );
+    buildThermalSpokes( aZone, thermalSpokes, window );
 
     // Create a temporary zone that we can hit-test spoke-ends against.  It's only temporary
     // because the "real" subtract-clearance-holes has to be done after the spokes are added.
@@ -762,7 +1633,7 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone,
 
     // Ensure previous changes (adding thermal stubs) do not add
     // filled areas outside the zone boundary
-    aRawPolys.BooleanIntersection( aSmoothedOutline, SHAPE_POLY_SET::PM_FAST );
+    aRawPolys.BooleanIntersection( *outline, SHAPE_POLY_SET::PM_FAST );
     aRawPolys.Simplify( SHAPE_POLY_SET::PM_FAST );
 
     if( s_DumpZonesWhenFilling )
@@ -797,9 +1668,29 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone,
         // If we've deflated/inflated by something near our corner radius then we will have
         // ended up with too-sharp corners.  Apply outline smoothing again.
         if( aZone->GetMinThickness() > (int)aZone->GetCornerRadius() )
-            aRawPolys.BooleanIntersection( aSmoothedOutline, SHAPE_POLY_SET::PM_FAST );
+            aRawPolys.BooleanIntersection( *outline, SHAPE_POLY_SET::PM_FAST );
+    }
+
+    // Patch the refilled window into the previous fill.  The new fill is also kept a little
+    // outside the patch, where both fills are exact, so that they overlap.
+    if( aArea )
+    {
+        SHAPE_POLY_SET previousFill = *aArea->m_PreviousFill;
+        EDA_RECT       overlap = aArea->m_Patch;
+
+        overlap.Inflate( aZone->GetMinThickness() );
+
+        previousFill.BooleanSubtract( rectToPoly( aArea->m_Patch ), SHAPE_POLY_SET::PM_FAST );
+        aRawPolys.BooleanIntersection( rectToPoly( overlap ), SHAPE_POLY_SET::PM_FAST );
+        aRawPolys.BooleanAdd( previousFill, SHAPE_POLY_SET::PM_FAST );
+
+        if( s_DumpZonesWhenFilling )
+            dumper->Write( &aRawPolys, "solid-areas-patched" );
     }
 
+    if( aUnfractured )
+        *aUnfractured = aRawPolys;
+
     aRawPolys.Fracture( SHAPE_POLY_SET::PM_FAST );
 
     if( s_DumpZonesWhenFilling )
@@ -818,7 +1709,10 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone,
  * ( holes are linked by overlapping segments to the main outline)
  */
 bool ZONE_FILLER::fillSingleZone( ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aRawPolys,
-                                  SHAPE_POLY_SET& aFinalPolys )
+                                  SHAPE_POLY_SET& aFinalPolys,
+                                  const SHAPE_POLY_SET* aClearanceHoles,
+                                  const FILL_AREA* aArea,
+                                  SHAPE_POLY_SET* aUnfractured )
 {
     SHAPE_POLY_SET smoothedPoly;
     std::set<VECTOR2I> colinearCorners;
@@ -834,7 +1728,8 @@ bool ZONE_FILLER::fillSingleZone( ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aRawPol
 
     if( aZone->IsOnCopperLayer() )
     {
-        computeRawFilledArea( aZone, smoothedPoly, &colinearCorners, aRawPolys, aFinalPolys );
+        computeRawFilledArea( aZone, smoothedPoly, &colinearCorners, aRawPolys, aFinalPolys,
+                              aClearanceHoles, aArea, aUnfractured );
     }
     else
     {
@@ -874,11 +1769,92 @@ bool ZONE_FILLER::fillSingleZone( ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aRawPol
 }
 
 
+/**
+ * Builds the four thermal spokes of a pad, relative to the pad position.  The spokes are
+ * laid out around the pad's bounding box, inflated by aReliefGap, at the orientation of
+ * the pad.
+ */
+static void buildPadSpokes( const D_PAD* aPad, int aReliefGap, int aSpokeHalfWidth,
+                            std::vector<SHAPE_LINE_CHAIN>& aSpokes )
+{
+    int spoke_half_w = aSpokeHalfWidth;
+
+    // Thermal spokes consist of segments from the pad center to points just outside
+    // the thermal relief.
+    //
+    // We use the bounding-box to lay out the spokes, but for this to work the
+    // bounding box has to be built at the same rotation as the spokes.  The pad is
+    // shared with other fill threads, so an unrotated copy is used.
+
+    wxPoint shapeOffset = aPad->ShapePos() - aPad->GetPosition();
+    double padAngle = aPad->GetOrientation();
+    D_PAD unrotatedPad( *aPad );
+    unrotatedPad.SetOrientation( 0.0 );
+    unrotatedPad.SetPosition( { 0, 0 } );
+    BOX2I reliefBB = unrotatedPad.GetBoundingBox();
+
+    reliefBB.Inflate( aReliefGap );
+
+    // For circle pads, the thermal spoke orientation is 45 deg
+    if( aPad->GetShape() == PAD_SHAPE_CIRCLE )
+        padAngle = s_RoundPadThermalSpokeAngle;
+
+    for( int i = 0; i < 4; i++ )
+    {
+        SHAPE_LINE_CHAIN spoke;
+        switch( i )
+        {
+        case 0:       // lower stub
+            spoke.Append( +spoke_half_w,       -spoke_half_w );
+            spoke.Append( -spoke_half_w,       -spoke_half_w );
+            spoke.Append( -spoke_half_w,       reliefBB.GetBottom() );
+            spoke.Append( 0,                   reliefBB.GetBottom() );  // test pt
+            spoke.Append( +spoke_half_w,       reliefBB.GetBottom() );
+            break;
+
+        case 1:       // upper stub
+            spoke.Append( +spoke_half_w,       spoke_half_w );
+            spoke.Append( -spoke_half_w,       spoke_half_w );
+            spoke.Append( -spoke_half_w,       reliefBB.GetTop() );
+            spoke.Append( 0,                   reliefBB.GetTop() );     // test pt
+            spoke.Append( +spoke_half_w,       reliefBB.GetTop() );
+            break;
+
+        case 2:       // right stub
+            spoke.Append( -spoke_half_w,       spoke_half_w );
+            spoke.Append( -spoke_half_w,       -spoke_half_w );
+            spoke.Append( reliefBB.GetRight(), -spoke_half_w );
+            spoke.Append( reliefBB.GetRight(), 0 );                     // test pt
+            spoke.Append( reliefBB.GetRight(), spoke_half_w );
+            break;
+
+        case 3:       // left stub
+            spoke.Append( spoke_half_w,        spoke_half_w );
+            spoke.Append( spoke_half_w,        -spoke_half_w );
+            spoke.Append( reliefBB.GetLeft(),  -spoke_half_w );
+            spoke.Append( reliefBB.GetLeft(),  0 );                     // test pt
+            spoke.Append( reliefBB.GetLeft(),  spoke_half_w );
+            break;
+        }
+
+        for( int j = 0; j < spoke.PointCount(); j++ )
+        {
+            RotatePoint( spoke.Point( j ), padAngle );
+            spoke.Point( j ) += shapeOffset;
+        }
+
+        spoke.SetClosed( true );
+        aSpokes.push_back( std::move( spoke ) );
+    }
+}
+
+
 /**
  * Function buildThermalSpokes
  */
 void ZONE_FILLER::buildThermalSpokes( const ZONE_CONTAINER* aZone,
-                                      std::deque<SHAPE_LINE_CHAIN>& aSpokesList )
+                                      std::deque<SHAPE_LINE_CHAIN>& aSpokesList,
+                                      const EDA_RECT* aWindow )
 {
     auto zoneBB = aZone->GetBoundingBox();
     int  zone_clearance = aZone->GetZoneClearance();
@@ -897,6 +1873,9 @@ void ZONE_FILLER::buildThermalSpokes( const ZONE_CONTAINER* aZone,
             if( !hasThermalConnection( pad, aZone ) )
                 continue;
 
+            if( aWindow && !thermalReach( pad, aZone ).Intersects( *aWindow ) )
+                continue;
+
             // We currently only connect to pads, not pad holes
             if( !pad->IsOnLayer( aZone->GetLayer() ) )
                 continue;
@@ -920,72 +1899,35 @@ void ZONE_FILLER::buildThermalSpokes( const ZONE_CONTAINER* aZone,
             if( !( itemBB.Intersects( zoneBB ) ) )
                 continue;
 
-            // Thermal spokes consist of segments from the pad center to points just outside
-            // the thermal relief.
-            //
-            // We use the bounding-box to lay out the spokes, but for this to work the
-            // bounding box has to be built at the same rotation as the spokes.
-
-            wxPoint shapePos = pad->ShapePos();
-            wxPoint padPos = pad->GetPosition();
-            double padAngle = pad->GetOrientation();
-            pad->SetOrientation( 0.0 );
-            pad->SetPosition( { 0, 0 } );
-            BOX2I reliefBB = pad->GetBoundingBox();
-            pad->SetPosition( padPos );
-            pad->SetOrientation( padAngle );
+            THERMAL_KEY                   key;
+            bool                          useTemplate;
+            std::vector<SHAPE_LINE_CHAIN> spokes;
 
-            reliefBB.Inflate( thermalReliefGap + epsilon );
+            useTemplate = getThermalKey( pad, thermalReliefGap, spoke_w, key );
 
-            // For circle pads, the thermal spoke orientation is 45 deg
-            if( pad->GetShape() == PAD_SHAPE_CIRCLE )
-                padAngle = s_RoundPadThermalSpokeAngle;
-
-            for( int i = 0; i < 4; i++ )
+            if( useTemplate )
             {
-                SHAPE_LINE_CHAIN spoke;
-                switch( i )
-                {
-                case 0:       // lower stub
-                    spoke.Append( +spoke_half_w,       -spoke_half_w );
-                    spoke.Append( -spoke_half_w,       -spoke_half_w );
-                    spoke.Append( -spoke_half_w,       reliefBB.GetBottom() );
-                    spoke.Append( 0,                   reliefBB.GetBottom() );  // test pt
-                    spoke.Append( +spoke_half_w,       reliefBB.GetBottom() );
-                    break;
-
-                case 1:       // upper stub
-                    spoke.Append( +spoke_half_w,       spoke_half_w );
-                    spoke.Append( -spoke_half_w,       spoke_half_w );
-                    spoke.Append( -spoke_half_w,       reliefBB.GetTop() );
-                    spoke.Append( 0,                   reliefBB.GetTop() );     // test pt
-                    spoke.Append( +spoke_half_w,       reliefBB.GetTop() );
-                    break;
+                std::lock_guard<std::mutex> lock( m_templatesLock );
+                auto it = m_spokeTemplates.find( key );
 
-                case 2:       // right stub
-                    spoke.Append( -spoke_half_w,       spoke_half_w );
-                    spoke.Append( -spoke_half_w,       -spoke_half_w );
-                    spoke.Append( reliefBB.GetRight(), -spoke_half_w );
-                    spoke.Append( reliefBB.GetRight(), 0 );                     // test pt
-                    spoke.Append( reliefBB.GetRight(), spoke_half_w );
-                    break;
+                if( it != m_spokeTemplates.end() )
+                    spokes = it->second;
+            }
 
-                case 3:       // left stub
-                    spoke.Append( spoke_half_w,        spoke_half_w );
-                    spoke.Append( spoke_half_w,        -spoke_half_w );
-                    spoke.Append( reliefBB.GetLeft(),  -spoke_half_w );
-                    spoke.Append( reliefBB.GetLeft(),  0 );                     // test pt
-                    spoke.Append( reliefBB.GetLeft(),  spoke_half_w );
-                    break;
-                }
+            if( spokes.empty() )
+            {
+                buildPadSpokes( pad, thermalReliefGap + epsilon, spoke_half_w, spokes );
 
-                for( int j = 0; j < spoke.PointCount(); j++ )
+                if( useTemplate )
                 {
-                    RotatePoint( spoke.Point( j ), padAngle );
-                    spoke.Point( j ) += shapePos;
+                    std::lock_guard<std::mutex> lock( m_templatesLock );
+                    m_spokeTemplates.emplace( key, spokes );
                 }
+            }
 
-                spoke.SetClosed( true );
+            for( SHAPE_LINE_CHAIN& spoke : spokes )
+            {
+                spoke.Move( pad->GetPosition() );
                 spoke.GenerateBBoxCache();
                 aSpokesList.push_back( std::move( spoke ) );
             }
@@ -1126,7 +2068,7 @@ void ZONE_FILLER::addHatchFillTypeOnZone( const ZONE_CONTAINER* aZone, SHAPE_POL
     // It happens for holes near the zone outline
     for( int ii = 0; ii < holes.OutlineCount(); )
     {
-        double area = holes.Outline( ii ).Area();
+        double area = holes.COutline( ii ).Area();
 
         if( area < minimal_hole_area ) // The current hole is too small: remove it
             holes.DeletePolygon( ii );
@@ -27,6 +27,13 @@
 #define __ZONE_FILLER_H
 
 #include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <functional>
 #include <class_zone.h>
 
 class WX_PROGRESS_REPORTER;
@@ -36,6 +43,86 @@ class SHAPE_POLY_SET;
 class SHAPE_LINE_CHAIN;
 
 
+/**
+ * Class ZONE_FILL_CACHE
+ * Keeps what a ZONE_FILLER needs to refill zones incrementally: the fill of each zone
+ * (before fracturing and island removal) as of its last fill, and the board areas edited
+ * since then.  A zone whose cached fill is known is refilled only around the edits.
+ *
+ * It also keeps the clearance knockout of each item, so an item knocked out of several
+ * zones with the same clearance is only converted to a polygon once, and not again on
+ * the next fill if it hasn't changed.
+ */
+class ZONE_FILL_CACHE
+{
+public:
+    ZONE_FILL_CACHE();
+
+    /**
+     * Forgets all fills, so the next fill of each zone is a full one.  Must be called when
+     * the board is changed without going through a commit (undo, redo, reload).
+     */
+    void Clear();
+
+    /**
+     * Marks the copper area covered by aItem, and the nets of its copper, as edited.  For a
+     * modified item, both its previous and its new state must be passed.  A modified zone
+     * also loses its fill.
+     */
+    void AddDirtyItem( const BOARD_ITEM* aItem );
+
+    /**
+     * Returns the number of knockouts found in the cache, and the number built, since the
+     * last call to Clear().
+     */
+    size_t GetKnockoutHits() const { return m_knockoutHits; }
+    size_t GetKnockoutMisses() const { return m_knockoutMisses; }
+
+private:
+    friend class ZONE_FILLER;
+
+    /**
+     * A knockout of an item.  The knockout kind, gap and flag are the ones of
+     * ZONE_FILLER::KNOCKOUT; the geometry hash tells if the item has changed since the
+     * knockout was built.
+     */
+    struct KNOCKOUT_SHAPE
+    {
+        int            m_Kind;
+        int            m_Gap;
+        bool           m_Flag;
+        size_t         m_GeometryHash;
+        SHAPE_POLY_SET m_Shape;
+    };
+
+    void eraseKnockouts( const BOARD_ITEM* aItem );
+
+    struct DIRTY_AREA
+    {
+        LSET          m_Layers;
+        EDA_RECT      m_BBox;
+        std::set<int> m_Nets;       ///< the nets whose connectivity the edit may change
+    };
+
+    struct ZONE_FILL
+    {
+        SHAPE_POLY_SET m_Fill;
+        size_t         m_DirtyCount;    ///< the number of dirty areas already in m_Fill
+    };
+
+    std::map<const ZONE_CONTAINER*, ZONE_FILL> m_fills;
+    std::vector<DIRTY_AREA>                     m_dirtyAreas;
+    size_t                                      m_settingsHash;
+
+    // Knockouts are shared by the fill threads.  A deque keeps the shapes in place while
+    // other threads add knockouts, so they can be read without holding the lock.
+    std::unordered_map<const BOARD_ITEM*, std::deque<KNOCKOUT_SHAPE>> m_knockouts;
+    std::mutex                                                         m_knockoutsLock;
+    std::atomic<size_t>                                                m_knockoutHits;
+    std::atomic<size_t>                                                m_knockoutMisses;
+};
+
+
 class ZONE_FILLER
 {
 public:
@@ -43,15 +130,131 @@ public:
     ~ZONE_FILLER();
 
     void InstallNewProgressReporter( wxWindow* aParent, const wxString& aTitle, int aNumPhases );
+
+    /**
+     * Uses aCache to refill zones incrementally.  Zones the cache has no fill for are filled
+     * in full, and their fills are added to it.
+     */
+    void SetFillCache( ZONE_FILL_CACHE* aCache ) { m_fillCache = aCache; }
+
     bool Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck = false );
 
 private:
 
+    /**
+     * The part of a zone to refill when the zone's previous fill is known.  The fill is
+     * computed inside m_Window, which is large enough for it to be exact inside m_Patch,
+     * and patched into the previous fill.
+     */
+    struct FILL_AREA
+    {
+        EDA_RECT              m_Window;
+        EDA_RECT              m_Patch;
+        const SHAPE_POLY_SET* m_PreviousFill;
+    };
+
+    enum FILL_MODE
+    {
+        FILL_FULL,
+        FILL_PATCH,
+        FILL_ISLANDS,       ///< the fill is unchanged, but its net's connectivity may not be
+        FILL_UNCHANGED
+    };
+
+    /**
+     * Decides how aZone must be refilled, from the areas and nets edited since its cached
+     * fill.  Islands depend on the connectivity of the whole net, so a zone whose net was
+     * edited anywhere on the board has its islands looked for again, even if nothing near
+     * it changed.
+     * @param aArea is set to the area to refill when FILL_PATCH is returned, and to the
+     * previous fill for all modes but FILL_FULL.
+     */
+    FILL_MODE getFillArea( const ZONE_CONTAINER* aZone, FILL_AREA& aArea );
+
+    /**
+     * A copper item to knock out of a zone's fill, with the clearance it needs.
+     */
+    struct KNOCKOUT
+    {
+        enum KIND
+        {
+            PAD,            ///< the pad itself
+            PAD_HOLE,       ///< the hole of a pad which is not on the zone's layer
+            TRACK,
+            GRAPHIC,
+            ZONE_OUTLINE    ///< a higher priority zone or a keepout
+        };
+
+        KIND        m_Kind;
+        BOARD_ITEM* m_Item;
+        int         m_Gap;
+        bool        m_Flag;     ///< GRAPHIC: ignore line width, ZONE_OUTLINE: use net clearance
+    };
+
+    /**
+     * Runs aTask( 0 ) .. aTask( aCount - 1 ) on all available cores, keeping the progress
+     * reporter alive while waiting.  Tasks are handed out in index order.
+     */
+    void runParallel( size_t aCount, const std::function<void( size_t )>& aTask );
+
     void addKnockout( D_PAD* aPad, int aGap, SHAPE_POLY_SET& aHoles );
 
     void addKnockout( BOARD_ITEM* aItem, int aGap, bool aIgnoreLineWidth, SHAPE_POLY_SET& aHoles );
 
-    void knockoutThermalReliefs( const ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aFill );
+    /**
+     * Thermal reliefs and spokes only depend on the pad's shape, size and orientation and on
+     * the zone's gap and spoke width, not on where the pad is.  Pads which share these (the
+     * balls of a BGA, the pins of a connector) share a template built around the origin,
+     * which is moved to each pad.
+     */
+    struct THERMAL_KEY
+    {
+        int    m_Shape;
+        int    m_SizeX;
+        int    m_SizeY;
+        int    m_DeltaX;
+        int    m_DeltaY;
+        int    m_OffsetX;
+        int    m_OffsetY;
+        double m_Orientation;
+        double m_RoundRectRatio;
+        double m_ChamferRatio;
+        int    m_ChamferPositions;
+        int    m_Gap;
+        int    m_SpokeWidth;
+
+        bool operator<( const THERMAL_KEY& aOther ) const;
+    };
+
+    /**
+     * Builds the template key of a pad.  Returns false for pads which can't use templates.
+     */
+    bool getThermalKey( const D_PAD* aPad, int aGap, int aSpokeWidth, THERMAL_KEY& aKey ) const;
+
+    /**
+     * Adds the thermal relief of a pad, i.e. a knockout aGap larger than the pad.
+     */
+    void addThermalRelief( D_PAD* aPad, int aGap, SHAPE_POLY_SET& aHoles );
+
+    void knockoutThermalReliefs( const ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aFill,
+                                 const EDA_RECT* aWindow = nullptr );
+
+    /**
+     * Collects the copper items which share the zone's layer but are not connected to it,
+     * in the order their knockouts must be built.
+     */
+    void collectKnockouts( const ZONE_CONTAINER* aZone, std::vector<KNOCKOUT>& aKnockouts,
+                           const EDA_RECT* aWindow = nullptr );
+
+    /**
+     * Splits the knockouts of a zone into tiles of nearby items, in a grid over the zone's
+     * bounding box.  Each tile can be knocked out on its own; the union of the tiles is the
+     * clearance area of the zone.  Small zones get a single tile.
+     */
+    void tileKnockouts( const ZONE_CONTAINER* aZone, std::vector<KNOCKOUT>& aKnockouts,
+                        std::vector<std::vector<KNOCKOUT>>& aTiles );
+
+    void addKnockouts( const std::vector<KNOCKOUT>& aKnockouts, SHAPE_POLY_SET& aHoles );
 
     void buildCopperItemClearances( const ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aHoles );
 
@@ -65,17 +268,25 @@ private:
      * BuildFilledSolidAreasPolygons() call this function just after creating the
      *  filled copper area polygon (without clearance areas
      * @param aPcb: the current board
+     * @param aClearanceHoles: the already built clearance holes of the zone, or nullptr to
+     * build them here
+     * @param aArea: the area to refill, or nullptr to fill the whole zone
+     * @param aUnfractured: if not nullptr, receives the fill before fracturing
      */
     void computeRawFilledArea( const ZONE_CONTAINER* aZone,
                                const SHAPE_POLY_SET& aSmoothedOutline,
                                std::set<VECTOR2I>* aPreserveCorners,
-                               SHAPE_POLY_SET& aRawPolys, SHAPE_POLY_SET& aFinalPolys );
+                               SHAPE_POLY_SET& aRawPolys, SHAPE_POLY_SET& aFinalPolys,
+                               const SHAPE_POLY_SET* aClearanceHoles = nullptr,
+                               const FILL_AREA* aArea = nullptr,
+                               SHAPE_POLY_SET* aUnfractured = nullptr );
 
     /**
      * Function buildThermalSpokes
      * Constructs a list of all thermal spokes for the given zone.
      */
-    void buildThermalSpokes( const ZONE_CONTAINER* aZone, std::deque<SHAPE_LINE_CHAIN>& aSpokes );
+    void buildThermalSpokes( const ZONE_CONTAINER* aZone, std::deque<SHAPE_LINE_CHAIN>& aSpokes,
+                             const EDA_RECT* aWindow = nullptr );
 
     /**
      * Build the filled solid areas polygons from zone outlines (stored in m_Poly)
@@ -90,9 +301,16 @@ private:
      * (holes are linked to main outline by overlapping segments, and these polygons are shrinked
      * by aZone->GetMinThickness() / 2 to be drawn with a outline thickness = aZone->GetMinThickness()
      * aFinalPolys are polygons that will be drawn on screen and plotted
+     * @param aClearanceHoles: the already built clearance holes of a copper zone, or nullptr
+     * @param aArea: the area of a copper zone to refill, or nullptr to fill the whole zone
+     * @param aUnfractured: if not nullptr, receives the fill of a copper zone before
+     * fracturing
      */
     bool fillSingleZone( ZONE_CONTAINER* aZone, SHAPE_POLY_SET& aRawPolys,
-                         SHAPE_POLY_SET& aFinalPolys );
+                         SHAPE_POLY_SET& aFinalPolys,
+                         const SHAPE_POLY_SET* aClearanceHoles = nullptr,
+                         const FILL_AREA* aArea = nullptr,
+                         SHAPE_POLY_SET* aUnfractured = nullptr );
 
     /**
      * for zones having the ZONE_FILL_MODE::ZFM_HATCH_PATTERN, create a grid pattern
@@ -108,9 +326,15 @@ private:
     bool m_brdOutlinesValid;            // true if m_boardOutline can be calculated
                                         // false if not (not closed outlines for instance)
     COMMIT* m_commit;
+    ZONE_FILL_CACHE* m_fillCache;
     WX_PROGRESS_REPORTER* m_progressReporter;
     std::unique_ptr<WX_PROGRESS_REPORTER> m_uniqueReporter;
 
+    // Thermal templates, shared by the zones filled together
+    std::map<THERMAL_KEY, SHAPE_POLY_SET>                m_reliefTemplates;
+    std::map<THERMAL_KEY, std::vector<SHAPE_LINE_CHAIN>> m_spokeTemplates;
+    std::mutex                                           m_templatesLock;
+
     // m_high_def can be used to define a high definition arc to polygon approximation
     int m_high_def;
 
@@ -249,12 +249,12 @@ bool BOARD::TestAreaIntersection( ZONE_CONTAINER* area_ref, ZONE_CONTAINER* area
         return false;
 
     // Now test for intersecting segments
-    for( auto segIterator1 = poly1->IterateSegmentsWithHoles(); segIterator1; segIterator1++ )
+    for( auto segIterator1 = poly1->CIterateSegmentsWithHoles(); segIterator1; segIterator1++ )
     {
         // Build segment
         SEG firstSegment = *segIterator1;
 
-        for( auto segIterator2 = poly2->IterateSegmentsWithHoles(); segIterator2; segIterator2++ )
+        for( auto segIterator2 = poly2->CIterateSegmentsWithHoles(); segIterator2; segIterator2++ )
         {
             // Build second segment
             SEG secondSegment = *segIterator2;
@@ -267,13 +267,13 @@ bool BOARD::TestAreaIntersection( ZONE_CONTAINER* area_ref, ZONE_CONTAINER* area
 
     // If a contour is inside another contour, no segments intersects, but the zones
     // can be combined if a corner is inside an outline (only one corner is enough)
-    for( auto iter = poly2->IterateWithHoles(); iter; iter++ )
+    for( auto iter = poly2->CIterateWithHoles(); iter; iter++ )
     {
         if( poly1->Contains( *iter ) )
             return true;
     }
 
-    for( auto iter = poly1->IterateWithHoles(); iter; iter++ )
+    for( auto iter = poly1->CIterateWithHoles(); iter; iter++ )
     {
         if( poly2->Contains( *iter ) )
             return true;
@@ -0,0 +1,209 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <random>
+#include <set>
+
+#include <geometry/delaunay_triangulation.h>
+
+
+/**
+ * Exact in-circle test for small coordinates: positive if aP is inside the circumcircle of
+ * the counter-clockwise (in the mathematical sense) triangle aA, aB, aC.
+ */
+static int64_t inCircle( const VECTOR2I& aA, const VECTOR2I& aB, const VECTOR2I& aC,
+                         const VECTOR2I& aP )
+{
+    const int64_t dx = aA.x - aP.x, dy = aA.y - aP.y;
+    const int64_t ex = aB.x - aP.x, ey = aB.y - aP.y;
+    const int64_t fx = aC.x - aP.x, fy = aC.y - aP.y;
+
+    const int64_t ap = dx * dx + dy * dy;
+    const int64_t bp = ex * ex + ey * ey;
+    const int64_t cp = fx * fx + fy * fy;
+
+    return dx * ( ey * cp - bp * fy ) - dy * ( ex * cp - bp * fx ) + ap * ( ex * fy - ey * fx );
+}
+
+
+static int64_t orient( const VECTOR2I& aA, const VECTOR2I& aB, const VECTOR2I& aC )
+{
+    return (int64_t) ( aB.x - aA.x ) * ( aC.y - aA.y )
+           - (int64_t) ( aB.y - aA.y ) * ( aC.x - aA.x );
+}
+
+
+/**
+ * Checks the triangulation of aPoints is a valid Delaunay triangulation: consistent
+ * adjacency, all points used, all triangles with the same orientation, the expected number
+ * of triangles, and no point strictly inside the circumcircle of a neighbouring triangle.
+ */
+static void CheckTriangulation( const DELAUNAY_TRIANGULATION& aTri,
+                                const std::vector<VECTOR2I>&  aPoints )
+{
+    const auto& triangles = aTri.Triangles();
+    const auto& halfEdges = aTri.HalfEdges();
+
+    BOOST_REQUIRE_EQUAL( triangles.size(), halfEdges.size() );
+    BOOST_REQUIRE_EQUAL( triangles.size() % 3, 0 );
+
+    int hullEdges = 0;
+
+    for( int e = 0; e < (int) halfEdges.size(); e++ )
+    {
+        if( halfEdges[e] == -1 )
+            hullEdges++;
+        else
+            BOOST_REQUIRE_EQUAL( halfEdges[halfEdges[e]], e );
+    }
+
+    const int triCount = triangles.size() / 3;
+    const int pointCount = aPoints.size();
+
+    // Euler's formula for a triangulated convex hull
+    BOOST_CHECK_EQUAL( triCount, 2 * pointCount - 2 - hullEdges );
+
+    std::set<int> used( triangles.begin(), triangles.end() );
+    BOOST_CHECK_EQUAL( used.size(), aPoints.size() );
+
+    int64_t sign = 0;
+
+    for( int t = 0; t < triCount; t++ )
+    {
+        const int64_t o = orient( aPoints[triangles[3 * t]], aPoints[triangles[3 * t + 1]],
+                                  aPoints[triangles[3 * t + 2]] );
+
+        BOOST_REQUIRE( o != 0 );
+
+        if( sign == 0 )
+            sign = o > 0 ? 1 : -1;
+
+        BOOST_CHECK( ( o > 0 ) == ( sign > 0 ) );
+    }
+
+    int illegal = 0;
+
+    for( int e = 0; e < (int) halfEdges.size(); e++ )
+    {
+        const int opposite = halfEdges[e];
+
+        if( opposite == -1 )
+            continue;
+
+        const int t = e / 3;
+        const int apex = triangles[opposite - opposite % 3 + ( opposite + 2 ) % 3];
+
+        if( sign * inCircle( aPoints[triangles[3 * t]], aPoints[triangles[3 * t + 1]],
+                             aPoints[triangles[3 * t + 2]], aPoints[apex] ) > 0 )
+            illegal++;
+    }
+
+    BOOST_CHECK_EQUAL( illegal, 0 );
+}
+
+
+BOOST_AUTO_TEST_SUITE( DelaunayTriangulation )
+
+
+BOOST_AUTO_TEST_CASE( Degenerate )
+{
+    DELAUNAY_TRIANGULATION tri;
+
+    BOOST_CHECK( !tri.Triangulate( {} ) );
+    BOOST_CHECK( !tri.Triangulate( { { 0, 0 }, { 10, 0 } } ) );
+    BOOST_CHECK( !tri.Triangulate( { { 0, 0 }, { 10, 10 }, { 20, 20 }, { 50, 50 } } ) );
+    BOOST_CHECK( tri.Triangles().empty() );
+}
+
+
+BOOST_AUTO_TEST_CASE( Square )
+{
+    const std::vector<VECTOR2I> points = { { 0, 0 }, { 100, 0 }, { 100, 100 }, { 0, 100 } };
+
+    DELAUNAY_TRIANGULATION tri;
+    BOOST_REQUIRE( tri.Triangulate( points ) );
+
+    BOOST_CHECK_EQUAL( tri.Triangles().size(), 6 );
+
+    int edges = 0;
+    tri.ForEachEdge( [&]( int, int ) { edges++; } );
+
+    BOOST_CHECK_EQUAL( edges, 5 );
+
+    CheckTriangulation( tri, points );
+}
+
+
+/**
+ * A regular grid has many cocircular points, the worst case for the flips
+ */
+BOOST_AUTO_TEST_CASE( Grid )
+{
+    std::vector<VECTOR2I> points;
+
+    for( int y = 0; y < 30; y++ )
+    {
+        for( int x = 0; x < 30; x++ )
+            points.emplace_back( x * 100, y * 100 );
+    }
+
+    DELAUNAY_TRIANGULATION tri;
+    BOOST_REQUIRE( tri.Triangulate( points ) );
+
+    CheckTriangulation( tri, points );
+}
+
+
+BOOST_AUTO_TEST_CASE( Random )
+{
+    std::mt19937                       rng( 42 );
+    std::uniform_int_distribution<int> coord( -10000, 10000 );
+
+    DELAUNAY_TRIANGULATION tri;
+
+    for( int pointCount : { 3, 10, 100, 2000 } )
+    {
+        BOOST_TEST_CONTEXT( pointCount << " points" )
+        {
+            std::set<std::pair<int, int>> unique;
+            std::vector<VECTOR2I>         points;
+
+            while( (int) points.size() < pointCount )
+            {
+                const VECTOR2I p( coord( rng ), coord( rng ) );
+
+                if( unique.emplace( p.x, p.y ).second )
+                    points.push_back( p );
+            }
+
+            BOOST_REQUIRE( tri.Triangulate( points ) );
+
+            CheckTriangulation( tri, points );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,174 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cmath>
+#include <random>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+
+/**
+ * Area covered by aSet: the area of its outlines minus the area of their holes
+ */
+static double area( const SHAPE_POLY_SET& aSet )
+{
+    double total = 0.0;
+
+    for( int ii = 0; ii < aSet.OutlineCount(); ii++ )
+    {
+        total += std::abs( aSet.COutline( ii ).Area() );
+
+        for( int jj = 0; jj < aSet.HoleCount( ii ); jj++ )
+            total -= std::abs( aSet.CHole( ii, jj ).Area() );
+    }
+
+    return total;
+}
+
+
+/**
+ * Operands overlapping each other at random: each is a set of a few squares.  There are
+ * enough vertices for the operands to be merged on worker threads.
+ */
+struct BooleanManyFixture
+{
+    SHAPE_POLY_SET              base;
+    std::vector<SHAPE_POLY_SET> operands;
+
+    BooleanManyFixture()
+    {
+        std::mt19937                       rng( 42 );
+        std::uniform_int_distribution<int> coord( 0, 100000 );
+        std::uniform_int_distribution<int> size( 500, 5000 );
+
+        auto square = []( int aX, int aY, int aSize )
+        {
+            SHAPE_LINE_CHAIN chain;
+
+            chain.Append( aX, aY );
+            chain.Append( aX + aSize, aY );
+            chain.Append( aX + aSize, aY + aSize );
+            chain.Append( aX, aY + aSize );
+            chain.SetClosed( true );
+
+            return chain;
+        };
+
+        base.AddOutline( square( 10000, 10000, 80000 ) );
+        base.AddHole( square( 40000, 40000, 20000 ) );
+
+        for( int ii = 0; ii < 601; ii++ )
+        {
+            SHAPE_POLY_SET operand;
+
+            for( int jj = 0; jj < 5; jj++ )
+                operand.AddOutline( square( coord( rng ), coord( rng ), size( rng ) ) );
+
+            operands.push_back( operand );
+        }
+    }
+
+    ///> The union of the operands, computed with a single boolean operation
+    SHAPE_POLY_SET mergedOperands() const
+    {
+        SHAPE_POLY_SET merged;
+
+        for( const SHAPE_POLY_SET& operand : operands )
+            merged.Append( operand );
+
+        merged.Simplify( SHAPE_POLY_SET::PM_FAST );
+
+        return merged;
+    }
+
+    std::vector<const SHAPE_POLY_SET*> operandPtrs() const
+    {
+        std::vector<const SHAPE_POLY_SET*> ptrs;
+
+        for( const SHAPE_POLY_SET& operand : operands )
+            ptrs.push_back( &operand );
+
+        return ptrs;
+    }
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( SPSBoolean, BooleanManyFixture )
+
+
+/**
+ * BooleanMany() gives the same result as a boolean operation with the merged operands
+ */
+BOOST_AUTO_TEST_CASE( ManyOperands )
+{
+    const SHAPE_POLY_SET merged = mergedOperands();
+
+    for( ClipperLib::ClipType type : { ClipperLib::ctUnion, ClipperLib::ctDifference,
+                                       ClipperLib::ctIntersection } )
+    {
+        BOOST_TEST_CONTEXT( "Clip type " << type )
+        {
+            SHAPE_POLY_SET expected = base;
+
+            if( type == ClipperLib::ctUnion )
+                expected.BooleanAdd( merged, SHAPE_POLY_SET::PM_FAST );
+            else if( type == ClipperLib::ctDifference )
+                expected.BooleanSubtract( merged, SHAPE_POLY_SET::PM_FAST );
+            else
+                expected.BooleanIntersection( merged, SHAPE_POLY_SET::PM_FAST );
+
+            SHAPE_POLY_SET result = base;
+            result.BooleanMany( type, operandPtrs(), SHAPE_POLY_SET::PM_FAST );
+
+            BOOST_CHECK_EQUAL( result.OutlineCount(), expected.OutlineCount() );
+            BOOST_CHECK_CLOSE( area( result ), area( expected ), 1e-6 );
+
+            // The symmetric difference is empty
+            SHAPE_POLY_SET diff = result;
+            diff.BooleanSubtract( expected, SHAPE_POLY_SET::PM_FAST );
+            BOOST_CHECK_EQUAL( diff.OutlineCount(), 0 );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( EmptyCases )
+{
+    SHAPE_POLY_SET result = base;
+
+    result.BooleanMany( ClipperLib::ctUnion, {}, SHAPE_POLY_SET::PM_FAST );
+    BOOST_CHECK_CLOSE( area( result ), area( base ), 1e-6 );
+
+    result.BooleanMany( ClipperLib::ctIntersection, {}, SHAPE_POLY_SET::PM_FAST );
+    BOOST_CHECK_EQUAL( result.OutlineCount(), 0 );
+
+    // With an empty set, the union is the union of the operands
+    result.BooleanMany( ClipperLib::ctUnion, operandPtrs(), SHAPE_POLY_SET::PM_FAST );
+    BOOST_CHECK_CLOSE( area( result ), area( mergedOperands() ), 1e-6 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,255 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cmath>
+#include <random>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+/**
+ * The queries of a large poly set go through its edge index: they are checked against the
+ * same queries computed directly on the contours.
+ */
+struct EdgeIndexFixture
+{
+    SHAPE_POLY_SET        polySet;
+    std::vector<VECTOR2I> points;
+    std::vector<SEG>      segs;
+
+    EdgeIndexFixture()
+    {
+        std::mt19937                       rng( 42 );
+        std::uniform_int_distribution<int> radius( 400, 900 );
+        std::uniform_int_distribution<int> coord( -1000, 13000 );
+
+        // A grid of irregular polygons, each with a hole
+        for( int row = 0; row < 6; row++ )
+        {
+            for( int col = 0; col < 6; col++ )
+            {
+                const VECTOR2I   centre( col * 2000, row * 2000 );
+                SHAPE_LINE_CHAIN outline, hole;
+
+                for( int i = 0; i < 24; i++ )
+                {
+                    const double a = 2 * M_PI * i / 24;
+                    const int    r = radius( rng );
+
+                    outline.Append( centre.x + int( r * cos( a ) ), centre.y + int( r * sin( a ) ) );
+                }
+
+                for( int i = 0; i < 8; i++ )
+                {
+                    const double a = 2 * M_PI * i / 8;
+
+                    hole.Append( centre.x + int( 300 * cos( a ) ), centre.y + int( 300 * sin( a ) ) );
+                }
+
+                outline.SetClosed( true );
+                hole.SetClosed( true );
+
+                polySet.AddOutline( outline );
+                polySet.AddHole( hole );
+            }
+        }
+
+        for( int i = 0; i < 2000; i++ )
+            points.emplace_back( coord( rng ), coord( rng ) );
+
+        // The vertices and the middle of the edges are the hard cases
+        for( int poly = 0; poly < polySet.OutlineCount(); poly++ )
+        {
+            for( const SHAPE_LINE_CHAIN& chain : { polySet.COutline( poly ),
+                                                   polySet.CHole( poly, 0 ) } )
+            {
+                for( int i = 0; i < chain.SegmentCount(); i++ )
+                {
+                    points.push_back( chain.CSegment( i ).A );
+                    points.push_back( chain.CSegment( i ).Center() );
+                }
+            }
+        }
+
+        for( int i = 0; i < 500; i++ )
+            segs.emplace_back( points[i], points[i] + VECTOR2I( coord( rng ), coord( rng ) ) / 20 );
+    }
+
+    bool refContains( const VECTOR2I& aP, int aPolygon, int aAccuracy ) const
+    {
+        if( !polySet.CPolygon( aPolygon )[0].PointInside( aP, aAccuracy ) )
+            return false;
+
+        for( int hole = 0; hole < polySet.HoleCount( aPolygon ); hole++ )
+        {
+            if( polySet.CHole( aPolygon, hole ).PointInside( aP, 1 ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool refContains( const VECTOR2I& aP, int aAccuracy ) const
+    {
+        for( int poly = 0; poly < polySet.OutlineCount(); poly++ )
+        {
+            if( refContains( aP, poly, aAccuracy ) )
+                return true;
+        }
+
+        return false;
+    }
+
+    SEG::ecoord refSquaredEdgeDistance( const SEG& aSeg, int aPolygon ) const
+    {
+        SEG::ecoord best = VECTOR2I::ECOORD_MAX;
+
+        for( const SHAPE_LINE_CHAIN& chain : polySet.CPolygon( aPolygon ) )
+        {
+            for( int i = 0; i < chain.SegmentCount(); i++ )
+                best = std::min( best, chain.CSegment( i ).SquaredDistance( aSeg ) );
+        }
+
+        return best;
+    }
+
+    int refEdgeDistance( const SEG& aSeg, int aPolygon ) const
+    {
+        return (int) sqrt( (double) refSquaredEdgeDistance( aSeg, aPolygon ) );
+    }
+
+    int refDistance( const SEG& aSeg ) const
+    {
+        int best = std::numeric_limits<int>::max();
+
+        for( int poly = 0; poly < polySet.OutlineCount(); poly++ )
+        {
+            if( refContains( aSeg.A, poly, 1 ) )
+                return 0;
+
+            best = std::min( best, refEdgeDistance( aSeg, poly ) );
+        }
+
+        return best;
+    }
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( SPSEdgeIndex, EdgeIndexFixture )
+
+
+BOOST_AUTO_TEST_CASE( Contains )
+{
+    for( int accuracy : { 0, 1, 3 } )
+    {
+        for( const VECTOR2I& p : points )
+        {
+            BOOST_TEST_CONTEXT( "Point " << p << ", accuracy " << accuracy )
+            {
+                BOOST_CHECK_EQUAL( polySet.Contains( p, -1, accuracy ),
+                                   refContains( p, accuracy ) );
+
+                BOOST_CHECK_EQUAL( polySet.Contains( p, 7, accuracy ),
+                                   refContains( p, 7, accuracy ) );
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( Collide )
+{
+    for( int clearance : { 0, 10, 150 } )
+    {
+        for( const VECTOR2I& p : points )
+        {
+            BOOST_TEST_CONTEXT( "Point " << p << ", clearance " << clearance )
+            {
+                bool expected = refContains( p, 0 );
+
+                for( int poly = 0; poly < polySet.OutlineCount() && clearance > 0; poly++ )
+                {
+                    if( refSquaredEdgeDistance( SEG( p, p ), poly )
+                            <= (SEG::ecoord) clearance * clearance )
+                        expected = true;
+                }
+
+                BOOST_CHECK_EQUAL( polySet.Collide( p, clearance ), expected );
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( Distance )
+{
+    for( const VECTOR2I& p : points )
+    {
+        BOOST_TEST_CONTEXT( "Point " << p )
+        {
+            BOOST_CHECK_EQUAL( polySet.Distance( p ), refDistance( SEG( p, p ) ) );
+
+            const int expected = refContains( p, 7, 1 ) ? 0 : refEdgeDistance( SEG( p, p ), 7 );
+
+            BOOST_CHECK_EQUAL( polySet.DistanceToPolygon( p, 7 ), expected );
+        }
+    }
+
+    for( const SEG& seg : segs )
+    {
+        BOOST_TEST_CONTEXT( "Segment " << seg )
+        {
+            BOOST_CHECK_EQUAL( polySet.Distance( seg ), refDistance( seg ) );
+        }
+    }
+}
+
+
+/**
+ * Editing the set through a reference returned by Outline() drops the index
+ */
+BOOST_AUTO_TEST_CASE( Invalidation )
+{
+    const VECTOR2I p( 5000, 5000 );
+
+    BOOST_CHECK( !polySet.Contains( p ) );
+
+    SHAPE_POLY_SET copy( polySet );
+
+    polySet.Outline( 0 ).Clear();
+    polySet.Outline( 0 ).Append( 4000, 4000 );
+    polySet.Outline( 0 ).Append( 6000, 4000 );
+    polySet.Outline( 0 ).Append( 6000, 6000 );
+    polySet.Outline( 0 ).Append( 4000, 6000 );
+    polySet.Outline( 0 ).SetClosed( true );
+
+    BOOST_CHECK( polySet.Contains( p ) );
+
+    // The copy keeps the index of the original contours
+    BOOST_CHECK( !copy.Contains( p ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cmath>
+#include <random>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+
+/**
+ * Area covered by aSet: the area of its outlines minus the area of their holes
+ */
+static double area( const SHAPE_POLY_SET& aSet )
+{
+    double total = 0.0;
+
+    for( int ii = 0; ii < aSet.OutlineCount(); ii++ )
+    {
+        total += std::abs( aSet.COutline( ii ).Area() );
+
+        for( int jj = 0; jj < aSet.HoleCount( ii ); jj++ )
+            total -= std::abs( aSet.CHole( ii, jj ).Area() );
+    }
+
+    return total;
+}
+
+
+/**
+ * Clipper rounds the intersections of the offset edges to its scanbeams, which depend on all
+ * the polygons of the same operation, so the areas only match up to that rounding.  Missing
+ * polygons are caught by comparing the outline counts.
+ */
+static const double AREA_TOLERANCE_PERCENT = 0.05;
+
+
+/**
+ * Thousands of polygons with holes, sometimes overlapping their neighbours: enough vertices for
+ * the polygons to be offset on worker threads
+ */
+struct InflateFixture
+{
+    SHAPE_POLY_SET polySet;
+
+    InflateFixture()
+    {
+        std::mt19937                       rng( 42 );
+        std::uniform_int_distribution<int> jitter( -400, 400 );
+
+        for( int row = 0; row < 40; row++ )
+        {
+            for( int col = 0; col < 40; col++ )
+            {
+                const VECTOR2I   centre( col * 2000 + jitter( rng ), row * 2000 + jitter( rng ) );
+                SHAPE_LINE_CHAIN outline, hole;
+
+                for( int i = 0; i < 16; i++ )
+                {
+                    const double a = 2 * M_PI * i / 16;
+
+                    outline.Append( centre.x + int( 700 * cos( a ) ),
+                                    centre.y + int( 700 * sin( a ) ) );
+                    hole.Append( centre.x + int( 200 * cos( -a ) ),
+                                 centre.y + int( 200 * sin( -a ) ) );
+                }
+
+                outline.SetClosed( true );
+                hole.SetClosed( true );
+
+                polySet.AddOutline( outline );
+                polySet.AddHole( hole );
+            }
+        }
+    }
+
+    /**
+     * Offsets each polygon on its own, and merges the results
+     */
+    SHAPE_POLY_SET inflateEach( int aAmount ) const
+    {
+        SHAPE_POLY_SET result;
+
+        for( int ii = 0; ii < polySet.OutlineCount(); ii++ )
+        {
+            SHAPE_POLY_SET single;
+
+            single.AddOutline( polySet.COutline( ii ) );
+            single.AddHole( polySet.CHole( ii, 0 ) );
+            single.Inflate( aAmount, 16 );
+
+            result.Append( single );
+        }
+
+        result.Simplify( SHAPE_POLY_SET::PM_FAST );
+
+        return result;
+    }
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( SPSInflate, InflateFixture )
+
+
+/**
+ * Inflating is the same as inflating each polygon, even for the polygons that merge
+ */
+BOOST_AUTO_TEST_CASE( Inflate )
+{
+    for( int amount : { 100, 500 } )
+    {
+        BOOST_TEST_CONTEXT( "Amount " << amount )
+        {
+            SHAPE_POLY_SET expected = inflateEach( amount );
+            SHAPE_POLY_SET result = polySet;
+
+            result.Inflate( amount, 16 );
+            result.Simplify( SHAPE_POLY_SET::PM_FAST );
+
+            BOOST_CHECK_EQUAL( result.OutlineCount(), expected.OutlineCount() );
+            BOOST_CHECK_CLOSE( area( result ), area( expected ), AREA_TOLERANCE_PERCENT );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( Deflate )
+{
+    // Deflating does not merge polygons, but the overlapping ones must be deflated together
+    SHAPE_POLY_SET merged = polySet;
+    merged.Simplify( SHAPE_POLY_SET::PM_FAST );
+
+    SHAPE_POLY_SET expected;
+
+    for( int ii = 0; ii < merged.OutlineCount(); ii++ )
+    {
+        SHAPE_POLY_SET single;
+
+        single.AddOutline( merged.COutline( ii ) );
+
+        for( int jj = 0; jj < merged.HoleCount( ii ); jj++ )
+            single.AddHole( merged.CHole( ii, jj ) );
+
+        single.Deflate( 100, 16 );
+        expected.Append( single );
+    }
+
+    merged.Deflate( 100, 16 );
+
+    BOOST_CHECK_EQUAL( merged.OutlineCount(), expected.OutlineCount() );
+    BOOST_CHECK_CLOSE( area( merged ), area( expected ), AREA_TOLERANCE_PERCENT );
+}
+
+
+BOOST_AUTO_TEST_CASE( LinkedHoles )
+{
+    SHAPE_POLY_SET result = polySet;
+
+    result.InflateWithLinkedHoles( 100, 16, SHAPE_POLY_SET::PM_FAST );
+
+    BOOST_CHECK( !result.HasHoles() );
+
+    SHAPE_POLY_SET expected = inflateEach( 100 );
+
+    result.Unfracture( SHAPE_POLY_SET::PM_FAST );
+
+    BOOST_CHECK_EQUAL( result.OutlineCount(), expected.OutlineCount() );
+    BOOST_CHECK_CLOSE( area( result ), area( expected ), AREA_TOLERANCE_PERCENT );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,201 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cmath>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+#include "fixtures_geometry.h"
+
+
+/**
+ * Sum of the areas of the triangles of the cached triangulation of aSet
+ */
+static double triangulatedArea( const SHAPE_POLY_SET& aSet )
+{
+    double area = 0.0;
+
+    for( unsigned int i = 0; i < aSet.TriangulatedPolyCount(); i++ )
+    {
+        const SHAPE_POLY_SET::TRIANGULATED_POLYGON* poly = aSet.TriangulatedPolygon( i );
+
+        for( size_t t = 0; t < poly->GetTriangleCount(); t++ )
+        {
+            VECTOR2I a, b, c;
+            poly->GetTriangle( t, a, b, c );
+
+            area += std::abs( (double) ( b - a ).Cross( c - a ) ) / 2.0;
+        }
+    }
+
+    return area;
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( SPSTriangulation, KI_TEST::CommonTestData )
+
+
+/**
+ * The triangulation stays up to date until the set is edited, and follows copies
+ */
+BOOST_AUTO_TEST_CASE( ChangeTracking )
+{
+    BOOST_CHECK( !holeyPolySet.IsTriangulationUpToDate() );
+
+    holeyPolySet.CacheTriangulation();
+
+    BOOST_CHECK( holeyPolySet.IsTriangulationUpToDate() );
+
+    // The square, minus the pentagon and triangle holes
+    BOOST_CHECK_CLOSE( triangulatedArea( holeyPolySet ), 10000.0 - 75.0 - 100.0, 0.001 );
+
+    SHAPE_POLY_SET copy( holeyPolySet );
+
+    BOOST_CHECK( copy.IsTriangulationUpToDate() );
+    BOOST_CHECK( copy.GetHash() == holeyPolySet.GetHash() );
+
+    MD5_HASH hash = holeyPolySet.GetHash();
+
+    holeyPolySet.Move( VECTOR2I( 10, 0 ) );
+
+    BOOST_CHECK( !holeyPolySet.IsTriangulationUpToDate() );
+    BOOST_CHECK( holeyPolySet.GetHash() != hash );
+    BOOST_CHECK( copy.IsTriangulationUpToDate() );
+
+    // Edits through a non-const accessor are tracked too
+    copy.Outline( 0 ).Append( 50, 150 );
+
+    BOOST_CHECK( !copy.IsTriangulationUpToDate() );
+
+    holeyPolySet.CacheTriangulation();
+
+    BOOST_CHECK( holeyPolySet.IsTriangulationUpToDate() );
+}
+
+
+/**
+ * Read only paths, which may run on several threads at once, must not mark the set as edited
+ */
+BOOST_AUTO_TEST_CASE( ReadsDoNotModify )
+{
+    holeyPolySet.CacheTriangulation();
+
+    BOOST_CHECK( holeyPolySet.IsTriangulationUpToDate() );
+
+    holeyPolySet.Chamfer( 5 );
+    holeyPolySet.Fillet( 5, 1 );
+    holeyPolySet.Subset( 0, 1 );
+    holeyPolySet.IsVertexInHole( 5 );
+
+    int                          vertexCount = 0;
+    int                          globalIdx = -1;
+    SHAPE_POLY_SET::VERTEX_INDEX index;
+
+    for( auto it = holeyPolySet.CIterateWithHoles(); it; it++ )
+        vertexCount++;
+
+    for( auto it = holeyPolySet.CIterateSegmentsWithHoles(); it; it++ )
+        vertexCount--;
+
+    BOOST_CHECK_EQUAL( vertexCount, 0 );
+    BOOST_CHECK( holeyPolySet.GetRelativeIndices( 5, &index ) );
+    BOOST_CHECK( holeyPolySet.GetGlobalIndex( index, globalIdx ) );
+    BOOST_CHECK_EQUAL( globalIdx, 5 );
+
+    // Nothing to remove: nothing edited
+    BOOST_CHECK_EQUAL( holeyPolySet.RemoveNullSegments(), 0 );
+
+    BOOST_CHECK( holeyPolySet.IsTriangulationUpToDate() );
+}
+
+
+/**
+ * Chamfering drops the null segments of its result, not of the set
+ */
+BOOST_AUTO_TEST_CASE( ChamferKeepsNullSegments )
+{
+    SHAPE_LINE_CHAIN outline;
+
+    outline.Append( 0, 0 );
+    outline.Append( 100, 0 );
+    outline.Append( 100, 0, true );
+    outline.Append( 100, 100 );
+    outline.Append( 0, 100 );
+    outline.SetClosed( true );
+
+    SHAPE_POLY_SET set;
+
+    set.AddOutline( outline );
+    set.CacheTriangulation();
+
+    SHAPE_POLY_SET chamfered = set.Chamfer( 10 );
+
+    // Two points per corner of the square
+    BOOST_CHECK_EQUAL( chamfered.TotalVertices(), 8 );
+    BOOST_CHECK_EQUAL( set.TotalVertices(), 5 );
+    BOOST_CHECK( set.IsTriangulationUpToDate() );
+
+    BOOST_CHECK_EQUAL( set.RemoveNullSegments(), 1 );
+    BOOST_CHECK_EQUAL( set.TotalVertices(), 4 );
+    BOOST_CHECK( !set.IsTriangulationUpToDate() );
+}
+
+
+/**
+ * Many outlines are triangulated in parallel: each one must be triangulated
+ */
+BOOST_AUTO_TEST_CASE( ManyOutlines )
+{
+    SHAPE_POLY_SET set;
+    double         expectedArea = 0.0;
+
+    for( int i = 0; i < 200; i++ )
+    {
+        SHAPE_LINE_CHAIN outline;
+        const int        radius = 1000 + i;
+        const int        count = 100;
+
+        for( int j = 0; j < count; j++ )
+        {
+            const double a = 2 * M_PI * j / count;
+
+            outline.Append( i * 3000 + int( radius * cos( a ) ), int( radius * sin( a ) ) );
+        }
+
+        outline.SetClosed( true );
+        expectedArea += std::abs( outline.Area() );
+        set.AddOutline( outline );
+    }
+
+    set.CacheTriangulation();
+
+    BOOST_CHECK( set.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( set.TriangulatedPolyCount(), 200 );
+    BOOST_CHECK_CLOSE( triangulatedArea( set ), expectedArea, 0.001 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
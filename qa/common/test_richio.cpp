@@ -0,0 +1,231 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cstring>
+#include <string>
+
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include <dsnlexer.h>
+#include <richio.h>
+
+
+/**
+ * A temporary file, whose text is written by the test cases
+ */
+struct RICHIO_FIXTURE
+{
+    RICHIO_FIXTURE() : m_path( wxFileName::CreateTempFileName( "richio" ) )
+    {
+    }
+
+    ~RICHIO_FIXTURE()
+    {
+        wxRemoveFile( m_path );
+    }
+
+    void Write( const std::string& aText )
+    {
+        wxFFile file( m_path, "wb" );
+
+        BOOST_REQUIRE( file.IsOpened() );
+        BOOST_REQUIRE( file.Write( aText.data(), aText.size() ) == aText.size() );
+    }
+
+    /**
+     * Reads the next line with ReadLineView()
+     */
+    static std::string View( LINE_READER& aReader )
+    {
+        unsigned    length = 0;
+        const char* line = aReader.ReadLineView( length );
+
+        BOOST_REQUIRE( line );
+        BOOST_CHECK_EQUAL( length, aReader.Length() );
+
+        return std::string( line, length );
+    }
+
+    wxString m_path;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( RichIo, RICHIO_FIXTURE )
+
+
+/**
+ * The views and the copies are the lines of the file, with their line endings, the last
+ * one having none
+ */
+BOOST_AUTO_TEST_CASE( MmapLines )
+{
+    Write( "first\n\r\nthird\r\nlast" );
+
+    MMAP_LINE_READER reader( m_path );
+
+    BOOST_CHECK_EQUAL( reader.Size(), 19u );
+
+    BOOST_CHECK_EQUAL( View( reader ), "first\n" );
+    BOOST_CHECK_EQUAL( reader.LineNumber(), 1u );
+    BOOST_CHECK_EQUAL( View( reader ), "\r\n" );
+    BOOST_CHECK_EQUAL( View( reader ), "third\r\n" );
+    BOOST_CHECK_EQUAL( View( reader ), "last" );
+    BOOST_CHECK_EQUAL( reader.LineNumber(), 4u );
+    BOOST_CHECK_EQUAL( View( reader ), "" );
+    BOOST_CHECK_EQUAL( View( reader ), "" );
+
+    reader.Rewind();
+    BOOST_CHECK_EQUAL( reader.LineNumber(), 0u );
+
+    for( const char* expected : { "first\n", "\r\n", "third\r\n", "last" } )
+    {
+        BOOST_TEST_CONTEXT( expected )
+        {
+            const char* line = reader.ReadLine();
+
+            BOOST_REQUIRE( line );
+            BOOST_CHECK_EQUAL( line, expected );
+            BOOST_CHECK_EQUAL( reader.Length(), strlen( expected ) );
+        }
+    }
+
+    BOOST_CHECK( !reader.ReadLine() );
+}
+
+
+/**
+ * An empty file has no line, and no data to map
+ */
+BOOST_AUTO_TEST_CASE( MmapEmpty )
+{
+    Write( "" );
+
+    MMAP_LINE_READER reader( m_path );
+
+    BOOST_CHECK( !reader.Data() );
+    BOOST_CHECK_EQUAL( reader.Size(), 0u );
+    BOOST_CHECK_EQUAL( View( reader ), "" );
+    BOOST_CHECK( !reader.ReadLine() );
+}
+
+
+/**
+ * A line too long throws from ReadLine() and ReadLineView(), as with a FILE_LINE_READER
+ */
+BOOST_AUTO_TEST_CASE( MmapMaxLineLength )
+{
+    Write( "short\n0123456789\n" );
+
+    for( bool view : { false, true } )
+    {
+        BOOST_TEST_CONTEXT( ( view ? "ReadLineView" : "ReadLine" ) )
+        {
+            MMAP_LINE_READER mmapReader( m_path, 0, 8 );
+            FILE_LINE_READER fileReader( m_path, 0, 8 );
+            LINE_READER*     readers[] = { &mmapReader, &fileReader };
+
+            for( LINE_READER* reader : readers )
+            {
+                unsigned length = 0;
+
+                if( view )
+                {
+                    BOOST_CHECK_EQUAL( View( *reader ), "short\n" );
+                    BOOST_CHECK_THROW( reader->ReadLineView( length ), IO_ERROR );
+                }
+                else
+                {
+                    BOOST_CHECK_EQUAL( reader->ReadLine(), "short\n" );
+                    BOOST_CHECK_THROW( reader->ReadLine(), IO_ERROR );
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * The lexer reads the views of a mapped file, which are not nul terminated, up to their end
+ */
+BOOST_AUTO_TEST_CASE( LexerMmapViews )
+{
+    BOOST_TEST_CONTEXT( "Last line without newline" )
+    {
+        Write( "(layer F.Cu)\n(at 1.5 -2) \"a \\\"b\\\\\" end" );
+
+        MMAP_LINE_READER reader( m_path );
+        DSNLEXER         lexer( nullptr, 0, &reader );
+
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_LEFT );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_SYMBOL );
+        BOOST_CHECK_EQUAL( lexer.CurText(), "layer" );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_SYMBOL );
+        BOOST_CHECK_EQUAL( lexer.CurText(), "F.Cu" );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_RIGHT );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_LEFT );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_SYMBOL );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_NUMBER );
+        BOOST_CHECK_EQUAL( lexer.CurText(), "1.5" );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_NUMBER );
+        BOOST_CHECK_EQUAL( lexer.CurText(), "-2" );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_RIGHT );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_STRING );
+        BOOST_CHECK_EQUAL( lexer.CurText(), "a \"b\\" );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_SYMBOL );
+        BOOST_CHECK_EQUAL( lexer.CurText(), "end" );
+        BOOST_CHECK_EQUAL( lexer.CurLineNumber(), 2 );
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_EOF );
+    }
+
+    // Escapes cut by the end of the file: a backslash, a hex and an octal escape
+    for( const char* text : { "(\"abc\\", "(\"abc\\x4", "(\"abc\\10" } )
+    {
+        BOOST_TEST_CONTEXT( "Escape at end of buffer: " << text )
+        {
+            Write( text );
+
+            MMAP_LINE_READER reader( m_path );
+            DSNLEXER         lexer( nullptr, 0, &reader );
+
+            BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_LEFT );
+            BOOST_CHECK_THROW( lexer.NextTok(), PARSE_ERROR );
+        }
+    }
+
+    BOOST_TEST_CONTEXT( "Empty file" )
+    {
+        Write( "" );
+
+        MMAP_LINE_READER reader( m_path );
+        DSNLEXER         lexer( nullptr, 0, &reader );
+
+        BOOST_CHECK_EQUAL( lexer.NextTok(), DSN_EOF );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
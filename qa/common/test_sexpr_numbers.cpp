@@ -0,0 +1,158 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include <dsnlexer.h>
+#include <richio.h>
+
+
+/**
+ * Parses a whole string with DSNLEXER::ParseDouble()
+ * @return the number of characters of the number
+ */
+static size_t parse( const std::string& aText, double& aValue )
+{
+    return DSNLEXER::ParseDouble( aText.data(), aText.data() + aText.size(), aValue )
+           - aText.data();
+}
+
+
+BOOST_AUTO_TEST_SUITE( SexprNumbers )
+
+
+BOOST_AUTO_TEST_CASE( ParseDouble )
+{
+    double value = 0.0;
+
+    BOOST_CHECK_EQUAL( parse( "12.7", value ), 4 );
+    BOOST_CHECK_EQUAL( value, 12.7 );
+
+    BOOST_CHECK_EQUAL( parse( "-0.254)", value ), 6 );
+    BOOST_CHECK_EQUAL( value, -0.254 );
+
+    BOOST_CHECK_EQUAL( parse( "+.5", value ), 3 );
+    BOOST_CHECK_EQUAL( value, 0.5 );
+
+    BOOST_CHECK_EQUAL( parse( "1.5e-3", value ), 6 );
+    BOOST_CHECK_EQUAL( value, 1.5e-3 );
+
+    // An exponent without digits is not part of the number
+    BOOST_CHECK_EQUAL( parse( "2e", value ), 1 );
+    BOOST_CHECK_EQUAL( value, 2.0 );
+
+    value = 42.0;
+
+    for( const char* text : { "", "-", ".", "abc", "e5" } )
+    {
+        BOOST_CHECK_EQUAL( parse( text, value ), 0 );
+        BOOST_CHECK_EQUAL( value, 42.0 );
+    }
+
+    errno = 0;
+    parse( "1e400", value );
+    BOOST_CHECK_EQUAL( errno, ERANGE );
+
+    errno = 0;
+    parse( "-1e400", value );
+    BOOST_CHECK_EQUAL( errno, ERANGE );
+    BOOST_CHECK( value < 0.0 );
+}
+
+
+/**
+ * ParseDouble() is rounded like strtod() in the "C" locale, for the numbers on the fast path
+ * as well as for the others
+ */
+BOOST_AUTO_TEST_CASE( ParseDoubleMatchesStrtod )
+{
+    std::mt19937_64 rng( 42 );
+    char            buf[64];
+
+    for( int ii = 0; ii < 100000; ii++ )
+    {
+        uint64_t bits = rng();
+        double   random;
+
+        memcpy( &random, &bits, sizeof( random ) );
+
+        if( !std::isfinite( random ) )
+            continue;
+
+        if( ii % 2 )
+            snprintf( buf, sizeof( buf ), "%.17g", random );
+        else
+            snprintf( buf, sizeof( buf ), "%.10g", (int) bits / 1e6 );
+
+        double value;
+        parse( buf, value );
+
+        BOOST_TEST_CONTEXT( buf )
+        {
+            BOOST_CHECK_EQUAL( value, strtod( buf, nullptr ) );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( FormatDouble )
+{
+    BOOST_CHECK_EQUAL( OUTPUTFORMATTER::FormatDouble( 1.5 ), "1.5" );
+    BOOST_CHECK_EQUAL( OUTPUTFORMATTER::FormatDouble( 0.1, 6, true ), "0.100000" );
+    BOOST_CHECK_EQUAL( OUTPUTFORMATTER::FormatDouble( -2147.483648, 10 ), "-2147.483648" );
+    BOOST_CHECK_EQUAL( OUTPUTFORMATTER::FormatDouble( 1e-7, 10, true ), "0.0000001000" );
+    BOOST_CHECK_EQUAL( OUTPUTFORMATTER::FormatDouble( 1e20, 6 ), "1e+20" );
+    BOOST_CHECK_EQUAL( OUTPUTFORMATTER::FormatDouble( 3.0, 10 ), "3" );
+}
+
+
+BOOST_AUTO_TEST_CASE( RoundTrip )
+{
+    std::mt19937_64 rng( 7 );
+
+    for( int ii = 0; ii < 10000; ii++ )
+    {
+        uint64_t bits = rng();
+        double   random;
+
+        memcpy( &random, &bits, sizeof( random ) );
+
+        if( !std::isfinite( random ) )
+            continue;
+
+        std::string text = OUTPUTFORMATTER::FormatDouble( random, 17 );
+        double      value;
+
+        BOOST_CHECK_EQUAL( parse( text, value ), text.size() );
+        BOOST_CHECK_EQUAL( value, random );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -23,6 +23,11 @@
 
 #include "board_test_utils.h"
 
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <netinfo.h>
 #include <pcbnew_utils/board_file_utils.h>
 
 // For the temp directory logic: can be std::filesystem in C++17
@@ -50,4 +55,81 @@ void BOARD_DUMPER::DumpBoardToFile( BOARD& aBoard, const std::string& aName ) co
     ::KI_TEST::DumpBoardToFile( aBoard, path.string() );
 }
 
+
+BOARD_FIXTURE::BOARD_FIXTURE()
+{
+    NETINFO_ITEM* gnd = new NETINFO_ITEM( &m_board, "GND" );
+    NETINFO_ITEM* sig = new NETINFO_ITEM( &m_board, "SIG" );
+
+    m_board.Add( gnd );
+    m_board.Add( sig );
+    m_gnd = gnd->GetNet();
+    m_sig = sig->GetNet();
+}
+
+
+wxPoint BOARD_FIXTURE::mm( double aX, double aY )
+{
+    return wxPoint( Millimeter2iu( aX ), Millimeter2iu( aY ) );
+}
+
+
+D_PAD* BOARD_FIXTURE::AddPad( const wxPoint& aPos, int aNet, bool aSmd )
+{
+    MODULE* module = new MODULE( &m_board );
+    D_PAD*  pad = new D_PAD( module );
+
+    pad->SetShape( PAD_SHAPE_CIRCLE );
+    pad->SetSize( wxSize( Millimeter2iu( 1 ), Millimeter2iu( 1 ) ) );
+
+    if( aSmd )
+    {
+        pad->SetAttribute( PAD_ATTRIB_SMD );
+        pad->SetLayerSet( D_PAD::SMDMask() );
+    }
+
+    module->Add( pad );
+    module->SetPosition( aPos );
+    m_board.Add( module );
+    pad->SetNetCode( aNet );
+
+    return pad;
+}
+
+
+TRACK* BOARD_FIXTURE::AddTrack( const wxPoint& aStart, const wxPoint& aEnd, int aNet,
+                                PCB_LAYER_ID aLayer )
+{
+    TRACK* track = new TRACK( &m_board );
+
+    track->SetStart( aStart );
+    track->SetEnd( aEnd );
+    track->SetWidth( Millimeter2iu( 0.25 ) );
+    track->SetLayer( aLayer );
+
+    // Before the track is added, so that the connectivity sees it on its net
+    track->SetNetCode( aNet );
+    m_board.Add( track );
+
+    return track;
+}
+
+
+ZONE_CONTAINER* BOARD_FIXTURE::AddZone( const std::vector<wxPoint>& aCorners, int aNet,
+                                        PCB_LAYER_ID aLayer )
+{
+    ZONE_CONTAINER* zone = new ZONE_CONTAINER( &m_board );
+
+    zone->SetLayer( aLayer );
+    zone->Outline()->NewOutline();
+
+    for( const wxPoint& corner : aCorners )
+        zone->Outline()->Append( corner.x, corner.y );
+
+    m_board.Add( zone );
+    zone->SetNetCode( aNet );
+
+    return zone;
+}
+
 } // namespace KI_TEST
\ No newline at end of file
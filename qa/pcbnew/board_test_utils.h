@@ -30,9 +30,13 @@
 #define QA_PCBNEW_BOARD_TEST_UTILS__H
 
 #include <string>
+#include <vector>
 
-class BOARD;
-class BOARD_ITEM;
+#include <class_board.h>
+
+class D_PAD;
+class TRACK;
+class ZONE_CONTAINER;
 
 
 namespace KI_TEST
@@ -58,6 +62,43 @@ public:
     const bool m_dump_boards;
 };
 
+
+/**
+ * A fixture holding an empty board with the nets GND and SIG, and helpers to add the
+ * simple items that connectivity, DRC and zone fill tests work on.
+ */
+struct BOARD_FIXTURE
+{
+    BOARD_FIXTURE();
+
+    /**
+     * @return the point at aX, aY in mm
+     */
+    static wxPoint mm( double aX, double aY );
+
+    /**
+     * Adds a round 1 mm pad, SMD on the front layer or through hole, in a footprint of its
+     * own at aPos
+     */
+    D_PAD* AddPad( const wxPoint& aPos, int aNet, bool aSmd = true );
+
+    /**
+     * Adds a 0.25 mm wide track
+     */
+    TRACK* AddTrack( const wxPoint& aStart, const wxPoint& aEnd, int aNet,
+                     PCB_LAYER_ID aLayer = F_Cu );
+
+    /**
+     * Adds a zone outlined by aCorners, not filled
+     */
+    ZONE_CONTAINER* AddZone( const std::vector<wxPoint>& aCorners, int aNet,
+                             PCB_LAYER_ID aLayer = F_Cu );
+
+    BOARD m_board;
+    int   m_gnd;
+    int   m_sig;
+};
+
 } // namespace KI_TEST
 
 #endif // QA_PCBNEW_BOARD_TEST_UTILS__H
\ No newline at end of file
@@ -0,0 +1,244 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <chrono>
+#include <random>
+
+#include <class_board.h>
+#include <class_track.h>
+#include <drc.h>
+#include <profile.h>
+#include <trigo.h>
+
+#include <drc/drilled_hole_clearance.h>
+
+#include "../board_test_utils.h"
+#include "drc_test_utils.h"
+
+
+/**
+ * Parameters of a generated via field: a grid of through vias, each moved by a
+ * random (but repeatable) offset.
+ */
+struct VIA_FIELD
+{
+    int m_cols;
+    int m_rows;
+    int m_pitch;
+    int m_jitter;
+    int m_drill;
+};
+
+
+/**
+ * Fixture for drilled hole tests.  Boards are built from generated via fields, so the
+ * same fixture serves as a benchmark of the hole to hole test on large boards.
+ */
+struct DRILLED_HOLES_TEST_FIXTURE
+{
+    const KI_TEST::BOARD_DUMPER m_dumper;
+
+    std::unique_ptr<BOARD> MakeViaField( const VIA_FIELD& aField, int aHoleToHoleMin ) const
+    {
+        auto board = std::make_unique<BOARD>();
+
+        BOARD_DESIGN_SETTINGS des_settings;
+        des_settings.m_HoleToHoleMin = aHoleToHoleMin;
+        board->SetDesignSettings( des_settings );
+
+        std::mt19937                       rng( 42 );
+        std::uniform_int_distribution<int> offset( -aField.m_jitter, aField.m_jitter );
+
+        for( int row = 0; row < aField.m_rows; ++row )
+        {
+            for( int col = 0; col < aField.m_cols; ++col )
+            {
+                VIA* via = new VIA( board.get() );
+
+                via->SetViaType( VIA_THROUGH );
+                via->SetWidth( aField.m_drill * 2 );
+                via->SetDrill( aField.m_drill );
+                via->SetPosition( wxPoint( col * aField.m_pitch + offset( rng ),
+                                           row * aField.m_pitch + offset( rng ) ) );
+
+                board->Add( via, ADD_APPEND );
+            }
+        }
+
+        return board;
+    }
+
+    std::vector<std::unique_ptr<MARKER_PCB>> RunDrc( BOARD& aBoard ) const
+    {
+        DRC_MARKER_FACTORY                       marker_factory;
+        std::vector<std::unique_ptr<MARKER_PCB>> markers;
+
+        DRC_DRILLED_HOLE_CLEARANCE drc_holes( marker_factory, [&]( MARKER_PCB* aMarker ) {
+            markers.push_back( std::unique_ptr<MARKER_PCB>( aMarker ) );
+        } );
+
+        drc_holes.RunDRC( aBoard );
+
+        return markers;
+    }
+};
+
+
+/**
+ * The plain pairwise test, for reference: returns the (ref, conflicting) position pairs
+ * in the order they must be reported.
+ */
+static std::vector<std::pair<wxPoint, wxPoint>> ReferenceConflicts( BOARD& aBoard )
+{
+    std::vector<VIA*> vias;
+
+    for( TRACK* track : aBoard.Tracks() )
+        vias.push_back( static_cast<VIA*>( track ) );
+
+    const int holeToHoleMin = aBoard.GetDesignSettings().m_HoleToHoleMin;
+
+    std::vector<std::pair<wxPoint, wxPoint>> conflicts;
+
+    for( size_t ii = 0; ii < vias.size(); ++ii )
+    {
+        for( size_t jj = ii + 1; jj < vias.size(); ++jj )
+        {
+            const wxPoint a = vias[ii]->GetPosition();
+            const wxPoint b = vias[jj]->GetPosition();
+
+            if( a == b )
+                continue;
+
+            if( KiROUND( GetLineLength( a, b ) )
+                    < vias[ii]->GetDrillValue() / 2 + vias[jj]->GetDrillValue() / 2 + holeToHoleMin )
+            {
+                conflicts.emplace_back( a, b );
+            }
+        }
+    }
+
+    return conflicts;
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( DrcDrilledHoles, DRILLED_HOLES_TEST_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( Basic )
+{
+    // Three vias in a row: the first two are too close, the third is far enough
+    VIA_FIELD field{ 3, 1, Millimeter2iu( 0.5 ), 0, Millimeter2iu( 0.3 ) };
+
+    auto board = MakeViaField( field, Millimeter2iu( 0.25 ) );
+    board->Tracks().back()->SetPosition( wxPoint( Millimeter2iu( 10 ), 0 ) );
+
+    const auto markers = RunDrc( *board );
+
+    BOOST_REQUIRE_EQUAL( markers.size(), 1 );
+    BOOST_CHECK_PREDICATE(
+            KI_TEST::IsDrcMarkerOfType, ( *markers[0] )( DRCE_DRILLED_HOLES_TOO_CLOSE ) );
+    BOOST_CHECK( markers[0]->GetReporter().GetPointA() == wxPoint( 0, 0 ) );
+    BOOST_CHECK( markers[0]->GetReporter().GetPointB() == wxPoint( Millimeter2iu( 0.5 ), 0 ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( IgnoredHoles )
+{
+    VIA_FIELD field{ 2, 1, Millimeter2iu( 0.1 ), 0, Millimeter2iu( 0.3 ) };
+
+    // No minimum: test disabled
+    auto board = MakeViaField( field, 0 );
+    BOOST_CHECK_EQUAL( RunDrc( *board ).size(), 0 );
+
+    // Microvias are laser drilled
+    board = MakeViaField( field, Millimeter2iu( 0.25 ) );
+
+    for( TRACK* track : board->Tracks() )
+        static_cast<VIA*>( track )->SetViaType( VIA_MICROVIA );
+
+    BOOST_CHECK_EQUAL( RunDrc( *board ).size(), 0 );
+
+    // Stacked holes are allowed
+    board = MakeViaField( field, Millimeter2iu( 0.25 ) );
+    board->Tracks().back()->SetPosition( board->Tracks().front()->GetPosition() );
+
+    BOOST_CHECK_EQUAL( RunDrc( *board ).size(), 0 );
+}
+
+
+/**
+ * The sweep must report exactly what the pairwise test reports, in the same order.
+ */
+BOOST_AUTO_TEST_CASE( MatchesPairwise )
+{
+    VIA_FIELD field{ 40, 40, Millimeter2iu( 0.8 ), Millimeter2iu( 0.2 ), Millimeter2iu( 0.3 ) };
+
+    auto board = MakeViaField( field, Millimeter2iu( 0.25 ) );
+    m_dumper.DumpBoardToFile( *board, "drilled_holes_jittered" );
+
+    const auto markers = RunDrc( *board );
+    const auto expected = ReferenceConflicts( *board );
+
+    BOOST_REQUIRE_EQUAL( markers.size(), expected.size() );
+    BOOST_CHECK( markers.size() > 0 );
+
+    for( size_t ii = 0; ii < markers.size(); ++ii )
+    {
+        BOOST_TEST_CONTEXT( "Marker " << ii )
+        {
+            BOOST_CHECK( markers[ii]->GetReporter().GetPointA() == expected[ii].first );
+            BOOST_CHECK( markers[ii]->GetReporter().GetPointB() == expected[ii].second );
+        }
+    }
+}
+
+
+/**
+ * Benchmark: a 150 x 150 BGA-like field of vias.  The time is reported in the test log
+ * (run with --log_level=message) so it can be tracked.
+ */
+BOOST_AUTO_TEST_CASE( ViaFieldBenchmark )
+{
+    VIA_FIELD field{ 150, 150, Millimeter2iu( 0.8 ), Millimeter2iu( 0.05 ), Millimeter2iu( 0.3 ) };
+
+    auto board = MakeViaField( field, Millimeter2iu( 0.25 ) );
+
+    std::vector<std::unique_ptr<MARKER_PCB>> markers;
+    std::chrono::microseconds                duration;
+
+    {
+        SCOPED_PROF_COUNTER<std::chrono::microseconds> timer( duration );
+        markers = RunDrc( *board );
+    }
+
+    // Vias are 0.8mm apart +/- 0.1mm: holes need 0.3mm + 0.25mm
+    BOOST_CHECK_EQUAL( markers.size(), 0 );
+
+    BOOST_TEST_MESSAGE( "Drilled holes: " << board->Tracks().size() << " vias in "
+                                          << duration.count() << "us" );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,177 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <tuple>
+
+#include <class_board.h>
+#include <class_marker_pcb.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <drc.h>
+
+#include "../board_test_utils.h"
+
+
+/**
+ * A board with three tracks, A on SIG and B and C on GND, 5 mm apart, and a SIG pad far
+ * from them.  The test cases move them around, and check the markers of the online check
+ * against those of a full DRC run.
+ */
+struct DRC_ONLINE_FIXTURE : public KI_TEST::BOARD_FIXTURE
+{
+    ///> A marker, as its error code and its items in a given order
+    using VIOLATION = std::tuple<int, const void*, const void*>;
+
+    DRC_ONLINE_FIXTURE()
+    {
+        m_trackA = AddTrack( mm( 0, 0 ), mm( 10, 0 ), m_sig );
+        m_trackB = AddTrack( mm( 0, 5 ), mm( 10, 5 ), m_gnd );
+        m_trackC = AddTrack( mm( 0, 10 ), mm( 10, 10 ), m_gnd );
+        m_module = AddPad( mm( 30, 30 ), m_sig )->GetParent();
+
+        m_board.SynchronizeNetsAndNetClasses();
+        m_board.BuildConnectivity();
+    }
+
+    /**
+     * @return the markers of aMarkers involving a track of the board
+     */
+    std::multiset<VIOLATION> trackViolations( const std::vector<MARKER_PCB*>& aMarkers )
+    {
+        std::set<const void*>    tracks( m_board.Tracks().begin(), m_board.Tracks().end() );
+        std::multiset<VIOLATION> violations;
+
+        for( MARKER_PCB* marker : aMarkers )
+        {
+            const DRC_ITEM& item = marker->GetReporter();
+            const void*     main = item.GetMainItemWeakRef();
+            const void*     aux = item.GetAuxItemWeakRef();
+
+            // A pair of tracks is tested from either of them
+            if( aux && std::less<const void*>()( aux, main ) )
+                std::swap( main, aux );
+
+            if( tracks.count( main ) || tracks.count( aux ) )
+                violations.emplace( item.GetErrorCode(), main, aux );
+        }
+
+        return violations;
+    }
+
+    /**
+     * Runs the online check for the given items, then checks that the markers of the
+     * board match those of a full DRC run
+     */
+    void CheckOnline( const std::vector<BOARD_ITEM*>& aChanged,
+                      const std::vector<BOARD_ITEM*>& aRemoved, bool aExpectViolations )
+    {
+        m_board.BuildConnectivity();
+        m_online.RunBatchOnlineCheck( &m_board, aChanged, aRemoved );
+
+        std::vector<MARKER_PCB*> boardMarkers;
+
+        for( int ii = 0; ii < m_board.GetMARKERCount(); ++ii )
+            boardMarkers.push_back( m_board.GetMARKER( ii ) );
+
+        std::vector<std::unique_ptr<MARKER_PCB>> fullMarkers;
+        std::vector<MARKER_PCB*>                 fullMarkerPtrs;
+        DRC                                      full;
+
+        full.SetReportAllTrackErrors( true );
+        full.RunBatchTests( &m_board, [&]( MARKER_PCB* aMarker )
+                {
+                    fullMarkers.emplace_back( aMarker );
+                    fullMarkerPtrs.push_back( aMarker );
+                } );
+
+        std::multiset<VIOLATION> online = trackViolations( boardMarkers );
+        std::multiset<VIOLATION> expected = trackViolations( fullMarkerPtrs );
+
+        BOOST_CHECK_EQUAL( online.empty(), !aExpectViolations );
+        BOOST_CHECK_EQUAL( expected.empty(), !aExpectViolations );
+        BOOST_CHECK( online == expected );
+    }
+
+    DRC     m_online;
+    TRACK*  m_trackA;
+    TRACK*  m_trackB;
+    TRACK*  m_trackC;
+    MODULE* m_module;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( DrcOnline, DRC_ONLINE_FIXTURE )
+
+
+/**
+ * Edited tracks and footprints find the violations of a full run, and lose them once
+ * moved away or removed
+ */
+BOOST_AUTO_TEST_CASE( EditedItems )
+{
+    BOOST_TEST_CONTEXT( "All items" )
+    {
+        CheckOnline( { m_trackA, m_trackB, m_trackC, m_module }, {}, false );
+    }
+
+    BOOST_TEST_CONTEXT( "Track moved next to another one" )
+    {
+        m_trackA->Move( mm( 0, 4.8 ) );
+        CheckOnline( { m_trackA }, {}, true );
+    }
+
+    BOOST_TEST_CONTEXT( "Footprint moved next to a track" )
+    {
+        m_module->SetPosition( mm( 5, 10.5 ) );
+        CheckOnline( { m_module }, {}, true );
+    }
+
+    BOOST_TEST_CONTEXT( "Track moved away" )
+    {
+        m_trackA->Move( mm( 0, -9.8 ) );
+        CheckOnline( { m_trackA }, {}, true );
+    }
+
+    BOOST_TEST_CONTEXT( "Track removed" )
+    {
+        m_board.Remove( m_trackC );
+        CheckOnline( {}, { m_trackC }, false );
+        delete m_trackC;
+    }
+
+    BOOST_TEST_CONTEXT( "Markers deleted without the online check" )
+    {
+        m_board.DeleteMARKERs();
+        m_trackA->Move( mm( 0, 9.8 ) );
+        CheckOnline( { m_trackA }, {}, true );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
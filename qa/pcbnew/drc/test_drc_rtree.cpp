@@ -0,0 +1,134 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <algorithm>
+
+#include <drc/drc_rtree.h>
+
+
+BOOST_AUTO_TEST_SUITE( DrcRtree )
+
+
+/**
+ * Collect the sorted results of a query
+ */
+static std::vector<int> query( DRC_RTREE<int>& aTree, const BOX2I& aBox, LSET aLayers )
+{
+    std::vector<int> found;
+
+    auto visitor = [&]( int aItem ) -> bool
+    {
+        found.push_back( aItem );
+        return true;
+    };
+
+    aTree.Query( aBox, aLayers, visitor );
+    std::sort( found.begin(), found.end() );
+
+    return found;
+}
+
+
+BOOST_AUTO_TEST_CASE( PlanarQuery )
+{
+    DRC_RTREE<int> tree;
+
+    tree.Insert( BOX2I( VECTOR2I( 0, 0 ), VECTOR2I( 10, 10 ) ), LSET( F_Cu ), 0 );
+    tree.Insert( BOX2I( VECTOR2I( 100, 0 ), VECTOR2I( 10, 10 ) ), LSET( F_Cu ), 1 );
+    tree.Insert( BOX2I( VECTOR2I( 5, 5 ), VECTOR2I( 100, 10 ) ), LSET( F_Cu ), 2 );
+
+    BOOST_CHECK_EQUAL( tree.size(), 3 );
+
+    const std::vector<int> exp_left = { 0, 2 };
+    const std::vector<int> found_left = query(
+            tree, BOX2I( VECTOR2I( -5, -5 ), VECTOR2I( 12, 12 ) ), LSET( F_Cu ) );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+            found_left.begin(), found_left.end(), exp_left.begin(), exp_left.end() );
+
+    const std::vector<int> exp_none = {};
+    const std::vector<int> found_none = query(
+            tree, BOX2I( VECTOR2I( 200, 200 ), VECTOR2I( 10, 10 ) ), LSET( F_Cu ) );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+            found_none.begin(), found_none.end(), exp_none.begin(), exp_none.end() );
+}
+
+
+BOOST_AUTO_TEST_CASE( LayerQuery )
+{
+    DRC_RTREE<int> tree;
+    const BOX2I    box( VECTOR2I( 0, 0 ), VECTOR2I( 10, 10 ) );
+
+    tree.Insert( box, LSET( F_Cu ), 0 );
+    tree.Insert( box, LSET( B_Cu ), 1 );
+    tree.Insert( box, LSET( 3, F_Cu, In1_Cu, In2_Cu ), 2 );   // a blind via
+    tree.Insert( box, LSET( F_SilkS ), 3 );                    // no copper: all layers
+
+    const std::vector<int> exp_front = { 0, 2, 3 };
+    const std::vector<int> found_front = query( tree, box, LSET( F_Cu ) );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+            found_front.begin(), found_front.end(), exp_front.begin(), exp_front.end() );
+
+    const std::vector<int> exp_inner = { 2, 3 };
+    const std::vector<int> found_inner = query( tree, box, LSET( In2_Cu ) );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+            found_inner.begin(), found_inner.end(), exp_inner.begin(), exp_inner.end() );
+
+    const std::vector<int> exp_all = { 0, 1, 2, 3 };
+    const std::vector<int> found_all = query( tree, box, LSET::AllCuMask() );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+            found_all.begin(), found_all.end(), exp_all.begin(), exp_all.end() );
+}
+
+
+BOOST_AUTO_TEST_CASE( Remove )
+{
+    DRC_RTREE<int> tree;
+    const BOX2I    box( VECTOR2I( 0, 0 ), VECTOR2I( 10, 10 ) );
+
+    tree.Insert( box, LSET( F_Cu ), 0 );
+    tree.Insert( box, LSET( F_Cu ), 1 );
+
+    // Removing with a stale box falls back to a search of the whole tree
+    tree.Remove( BOX2I( VECTOR2I( 50, 50 ), VECTOR2I( 10, 10 ) ), LSET( F_Cu ), 0 );
+
+    BOOST_CHECK_EQUAL( tree.size(), 1 );
+
+    const std::vector<int> exp = { 1 };
+    const std::vector<int> found = query( tree, box, LSET( F_Cu ) );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS( found.begin(), found.end(), exp.begin(), exp.end() );
+
+    tree.RemoveAll();
+
+    BOOST_CHECK( tree.empty() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
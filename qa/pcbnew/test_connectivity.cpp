@@ -0,0 +1,465 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
+#include <tuple>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <connectivity/connectivity_algo.h>
+#include <connectivity/connectivity_data.h>
+#include <netinfo.h>
+#include <ratsnest_data.h>
+
+#include "board_test_utils.h"
+
+
+/**
+ * A board with the nets GND and SIG, whose items are added by the test cases
+ */
+struct CONNECTIVITY_FIXTURE : public KI_TEST::BOARD_FIXTURE
+{
+    ///> A ratsnest line, as its net and its ends in a given order
+    using LINE = std::tuple<int, int, int, int, int>;
+
+    /**
+     * Adds a zone on the front layer, filled with a 10 mm square at each of the top left
+     * corners aSquares, in that order
+     */
+    ZONE_CONTAINER* AddFilledZone( const std::vector<wxPoint>& aSquares, int aNet )
+    {
+        ZONE_CONTAINER* zone = new ZONE_CONTAINER( &m_board );
+        SHAPE_POLY_SET  fill;
+        int             side = Millimeter2iu( 10 );
+
+        for( const wxPoint& corner : aSquares )
+        {
+            fill.NewOutline();
+            fill.Append( corner.x, corner.y );
+            fill.Append( corner.x + side, corner.y );
+            fill.Append( corner.x + side, corner.y + side );
+            fill.Append( corner.x, corner.y + side );
+        }
+
+        zone->SetLayer( F_Cu );
+        *zone->Outline() = fill;
+        m_board.Add( zone );
+        zone->SetNetCode( aNet );
+        zone->SetFilledPolysList( fill );
+        zone->SetIsFilled( true );
+
+        return zone;
+    }
+
+    static LINE MakeLine( int aNet, const VECTOR2I& aA, const VECTOR2I& aB )
+    {
+        // The ends of a line are drawn in no particular order
+        if( std::tie( aB.x, aB.y ) < std::tie( aA.x, aA.y ) )
+            return LINE( aNet, aB.x, aB.y, aA.x, aA.y );
+
+        return LINE( aNet, aA.x, aA.y, aB.x, aB.y );
+    }
+
+    std::shared_ptr<CONNECTIVITY_DATA> Connectivity()
+    {
+        return m_board.GetConnectivity();
+    }
+
+    /**
+     * @return the net of each pad and track of the board
+     */
+    std::map<const BOARD_CONNECTED_ITEM*, int> ItemNets()
+    {
+        std::map<const BOARD_CONNECTED_ITEM*, int> nets;
+
+        for( TRACK* track : m_board.Tracks() )
+            nets[track] = track->GetNetCode();
+
+        for( MODULE* module : m_board.Modules() )
+        {
+            for( D_PAD* pad : module->Pads() )
+                nets[pad] = pad->GetNetCode();
+        }
+
+        return nets;
+    }
+
+    /**
+     * @return the ratsnest clusters of aConnectivity, as their net and their items
+     */
+    static std::multiset<std::pair<int, std::set<const BOARD_CONNECTED_ITEM*>>> Clusters(
+            CONNECTIVITY_DATA& aConnectivity )
+    {
+        std::multiset<std::pair<int, std::set<const BOARD_CONNECTED_ITEM*>>> clusters;
+
+        for( const auto& cluster : aConnectivity.GetConnectivityAlgo()->GetClusters() )
+        {
+            std::set<const BOARD_CONNECTED_ITEM*> items;
+
+            for( CN_ITEM* item : *cluster )
+                items.insert( item->Parent() );
+
+            clusters.emplace( cluster->OriginNet(), items );
+        }
+
+        return clusters;
+    }
+
+    /**
+     * @return the unconnected edges of the ratsnest of aConnectivity
+     */
+    static std::multiset<LINE> Ratsnest( CONNECTIVITY_DATA& aConnectivity )
+    {
+        std::multiset<LINE> lines;
+
+        for( int net = 1; net < aConnectivity.GetNetCount(); ++net )
+        {
+            RN_NET* rnNet = aConnectivity.GetRatsnestForNet( net );
+
+            if( !rnNet )
+                continue;
+
+            for( const CN_EDGE& edge : rnNet->GetUnconnected() )
+            {
+                lines.insert( MakeLine( net, edge.GetSourceNode()->Pos(),
+                                        edge.GetTargetNode()->Pos() ) );
+            }
+        }
+
+        return lines;
+    }
+
+    /**
+     * Updates the ratsnest of the board after an edit, then checks its nets, clusters and
+     * ratsnest against those of a connectivity built from scratch
+     */
+    void CheckFullRecompute()
+    {
+        auto connectivity = Connectivity();
+
+        connectivity->RecalculateRatsnest();
+
+        // Building again propagates the nets of the whole board, which must change nothing
+        std::map<const BOARD_CONNECTED_ITEM*, int> nets = ItemNets();
+        CONNECTIVITY_DATA                           full;
+
+        full.Build( &m_board );
+
+        BOOST_CHECK( ItemNets() == nets );
+        BOOST_CHECK( Clusters( *connectivity ) == Clusters( full ) );
+        BOOST_CHECK( Ratsnest( *connectivity ) == Ratsnest( full ) );
+        BOOST_CHECK_EQUAL( connectivity->GetUnconnectedCount(), full.GetUnconnectedCount() );
+    }
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( Connectivity, CONNECTIVITY_FIXTURE )
+
+
+/**
+ * Once up to date, the published dynamic ratsnest links each net of the moving pads to its
+ * nearest pad on the rest of the board, and the moving pads between them
+ */
+BOOST_AUTO_TEST_CASE( DynamicRatsnest )
+{
+    std::vector<D_PAD*> fixed = { AddPad( mm( 0, 0 ), m_sig ), AddPad( mm( 40, 0 ), m_sig ),
+                                  AddPad( mm( 0, 20 ), m_gnd ) };
+    std::vector<D_PAD*> moving = { AddPad( mm( 10, 1 ), m_sig ), AddPad( mm( 25, 3 ), m_sig ),
+                                   AddPad( mm( 12, 15 ), m_gnd ) };
+
+    std::vector<BOARD_ITEM*> items( moving.begin(), moving.end() );
+
+    m_board.BuildConnectivity();
+
+    auto connectivity = Connectivity();
+
+    auto waitForLines = [&]() -> std::multiset<LINE>
+    {
+        for( int ii = 0; ii < 2000 && !connectivity->IsDynamicRatsnestUpToDate(); ++ii )
+            std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+
+        BOOST_REQUIRE( connectivity->IsDynamicRatsnestUpToDate() );
+
+        std::multiset<LINE> lines;
+
+        for( const RN_DYNAMIC_LINE& line : *connectivity->GetDynamicRatsnest() )
+            lines.insert( MakeLine( line.netCode, line.a, line.b ) );
+
+        return lines;
+    };
+
+    // The nearest pair of a fixed and a moving pad of each net, and the line between the
+    // two moving SIG pads, whose net is not reported
+    auto expectedLines = [&]() -> std::multiset<LINE>
+    {
+        std::multiset<LINE> lines;
+
+        for( int net : { m_sig, m_gnd } )
+        {
+            VECTOR2I::extended_type bestDist = VECTOR2I::ECOORD_MAX;
+            LINE                    best;
+
+            for( D_PAD* target : fixed )
+            {
+                for( D_PAD* anchor : moving )
+                {
+                    if( target->GetNetCode() != net || anchor->GetNetCode() != net )
+                        continue;
+
+                    VECTOR2I a = target->ShapePos();
+                    VECTOR2I b = anchor->ShapePos();
+
+                    if( ( b - a ).SquaredEuclideanNorm() < bestDist )
+                    {
+                        bestDist = ( b - a ).SquaredEuclideanNorm();
+                        best = MakeLine( net, a, b );
+                    }
+                }
+            }
+
+            lines.insert( best );
+        }
+
+        lines.insert( MakeLine( 0, moving[0]->ShapePos(), moving[1]->ShapePos() ) );
+
+        return lines;
+    };
+
+    BOOST_TEST_CONTEXT( "Initial position" )
+    {
+        connectivity->ComputeDynamicRatsnest( items );
+
+        std::multiset<LINE> lines = waitForLines();
+
+        BOOST_CHECK( lines == expectedLines() );
+        BOOST_CHECK( lines.count( MakeLine( m_sig, mm( 0, 0 ), mm( 10, 1 ) ) ) );
+    }
+
+    // The snapshot of the items is kept, only the positions of the pads are read again
+    BOOST_TEST_CONTEXT( "Moved" )
+    {
+        for( D_PAD* pad : moving )
+            pad->GetParent()->Move( mm( 20, 0 ) );
+
+        connectivity->ComputeDynamicRatsnest( items );
+
+        std::multiset<LINE> lines = waitForLines();
+
+        BOOST_CHECK( lines == expectedLines() );
+        BOOST_CHECK( lines.count( MakeLine( m_sig, mm( 40, 0 ), mm( 45, 3 ) ) ) );
+    }
+
+    BOOST_TEST_CONTEXT( "Hidden" )
+    {
+        connectivity->HideDynamicRatsnest();
+        BOOST_CHECK( waitForLines().empty() );
+    }
+}
+
+
+/**
+ * The clusters and the ratsnest kept across edits, for which only the dirty nets are searched
+ * again, are those of a full recompute
+ */
+BOOST_AUTO_TEST_CASE( IncrementalRatsnest )
+{
+    NETINFO_ITEM* other = new NETINFO_ITEM( &m_board, "OTHER" );
+
+    m_board.Add( other );
+
+    AddPad( mm( 0, 0 ), m_sig );
+    AddPad( mm( 20, 0 ), m_sig );
+    D_PAD* sigEnd = AddPad( mm( 40, 0 ), m_sig );
+    AddPad( mm( 0, 20 ), m_gnd );
+    AddPad( mm( 30, 20 ), m_gnd );
+    AddPad( mm( 0, 40 ), other->GetNet() );
+    AddPad( mm( 10, 40 ), other->GetNet() );
+
+    TRACK* sigTrack = AddTrack( mm( 0, 0 ), mm( 20, 0 ), m_sig );
+    TRACK* otherTrack = AddTrack( mm( 0, 40 ), mm( 10, 40 ), other->GetNet() );
+
+    m_board.BuildConnectivity();
+
+    auto connectivity = Connectivity();
+
+    BOOST_TEST_CONTEXT( "Built" )
+    {
+        CheckFullRecompute();
+    }
+
+    BOOST_TEST_CONTEXT( "Track shortened, splitting its cluster" )
+    {
+        sigTrack->SetEnd( mm( 10, 0 ) );
+        connectivity->Update( sigTrack );
+        CheckFullRecompute();
+    }
+
+    BOOST_TEST_CONTEXT( "Track added, merging two clusters" )
+    {
+        AddTrack( mm( 20, 0 ), sigEnd->GetPosition(), m_sig );
+        CheckFullRecompute();
+    }
+
+    BOOST_TEST_CONTEXT( "Track removed" )
+    {
+        m_board.Remove( otherTrack );
+        delete otherTrack;
+        CheckFullRecompute();
+    }
+
+    // The new track is on a GND pad, so the net propagation moves it from SIG to GND
+    BOOST_TEST_CONTEXT( "Track net propagated" )
+    {
+        TRACK* stale = AddTrack( mm( 0, 20 ), mm( 5, 20 ), m_sig );
+
+        CheckFullRecompute();
+        BOOST_CHECK_EQUAL( stale->GetNetCode(), m_gnd );
+    }
+}
+
+
+/**
+ * The connections searched at once by the CN_STORE of a full build are those found by
+ * searching the items one by one through the R-tree
+ */
+BOOST_AUTO_TEST_CASE( FullBuildConnections )
+{
+    // Two overlapping GND zones, and a SIG zone that a GND track only crosses
+    AddFilledZone( { mm( 0, 0 ) }, m_gnd );
+    AddFilledZone( { mm( 5, 5 ), mm( 40, 0 ) }, m_gnd );
+    AddFilledZone( { mm( 5, 30 ) }, m_sig );
+
+    AddPad( mm( 2, 2 ), m_gnd );
+    AddTrack( mm( 12, 12 ), mm( 12, 45 ), m_gnd );
+    AddPad( mm( 12, 45 ), m_gnd, false );
+    AddTrack( mm( 12, 45 ), mm( 30, 45 ), m_gnd, B_Cu );
+    AddTrack( mm( 20, 20 ), mm( 30, 20 ), m_sig );
+    AddPad( mm( 30, 20 ), m_sig );
+
+    m_board.BuildConnectivity();
+
+    auto algo = Connectivity()->GetConnectivityAlgo();
+
+    auto connections = [&]() -> std::set<std::pair<CN_ITEM*, CN_ITEM*>>
+    {
+        std::set<std::pair<CN_ITEM*, CN_ITEM*>> pairs;
+
+        algo->ForEachItem( [&]( CN_ITEM& aItem )
+                {
+                    for( CN_ITEM* connected : aItem.ConnectedItems() )
+                        pairs.emplace( &aItem, connected );
+                } );
+
+        return pairs;
+    };
+
+    std::set<std::pair<CN_ITEM*, CN_ITEM*>> built = connections();
+
+    // zone-zone, zone-pad, zone-track, track-pad on both layers, track-pad
+    BOOST_CHECK_EQUAL( built.size(), 2 * 6 );
+
+    algo->ForEachItem( []( CN_ITEM& aItem ) { aItem.ClearConnections(); } );
+    algo->ItemList().MarkAllAsDirty();
+    algo->SearchClusters( CN_CONNECTIVITY_ALGO::CSM_CONNECTIVITY_CHECK );
+
+    BOOST_CHECK( connections() == built );
+}
+
+
+/**
+ * The islands found by flooding each net from its pads, in parallel, are the known ones, and
+ * those of the orphaned clusters of a board-wide search
+ */
+BOOST_AUTO_TEST_CASE( IsolatedCopperIslands )
+{
+    // GND: reached by a pad, an island, reached by a track, holding a pad of another net
+    ZONE_CONTAINER* gnd = AddFilledZone( { mm( 0, 0 ), mm( 20, 0 ), mm( 40, 0 ), mm( 60, 0 ) },
+                                         m_gnd );
+    // SIG: reached by a pad, an island
+    ZONE_CONTAINER* sig = AddFilledZone( { mm( 0, 30 ), mm( 20, 30 ) }, m_sig );
+    // Another GND zone: reached by a pad, an island
+    ZONE_CONTAINER* gnd2 = AddFilledZone( { mm( 20, 50 ), mm( 40, 50 ) }, m_gnd );
+
+    AddPad( mm( 5, 5 ), m_gnd );
+    AddTrack( mm( 45, 5 ), mm( 45, 20 ), m_gnd );
+    AddPad( mm( 45, 20 ), m_gnd );
+    AddPad( mm( 65, 5 ), m_sig );
+    AddPad( mm( 5, 35 ), m_sig );
+    AddPad( mm( 25, 55 ), m_gnd );
+
+    m_board.BuildConnectivity();
+
+    std::map<const ZONE_CONTAINER*, std::set<int>> expected = { { gnd, { 1, 3 } },
+                                                                 { sig, { 1 } },
+                                                                 { gnd2, { 1 } } };
+    std::vector<CN_ZONE_ISOLATED_ISLAND_LIST>      zones;
+
+    for( ZONE_CONTAINER* zone : { gnd, sig, gnd2 } )
+        zones.emplace_back( zone );
+
+    auto connectivity = Connectivity();
+
+    connectivity->FindIsolatedCopperIslands( zones );
+
+    auto clusters = connectivity->GetConnectivityAlgo()->SearchClusters(
+            CN_CONNECTIVITY_ALGO::CSM_CONNECTIVITY_CHECK );
+
+    for( size_t ii = 0; ii < zones.size(); ++ii )
+    {
+        const CN_ZONE_ISOLATED_ISLAND_LIST& zone = zones[ii];
+
+        BOOST_TEST_CONTEXT( "Zone " << ii )
+        {
+            std::set<int> islands( zone.m_islands.begin(), zone.m_islands.end() );
+            std::set<int> orphaned;
+
+            for( const auto& cluster : clusters )
+            {
+                if( !cluster->Contains( zone.m_zone ) || !cluster->IsOrphaned() )
+                    continue;
+
+                for( CN_ITEM* item : *cluster )
+                {
+                    if( item->Parent() == zone.m_zone )
+                        orphaned.insert( static_cast<CN_ZONE*>( item )->SubpolyIndex() );
+                }
+            }
+
+            BOOST_CHECK_EQUAL( islands.size(), zone.m_islands.size() );
+            BOOST_CHECK( islands == expected[zone.m_zone] );
+            BOOST_CHECK( islands == orphaned );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
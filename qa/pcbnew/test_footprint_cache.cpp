@@ -0,0 +1,234 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <memory>
+
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include <class_module.h>
+#include <kicad_plugin.h>
+#include <properties.h>
+
+
+/**
+ * A .pretty library with the footprints FP_1 to FP_5, FP_<n> having n pads
+ */
+struct FP_CACHE_FIXTURE
+{
+    FP_CACHE_FIXTURE()
+    {
+        wxString tempFile = wxFileName::CreateTempFileName( "fp-cache" );
+
+        wxRemoveFile( tempFile );
+        m_path = tempFile + ".pretty";
+        wxFileName::Mkdir( m_path );
+
+        for( int ii = 1; ii <= 5; ++ii )
+            Write( Name( ii ), ii );
+
+        m_lazy["lazy_load"] = UTF8();
+    }
+
+    ~FP_CACHE_FIXTURE()
+    {
+        PCB_IO io;
+
+        io.FootprintLibDelete( m_path );
+    }
+
+    static wxString Name( int aIndex )
+    {
+        return wxString::Format( "FP_%d", aIndex );
+    }
+
+    /**
+     * Writes the footprint file aName, with aPadCount pads
+     */
+    void Write( const wxString& aName, int aPadCount )
+    {
+        wxString text = wxString::Format( "(module %s (layer F.Cu) (tedit 5C000000)\n", aName );
+
+        for( int ii = 1; ii <= aPadCount; ++ii )
+        {
+            text += wxString::Format( "  (pad %d smd rect (at %d 0) (size 1 1) (layers F.Cu))\n",
+                                      ii, 2 * ii );
+        }
+
+        text += ")\n";
+
+        WriteText( aName, text );
+    }
+
+    void WriteText( const wxString& aName, const wxString& aText )
+    {
+        wxFFile file( wxFileName( m_path, aName, "kicad_mod" ).GetFullPath(), "w" );
+
+        BOOST_REQUIRE( file.IsOpened() );
+        BOOST_REQUIRE( file.Write( aText ) );
+    }
+
+    static void CheckFootprint( const MODULE* aFootprint, const wxString& aName,
+                                unsigned aPadCount )
+    {
+        BOOST_REQUIRE( aFootprint );
+        BOOST_CHECK_EQUAL( wxString( aFootprint->GetFPID().GetLibItemName() ), aName );
+        BOOST_CHECK_EQUAL( aFootprint->GetPadCount(), aPadCount );
+    }
+
+    wxString   m_path;
+    PROPERTIES m_lazy;      ///< The options of a lazy cache
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( FootprintCache, FP_CACHE_FIXTURE )
+
+
+/**
+ * A lazy cache parses a footprint when it is requested, not when the library is read
+ */
+BOOST_AUTO_TEST_CASE( LazyLoad )
+{
+    WriteText( "BROKEN", "(module BROKEN (layer" );
+
+    wxArrayString names;
+
+    {
+        PCB_IO io;
+
+        BOOST_CHECK_THROW( io.FootprintEnumerate( names, m_path ), IO_ERROR );
+    }
+
+    PCB_IO io;
+
+    names.Clear();
+    io.FootprintEnumerate( names, m_path, &m_lazy );
+    BOOST_CHECK_EQUAL( names.size(), 6u );
+
+    for( int ii = 1; ii <= 5; ++ii )
+    {
+        BOOST_TEST_CONTEXT( Name( ii ) )
+        {
+            CheckFootprint( io.GetEnumeratedFootprint( m_path, Name( ii ), &m_lazy ),
+                            Name( ii ), ii );
+
+            std::unique_ptr<MODULE> copy( io.FootprintLoad( m_path, Name( ii ), &m_lazy ) );
+            CheckFootprint( copy.get(), Name( ii ), ii );
+        }
+    }
+
+    BOOST_CHECK( !io.GetEnumeratedFootprint( m_path, "BROKEN", &m_lazy ) );
+    BOOST_CHECK_THROW( io.FootprintLoad( m_path, "BROKEN", &m_lazy ), IO_ERROR );
+    BOOST_CHECK( !io.GetEnumeratedFootprint( m_path, "MISSING", &m_lazy ) );
+}
+
+
+/**
+ * A bounded cache drops the least recently used footprints, but not the one held by the
+ * caller of GetEnumeratedFootprint()
+ */
+BOOST_AUTO_TEST_CASE( Eviction )
+{
+    for( bool bounded : { false, true } )
+    {
+        BOOST_TEST_CONTEXT( ( bounded ? "Bounded" : "Unbounded" ) )
+        {
+            PROPERTIES    props = m_lazy;
+            PCB_IO        io;
+            wxArrayString names;
+
+            if( bounded )
+                props["max_resident_footprints"] = "2";
+
+            Write( Name( 1 ), 1 );
+            io.FootprintEnumerate( names, m_path, &props );
+
+            const MODULE* held = io.GetEnumeratedFootprint( m_path, Name( 1 ), &props );
+
+            CheckFootprint( held, Name( 1 ), 1 );
+
+            for( int ii = 2; ii <= 5; ++ii )
+            {
+                std::unique_ptr<MODULE> copy( io.FootprintLoad( m_path, Name( ii ), &props ) );
+                CheckFootprint( copy.get(), Name( ii ), ii );
+            }
+
+            // The held footprint is still valid, dropped or not
+            CheckFootprint( held, Name( 1 ), 1 );
+
+            // A footprint dropped from the cache is parsed again from its file.  This one
+            // does not check the timestamps, so the other footprints are kept.
+            Write( Name( 1 ), 7 );
+            CheckFootprint( io.GetEnumeratedFootprint( m_path, Name( 1 ), &props ), Name( 1 ),
+                            bounded ? 7 : 1 );
+            CheckFootprint( io.GetEnumeratedFootprint( m_path, Name( 5 ), &props ), Name( 5 ),
+                            5 );
+        }
+    }
+}
+
+
+/**
+ * The footprints parsed in background are the same as those parsed on demand, and a
+ * plugin can be deleted while its cache is prefetching
+ */
+BOOST_AUTO_TEST_CASE( Prefetch )
+{
+    for( const char* bound : { "", "2" } )
+    {
+        BOOST_TEST_CONTEXT( "Bound: " << bound )
+        {
+            PROPERTIES    props = m_lazy;
+            wxArrayString names;
+
+            props["prefetch"] = UTF8();
+
+            if( *bound )
+                props["max_resident_footprints"] = bound;
+
+            {
+                PCB_IO io;
+
+                io.FootprintEnumerate( names, m_path, &props );
+            }
+
+            PCB_IO io;
+
+            names.Clear();
+            io.FootprintEnumerate( names, m_path, &props );
+            BOOST_CHECK_EQUAL( names.size(), 5u );
+
+            for( int ii = 5; ii >= 1; --ii )
+            {
+                CheckFootprint( io.GetEnumeratedFootprint( m_path, Name( ii ), &props ),
+                                Name( ii ), ii );
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
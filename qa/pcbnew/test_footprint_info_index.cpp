@@ -0,0 +1,191 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include <footprint_info_impl.h>
+#include <footprint_info_index.h>
+
+
+struct FP_INFO_INDEX_FIXTURE
+{
+    FP_INFO_INDEX_FIXTURE() : m_path( wxFileName::CreateTempFileName( "fp-info-index" ) )
+    {
+    }
+
+    ~FP_INFO_INDEX_FIXTURE()
+    {
+        wxRemoveFile( m_path );
+    }
+
+    void Add( FOOTPRINT_INFO_INDEX& aIndex, const wxString& aLibrary, const wxString& aName,
+              long long aTimestamp, unsigned aPadCount )
+    {
+        FOOTPRINT_INFO_IMPL info( "nick", aName, aName + " description", "kw1 kw2", 0,
+                                  aPadCount, aPadCount - 1 );
+
+        aIndex.Add( aLibrary, info, aTimestamp );
+    }
+
+    wxString m_path;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( FootprintInfoIndex, FP_INFO_INDEX_FIXTURE )
+
+
+/**
+ * A missing or invalid file is an empty index
+ */
+BOOST_AUTO_TEST_CASE( Invalid )
+{
+    FOOTPRINT_INFO_INDEX index;
+
+    index.Load( m_path );
+    BOOST_CHECK( !index.Find( "/lib.pretty", "nick", "R_0603", 1 ) );
+
+    index.Load( m_path + ".missing" );
+    BOOST_CHECK( !index.Find( "/lib.pretty", "nick", "R_0603", 1 ) );
+}
+
+
+/**
+ * Records are read back for their timestamp only
+ */
+BOOST_AUTO_TEST_CASE( RoundTrip )
+{
+    {
+        FOOTPRINT_INFO_INDEX index;
+
+        index.Load( m_path );
+        Add( index, "/b.pretty", "R_0603", 100, 2 );
+        Add( index, "/a.pretty", "R_0805", 200, 3 );
+        Add( index, "/a.pretty", "C_0402", 300, 4 );
+
+        // Added records are found before the index is saved
+        BOOST_CHECK( index.Find( "/a.pretty", "nick", "C_0402", 300 ) );
+        BOOST_CHECK( index.Save( m_path ) );
+    }
+
+    FOOTPRINT_INFO_INDEX index;
+
+    index.Load( m_path );
+
+    auto info = index.Find( "/a.pretty", "other", "R_0805", 200 );
+
+    BOOST_REQUIRE( info );
+    BOOST_CHECK_EQUAL( info->GetLibNickname(), "other" );
+    BOOST_CHECK_EQUAL( info->GetName(), "R_0805" );
+    BOOST_CHECK_EQUAL( info->GetDescription(), "R_0805 description" );
+    BOOST_CHECK_EQUAL( info->GetKeywords(), "kw1 kw2" );
+    BOOST_CHECK_EQUAL( info->GetPadCount(), 3 );
+    BOOST_CHECK_EQUAL( info->GetUniquePadCount(), 2 );
+
+    BOOST_CHECK( index.Find( "/b.pretty", "nick", "R_0603", 100 ) );
+    BOOST_CHECK( index.Find( "/a.pretty", "nick", "C_0402", 300 ) );
+
+    // A changed file, a footprint of another library and an unknown footprint
+    BOOST_CHECK( !index.Find( "/a.pretty", "nick", "R_0805", 201 ) );
+    BOOST_CHECK( !index.Find( "/b.pretty", "nick", "R_0805", 200 ) );
+    BOOST_CHECK( !index.Find( "/a.pretty", "nick", "R_1206", 200 ) );
+}
+
+
+/**
+ * A library read again keeps only its found and added records
+ */
+BOOST_AUTO_TEST_CASE( Refresh )
+{
+    {
+        FOOTPRINT_INFO_INDEX index;
+
+        index.Load( m_path );
+        Add( index, "/a.pretty", "R_0603", 100, 2 );
+        Add( index, "/a.pretty", "R_0805", 100, 2 );
+        Add( index, "/b.pretty", "R_0603", 100, 2 );
+        BOOST_CHECK( index.Save( m_path ) );
+    }
+
+    {
+        FOOTPRINT_INFO_INDEX index;
+
+        index.Load( m_path );
+        index.Refresh( "/a.pretty" );
+        BOOST_CHECK( index.Find( "/a.pretty", "nick", "R_0603", 100 ) );
+        Add( index, "/a.pretty", "R_0805", 150, 5 );
+        Add( index, "/a.pretty", "C_0402", 100, 2 );
+        BOOST_CHECK( index.Save( m_path ) );
+    }
+
+    FOOTPRINT_INFO_INDEX index;
+
+    index.Load( m_path );
+
+    auto info = index.Find( "/a.pretty", "nick", "R_0805", 150 );
+
+    BOOST_REQUIRE( info );
+    BOOST_CHECK_EQUAL( info->GetPadCount(), 5 );
+
+    BOOST_CHECK( index.Find( "/a.pretty", "nick", "R_0603", 100 ) );
+    BOOST_CHECK( index.Find( "/a.pretty", "nick", "C_0402", 100 ) );
+    BOOST_CHECK( !index.Find( "/a.pretty", "nick", "R_0805", 100 ) );
+
+    // Another library is kept as is
+    BOOST_CHECK( index.Find( "/b.pretty", "nick", "R_0603", 100 ) );
+}
+
+
+/**
+ * A library read again without its old footprints loses them
+ */
+BOOST_AUTO_TEST_CASE( Removed )
+{
+    {
+        FOOTPRINT_INFO_INDEX index;
+
+        index.Load( m_path );
+        Add( index, "/a.pretty", "R_0603", 100, 2 );
+        Add( index, "/a.pretty", "R_0805", 100, 2 );
+        BOOST_CHECK( index.Save( m_path ) );
+    }
+
+    {
+        FOOTPRINT_INFO_INDEX index;
+
+        index.Load( m_path );
+        index.Refresh( "/a.pretty" );
+        BOOST_CHECK( index.Find( "/a.pretty", "nick", "R_0805", 100 ) );
+        BOOST_CHECK( index.Save( m_path ) );
+    }
+
+    FOOTPRINT_INFO_INDEX index;
+
+    index.Load( m_path );
+    BOOST_CHECK( !index.Find( "/a.pretty", "nick", "R_0603", 100 ) );
+    BOOST_CHECK( index.Find( "/a.pretty", "nick", "R_0805", 100 ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
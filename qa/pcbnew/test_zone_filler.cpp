@@ -0,0 +1,329 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include "board_test_utils.h"
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <convert_basic_shapes_to_polygon.h>
+#include <zone_filler.h>
+
+
+/**
+ * A board with a GND zone on the front layer, (0, 0) to (20, 20) mm, and a GND pad at
+ * (60, 10) mm.  Tracks are added by the test cases.
+ */
+struct ZONE_FILLER_FIXTURE : public KI_TEST::BOARD_FIXTURE
+{
+    ZONE_FILLER_FIXTURE()
+    {
+        AddPad( mm( 60, 10 ), m_gnd );
+
+        m_zone = AddZone( { mm( 0, 0 ), mm( 20, 0 ), mm( 20, 20 ), mm( 0, 20 ) }, m_gnd );
+    }
+
+    /**
+     * Fills the zones incrementally, with the fixture's cache
+     */
+    void Fill()
+    {
+        m_board.SynchronizeNetsAndNetClasses();
+        m_board.BuildConnectivity();
+
+        ZONE_FILLER filler( &m_board );
+
+        filler.SetFillCache( &m_cache );
+        BOOST_REQUIRE( filler.Fill( m_board.Zones() ) );
+    }
+
+    /**
+     * Checks that two fills cover the same area.  They may differ by rounding, e.g. where
+     * a patch meets the previous fill.
+     */
+    static void CheckSameFill( const SHAPE_POLY_SET& aFill, const SHAPE_POLY_SET& aExpected )
+    {
+        const int epsilon = Millimeter2iu( 0.001 );
+
+        BOOST_CHECK_EQUAL( aFill.OutlineCount(), aExpected.OutlineCount() );
+
+        SHAPE_POLY_SET extra = aFill;
+        extra.BooleanSubtract( aExpected, SHAPE_POLY_SET::PM_FAST );
+        extra.Deflate( epsilon, 8 );
+        BOOST_CHECK( extra.IsEmpty() );
+
+        SHAPE_POLY_SET missing = aExpected;
+        missing.BooleanSubtract( aFill, SHAPE_POLY_SET::PM_FAST );
+        missing.Deflate( epsilon, 8 );
+        BOOST_CHECK( missing.IsEmpty() );
+    }
+
+    /**
+     * Checks that the current fill of the zone is the one of a full refill
+     */
+    void CheckFullRefill()
+    {
+        SHAPE_POLY_SET incremental = m_zone->GetFilledPolysList();
+        ZONE_FILLER    filler( &m_board );
+
+        m_board.BuildConnectivity();
+        BOOST_REQUIRE( filler.Fill( m_board.Zones() ) );
+
+        CheckSameFill( incremental, m_zone->GetFilledPolysList() );
+    }
+
+    ZONE_FILL_CACHE m_cache;
+    ZONE_CONTAINER* m_zone;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ZoneFiller, ZONE_FILLER_FIXTURE )
+
+
+/**
+ * Cutting a net far away from a zone makes the zone an island
+ */
+BOOST_AUTO_TEST_CASE( IslandCutOffOutsideZone )
+{
+    AddTrack( mm( 10, 10 ), mm( 40, 10 ), m_gnd );
+    TRACK* link = AddTrack( mm( 40, 10 ), mm( 60, 10 ), m_gnd );
+
+    Fill();
+    BOOST_CHECK( !m_zone->GetFilledPolysList().IsEmpty() );
+
+    // The link is outside the zone and its clearance
+    m_cache.AddDirtyItem( link );
+    m_board.Remove( link );
+    delete link;
+
+    Fill();
+    BOOST_CHECK( m_zone->GetFilledPolysList().IsEmpty() );
+    CheckFullRefill();
+}
+
+
+/**
+ * Connecting a net far away from a zone brings back its island
+ */
+BOOST_AUTO_TEST_CASE( IslandConnectedOutsideZone )
+{
+    AddTrack( mm( 10, 10 ), mm( 40, 10 ), m_gnd );
+
+    Fill();
+    BOOST_CHECK( m_zone->GetFilledPolysList().IsEmpty() );
+
+    TRACK* link = AddTrack( mm( 40, 10 ), mm( 60, 10 ), m_gnd );
+    m_cache.AddDirtyItem( link );
+
+    Fill();
+    BOOST_CHECK( !m_zone->GetFilledPolysList().IsEmpty() );
+    CheckFullRefill();
+}
+
+
+/**
+ * An edit of another net outside the zone leaves its fill as it is
+ */
+BOOST_AUTO_TEST_CASE( OtherNetOutsideZone )
+{
+    AddTrack( mm( 10, 10 ), mm( 60, 10 ), m_gnd );
+
+    Fill();
+    BOOST_CHECK( !m_zone->GetFilledPolysList().IsEmpty() );
+
+    TRACK* other = AddTrack( mm( 40, 30 ), mm( 60, 30 ), m_sig );
+    m_cache.AddDirtyItem( other );
+
+    Fill();
+    CheckFullRefill();
+}
+
+
+/**
+ * A track added to and removed from a corner of a zone is patched into its fill
+ */
+BOOST_AUTO_TEST_CASE( PatchedFill )
+{
+    AddTrack( mm( 10, 10 ), mm( 60, 10 ), m_gnd );
+
+    Fill();
+
+    TRACK* other = AddTrack( mm( 2, 2 ), mm( 6, 2 ), m_sig );
+    m_cache.AddDirtyItem( other );
+
+    Fill();
+    CheckFullRefill();
+
+    m_cache.AddDirtyItem( other );
+    m_board.Remove( other );
+    delete other;
+
+    Fill();
+    CheckFullRefill();
+}
+
+
+/**
+ * A cached knockout is rebuilt when its item has changed in place, even if its bounding
+ * box has not
+ */
+BOOST_AUTO_TEST_CASE( KnockoutEditedInPlace )
+{
+    AddTrack( mm( 10, 10 ), mm( 60, 10 ), m_gnd );
+
+    ZONE_CONTAINER* other = AddZone( { mm( 4, 4 ), mm( 8, 4 ), mm( 4, 8 ) }, m_sig );
+    other->SetPriority( 1 );
+
+    // An unchanged knockout, found in the cache
+    AddTrack( mm( 12, 2 ), mm( 16, 2 ), m_sig );
+
+    Fill();
+
+    // Same bounding box and vertex count, another triangle
+    other->Outline()->Vertex( 2 ) = VECTOR2I( mm( 8, 8 ) );
+
+    // Refill the whole zone, with the knockouts of the cache
+    m_cache.AddDirtyItem( m_zone );
+
+    Fill();
+    BOOST_CHECK_GT( m_cache.GetKnockoutHits(), 0 );
+    CheckFullRefill();
+}
+
+
+/**
+ * A zone with enough knockouts to be split into tiles is filled as if it was not
+ */
+BOOST_AUTO_TEST_CASE( TiledFill )
+{
+    std::vector<wxPoint> corners = { mm( 0, 30 ), mm( 100, 30 ), mm( 100, 130 ), mm( 0, 130 ) };
+
+    ZONE_CONTAINER* front = AddZone( corners, m_gnd, F_Cu );
+    ZONE_CONTAINER* back = AddZone( corners, m_gnd, B_Cu );
+
+    AddPad( mm( 51.7, 82 ), m_gnd, false );
+
+    // The same tracks on both layers, twice on the front one: the front zone gets twice as
+    // many knockouts, which are split into tiles, for the same fill
+    for( int ii = 0; ii < 40; ++ii )
+    {
+        for( int jj = 0; jj < 25; ++jj )
+        {
+            wxPoint start = mm( 2 + ii * 2.4, 32 + jj * 4 );
+            wxPoint end = start + mm( 1, 0 );
+
+            AddTrack( start, end, m_sig, F_Cu );
+            AddTrack( start, end, m_sig, F_Cu );
+            AddTrack( start, end, m_sig, B_Cu );
+        }
+    }
+
+    Fill();
+
+    BOOST_CHECK( !front->GetFilledPolysList().IsEmpty() );
+    CheckSameFill( front->GetFilledPolysList(), back->GetFilledPolysList() );
+}
+
+
+/**
+ * Thermal reliefs are built once per pad shape, around the origin, and moved to each pad.
+ * A relief built that way must be the one built on the pad itself.
+ */
+BOOST_AUTO_TEST_CASE( ThermalReliefTemplates )
+{
+    const PAD_SHAPE_T shapes[] = { PAD_SHAPE_CIRCLE, PAD_SHAPE_OVAL, PAD_SHAPE_RECT,
+                                   PAD_SHAPE_TRAPEZOID, PAD_SHAPE_ROUNDRECT,
+                                   PAD_SHAPE_CHAMFERED_RECT };
+
+    const int gap = Millimeter2iu( 0.5 );
+    const int maxError = m_board.GetDesignSettings().m_MaxError;
+
+    for( PAD_SHAPE_T shape : shapes )
+    {
+        BOOST_TEST_CONTEXT( "Pad shape " << shape )
+        {
+            D_PAD* pad = AddPad( mm( 12.3456, 7.891 ), m_gnd, false );
+
+            pad->SetShape( shape );
+            pad->SetSize( wxSize( Millimeter2iu( 1.7 ), Millimeter2iu( 1.1 ) ) );
+            pad->SetOffset( mm( 0.13, -0.07 ) );
+            pad->SetOrientation( 337 );
+
+            if( shape == PAD_SHAPE_TRAPEZOID )
+                pad->SetDelta( wxSize( Millimeter2iu( 0.3 ), 0 ) );
+
+            if( shape == PAD_SHAPE_CHAMFERED_RECT )
+                pad->SetChamferPositions( RECT_CHAMFER_TOP_LEFT | RECT_CHAMFER_BOTTOM_RIGHT );
+
+            SHAPE_POLY_SET onPad;
+            pad->TransformShapeWithClearanceToPolygon( onPad, gap, maxError );
+
+            D_PAD padAtOrigin( *pad );
+            padAtOrigin.SetPosition( wxPoint( 0, 0 ) );
+
+            SHAPE_POLY_SET moved;
+            padAtOrigin.TransformShapeWithClearanceToPolygon( moved, gap, maxError );
+            moved.Move( pad->GetPosition() );
+
+            CheckSameFill( moved, onPad );
+        }
+    }
+}
+
+
+/**
+ * Pads of the same shape share their thermal relief and spokes, on a full fill and on a
+ * patched one
+ */
+BOOST_AUTO_TEST_CASE( ThermalPads )
+{
+    std::vector<D_PAD*> pads = { AddPad( mm( 5.37, 5.11 ), m_gnd, false ),
+                                 AddPad( mm( 14.29, 13.73 ), m_gnd, false ),
+                                 AddPad( mm( 4.02, 15.5 ), m_gnd, false ) };
+
+    for( D_PAD* pad : pads )
+    {
+        pad->SetShape( PAD_SHAPE_RECT );
+        pad->SetSize( wxSize( Millimeter2iu( 1.7 ), Millimeter2iu( 1.1 ) ) );
+        pad->SetOrientation( 337 );
+    }
+
+    Fill();
+    CheckFullRefill();
+
+    MODULE* module = pads[1]->GetParent();
+
+    m_cache.AddDirtyItem( module );
+    module->SetPosition( mm( 15.03, 12.61 ) );
+    m_cache.AddDirtyItem( module );
+
+    Fill();
+    CheckFullRefill();
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -23,7 +23,9 @@
 
 #include <qa_utils/utility_program.h>
 
+#include "tools/connectivity_benchmark/connectivity_benchmark.h"
 #include "tools/drc_tool/drc_tool.h"
+#include "tools/geometry_benchmark/geometry_benchmark.h"
 #include "tools/pcb_parser/pcb_parser_tool.h"
 #include "tools/polygon_generator/polygon_generator.h"
 #include "tools/polygon_triangulation/polygon_triangulation.h"
@@ -35,7 +37,9 @@
  * it's effective enough. When you have a new tool, add it to this list.
  */
 const static std::vector<KI_TEST::UTILITY_PROGRAM*> known_tools = {
+    &connectivity_benchmark_tool,
     &drc_tool,
+    &geometry_benchmark_tool,
     &pcb_parser_tool,
     &polygon_generator_tool,
     &polygon_triangulation_tool,
@@ -0,0 +1,281 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "connectivity_benchmark.h"
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <connectivity/connectivity_algo.h>
+#include <connectivity/connectivity_data.h>
+#include <connectivity/connectivity_store.h>
+#include <convert_to_biu.h>
+#include <netinfo.h>
+#include <profile.h>
+
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+
+
+/**
+ * The counts reported for a board, which only change with the connectivity results
+ */
+struct CONN_BENCH_RESULT
+{
+    uint64_t m_items = 0;           ///< CN_ITEMs of the connectivity graph
+    uint64_t m_connections = 0;     ///< Connections between them, both ways
+    uint64_t m_unconnected = 0;     ///< Ratsnest edges left
+};
+
+
+/**
+ * Generates a board of aSide x aSide footprints with two through hole pads.  The footprints
+ * of a row are daisy chained on one net, by a front track, a via and a back track between
+ * each pair.  Each footprint brings five connected items.
+ */
+static std::unique_ptr<BOARD> generatedBoard( int aSide )
+{
+    auto      board = std::make_unique<BOARD>();
+    const int pitch = Millimeter2iu( 5 );
+    const int padGap = Millimeter2iu( 2 );
+
+    for( int row = 0; row < aSide; row++ )
+    {
+        NETINFO_ITEM* net = new NETINFO_ITEM( board.get(), wxString::Format( "NET%d", row ) );
+
+        board->Add( net );
+
+        wxPoint prevPad;
+
+        for( int col = 0; col < aSide; col++ )
+        {
+            MODULE* module = new MODULE( board.get() );
+
+            for( int ii = 0; ii < 2; ii++ )
+            {
+                D_PAD* pad = new D_PAD( module );
+
+                pad->SetShape( PAD_SHAPE_CIRCLE );
+                pad->SetSize( wxSize( Millimeter2iu( 1.2 ), Millimeter2iu( 1.2 ) ) );
+                pad->SetDrillSize( wxSize( Millimeter2iu( 0.6 ), Millimeter2iu( 0.6 ) ) );
+                pad->SetAttribute( PAD_ATTRIB_STANDARD );
+                pad->SetLayerSet( D_PAD::StandardMask() );
+                pad->SetPos0( wxPoint( ii * padGap, 0 ) );
+                pad->SetName( wxString::Format( "%d", ii + 1 ) );
+                module->Add( pad );
+            }
+
+            const wxPoint pos( col * pitch, row * pitch );
+
+            module->SetPosition( pos );
+            board->Add( module );
+
+            for( D_PAD* pad : module->Pads() )
+                pad->SetNetCode( net->GetNet() );
+
+            if( col > 0 )
+            {
+                const wxPoint mid( ( prevPad.x + pos.x ) / 2, pos.y );
+                VIA*          via = new VIA( board.get() );
+
+                via->SetPosition( mid );
+                via->SetWidth( Millimeter2iu( 0.8 ) );
+                via->SetDrill( Millimeter2iu( 0.4 ) );
+                via->SetViaType( VIA_THROUGH );
+                via->SetLayerPair( F_Cu, B_Cu );
+                board->Add( via );
+                via->SetNetCode( net->GetNet() );
+
+                for( PCB_LAYER_ID layer : { F_Cu, B_Cu } )
+                {
+                    TRACK* track = new TRACK( board.get() );
+
+                    track->SetStart( layer == F_Cu ? prevPad : mid );
+                    track->SetEnd( layer == F_Cu ? mid : pos );
+                    track->SetWidth( Millimeter2iu( 0.25 ) );
+                    track->SetLayer( layer );
+                    board->Add( track );
+                    track->SetNetCode( net->GetNet() );
+                }
+            }
+
+            prevPad = pos + wxPoint( padGap, 0 );
+        }
+    }
+
+    board->SynchronizeNetsAndNetClasses();
+
+    return board;
+}
+
+
+/**
+ * Builds the connectivity of aBoard aReps times, and reports the counts of the first build,
+ * the time of the fastest one, and the time and memory of the fastest connection search
+ * done by a CN_STORE on the built items
+ */
+static void runBenchmark( const std::string& aName, BOARD& aBoard, int aReps, bool aShowTimes )
+{
+    CONN_BENCH_RESULT first;
+    double            bestMs = 0.0;
+    double            bestStoreMs = 0.0;
+    size_t            storeBytes = 0;
+
+    for( int ii = 0; ii < aReps; ii++ )
+    {
+        auto         connectivity = std::make_shared<CONNECTIVITY_DATA>();
+        PROF_COUNTER timer;
+
+        connectivity->Build( &aBoard );
+
+        const double ms = timer.msecs();
+
+        if( ii == 0 || ms < bestMs )
+            bestMs = ms;
+
+        CN_STORE     store;
+        PROF_COUNTER storeTimer;
+
+        store.Build( connectivity->GetConnectivityAlgo()->ItemList() );
+
+        const double storeMs = storeTimer.msecs();
+
+        if( ii == 0 || storeMs < bestStoreMs )
+            bestStoreMs = storeMs;
+
+        storeBytes = store.MemoryUsage();
+
+        if( ii > 0 )
+            continue;
+
+        for( CN_ITEM* item : connectivity->GetConnectivityAlgo()->ItemList() )
+        {
+            first.m_items++;
+            first.m_connections += item->ConnectedItems().size();
+        }
+
+        first.m_unconnected = connectivity->GetUnconnectedCount();
+    }
+
+    printf( "%-24s %10" PRIu64 " %12" PRIu64 " %12" PRIu64, aName.c_str(), first.m_items,
+            first.m_connections, first.m_unconnected );
+
+    if( aShowTimes )
+        printf( " %12.1f %12.1f %12zu", bestMs, bestStoreMs, storeBytes / 1024 );
+
+    printf( "\n" );
+    fflush( stdout );
+}
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_SWITCH, "h", "help", _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+    { wxCMD_LINE_OPTION, "r", "reps", _( "number of builds of each board (default 5)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_SWITCH, "c", "checksums-only",
+            _( "do not report the times, for an output that only changes with the results" )
+                    .mb_str() },
+    { wxCMD_LINE_PARAM, nullptr, nullptr, _( "board file" ).mb_str(), wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum CONN_BENCH_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+};
+
+
+int connectivity_benchmark_main( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText(
+            _( "This program benchmarks the connectivity build on generated boards of about "
+               "10k and 100k items, and on the given boards. Each line reports the board, "
+               "the connectivity items, their connections, the unconnected items, the time "
+               "of the fastest build (ms), and the time (ms) and memory (KiB) of the "
+               "connection search of the build alone." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long reps = 5;
+
+    cl_parser.Found( "reps", &reps );
+
+    const bool showTimes = !cl_parser.Found( "checksums-only" );
+
+    std::vector<std::pair<std::string, std::unique_ptr<BOARD>>> boards;
+
+    boards.emplace_back( "generated_10k", generatedBoard( 45 ) );
+    boards.emplace_back( "generated_100k", generatedBoard( 142 ) );
+
+    for( unsigned i = 0; i < cl_parser.GetParamCount(); i++ )
+    {
+        const wxFileName filename( cl_parser.GetParam( i ) );
+        std::unique_ptr<BOARD> board = KI_TEST::ReadBoardFromFileOrStream(
+                filename.GetFullPath().ToStdString() );
+
+        if( !board )
+            return CONN_BENCH_RET_CODES::LOAD_FAILED;
+
+        boards.emplace_back( filename.GetName().ToStdString(), std::move( board ) );
+    }
+
+    printf( "# %-22s %10s %12s %12s", "board", "items", "connections", "unconnected" );
+
+    if( showTimes )
+        printf( " %12s %12s %12s", "ms", "search ms", "search KiB" );
+
+    printf( "\n" );
+
+    for( const auto& board : boards )
+        runBenchmark( board.first, *board.second, std::max( 1L, reps ), showTimes );
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM connectivity_benchmark_tool = {
+    "connectivity_benchmark",
+    "Benchmark the connectivity build on generated and given boards",
+    connectivity_benchmark_main,
+};
@@ -24,6 +24,8 @@
 #include "drc_tool.h"
 
 #include <cstdio>
+#include <iomanip>
+#include <sstream>
 #include <string>
 
 #include <common.h>
@@ -36,6 +38,8 @@
 // DRC
 #include <drc/courtyard_overlap.h>
 #include <drc/drc_marker_factory.h>
+#include <drc/drilled_hole_clearance.h>
+#include <tools/drc.h>
 
 #include <qa_utils/stdstream_line_reader.h>
 
@@ -208,6 +212,241 @@ private:
 };
 
 
+/**
+ * DRC runner to run only DRC drilled hole to hole checks
+ */
+class DRC_DRILLED_HOLES_RUNNER : public DRC_RUNNER
+{
+public:
+    DRC_DRILLED_HOLES_RUNNER( const EXECUTION_CONTEXT& aCtx ) : DRC_RUNNER( aCtx )
+    {
+    }
+
+private:
+    std::string getRunnerIntro() const override
+    {
+        return "Drilled hole clearance";
+    }
+
+    BOARD_DESIGN_SETTINGS getDesignSettings() const override
+    {
+        BOARD_DESIGN_SETTINGS des_settings;
+        des_settings.m_HoleToHoleMin = Millimeter2iu( DEFAULT_HOLETOHOLEMIN );
+
+        return des_settings;
+    }
+
+    std::unique_ptr<DRC_PROVIDER> createDrcProvider(
+            BOARD& aBoard, DRC_PROVIDER::MARKER_HANDLER aHandler ) override
+    {
+        return std::make_unique<DRC_DRILLED_HOLE_CLEARANCE>( getMarkerFactory(), aHandler );
+    }
+};
+
+
+/**
+ * Escape a string for a JSON string literal
+ */
+static std::string jsonString( const wxString& aStr )
+{
+    std::ostringstream out;
+
+    out << '"';
+
+    for( char c : std::string( aStr.ToUTF8() ) )
+    {
+        switch( c )
+        {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if( (unsigned char) c < 0x20 )
+                out << "\\u" << std::hex << std::setw( 4 ) << std::setfill( '0' ) << (int) c
+                    << std::dec << std::setfill( ' ' );
+            else
+                out << c;
+        }
+    }
+
+    out << '"';
+
+    return out.str();
+}
+
+
+/**
+ * Write a DRC item as a JSON object: the error, where it is reported and the items
+ * involved.  Positions are in millimetres.
+ */
+static void writeJsonItem( std::ostream& aOut, const DRC_ITEM& aItem, const wxPoint& aPos )
+{
+    auto writePos = [&]( const wxPoint& aPoint )
+    {
+        aOut << "\"x_mm\": " << Iu2Millimeter( aPoint.x )
+             << ", \"y_mm\": " << Iu2Millimeter( aPoint.y );
+    };
+
+    aOut << "{\"code\": " << aItem.GetErrorCode()
+         << ", \"description\": " << jsonString( aItem.GetErrorText() ) << ", ";
+    writePos( aPos );
+    aOut << ", \"items\": [{\"text\": " << jsonString( aItem.GetMainText() ) << ", ";
+    writePos( aItem.GetPointA() );
+    aOut << "}";
+
+    if( aItem.HasSecondItem() )
+    {
+        aOut << ", {\"text\": " << jsonString( aItem.GetAuxiliaryText() ) << ", ";
+        writePos( aItem.GetPointB() );
+        aOut << "}";
+    }
+
+    aOut << "]}";
+}
+
+
+/**
+ * Runs the full DRC, i.e. all the tests the DRC dialog runs, without the editor.
+ *
+ * The results are either printed like those of the DRC_RUNNERs, or written to stdout as
+ * a JSON report for scripts and CI.
+ */
+class DRC_FULL_RUNNER
+{
+public:
+    struct OPTIONS
+    {
+        bool m_verbose;
+        bool m_print_times;
+        bool m_print_markers;
+        bool m_json;
+        bool m_refill_zones;
+    };
+
+    DRC_FULL_RUNNER( const OPTIONS& aOptions ) : m_options( aOptions )
+    {
+    }
+
+    /**
+     * @return the number of violations found, unconnected items included
+     */
+    size_t Execute( BOARD& aBoard )
+    {
+        if( m_options.m_verbose && !m_options.m_json )
+            std::cout << "Running DRC check: Full DRC" << std::endl;
+
+        std::vector<std::unique_ptr<MARKER_PCB>> markers;
+
+        auto marker_handler = [&]( MARKER_PCB* aMarker ) {
+            markers.push_back( std::unique_ptr<MARKER_PCB>( aMarker ) );
+        };
+
+        DRC drc;
+        drc.SetRefillZones( m_options.m_refill_zones );
+
+        DRC_DURATION duration;
+        {
+            SCOPED_PROF_COUNTER<DRC_DURATION> timer( duration );
+            drc.RunBatchTests( &aBoard, marker_handler );
+        }
+
+        const DRC_LIST& unconnected = drc.GetUnconnectedItems();
+
+        if( m_options.m_json )
+        {
+            writeJson( markers, unconnected, drc.GetTestTimings(), duration );
+        }
+        else
+        {
+            if( m_options.m_print_times )
+                reportTimings( drc.GetTestTimings(), duration );
+
+            if( m_options.m_print_markers )
+                reportMarkers( markers, unconnected );
+        }
+
+        return markers.size() + unconnected.size();
+    }
+
+private:
+    void reportTimings( const std::vector<DRC_TEST_TIMING>& aTimings,
+                        const DRC_DURATION& aDuration ) const
+    {
+        for( const DRC_TEST_TIMING& timing : aTimings )
+        {
+            std::cout << timing.m_Test << ": " << timing.m_ItemCount << " items, "
+                      << timing.m_Msecs << "ms" << std::endl;
+        }
+
+        std::cout << "Took: " << aDuration.count() << "us" << std::endl;
+    }
+
+    void reportMarkers( const std::vector<std::unique_ptr<MARKER_PCB>>& aMarkers,
+                        const DRC_LIST& aUnconnected ) const
+    {
+        std::cout << "DRC markers: " << aMarkers.size() << std::endl;
+
+        int index = 0;
+        for( const auto& m : aMarkers )
+        {
+            std::cout << index++ << ": " << m->GetReporter().ShowReport( EDA_UNITS_T::MILLIMETRES );
+        }
+
+        std::cout << "Unconnected items: " << aUnconnected.size() << std::endl;
+
+        index = 0;
+        for( const DRC_ITEM* item : aUnconnected )
+        {
+            std::cout << index++ << ": " << item->ShowReport( EDA_UNITS_T::MILLIMETRES );
+        }
+    }
+
+    void writeJson( const std::vector<std::unique_ptr<MARKER_PCB>>& aMarkers,
+                    const DRC_LIST& aUnconnected, const std::vector<DRC_TEST_TIMING>& aTimings,
+                    const DRC_DURATION& aDuration ) const
+    {
+        std::ostream& out = std::cout;
+
+        out << std::fixed << std::setprecision( 6 );
+        out << "{\n  \"violations\": [";
+
+        for( size_t ii = 0; ii < aMarkers.size(); ++ii )
+        {
+            out << ( ii ? ",\n    " : "\n    " );
+            writeJsonItem( out, aMarkers[ii]->GetReporter(), aMarkers[ii]->GetPosition() );
+        }
+
+        out << "\n  ],\n  \"unconnected\": [";
+
+        for( size_t ii = 0; ii < aUnconnected.size(); ++ii )
+        {
+            out << ( ii ? ",\n    " : "\n    " );
+            writeJsonItem( out, *aUnconnected[ii], aUnconnected[ii]->GetPointA() );
+        }
+
+        out << "\n  ],\n  \"tests\": [";
+
+        for( size_t ii = 0; ii < aTimings.size(); ++ii )
+        {
+            const DRC_TEST_TIMING& timing = aTimings[ii];
+
+            out << ( ii ? ",\n    " : "\n    " )
+                << "{\"test\": " << jsonString( timing.m_Test )
+                << ", \"items\": " << timing.m_ItemCount
+                << ", \"time_ms\": " << std::setprecision( 3 ) << timing.m_Msecs
+                << std::setprecision( 6 ) << "}";
+        }
+
+        out << "\n  ],\n  \"time_ms\": " << std::setprecision( 3 )
+            << aDuration.count() / 1000.0 << "\n}" << std::endl;
+    }
+
+    const OPTIONS m_options;
+};
+
+
 static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
     {
             wxCMD_LINE_SWITCH,
@@ -253,6 +492,30 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
             "courtyard-missing",
             _( "perform courtyard-missing checking" ).mb_str(),
     },
+    {
+            wxCMD_LINE_SWITCH,
+            "H",
+            "drilled-holes",
+            _( "perform drilled hole to hole clearance checking" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_SWITCH,
+            "F",
+            "full",
+            _( "perform the full DRC, as the DRC dialog does (exit status 11 on errors)" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_SWITCH,
+            "j",
+            "json",
+            _( "write the full DRC results as a JSON report to stdout" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_SWITCH,
+            "z",
+            "refill-zones",
+            _( "refill all zones before the full DRC" ).mb_str(),
+    },
     {
             wxCMD_LINE_PARAM,
             nullptr,
@@ -270,6 +533,9 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
 enum PARSER_RET_CODES
 {
     PARSE_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+
+    /// The full DRC found errors
+    DRC_ERRORS,
 };
 
 
@@ -315,6 +581,26 @@ int drc_main_func( int argc, char** argv )
 
     const bool all = cl_parser.Found( "all-checks" );
 
+    int ret = KI_TEST::RET_CODES::OK;
+
+    // The full DRC runs first, with the board's own design settings: the other runners
+    // replace them
+    if( cl_parser.Found( "full" ) )
+    {
+        DRC_FULL_RUNNER::OPTIONS options{
+            verbose,
+            cl_parser.Found( "timings" ),
+            cl_parser.Found( "print-markers" ),
+            cl_parser.Found( "json" ),
+            cl_parser.Found( "refill-zones" ),
+        };
+
+        DRC_FULL_RUNNER runner( options );
+
+        if( runner.Execute( *board ) > 0 )
+            ret = PARSER_RET_CODES::DRC_ERRORS;
+    }
+
     // Run the DRC on the board
     if( all || cl_parser.Found( "courtyard-overlap" ) )
     {
@@ -328,7 +614,13 @@ int drc_main_func( int argc, char** argv )
         runner.Execute( *board );
     }
 
-    return KI_TEST::RET_CODES::OK;
+    if( all || cl_parser.Found( "drilled-holes" ) )
+    {
+        DRC_DRILLED_HOLES_RUNNER runner( exec_context );
+        runner.Execute( *board );
+    }
+
+    return ret;
 }
 
 
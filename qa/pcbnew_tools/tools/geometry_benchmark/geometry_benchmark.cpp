@@ -0,0 +1,653 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "geometry_benchmark.h"
+
+#include <geometry/rtree.h>
+#include <geometry/seg.h>
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <convert_to_biu.h>
+#include <profile.h>
+
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <random>
+
+
+/**
+ * Pseudo-random numbers from std::mt19937, whose sequence is the same with every standard
+ * library (unlike the std distributions), so the generated fixtures are the same everywhere.
+ */
+class BENCH_RNG
+{
+public:
+    BENCH_RNG( unsigned aSeed ) : m_rng( aSeed )
+    {
+    }
+
+    int Next( int aMin, int aMax )
+    {
+        return aMin + int( m_rng() % unsigned( aMax - aMin + 1 ) );
+    }
+
+private:
+    std::mt19937 m_rng;
+};
+
+
+using SEG_TREE = RTree<int, int, 2, double>;
+
+
+/**
+ * The bounding box of a segment, inflated by aInflate, as RTree bounds
+ */
+static void segBounds( const SEG& aSeg, int aInflate, int aMin[2], int aMax[2] )
+{
+    aMin[0] = std::min( aSeg.A.x, aSeg.B.x ) - aInflate;
+    aMin[1] = std::min( aSeg.A.y, aSeg.B.y ) - aInflate;
+    aMax[0] = std::max( aSeg.A.x, aSeg.B.x ) + aInflate;
+    aMax[1] = std::max( aSeg.A.y, aSeg.B.y ) + aInflate;
+}
+
+
+/**
+ * The geometry the benchmarks run on
+ */
+struct BENCH_FIXTURE
+{
+    std::string                 m_name;
+
+    ///> The operands of the poly set benchmarks.  Consecutive sets overlap.
+    std::vector<SHAPE_POLY_SET> m_polySets;
+
+    std::vector<SEG>            m_segs;
+    std::vector<VECTOR2I>       m_points;
+
+    ///> Offset for Inflate() and clearance for the collisions, in the units of the fixture
+    int                         m_clearance;
+
+    ///> All the contours of m_polySets, and points within the bounding box of each
+    std::vector<SHAPE_LINE_CHAIN>      m_chains;
+    std::vector<std::vector<VECTOR2I>> m_probes;
+
+    ///> The bounding boxes of m_segs
+    std::unique_ptr<SEG_TREE>   m_segTree;
+
+    BENCH_FIXTURE( const std::string& aName, int aClearance ) :
+            m_name( aName ),
+            m_clearance( aClearance )
+    {
+    }
+
+    /**
+     * Derives the chains, the probe points and the segment tree from the poly sets and the
+     * segments
+     */
+    void Finalize()
+    {
+        BENCH_RNG rng( 1 );
+
+        for( const SHAPE_POLY_SET& set : m_polySets )
+        {
+            for( int ii = 0; ii < set.OutlineCount(); ii++ )
+            {
+                for( const SHAPE_LINE_CHAIN& chain : set.CPolygon( ii ) )
+                {
+                    const BOX2I           bbox = chain.BBox();
+                    std::vector<VECTOR2I> probes;
+
+                    for( int jj = 0; jj < 8; jj++ )
+                    {
+                        probes.emplace_back( rng.Next( bbox.GetLeft(), bbox.GetRight() ),
+                                             rng.Next( bbox.GetTop(), bbox.GetBottom() ) );
+                    }
+
+                    m_chains.push_back( chain );
+                    m_probes.push_back( probes );
+                }
+            }
+        }
+
+        m_segTree.reset( new SEG_TREE );
+
+        for( size_t ii = 0; ii < m_segs.size(); ii++ )
+        {
+            int min[2], max[2];
+
+            segBounds( m_segs[ii], 0, min, max );
+            m_segTree->Insert( min, max, (int) ii );
+        }
+    }
+};
+
+
+/**
+ * The outcome of one pass of a benchmark
+ */
+struct BENCH_RESULT
+{
+    ///> The number of operations of the pass, the unit of the throughput
+    uint64_t m_ops = 0;
+
+    /**
+     * A checksum of the results of the operations.  It keeps the compiler from optimising
+     * the operations away, and changes when the results of the kernel do.
+     */
+    uint64_t m_checksum = 0;
+};
+
+
+using BENCH_FUNC = std::function<void( const BENCH_FIXTURE&, BENCH_RESULT& )>;
+
+
+struct BENCHMARK
+{
+    std::string m_name;
+    BENCH_FUNC  m_func;
+};
+
+
+/**
+ * Runs a boolean operation between each pair of consecutive poly sets
+ */
+template <void ( SHAPE_POLY_SET::*OP )( const SHAPE_POLY_SET&, SHAPE_POLY_SET::POLYGON_MODE )>
+static void bench_poly_boolean( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    for( size_t ii = 1; ii < aFixture.m_polySets.size(); ii++ )
+    {
+        SHAPE_POLY_SET result = aFixture.m_polySets[ii - 1];
+
+        ( result.*OP )( aFixture.m_polySets[ii], SHAPE_POLY_SET::PM_FAST );
+
+        aResult.m_ops++;
+        aResult.m_checksum += result.TotalVertices();
+    }
+}
+
+
+static void bench_poly_fracture( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    for( const SHAPE_POLY_SET& set : aFixture.m_polySets )
+    {
+        SHAPE_POLY_SET result = set;
+
+        result.Fracture( SHAPE_POLY_SET::PM_FAST );
+
+        aResult.m_ops++;
+        aResult.m_checksum += result.TotalVertices();
+    }
+}
+
+
+static void bench_poly_inflate( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    for( const SHAPE_POLY_SET& set : aFixture.m_polySets )
+    {
+        SHAPE_POLY_SET result = set;
+
+        result.Inflate( aFixture.m_clearance, 16 );
+
+        aResult.m_ops++;
+        aResult.m_checksum += result.TotalVertices();
+    }
+}
+
+
+static void bench_poly_triangulate( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    for( const SHAPE_POLY_SET& set : aFixture.m_polySets )
+    {
+        SHAPE_POLY_SET result = set;
+
+        result.CacheTriangulation();
+
+        aResult.m_ops++;
+
+        for( unsigned int ii = 0; ii < result.TriangulatedPolyCount(); ii++ )
+            aResult.m_checksum += result.TriangulatedPolygon( ii )->GetTriangleCount();
+    }
+}
+
+
+/**
+ * Checks each point against one of the poly sets, so each point is checked once
+ */
+static void bench_poly_collide( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    if( aFixture.m_polySets.empty() )
+        return;
+
+    const size_t count = aFixture.m_polySets.size();
+
+    for( size_t ii = 0; ii < aFixture.m_points.size(); ii++ )
+    {
+        const SHAPE_POLY_SET& set = aFixture.m_polySets[ii * count / aFixture.m_points.size()];
+
+        aResult.m_ops++;
+        aResult.m_checksum += set.Collide( aFixture.m_points[ii], aFixture.m_clearance );
+    }
+}
+
+
+/**
+ * Intersects each chain with the next few ones, which are the contours of nearby polygons
+ */
+static void bench_chain_intersect( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    const std::vector<SHAPE_LINE_CHAIN>& chains = aFixture.m_chains;
+    SHAPE_LINE_CHAIN::INTERSECTIONS      intersections;
+
+    for( size_t ii = 0; ii < chains.size(); ii++ )
+    {
+        for( size_t jj = ii + 1; jj < chains.size() && jj <= ii + 4; jj++ )
+        {
+            intersections.clear();
+
+            aResult.m_ops++;
+            aResult.m_checksum += chains[ii].Intersect( chains[jj], intersections );
+        }
+    }
+}
+
+
+static void bench_chain_point_inside( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    for( size_t ii = 0; ii < aFixture.m_chains.size(); ii++ )
+    {
+        for( const VECTOR2I& probe : aFixture.m_probes[ii] )
+        {
+            aResult.m_ops++;
+            aResult.m_checksum += aFixture.m_chains[ii].PointInside( probe );
+        }
+    }
+}
+
+
+static void bench_chain_simplify( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    for( const SHAPE_LINE_CHAIN& chain : aFixture.m_chains )
+    {
+        SHAPE_LINE_CHAIN result = chain;
+
+        result.Simplify();
+
+        aResult.m_ops++;
+        aResult.m_checksum += result.PointCount();
+    }
+}
+
+
+/**
+ * Measures the distance between each segment and the next few ones
+ */
+static void bench_seg_distance( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    const std::vector<SEG>& segs = aFixture.m_segs;
+
+    for( size_t ii = 0; ii < segs.size(); ii++ )
+    {
+        for( size_t jj = ii + 1; jj < segs.size() && jj <= ii + 8; jj++ )
+        {
+            aResult.m_ops++;
+            aResult.m_checksum += segs[ii].SquaredDistance( segs[jj] );
+        }
+    }
+}
+
+
+static void bench_rtree_insert( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    SEG_TREE tree;
+
+    for( size_t ii = 0; ii < aFixture.m_segs.size(); ii++ )
+    {
+        int min[2], max[2];
+
+        segBounds( aFixture.m_segs[ii], 0, min, max );
+        tree.Insert( min, max, (int) ii );
+        aResult.m_ops++;
+    }
+
+    aResult.m_checksum += tree.Count();
+}
+
+
+/**
+ * Searches the segment tree around each segment, inflated by the clearance
+ */
+static void bench_rtree_search( const BENCH_FIXTURE& aFixture, BENCH_RESULT& aResult )
+{
+    for( const SEG& seg : aFixture.m_segs )
+    {
+        int min[2], max[2];
+
+        segBounds( seg, aFixture.m_clearance, min, max );
+
+        aResult.m_ops++;
+        aResult.m_checksum += aFixture.m_segTree->Search( min, max,
+                []( const int& ) { return true; } );
+    }
+}
+
+
+/**
+ * List of available benchmarks, in the order of the report
+ */
+static const std::vector<BENCHMARK> benchmarkList =
+{
+    { "poly_boolean_add", bench_poly_boolean<&SHAPE_POLY_SET::BooleanAdd> },
+    { "poly_boolean_subtract", bench_poly_boolean<&SHAPE_POLY_SET::BooleanSubtract> },
+    { "poly_boolean_intersection", bench_poly_boolean<&SHAPE_POLY_SET::BooleanIntersection> },
+    { "poly_fracture", bench_poly_fracture },
+    { "poly_inflate", bench_poly_inflate },
+    { "poly_triangulate", bench_poly_triangulate },
+    { "poly_collide", bench_poly_collide },
+    { "chain_intersect", bench_chain_intersect },
+    { "chain_point_inside", bench_chain_point_inside },
+    { "chain_simplify", bench_chain_simplify },
+    { "seg_distance", bench_seg_distance },
+    { "rtree_insert", bench_rtree_insert },
+    { "rtree_search", bench_rtree_search },
+};
+
+
+/**
+ * A polygon of 24 vertices at a random distance of the centre, with an octagonal hole
+ */
+static void addRandomPolygon( SHAPE_POLY_SET& aSet, const VECTOR2I& aCentre, BENCH_RNG& aRng )
+{
+    SHAPE_LINE_CHAIN outline, hole;
+
+    for( int ii = 0; ii < 24; ii++ )
+    {
+        const double a = 2 * M_PI * ii / 24;
+        const int    r = aRng.Next( 400, 900 );
+
+        outline.Append( aCentre.x + int( r * cos( a ) ), aCentre.y + int( r * sin( a ) ) );
+    }
+
+    for( int ii = 0; ii < 8; ii++ )
+    {
+        const double a = 2 * M_PI * ii / 8;
+
+        hole.Append( aCentre.x + int( 300 * cos( a ) ), aCentre.y + int( 300 * sin( a ) ) );
+    }
+
+    outline.SetClosed( true );
+    hole.SetClosed( true );
+
+    aSet.AddOutline( outline );
+    aSet.AddHole( hole );
+}
+
+
+/**
+ * Generates aSetCount poly sets of aSide x aSide polygons on a grid, each set overlapping
+ * half of the next one, and random points and segments over the same area
+ */
+static std::unique_ptr<BENCH_FIXTURE> generatedFixture( const std::string& aName, int aSetCount,
+                                                        int aSide )
+{
+    const int pitch = 1500;
+    auto      fixture = std::make_unique<BENCH_FIXTURE>( aName, 100 );
+    BENCH_RNG rng( 42 );
+
+    for( int set = 0; set < aSetCount; set++ )
+    {
+        SHAPE_POLY_SET polySet;
+
+        for( int row = 0; row < aSide; row++ )
+        {
+            for( int col = 0; col < aSide; col++ )
+            {
+                const VECTOR2I centre( ( set * aSide / 2 + col ) * pitch + rng.Next( -200, 200 ),
+                                       row * pitch + rng.Next( -200, 200 ) );
+
+                addRandomPolygon( polySet, centre, rng );
+            }
+        }
+
+        fixture->m_polySets.push_back( polySet );
+    }
+
+    const int width = ( aSetCount + 1 ) * aSide / 2 * pitch;
+    const int height = aSide * pitch;
+
+    for( int ii = 0; ii < 20000; ii++ )
+    {
+        const VECTOR2I a( rng.Next( 0, width ), rng.Next( 0, height ) );
+        const VECTOR2I b = a + VECTOR2I( rng.Next( -2000, 2000 ), rng.Next( -2000, 2000 ) );
+
+        fixture->m_points.push_back( a );
+        fixture->m_segs.emplace_back( a, b );
+    }
+
+    fixture->Finalize();
+
+    return fixture;
+}
+
+
+/**
+ * Takes the geometry of a board: the copper of each net as a poly set, the zone fills, the
+ * tracks as segments and the pads and track ends as points
+ */
+static std::unique_ptr<BENCH_FIXTURE> boardFixture( const std::string& aName, BOARD& aBoard )
+{
+    auto                        fixture = std::make_unique<BENCH_FIXTURE>( aName,
+                                                                           Millimeter2iu( 0.2 ) );
+    std::vector<SHAPE_POLY_SET> nets( aBoard.GetNetCount() );
+
+    for( TRACK* track : aBoard.Tracks() )
+    {
+        if( track->GetNetCode() > 0 && track->GetNetCode() < (int) nets.size() )
+            track->TransformShapeWithClearanceToPolygon( nets[track->GetNetCode()], 0,
+                                                         ARC_HIGH_DEF );
+
+        fixture->m_segs.emplace_back( track->GetStart(), track->GetEnd() );
+        fixture->m_points.push_back( track->GetStart() );
+    }
+
+    for( MODULE* module : aBoard.Modules() )
+    {
+        for( D_PAD* pad : module->Pads() )
+        {
+            if( pad->GetNetCode() > 0 && pad->GetNetCode() < (int) nets.size() )
+                pad->TransformShapeWithClearanceToPolygon( nets[pad->GetNetCode()], 0,
+                                                           ARC_HIGH_DEF );
+
+            fixture->m_points.push_back( pad->ShapePos() );
+        }
+    }
+
+    for( SHAPE_POLY_SET& net : nets )
+    {
+        if( net.IsEmpty() )
+            continue;
+
+        net.Simplify( SHAPE_POLY_SET::PM_FAST );
+        fixture->m_polySets.push_back( net );
+    }
+
+    for( ZONE_CONTAINER* zone : aBoard.Zones() )
+    {
+        if( !zone->GetFilledPolysList().IsEmpty() )
+            fixture->m_polySets.push_back( zone->GetFilledPolysList() );
+    }
+
+    fixture->Finalize();
+
+    return fixture;
+}
+
+
+/**
+ * Runs a benchmark aReps times, and reports the checksum of the first pass and the time of
+ * the fastest one, which is the least sensitive to the load of the machine
+ */
+static void runBenchmark( const BENCHMARK& aBenchmark, const BENCH_FIXTURE& aFixture, int aReps,
+                          bool aShowTimes )
+{
+    BENCH_RESULT first;
+    double       bestNs = 0.0;
+
+    for( int ii = 0; ii < aReps; ii++ )
+    {
+        BENCH_RESULT result;
+        PROF_COUNTER timer;
+
+        aBenchmark.m_func( aFixture, result );
+
+        const double ns = timer.SinceStart<std::chrono::duration<double, std::nano>>().count();
+
+        if( ii == 0 || ns < bestNs )
+            bestNs = ns;
+
+        if( ii == 0 )
+            first = result;
+    }
+
+    printf( "%-24s %-28s %10" PRIu64 " %20" PRIu64, aFixture.m_name.c_str(),
+            aBenchmark.m_name.c_str(), first.m_ops, first.m_checksum );
+
+    if( aShowTimes && first.m_ops > 0 )
+        printf( " %12.1f %14.0f", bestNs / first.m_ops, first.m_ops * 1e9 / bestNs );
+
+    printf( "\n" );
+    fflush( stdout );
+}
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_SWITCH, "h", "help", _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+    { wxCMD_LINE_OPTION, "r", "reps", _( "number of passes of each benchmark (default 5)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_OPTION, "f", "filter",
+            _( "only run the benchmarks whose name contains this string" ).mb_str(),
+            wxCMD_LINE_VAL_STRING },
+    { wxCMD_LINE_SWITCH, "c", "checksums-only",
+            _( "do not report the times, for an output that only changes with the results" )
+                    .mb_str() },
+    { wxCMD_LINE_PARAM, nullptr, nullptr, _( "board file" ).mb_str(), wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum GEOM_BENCH_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+};
+
+
+int geometry_benchmark_main( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText(
+            _( "This program benchmarks the geometry kernel on generated geometry, and on the "
+               "geometry of the given boards (e.g. qa/data/complex_hierarchy.kicad_pcb). Each "
+               "line reports the fixture, the benchmark, the operations of a pass, the "
+               "checksum of their results, and the time per operation (ns) and throughput "
+               "(operations per second) of the fastest pass." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long     reps = 5;
+    wxString filter;
+
+    cl_parser.Found( "reps", &reps );
+    cl_parser.Found( "filter", &filter );
+
+    const bool showTimes = !cl_parser.Found( "checksums-only" );
+
+    std::vector<std::unique_ptr<BENCH_FIXTURE>> fixtures;
+
+    fixtures.push_back( generatedFixture( "generated", 32, 10 ) );
+    fixtures.push_back( generatedFixture( "generated_large", 2, 40 ) );
+
+    for( unsigned i = 0; i < cl_parser.GetParamCount(); i++ )
+    {
+        const wxFileName filename( cl_parser.GetParam( i ) );
+        std::unique_ptr<BOARD> board = KI_TEST::ReadBoardFromFileOrStream(
+                filename.GetFullPath().ToStdString() );
+
+        if( !board )
+            return GEOM_BENCH_RET_CODES::LOAD_FAILED;
+
+        fixtures.push_back( boardFixture( filename.GetName().ToStdString(), *board ) );
+    }
+
+    printf( "# %-22s %-28s %10s %20s", "fixture", "benchmark", "ops", "checksum" );
+
+    if( showTimes )
+        printf( " %12s %14s", "ns/op", "ops/s" );
+
+    printf( "\n" );
+
+    for( const auto& fixture : fixtures )
+    {
+        for( const BENCHMARK& bmark : benchmarkList )
+        {
+            if( !filter.IsEmpty()
+                    && !wxString( fixture->m_name + "/" + bmark.m_name ).Contains( filter ) )
+                continue;
+
+            runBenchmark( bmark, *fixture, std::max( 1L, reps ), showTimes );
+        }
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM geometry_benchmark_tool = {
+    "geometry_benchmark",
+    "Benchmark the geometry kernel on generated and board geometry",
+    geometry_benchmark_main,
+};